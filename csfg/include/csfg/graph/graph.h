@@ -1,12 +1,18 @@
 #pragma once
 
 #include "csfg/graph/path.h"
+#include "csfg/util/hash.h"
 #include "csfg/util/strview.h"
 #include "csfg/util/vec.h"
 
 #define CSFG_GRAPH_GC_ID ((uint16_t)-1)
 
+/* Above this many loops, enumerating loop combinations for Mason's determinant
+ * becomes more expensive than solving the node equations directly */
+#define CSFG_GRAPH_MASON_MAX_LOOPS 12
+
 struct csfg_path_vec;
+struct csfg_var_table;
 struct str;
 
 struct csfg_node
@@ -31,8 +37,8 @@ struct csfg_edge
     uint16_t id;
 };
 
-VEC_DECLARE(csfg_node_vec, struct csfg_node, 16)
-VEC_DECLARE(csfg_edge_vec, struct csfg_edge, 16)
+VEC_DECLARE(csfg_node_vec, struct csfg_node, 32)
+VEC_DECLARE(csfg_edge_vec, struct csfg_edge, 32)
 
 struct csfg_graph
 {
@@ -45,6 +51,13 @@ void csfg_graph_init(struct csfg_graph* g);
 void csfg_graph_deinit(struct csfg_graph* g);
 void csfg_graph_clear(struct csfg_graph* g);
 
+/*!
+ * @brief Nodes and edges share the 16-bit ID space, so a graph holds at most
+ * CSFG_GRAPH_GC_ID nodes and edges combined, including the ones marked as
+ * deleted.
+ * @return Returns the index of the new node or edge, or -1 on failure, e.g.
+ * if no ID is left.
+ */
 int csfg_graph_add_node(struct csfg_graph* g, const char* name);
 int csfg_graph_add_node_steal_name(struct csfg_graph* g, struct str* name);
 int csfg_graph_add_edge(
@@ -60,6 +73,17 @@ void csfg_graph_mark_edge_deleted(struct csfg_graph* g, int e);
 
 void csfg_graph_gc(struct csfg_graph* g);
 
+/*!
+ * @brief Computes a hash of the graph's structure, i.e. the number of nodes,
+ * which nodes are connected by edges, and the input and output nodes. Edge
+ * expressions and node names are not included.
+ */
+hash32 csfg_graph_topology_hash(
+    const struct csfg_graph* g, int node_in, int node_out);
+
+/*! Computes a hash of all edge expressions, in edge order */
+hash32 csfg_graph_edge_exprs_hash(const struct csfg_graph* g);
+
 #define csfg_graph_for_each_node(g, var)                                       \
     vec_for_each ((g) ? (g)->nodes : NULL, (var))
 #define csfg_graph_for_each_edge(g, var)                                       \
@@ -107,3 +131,110 @@ int csfg_graph_mason(
     struct csfg_expr_pool** pool,
     const struct csfg_path_vec* paths,
     const struct csfg_path_vec* loops);
+
+/*!
+ * @brief Returns the expression that is used as the gain of an edge. The
+ * expression must be created in "pool".
+ * @return Expression root into "pool", or -1 if an error occurred.
+ */
+typedef int (*csfg_graph_edge_gain_func)(
+    struct csfg_expr_pool** pool, int edge_idx, void* user);
+
+/*!
+ * @brief Creates an opaque symbol "G[i]" that stands for the gain of the edge
+ * at index i. Can be passed as the callback to @see csfg_graph_mason_with()
+ * to build the transfer function in terms of edge symbols, which is much
+ * smaller than the fully expanded expression.
+ * @note "user" is unused.
+ */
+int csfg_graph_edge_symbol(
+    struct csfg_expr_pool** pool, int edge_idx, void* user);
+
+/*!
+ * @brief Returns the symbol ID of "G[i]" for the edge at index i.
+ * @return Returns -1 if memory could not be allocated.
+ */
+int csfg_graph_edge_symbol_id(int edge_idx);
+
+/*!
+ * @brief Returns the index of the edge a symbol created by
+ * @see csfg_graph_edge_symbol() stands for, or -1 if the symbol is not an edge
+ * symbol.
+ */
+int csfg_graph_edge_symbol_index(int symbol);
+
+/*!
+ * @brief Maps the symbol of an edge to a copy of the edge's expression in the
+ * variable table. Inserting the table into an expression built with
+ * @see csfg_graph_edge_symbol() gives the fully expanded expression.
+ * @return Returns -1 if the edge has no valid expression, 0 on success.
+ */
+int csfg_graph_edge_symbol_set(
+    const struct csfg_graph* graph, struct csfg_var_table* vt, int edge_idx);
+
+/*!
+ * @brief Clears the variable table and calls
+ * @see csfg_graph_edge_symbol_set() for every edge.
+ * @return Returns -1 if any edge could not be mapped, 0 on success. The
+ * remaining edges are mapped either way, only the failing edges are missing
+ * from the table.
+ */
+int csfg_graph_edge_symbol_table(
+    const struct csfg_graph* graph, struct csfg_var_table* vt);
+
+/*!
+ * @brief Same as @see csfg_graph_mason(), but the gain of each edge is
+ * obtained through a callback instead of copying the edge's expression. This
+ * allows building the transfer function over placeholders, which can be
+ * substituted later without having to enumerate loop combinations again.
+ */
+int csfg_graph_mason_with(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    const struct csfg_path_vec* paths,
+    const struct csfg_path_vec* loops,
+    csfg_graph_edge_gain_func edge_gain,
+    void* user);
+
+/*!
+ * @brief Computes the graph's transfer function as an expression by solving
+ * the node equations with fraction-free Gaussian elimination. The result is
+ * equivalent to @see csfg_graph_mason(), but does not require forward paths
+ * or loops to be enumerated.
+ * @return Expression root into "pool", or -1 if an error occurred.
+ */
+int csfg_graph_bareiss(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    int node_in,
+    int node_out);
+int csfg_graph_bareiss_with(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    int node_in,
+    int node_out,
+    csfg_graph_edge_gain_func edge_gain,
+    void* user);
+
+/*!
+ * @brief Computes the graph's transfer function using either
+ * @see csfg_graph_mason() or @see csfg_graph_bareiss(), depending on how
+ * many loops the graph has.
+ * @return Expression root into "pool", or -1 if an error occurred.
+ */
+int csfg_graph_transfer_function(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    const struct csfg_path_vec* paths,
+    const struct csfg_path_vec* loops,
+    int node_in,
+    int node_out);
+int csfg_graph_transfer_function_with(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    const struct csfg_path_vec* paths,
+    const struct csfg_path_vec* loops,
+    int node_in,
+    int node_out,
+    csfg_graph_edge_gain_func edge_gain,
+    void* user);
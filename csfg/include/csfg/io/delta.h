@@ -0,0 +1,42 @@
+#pragma once
+
+#include "csfg/config.h"
+
+struct serializer;
+
+/*
+ * Binary diff between two buffers. A delta describes the new buffer as a
+ * sequence of byte ranges copied from the old buffer and literal bytes that
+ * don't appear in the old buffer. Its size is roughly proportional to the
+ * number of bytes that changed, even if data was inserted or removed.
+ *
+ * Each operation starts with a lu32 "(len << 1) | is_copy". Copies are
+ * followed by a lu32 offset into the old buffer, literals by "len" bytes.
+ */
+
+/* Matches shorter than this are stored as literals */
+#define DELTA_BLOCK_SIZE 16
+
+/*!
+ * @brief Appends a delta that turns "src" into "dst" to "delta".
+ * @return Returns 0 on success, -1 if memory could not be allocated.
+ */
+int delta_encode(
+    struct serializer** delta,
+    const void* src,
+    int src_len,
+    const void* dst,
+    int dst_len);
+
+/*!
+ * @brief Applies a delta created by @see delta_encode() to "src" and appends
+ * the result to "dst".
+ * @return Returns 0 on success, -1 if the delta is invalid or memory could not
+ * be allocated.
+ */
+int delta_apply(
+    struct serializer** dst,
+    const void* src,
+    int src_len,
+    const void* delta,
+    int delta_len);
@@ -31,7 +31,18 @@ int16_t deserialize_li16(struct deserializer* des);
 uint32_t deserialize_lu32(struct deserializer* des);
 int32_t deserialize_li32(struct deserializer* des);
 float deserialize_lf32(struct deserializer* des);
+double deserialize_lf64(struct deserializer* des);
 const char* deserialize_cstr(struct deserializer* des);
 
+/*!
+ * @brief Reads an array of little endian values into "dst". On little endian
+ * machines this is a single memcpy. If there is not enough data left, "dst" is
+ * left untouched and the error flag is set.
+ */
+void deserialize_lu16_array(struct deserializer* des, uint16_t* dst, int count);
+void deserialize_lu32_array(struct deserializer* des, uint32_t* dst, int count);
+void deserialize_li32_array(struct deserializer* des, int32_t* dst, int count);
+void deserialize_lf64_array(struct deserializer* des, double* dst, int count);
+
 int deserializer_err(const struct deserializer* des);
 int deserializer_bytes_left(const struct deserializer* des);
@@ -24,6 +24,25 @@ int csfg_io_graph_load(
     int* node_in,
     int* node_out);
 
+/*!
+ * @brief Same as @see csfg_io_graph_save(), but writes the graph to a file.
+ */
+int csfg_io_graph_save_file(
+    const char* filepath,
+    const struct csfg_graph* graph,
+    int node_in,
+    int node_out);
+/*!
+ * @brief Memory-maps the file and loads the graph directly from the mapping.
+ * Node names and expressions are decoded straight out of the mapped memory
+ * without copying the file into a buffer first.
+ */
+int csfg_io_graph_load_file(
+    const char* filepath,
+    struct csfg_graph* graph,
+    int* node_in,
+    int* node_out);
+
 int csfg_io_var_table_save(
     struct serializer** ser, const struct csfg_var_table* vt);
 int csfg_io_var_table_load(struct deserializer* des, struct csfg_var_table* vt);
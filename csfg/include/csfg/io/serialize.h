@@ -7,6 +7,20 @@ struct strlist;
 
 VEC_DECLARE(serializer, uint8_t, 32)
 
+/*!
+ * @brief Appends "len" uninitialized bytes to the end of the buffer. The
+ * buffer grows geometrically, so many small writes don't reallocate every time.
+ * @warning The returned pointer is invalidated by the next write.
+ * @return Returns a pointer to the new bytes, or NULL if memory could not be
+ * allocated.
+ */
+uint8_t* serialize_emplace(struct serializer** ser, int len);
+/*!
+ * @brief Makes sure at least "len" more bytes can be written without
+ * reallocating. Use this before writing many small values whose total size is
+ * known in advance.
+ */
+int serialize_reserve(struct serializer** ser, int len);
 int serialize_data(struct serializer** ser, const void* data, int len);
 int serialize_char(struct serializer** ser, char value);
 int serialize_u8(struct serializer** ser, uint8_t value);
@@ -15,4 +29,18 @@ int serialize_li16(struct serializer** ser, int16_t value);
 int serialize_lu32(struct serializer** ser, uint32_t value);
 int serialize_li32(struct serializer** ser, int32_t value);
 int serialize_lf32(struct serializer** ser, float value);
+int serialize_lf64(struct serializer** ser, double value);
 int serialize_cstr(struct serializer** ser, const char* cstr);
+
+/*!
+ * @brief Writes an array of values in little endian byte order. On little
+ * endian machines this is a single memcpy.
+ */
+int serialize_lu16_array(
+    struct serializer** ser, const uint16_t* values, int count);
+int serialize_lu32_array(
+    struct serializer** ser, const uint32_t* values, int count);
+int serialize_li32_array(
+    struct serializer** ser, const int32_t* values, int count);
+int serialize_lf64_array(
+    struct serializer** ser, const double* values, int count);
@@ -28,7 +28,7 @@ static struct csfg_complex csfg_complex_nan(void)
 
 static double csfg_complex_mag(const struct csfg_complex c)
 {
-    return sqrt(c.real * c.real + c.imag * c.imag);
+    return hypot(c.real, c.imag);
 }
 
 static double csfg_complex_phase(const struct csfg_complex c)
@@ -72,12 +72,34 @@ csfg_complex_div(struct csfg_complex a, struct csfg_complex b)
 {
     /* a+b*i   (a+b*i)(c-d*i)   a*c + b*d   b*c - a*d
      * ----- = -------------- = --------- + ---------i
-     * c+d*i     c^2 - d^2      c^2 - d^2   c^2 - d^2
+     * c+d*i     c^2 + d^2      c^2 + d^2   c^2 + d^2
+     *
+     * The squares and products over- or underflow for magnitudes beyond
+     * 1e+-154, which high order polynomials easily reach. Those are divided
+     * through by the larger of c and d instead (Smith's method).
      */
-    double den = b.real * b.real + b.imag * b.imag;
+    double r, den;
+    double scale = fabs(b.real) > fabs(b.imag) ? fabs(b.real) : fabs(b.imag);
+    if (scale > 1e-150 && scale < 1e150 && fabs(a.real) < 1e150
+        && fabs(a.imag) < 1e150)
+    {
+        den = b.real * b.real + b.imag * b.imag;
+        return csfg_complex(
+            (a.real * b.real + a.imag * b.imag) / den,
+            (a.imag * b.real - a.real * b.imag) / den);
+    }
+
+    if (fabs(b.real) >= fabs(b.imag))
+    {
+        r   = b.imag / b.real;
+        den = b.real + b.imag * r;
+        return csfg_complex(
+            (a.real + a.imag * r) / den, (a.imag - a.real * r) / den);
+    }
+    r   = b.real / b.imag;
+    den = b.real * r + b.imag;
     return csfg_complex(
-        (a.real * b.real + a.imag * b.imag) / den,
-        (a.imag * b.real - a.real * b.imag) / den);
+        (a.real * r + a.imag) / den, (a.imag * r - a.real) / den);
 }
 
 static struct csfg_complex
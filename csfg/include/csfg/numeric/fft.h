@@ -0,0 +1,28 @@
+#pragma once
+
+#include "csfg/numeric/complex.h"
+
+/*!
+ * @brief Computes the discrete fourier transform in-place using the iterative
+ * radix-2 Cooley-Tukey algorithm:
+ *
+ *   X_j = sum_k x_k * exp(-2*pi*i*j*k/n)
+ *
+ * @param[in] n Number of elements. Must be a power of two.
+ * @return Returns -1 if "n" is not a power of two, 0 on success.
+ */
+int csfg_fft(struct csfg_complex* data, int n);
+
+/*!
+ * @brief Computes the inverse of @see csfg_fft() in-place, including the 1/n
+ * normalization:
+ *
+ *   x_k = 1/n * sum_j X_j * exp(2*pi*i*j*k/n)
+ *
+ * @param[in] n Number of elements. Must be a power of two.
+ * @return Returns -1 if "n" is not a power of two, 0 on success.
+ */
+int csfg_ifft(struct csfg_complex* data, int n);
+
+/*! Returns the smallest power of two that is greater or equal to "n" */
+int csfg_fft_size(int n);
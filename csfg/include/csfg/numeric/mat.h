@@ -9,7 +9,7 @@ struct csfg_mat
     struct csfg_complex data[1];
 };
 
-VEC_DECLARE(csfg_mat_reorder, int8_t, 8)
+VEC_DECLARE(csfg_mat_reorder, int16_t, 16)
 
 void csfg_mat_init(struct csfg_mat** mat);
 void csfg_mat_deinit(struct csfg_mat* mat);
@@ -21,6 +21,19 @@ void csfg_mat_set_real(struct csfg_mat* mat, ...);
 int  csfg_mat_mul(
      struct csfg_mat** out, const struct csfg_mat* a, const struct csfg_mat* b);
 
+/*!
+ * @brief Computes the matrix exponential e^M of a square matrix by scaling
+ * and squaring:
+ *
+ *   e^M = (e^(M/2^s))^(2^s)
+ *
+ * where s is chosen so the norm of M/2^s is small enough for a truncated
+ * Taylor series to be accurate to double precision.
+ * @return Returns -1 if memory could not be allocated or the matrix contains
+ * non-finite values, 0 on success.
+ */
+int csfg_mat_expm(struct csfg_mat** out, const struct csfg_mat* in);
+
 /* Row operations ----------------------------------------------------------- */
 /* r2 - s*r1 -> r2 */
 int csfg_mat_reorder_identity(
@@ -38,6 +51,16 @@ void csfg_mat_rotate_rows_in_range(
 void csfg_mat_swap_rows(
     struct csfg_mat* mat, struct csfg_mat_reorder* reorder, int r1, int r2);
 
+/*!
+ * @brief Decomposes a square matrix into a lower triangular matrix L with a
+ * unit diagonal and an upper triangular matrix U, such that L*U equals the
+ * input with its rows reordered. In each column, the remaining row with the
+ * largest magnitude is used as the pivot.
+ * @param[out] reorder Row "r" of L*U is row reorder[r] of the input. Use
+ * csfg_mat_apply_reorder() on L*U to get the input back.
+ * @return Returns -1 if the matrix is singular or memory could not be
+ * allocated, 0 on success.
+ */
 int csfg_mat_lu_decomposition(
     struct csfg_mat**         L,
     struct csfg_mat**         U,
@@ -13,7 +13,10 @@ struct csfg_poly_expr;
  *
  *   p(s) = c0 + c1*s + c2*s^2 + ... + cn*s^n
  */
-VEC_DECLARE(csfg_cpoly, struct csfg_complex, 8)
+VEC_DECLARE(csfg_cpoly, struct csfg_complex, 16)
+
+/*! Largest power of two that fits into a cpoly */
+#define CSFG_CPOLY_MAX_COEFFS 16384
 
 /*!
  * "rpoly" is short for "root-polynomial". A list of roots are stored in no
@@ -22,7 +25,7 @@ VEC_DECLARE(csfg_cpoly, struct csfg_complex, 8)
  *
  *  p(s) = (s-1)*(s+2)  we store  [1, -2]
  */
-VEC_DECLARE(csfg_rpoly, struct csfg_complex, 8)
+VEC_DECLARE(csfg_rpoly, struct csfg_complex, 16)
 
 /*!
  * @brief Stores one term of a Partial Fraction Decomposition (PFD)
@@ -35,10 +38,10 @@ struct csfg_pfd
 {
     struct csfg_complex A;
     struct csfg_complex p;
-    int8_t              n;
+    int16_t             n;
 };
 
-VEC_DECLARE(csfg_pfd_poly, struct csfg_pfd, 8)
+VEC_DECLARE(csfg_pfd_poly, struct csfg_pfd, 16)
 
 /*! Rescales the coefficiets so that the highest degree coefficient equals 1.0.
  * This is known as a monic polynomial. The scale factor is returned. */
@@ -58,7 +61,9 @@ int csfg_cpoly_find_roots(
  *   T(s) = ------------------------ = ---- + ---- + ... + ----
  *           (s-p1)(s-p2)...(s-pn)     s-p1   s-p2         s-pn
  *
- * Repeated roots are supported.
+ * Repeated roots are supported. Each coefficient is computed directly as a
+ * residue, by evaluating the Taylor series of the remaining function at its
+ * pole, which costs O(n^2) in total.
  *
  * @return Returns -1 if an error occurs, 0 if successful.
  */
@@ -67,6 +72,24 @@ int csfg_rpoly_partial_fraction_decomposition(
     const struct csfg_cpoly* numerator,
     const struct csfg_rpoly* denominator);
 
+/*!
+ * @brief Computes the Partial Fraction Decomposition of T(s)/s from the one of
+ * T(s), without decomposing again. Applying this to the decomposition of a
+ * transfer function yields its step response, applying it twice the ramp
+ * response.
+ *
+ *     A         A*(-1)^n     n      A*(-1)^(n-k)
+ *   ------ --> ---------- + sum  --------------------
+ *   (s-p)^n     s*p^n       k=1  p^(n-k+1) * (s-p)^k
+ *
+ * Terms with the same pole and power are merged.
+ *
+ * @param[out] out Cleared, then filled with the new terms. Must not be "in".
+ * @return Returns -1 if memory could not be allocated, 0 if successful.
+ */
+int csfg_pfd_poly_div_s(
+    struct csfg_pfd_poly** out, const struct csfg_pfd_poly* in);
+
 double csfg_pfd_poly_eval_inverse_laplace(
     const struct csfg_pfd_poly* pfd,
     double t);
@@ -79,6 +102,29 @@ int csfg_cpoly_from_symbolic(
     const struct csfg_var_table* vt,
     const struct csfg_poly_expr* symbolic);
 
+/*!
+ * @brief Recovers the coefficients of a real polynomial from its values at
+ * equally spaced points on a circle in the complex plane:
+ *
+ *   s_k = radius * exp(i*(2*pi*k/n + phase)),  k = 0, 1, ..., n-1
+ *
+ * This is the inverse of evaluating the polynomial at n points and is
+ * computed with an FFT in O(n*log(n)). Trailing coefficients that are
+ * negligible compared to the rest of the polynomial are dropped.
+ *
+ * @param[inout] samples The values p(s_k). The array is used as scratch space
+ * and is overwritten.
+ * @param[in] n Number of samples. Must be a power of two, greater than the
+ * degree of the polynomial and at most CSFG_CPOLY_MAX_COEFFS.
+ * @return Returns -1 if an error occurs, 0 if successful.
+ */
+int csfg_cpoly_interpolate_circle(
+    struct csfg_cpoly**  poly,
+    struct csfg_complex* samples,
+    int                  n,
+    double               radius,
+    double               phase);
+
 /*! Evaluates a coefficient-polynomial at the value "s" */
 struct csfg_complex
 csfg_cpoly_eval(const struct csfg_cpoly* poly, struct csfg_complex s);
@@ -0,0 +1,70 @@
+#pragma once
+
+/* Upper bound on the number of levels, which limits the base resolution to
+ * 2^(CSFG_PYRAMID_MAX_LEVELS-1) buckets */
+#define CSFG_PYRAMID_MAX_LEVELS 24
+
+/*! Range of values of a bucket. Empty buckets have min > max. */
+struct csfg_minmax
+{
+    double min;
+    double max;
+};
+
+/*!
+ * Multi-resolution summary of a curve y(x) over a fixed x interval. The
+ * finest level divides the interval into equally sized buckets and stores
+ * the range of y within each. Every following level merges pairs of buckets
+ * of the previous level, so any x range can be summarized at screen
+ * resolution by touching roughly one bucket per pixel, independently of how
+ * many samples the curve was built from.
+ */
+struct csfg_pyramid
+{
+    struct csfg_minmax* data; /* All levels, finest first */
+    int                 offset[CSFG_PYRAMID_MAX_LEVELS];
+    int                 count[CSFG_PYRAMID_MAX_LEVELS];
+    int                 levels;
+    double              x_start;
+    double              x_end;
+};
+
+void csfg_pyramid_init(struct csfg_pyramid* pyr);
+void csfg_pyramid_deinit(struct csfg_pyramid* pyr);
+
+/*!
+ * @brief Builds the pyramid from a polyline.
+ *
+ * The segments between consecutive points are clipped to each bucket of the
+ * finest level, so narrow peaks between two bucket boundaries are kept and
+ * buckets without any points still cover the line passing through them.
+ * Segments with non-finite endpoints are skipped.
+ *
+ * @param[in] x Strictly increasing x coordinates.
+ * @param[in] y Values at each x coordinate.
+ * @param[in] n Number of points. Must be at least 2.
+ * @param[in] buckets Number of buckets of the finest level. Rounded up to the
+ * next power of two.
+ * @return Returns 0 on success, -1 on failure.
+ */
+int csfg_pyramid_build(
+    struct csfg_pyramid* pyr,
+    const double*        x,
+    const double*        y,
+    int                  n,
+    int                  buckets);
+
+/*!
+ * @brief Summarizes the range [x_start, x_end) in "n" equally sized buckets.
+ *
+ * The coarsest level whose buckets are no larger than the requested buckets
+ * is used, so the cost is proportional to "n" and not to the number of
+ * points the pyramid was built from. Parts of the range outside of the
+ * pyramid produce empty buckets.
+ */
+void csfg_pyramid_query(
+    const struct csfg_pyramid* pyr,
+    double                     x_start,
+    double                     x_end,
+    struct csfg_minmax*        out,
+    int                        n);
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "csfg/util/vec.h"
+
+struct csfg_tf;
+
+enum csfg_discretization
+{
+    /*! Tustin's method, s = 2/T * (z-1)/(z+1). Maps the left half plane onto
+     * the unit disc, so stable systems stay stable for any step size, and
+     * preserves the shape of the frequency response up to a warping of the
+     * frequency axis. */
+    CSFG_BILINEAR,
+    /*! Zero-order hold, i.e. the input is assumed to be constant between
+     * samples. The whole system is discretized exactly, so the step response
+     * is exact at the sample instants for any order and step size. Poles map
+     * to z = e^(p*T). The zeros don't map individually and are found
+     * numerically, which loses accuracy for systems with many more poles
+     * than zeros. */
+    CSFG_ZOH
+};
+
+/*!
+ * Discrete second-order section in transposed direct form II:
+ *
+ *           b0 + b1*z^-1 + b2*z^-2
+ *   H(z) = ------------------------
+ *            1 + a1*z^-1 + a2*z^-2
+ *
+ * First-order sections have b2 = a2 = 0.
+ */
+struct csfg_biquad
+{
+    double b0, b1, b2;
+    double a1, a2;
+    double z1, z2; /* State */
+};
+
+VEC_DECLARE(csfg_biquad_vec, struct csfg_biquad, 16)
+
+/*!
+ * A transfer function discretized into a cascade of real second-order
+ * sections. Conjugate pole pairs share a section, so repeated and clustered
+ * poles don't need to be decomposed into partial fractions, and high-order
+ * systems don't suffer from the cancellation of expanded polynomials.
+ */
+struct csfg_sim
+{
+    struct csfg_biquad_vec* sections;
+    double                  gain;
+    double                  dt;
+};
+
+static void csfg_sim_init(struct csfg_sim* sim)
+{
+    csfg_biquad_vec_init(&sim->sections);
+    sim->gain = 1.0;
+    sim->dt   = 0.0;
+}
+
+static void csfg_sim_deinit(struct csfg_sim* sim)
+{
+    csfg_biquad_vec_deinit(sim->sections);
+}
+
+/*!
+ * @brief Discretizes the transfer function into second-order sections (see
+ * csfg_tf_factor_sections()). The sections stored in the transfer function
+ * are used if available, otherwise they are computed from its poles and
+ * zeros. The bilinear transform is applied to each section. The zero-order
+ * hold discretizes their cascade as a whole and factors the result into
+ * sections again.
+ * @param[in] dt Step size in seconds.
+ * @return Returns -1 if the transfer function has more zeros than poles, has
+ * complex coefficients, or the step size is not positive, 0 on success. The
+ * state of the simulation is reset.
+ */
+int csfg_sim_from_tf(
+    struct csfg_sim*         sim,
+    const struct csfg_tf*    tf,
+    double                   dt,
+    enum csfg_discretization method);
+
+/*! Sets the state of every section to zero. */
+void csfg_sim_reset(struct csfg_sim* sim);
+
+/*!
+ * @brief Feeds "n" input samples through the system and writes the output
+ * samples. The state carries over between calls, so long signals can be
+ * simulated in chunks.
+ * @note "in" and "out" may point to the same buffer.
+ */
+void csfg_sim_run(struct csfg_sim* sim, const double* in, double* out, int n);
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "csfg/numeric/mat.h"
+
+struct csfg_tf;
+
+/*!
+ * Single-input single-output state-space representation:
+ *
+ *   x' = A*x + B*u
+ *   y  = C*x + D*u
+ *
+ * A is n x n, B is n x 1, C is 1 x n and D is 1 x 1, where n is the order of
+ * the denominator.
+ */
+struct csfg_ss
+{
+    struct csfg_mat* A;
+    struct csfg_mat* B;
+    struct csfg_mat* C;
+    struct csfg_mat* D;
+};
+
+static void csfg_ss_init(struct csfg_ss* ss)
+{
+    csfg_mat_init(&ss->A);
+    csfg_mat_init(&ss->B);
+    csfg_mat_init(&ss->C);
+    csfg_mat_init(&ss->D);
+}
+
+static void csfg_ss_deinit(struct csfg_ss* ss)
+{
+    csfg_mat_deinit(ss->D);
+    csfg_mat_deinit(ss->C);
+    csfg_mat_deinit(ss->B);
+    csfg_mat_deinit(ss->A);
+}
+
+/*!
+ * @brief Realizes a transfer function in controllable canonical form.
+ *
+ *          b0 + b1*s + ... + bn*s^n
+ *   T(s) = ------------------------
+ *          a0 + a1*s + ... +    s^n
+ *
+ *       [  0    1   ...    0    ]       [0]
+ *       [  :         .     :    ]       [:]
+ *   A = [  0    0   ...    1    ]   B = [0]
+ *       [-a0  -a1   ...  -a(n-1)]       [1]
+ *
+ *   C = [b0-bn*a0  b1-bn*a1  ...  b(n-1)-bn*a(n-1)]   D = bn
+ *
+ * @return Returns -1 if the transfer function is improper or memory could not
+ * be allocated, 0 on success.
+ */
+int csfg_ss_from_tf_controllable(struct csfg_ss* ss, const struct csfg_tf* tf);
+
+/*!
+ * @brief Realizes a transfer function in observable canonical form, which is
+ * the dual of the controllable form: A and the roles of B and C are
+ * transposed.
+ * @return Returns -1 if the transfer function is improper or memory could not
+ * be allocated, 0 on success.
+ */
+int csfg_ss_from_tf_observable(struct csfg_ss* ss, const struct csfg_tf* tf);
+
+/*!
+ * @brief Computes the impulse response at t = k*dt, k = 0, 1, ..., n-1.
+ *
+ *   y(t) = C*e^(A*t)*B
+ *
+ * The exponential is computed once for a single step and applied repeatedly,
+ * so the samples are exact up to rounding, regardless of how clustered or
+ * repeated the poles are. The Dirac impulse contributed by D at t = 0 is not
+ * included.
+ * @return Returns -1 if dt is not positive or memory could not be allocated,
+ * 0 on success.
+ */
+int csfg_ss_impulse_response(
+    const struct csfg_ss* ss, double dt, double* out, int n);
+
+/*!
+ * @brief Computes the step response at t = k*dt, k = 0, 1, ..., n-1.
+ *
+ *   y(t) = C*integral(e^(A*tau), 0, t)*B + D
+ *
+ * One step of the integral is obtained together with e^(A*dt) from the
+ * exponential of an augmented matrix, so A doesn't need to be invertible.
+ * @return Returns -1 if dt is not positive or memory could not be allocated,
+ * 0 on success.
+ */
+int csfg_ss_step_response(
+    const struct csfg_ss* ss, double dt, double* out, int n);
@@ -2,8 +2,28 @@
 
 #include "csfg/numeric/poly.h"
 
+struct csfg_graph;
 struct csfg_tf_expr;
 
+/*!
+ * Real second-order section of a transfer function:
+ *
+ *          b0 + b1*s + b2*s^2
+ *   H(s) = ------------------
+ *          a0 + a1*s + a2*s^2
+ *
+ * Numerator and denominator are real monic factors built from a conjugate
+ * pair or two real roots (s^2 + c1*s + c0), a single real root (s + c0), or
+ * no root at all (1).
+ */
+struct csfg_sos
+{
+    double b[3];
+    double a[3];
+};
+
+VEC_DECLARE(csfg_sos_vec, struct csfg_sos, 16)
+
 struct csfg_tf
 {
     /* The polynomials listed below are monic polynomials, meaning, the
@@ -17,6 +37,10 @@ struct csfg_tf
 
     struct csfg_rpoly* zeros;
     struct csfg_rpoly* poles;
+
+    /* The roots factored into real second-order sections. Empty if the roots
+     * are not known or the polynomials have complex coefficients. */
+    struct csfg_sos_vec* sections;
 };
 
 static void csfg_tf_init(struct csfg_tf* tf)
@@ -26,10 +50,12 @@ static void csfg_tf_init(struct csfg_tf* tf)
     csfg_cpoly_init(&tf->den);
     csfg_rpoly_init(&tf->zeros);
     csfg_rpoly_init(&tf->poles);
+    csfg_sos_vec_init(&tf->sections);
 }
 
 static void csfg_tf_deinit(struct csfg_tf* tf)
 {
+    csfg_sos_vec_deinit(tf->sections);
     csfg_rpoly_deinit(tf->poles);
     csfg_rpoly_deinit(tf->zeros);
     csfg_cpoly_deinit(tf->den);
@@ -42,11 +68,107 @@ int csfg_tf_from_symbolic(
     const struct csfg_tf_expr*   tf_expr,
     const struct csfg_var_table* vt);
 
+/*!
+ * @brief Computes the transfer function of a graph numerically, without
+ * building a symbolic expression first. Each edge is converted into a rational
+ * function of "s" with numeric coefficients, the node equations are solved at
+ * sample points on a circle in the complex plane, and the coefficients of the
+ * numerator and denominator are interpolated from the samples.
+ * @param[in] substitutions Optional. Inserted into each edge expression before
+ * it is evaluated. Limits are not supported.
+ * @param[in] parameters Values for all remaining variables.
+ * @return Returns -1 if an error occurred, if there is no path from the
+ * input to the output node, or if the coefficients span too many orders of
+ * magnitude to be interpolated accurately. Use csfg_tf_from_symbolic() in the
+ * last case. The reason is logged and "tf" is left empty, with no
+ * coefficients, roots or sections. Returns 0 on success.
+ */
+int csfg_tf_from_graph(
+    struct csfg_tf*              tf,
+    const struct csfg_graph*     graph,
+    int                          node_in,
+    int                          node_out,
+    const struct csfg_var_table* substitutions,
+    const struct csfg_var_table* parameters);
+
 int csfg_tf_interesting_frequency_interval(
     const struct csfg_tf* tf, double* f_start_hz, double* f_end_hz);
 
 int csfg_tf_interesting_time_interval(
     const struct csfg_tf* tf, double* t_start_s, double* t_end_s);
 
+/*!
+ * @brief Evaluates the transfer function at "s". If the sections are
+ * available, the product of the sections is used, which is more accurate
+ * than expanded polynomials of high order. Otherwise the numerator and
+ * denominator are evaluated directly.
+ */
 struct csfg_complex
 csfg_tf_eval(const struct csfg_tf* tf, struct csfg_complex s);
+
+/*!
+ * @brief Factors the transfer function into real second-order sections
+ * using its poles and zeros.
+ *
+ * Conjugate roots are paired into one section, as are real roots of similar
+ * magnitude, leaving at most one first-order factor. Each zero factor is
+ * placed over the pole factor closest to it in frequency so every section
+ * has a gain close to 1 over most of the spectrum. Sections are ordered by
+ * ascending frequency. The constant gain of the transfer function is not
+ * included.
+ *
+ * @param[out] sections Cleared, then filled with the sections. Usually
+ * &tf->sections.
+ * The sections are checked against the numerator and denominator at a few
+ * points near the poles. If the roots are too inaccurate to reproduce the
+ * polynomials, no sections are returned and csfg_tf_eval() falls back to
+ * evaluating the polynomials.
+ *
+ * @return Returns -1 if memory could not be allocated. Returns 1 if the
+ * numerator or denominator has complex coefficients, or if the sections
+ * don't match the polynomials, in which case "sections" is left empty.
+ * Returns 0 on success.
+ */
+int csfg_tf_factor_sections(
+    struct csfg_sos_vec** sections, const struct csfg_tf* tf);
+
+/*!
+ * One point of a Bode plot. The frequency is stored as log10(f) so the points
+ * can be drawn on a logarithmic axis directly.
+ */
+struct csfg_bode_point
+{
+    double log_f;
+    double mag_db;
+    double phase; /* Radians, unwrapped so the curve has no jumps */
+};
+
+VEC_DECLARE(csfg_bode_vec, struct csfg_bode_point, 32)
+
+/*!
+ * @brief Samples the frequency response T(i*f) between two frequencies.
+ *
+ * Samples are not spaced evenly. A coarse logarithmic grid is combined with
+ * clusters of samples around |Im(p)| of every lightly damped pole and zero,
+ * where the response changes quickly. Each interval is then halved for as
+ * long as its midpoint deviates from a straight line between its ends by more
+ * than the tolerances, so flat regions end up with few points and sharp
+ * resonances with many.
+ *
+ * The result is a polyline that can be drawn at any zoom level without
+ * evaluating the transfer function again.
+ *
+ * @param[out] points Cleared, then filled with points in ascending frequency.
+ * The first and last points are at f_start and f_end.
+ * @param[in] tolerance_db Allowed deviation of the magnitude.
+ * @param[in] tolerance_rad Allowed deviation of the phase.
+ * @return Returns -1 if memory could not be allocated or if the interval is
+ * invalid.
+ */
+int csfg_tf_bode(
+    struct csfg_bode_vec** points,
+    const struct csfg_tf*  tf,
+    double                 f_start,
+    double                 f_end,
+    double                 tolerance_db,
+    double                 tolerance_rad);
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "csfg/util/hash.h"
 #include "csfg/util/strlist.h"
 
+struct arena;
 struct csfg_var_table;
 struct str;
 
@@ -19,29 +21,46 @@ enum csfg_expr_type
 
 struct csfg_expr_node
 {
-    union
-    {
-        float lit;
-        int var_idx;
-    } value;
     int child[2];
     unsigned type    : 4;
     unsigned visited : 1;
+    /* CSFG_EXPR_LIT: Index into csfg_expr_pool::lits
+     * CSFG_EXPR_VAR: Symbol ID, see csfg/symbolic/symbol.h */
+    unsigned value : 27;
 };
 
 struct csfg_expr_pool
 {
-    struct strlist* var_names;
+    /* Values of literal nodes. Entries are never modified after they are
+     * added, so several nodes can refer to the same entry. csfg_expr_gc()
+     * removes unused entries once enough of them accumulate */
+    double* lits;
+    struct arena* arena; /* NULL if the nodes are allocated with mem_alloc() */
+    int lit_count;
+    int lit_capacity;
     int count;
     int capacity;
     struct csfg_expr_node nodes[1];
 };
 
 void csfg_expr_pool_init(struct csfg_expr_pool** pool);
+/*!
+ * @brief Creates an empty pool whose nodes and literals are allocated from an
+ * arena. The pool doesn't own any other memory, so it can be released either
+ * with csfg_expr_pool_deinit() or by resetting the arena.
+ */
+int csfg_expr_pool_init_arena(
+    struct csfg_expr_pool** pool, struct arena* arena);
 void csfg_expr_pool_deinit(struct csfg_expr_pool* pool);
 void csfg_expr_pool_clear(struct csfg_expr_pool* pool);
 #define csfg_expr_pool_count(pool) (pool ? pool->count : 0)
 
+/*! Returns the value of a CSFG_EXPR_LIT node */
+static double csfg_expr_lit_value(const struct csfg_expr_pool* pool, int n)
+{
+    return pool->lits[pool->nodes[n].value];
+}
+
 /*!
  * @brief Parses a string into a syntax tree. The resulting expression can be
  * evaluated using @see csfg_expr_eval();
@@ -67,6 +86,19 @@ int csfg_expr_parse(struct csfg_expr_pool** pool, struct strview text);
 double csfg_expr_eval(
     struct csfg_expr_pool* pool, int root, const struct csfg_var_table* vt);
 
+/*!
+ * @brief Same as @see csfg_expr_eval(), but the value of each variable is
+ * read directly from an array indexed by symbol ID instead of looking it up
+ * by name. Use @see csfg_var_table_eval_symbols() to fill the array.
+ * @param[in] count Number of entries in "values". Variables with larger IDs
+ * evaluate to NaN.
+ */
+double csfg_expr_eval_symbols(
+    const struct csfg_expr_pool* pool,
+    int root,
+    const double* values,
+    int count);
+
 int csfg_expr_to_str(
     struct str** str, const struct csfg_expr_pool* pool, int expr);
 
@@ -85,6 +117,11 @@ int csfg_expr_equal(
 /*! Counts (recursively) the number of nodes in an expression */
 int csfg_expr_count(const struct csfg_expr_pool* pool, int expr);
 
+/*! Computes a hash of the structure and values of a subtree. Subtrees that
+ * compare equal with @see csfg_expr_equal() have the same hash, even if they
+ * are stored in different pools. An expression of -1 is also valid. */
+hash32 csfg_expr_hash(const struct csfg_expr_pool* pool, int expr);
+
 int csfg_expr_lexicographical_compare(
     const struct csfg_expr_pool* pool, int a, int b);
 
@@ -124,8 +161,17 @@ int csfg_expr_simplify(struct csfg_expr_pool** pool, int expr);
 /* Leaf nodes */
 int csfg_expr_lit(struct csfg_expr_pool** pool, double value);
 int csfg_expr_var(struct csfg_expr_pool** pool, struct strview name);
+/* Same as csfg_expr_var(), but takes an already interned symbol ID */
+int csfg_expr_symbol(struct csfg_expr_pool** pool, int id);
 int csfg_expr_inf(struct csfg_expr_pool** pool);
 
+/*!
+ * @brief Turns an existing node into a literal. This adds a new entry to the
+ * literal table, so unlike the other setters it can fail.
+ * @note Call this before marking the children of the node as deleted, so the
+ * tree is left intact if it fails.
+ * @return Returns the node, or -1 if memory could not be allocated.
+ */
 int csfg_expr_set_lit(struct csfg_expr_pool* pool, int n, double value);
 int csfg_expr_set_var(struct csfg_expr_pool* pool, int n, struct strview name);
 int csfg_expr_set_inf(struct csfg_expr_pool* pool, int n);
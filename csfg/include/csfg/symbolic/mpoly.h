@@ -0,0 +1,156 @@
+#pragma once
+
+#include "csfg/util/vec.h"
+
+struct csfg_expr_pool;
+struct csfg_var_table;
+struct csfg_poly_expr;
+
+/*!
+ * "mpoly" is short for "multivariate polynomial". It is a sparse, canonical
+ * representation of a sum of monomials in the circuit parameters:
+ *
+ *   p = 3*a*b^2 + 2*c^-1 + 5
+ *
+ * Each term is a double coefficient and a monomial. A monomial is a list of
+ * (variable, exponent) factors sorted by variable index. Exponents are allowed
+ * to be negative, so reciprocals such as 1/R can be represented.
+ *
+ * Variable indices are symbol IDs (see csfg/symbolic/symbol.h), so polynomials
+ * created from different expression pools can be combined.
+ *
+ * Terms are kept sorted in a graded monomial order and like terms are always
+ * combined, so two equal polynomials have identical representations. Because
+ * the monomial order is compatible with multiplication, sums and products are
+ * computed by merging sorted term lists, which keeps results compact without
+ * needing a separate simplification step.
+ */
+struct csfg_mpoly_factor
+{
+    int16_t var;
+    int16_t exp;
+};
+
+struct csfg_mpoly_term
+{
+    double coeff;
+    int32_t first; /* Index of first factor in csfg_mpoly::factors */
+    int32_t count; /* Number of factors in this monomial */
+};
+
+VEC_DECLARE(csfg_mpoly_factors, struct csfg_mpoly_factor, 32)
+VEC_DECLARE(csfg_mpoly_terms, struct csfg_mpoly_term, 32)
+
+struct csfg_mpoly
+{
+    struct csfg_mpoly_terms* terms;
+    struct csfg_mpoly_factors* factors;
+};
+
+static void csfg_mpoly_init(struct csfg_mpoly* mp)
+{
+    csfg_mpoly_terms_init(&mp->terms);
+    csfg_mpoly_factors_init(&mp->factors);
+}
+
+static void csfg_mpoly_deinit(struct csfg_mpoly* mp)
+{
+    csfg_mpoly_factors_deinit(mp->factors);
+    csfg_mpoly_terms_deinit(mp->terms);
+}
+
+static void csfg_mpoly_clear(struct csfg_mpoly* mp)
+{
+    csfg_mpoly_terms_clear(mp->terms);
+    csfg_mpoly_factors_clear(mp->factors);
+}
+
+#define csfg_mpoly_term_count(mp) vec_count((mp)->terms)
+#define csfg_mpoly_is_zero(mp)    (vec_count((mp)->terms) == 0)
+
+int csfg_mpoly_copy(struct csfg_mpoly* dst, const struct csfg_mpoly* src);
+void csfg_mpoly_swap(struct csfg_mpoly* a, struct csfg_mpoly* b);
+
+/*! Sets the polynomial to a constant. A value of 0.0 results in no terms. */
+int csfg_mpoly_set_lit(struct csfg_mpoly* mp, double value);
+
+/*! Sets the polynomial to a single variable raised to the power of 1. */
+int csfg_mpoly_set_var(struct csfg_mpoly* mp, int var_idx);
+
+/*! Multiplies every coefficient by "factor". */
+void csfg_mpoly_scale(struct csfg_mpoly* mp, double factor);
+
+/*!
+ * Calculates the sum of two polynomials. "out" must not alias "a" or "b".
+ */
+int csfg_mpoly_add(
+    struct csfg_mpoly* out,
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly* b);
+
+/*!
+ * Calculates the product of two polynomials. "out" must not alias "a" or "b".
+ * @return Returns -1 if an exponent of the product doesn't fit into 16 bits,
+ * 0 on success.
+ */
+int csfg_mpoly_mul(
+    struct csfg_mpoly* out,
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly* b);
+
+/*!
+ * Calculates a / b for the case where "b" is known to divide "a" without a
+ * remainder, as happens in fraction-free elimination. Both polynomials must
+ * only have non-negative exponents. "out" must not alias "a" or "b".
+ * @return Returns -1 if the division is not exact, 0 on success.
+ */
+int csfg_mpoly_div_exact(
+    struct csfg_mpoly* out,
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly* b);
+
+/*!
+ * Raises the polynomial to an integer power. Negative powers are only
+ * possible if the polynomial consists of a single term.
+ * @return Returns -1 if the result is not representable, including exponents
+ * that don't fit into 16 bits, 0 on success.
+ */
+int csfg_mpoly_pow(
+    struct csfg_mpoly* out, const struct csfg_mpoly* base, int exp);
+
+/*! Returns 1 if both polynomials have the exact same terms, 0 otherwise. */
+int csfg_mpoly_equal(const struct csfg_mpoly* a, const struct csfg_mpoly* b);
+
+/*!
+ * @brief Converts an expression into a multivariate polynomial.
+ * @return Returns -1 if the expression contains anything that can't be
+ * represented, such as a division by a sum, non-integer exponents or infinity.
+ * In this case "mp" is left in an undefined state. Returns 0 on success.
+ */
+int csfg_mpoly_from_expr(
+    struct csfg_mpoly* mp, const struct csfg_expr_pool* pool, int expr);
+
+/*!
+ * @brief Converts the polynomial back into an expression. Each variable
+ * becomes a variable node with the same symbol ID.
+ * @return Returns the root node of the new expression, or -1 on error.
+ */
+int csfg_mpoly_to_expr(
+    const struct csfg_mpoly* mp, struct csfg_expr_pool** pool);
+
+typedef int (*csfg_mpoly_var_to_expr_func)(
+    struct csfg_expr_pool** pool, int var, void* user);
+
+/*!
+ * @brief Same as @see csfg_mpoly_to_expr(), but each variable is converted
+ * using a callback instead of creating a variable node. This
+ * allows polynomials whose variables are placeholders for other expressions.
+ */
+int csfg_mpoly_to_expr_with(
+    const struct csfg_mpoly* mp,
+    struct csfg_expr_pool** pool,
+    csfg_mpoly_var_to_expr_func var_to_expr,
+    void* user);
+
+double csfg_mpoly_eval(
+    const struct csfg_mpoly* mp, const struct csfg_var_table* vt);
@@ -19,7 +19,7 @@ static struct csfg_coeff_expr csfg_coeff_expr(double factor, int expr)
     return c;
 }
 
-VEC_DECLARE(csfg_poly_expr, struct csfg_coeff_expr, 8)
+VEC_DECLARE(csfg_poly_expr, struct csfg_coeff_expr, 16)
 
 /*! Duplicates a polynomial. "dst" must be empty before calling. */
 int csfg_poly_expr_copy(
@@ -27,6 +27,13 @@ int csfg_poly_expr_copy(
 
 /*!
  * Calculates the sum of two polynomials. "out" must be empty before calling.
+ *
+ * The coefficients are added as sparse multivariate polynomials
+ * (\see csfg_mpoly), so like terms are combined and the resulting
+ * expressions are in canonical form. Single-term coefficients have their
+ * constant in "factor", sums have a factor of 1. If a coefficient is not a
+ * polynomial in the parameters, e.g. a division by a sum, the expressions
+ * are combined as they are instead.
  */
 int csfg_poly_expr_add(
     struct csfg_expr_pool** pool,
@@ -36,7 +43,8 @@ int csfg_poly_expr_add(
 
 /*!
  * Calculates the product of two polynomials. "out" must be empty before
- * calling.
+ * calling. The coefficients are combined the same way as in
+ * \see csfg_poly_expr_add().
  */
 int csfg_poly_expr_mul(
     struct csfg_expr_pool** pool,
@@ -65,6 +73,24 @@ int csfg_poly_expr_gcd(
     const struct csfg_poly_expr* p1,
     const struct csfg_poly_expr* p2);
 
+/*!
+ * \brief Rewrites a coefficient into canonical form by converting its
+ * expression into a sparse multivariate polynomial (\see csfg_mpoly) and back.
+ * Single-term coefficients have their constant moved into "factor". For
+ * multi-term coefficients the factor of the highest order term is pulled out.
+ * \return Returns -1 if the expression can't be represented as a
+ * multivariate polynomial. In this case the coefficient is not modified.
+ */
+int csfg_coeff_expr_canonicalize(
+    struct csfg_expr_pool** pool, struct csfg_coeff_expr* coeff);
+
+/*!
+ * \brief Calls \see csfg_coeff_expr_canonicalize() on every coefficient.
+ * \return Returns the number of coefficients that could not be canonicalized.
+ */
+int csfg_poly_expr_canonicalize(
+    struct csfg_expr_pool** pool, struct csfg_poly_expr* poly);
+
 int csfg_poly_expr_to_str(
     struct str** str,
     const struct csfg_expr_pool* pool,
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "csfg/config.h"
+#include "csfg/util/strview.h"
+
+/*
+ * Process-wide table of variable names. Variable nodes store the ID of their
+ * name instead of the name itself, so the same variable has the same ID in
+ * every expression pool. Copying a variable between pools or comparing two
+ * variables never has to touch the string.
+ *
+ * Names are never removed from the table. csfg_deinit() frees it.
+ */
+
+/*!
+ * @brief Returns the ID of a name, adding it to the table if it doesn't exist
+ * yet. IDs are assigned consecutively starting at 0.
+ * @return Returns -1 if memory could not be allocated.
+ */
+int csfg_symbol_intern(struct strview name);
+
+/*! @brief Returns the ID of a name, or -1 if it was never interned. */
+int csfg_symbol_find(struct strview name);
+
+/*!
+ * @brief Returns the name of a symbol.
+ * @note The view is invalidated by the next call to @see csfg_symbol_intern().
+ */
+struct strview csfg_symbol_view(int id);
+const char* csfg_symbol_cstr(int id);
+
+/*! @brief Number of symbols in the table. Valid IDs are 0..count-1 */
+int csfg_symbol_count(void);
+
+void csfg_symbols_deinit(void);
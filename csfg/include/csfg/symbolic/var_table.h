@@ -1,5 +1,6 @@
 #pragma once
 
+#include "csfg/util/hash.h"
 #include "csfg/util/hmap_str.h"
 #include "csfg/util/strview.h"
 
@@ -73,3 +74,20 @@ struct csfg_expr_pool* csfg_var_table_get(
  */
 double
 csfg_var_table_eval(const struct csfg_var_table* vt, struct strview name);
+
+/*!
+ * @brief Evaluates every variable in the table once and stores the results in
+ * an array indexed by symbol ID, for use with @see csfg_expr_eval_symbols().
+ * Symbols that are not in the table are set to NaN.
+ * @param[out] values Must be freed with mem_free().
+ * @return Returns the number of entries in the array, or -1 on error.
+ */
+int csfg_var_table_eval_symbols(
+    const struct csfg_var_table* vt, double** values);
+
+/*!
+ * @brief Computes a hash of all names and expressions in the table. Two tables
+ * with the same contents have the same hash, regardless of the order in which
+ * the entries were inserted.
+ */
+hash32 csfg_var_table_hash(const struct csfg_var_table* vt);
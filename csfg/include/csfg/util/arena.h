@@ -0,0 +1,91 @@
+#pragma once
+
+#include "csfg/config.h"
+
+/*
+ * Region allocator for short-lived data. Allocations are carved out of large
+ * blocks and rounded up to a power-of-two size class. Freed allocations are
+ * kept in a free list per size class and handed out again. arena_reset()
+ * releases every allocation at once, but keeps the blocks, so an arena that is
+ * reset and reused stops calling mem_alloc() entirely.
+ *
+ * Allocations larger than the largest size class are forwarded to mem_alloc()
+ * and are also released by arena_reset().
+ */
+
+#define ARENA_MIN_CLASS  4  /* 16 bytes */
+#define ARENA_MAX_CLASS  16 /* 64 KiB */
+#define ARENA_BLOCK_SIZE (256 * 1024)
+
+struct arena_block;
+struct arena_large;
+
+struct arena_stats
+{
+    int allocs;       /* Number of calls to arena_alloc()/arena_realloc() */
+    int reuses;       /* Allocations served from a free list */
+    int frees;        /* Number of calls to arena_free() */
+    int heap_allocs;  /* Number of calls to mem_alloc() made by the arena */
+    int bytes_in_use; /* Including size class padding */
+    int peak_bytes;
+};
+
+struct arena
+{
+    struct arena_block* blocks;  /* All blocks, in order of allocation */
+    struct arena_block* current; /* Block new allocations are taken from */
+    struct arena_large* large;
+    void* free_lists[ARENA_MAX_CLASS + 1];
+    struct arena_stats stats;
+};
+
+void arena_init(struct arena* a);
+void arena_deinit(struct arena* a);
+
+/*!
+ * @brief Releases all allocations. The blocks are kept for future
+ * allocations. The statistics are not reset, except for bytes_in_use.
+ */
+void arena_reset(struct arena* a);
+
+void* arena_alloc(struct arena* a, int size);
+/*!
+ * @brief Same semantics as realloc(). If the new size fits into the same size
+ * class, the pointer is returned unchanged.
+ */
+void* arena_realloc(struct arena* a, void* p, int new_size);
+void arena_free(struct arena* a, void* p);
+
+/*!
+ * @brief Returns true if the pointer was returned by arena_alloc() or
+ * arena_realloc() of this arena.
+ */
+int arena_owns(const struct arena* a, const void* p);
+
+/*
+ * Containers holding temporaries of the symbolic library are defined with
+ * VEC_DEFINE_SCRATCH() and allocate through arena_scratch_realloc(). While a
+ * scratch scope is open and a scratch arena is installed, new allocations are
+ * taken from the arena. Otherwise they come from the heap. Memory is always
+ * returned to where it came from, so containers from outside of a scope can be
+ * grown and freed inside of it.
+ *
+ * A function opening a scope must not hand memory allocated inside of it to
+ * its caller. It copies results out after closing the scope instead.
+ */
+#define VEC_DEFINE_SCRATCH(prefix, T, bits)                                    \
+    VEC_DEFINE_ALLOC(                                                          \
+        prefix, T, bits, 32, 2, arena_scratch_realloc, arena_scratch_free)
+
+/*!
+ * @brief Installs the arena scratch allocations are taken from. Pass NULL to
+ * allocate everything from the heap.
+ * @note The arena must not be reset while containers allocated from it are
+ * still in use.
+ * @return Returns the previously installed arena.
+ */
+struct arena* arena_scratch_set(struct arena* a);
+void arena_scratch_begin(void);
+void arena_scratch_end(void);
+void* arena_scratch_realloc(void* p, int size);
+void arena_scratch_free(void* p);
@@ -6,6 +6,7 @@
 
 typedef uint32_t hash32;
 typedef hash32 (*hash32_func)(const void*, int);
+typedef uint64_t hash64;
 
 /*!
  * @brief Calculate a hash from generic data, using Jenkin's "One At A Time".
@@ -13,6 +14,13 @@ typedef hash32 (*hash32_func)(const void*, int);
  */
 hash32 hash32_jenkins_oaat(const void* key, int len);
 
+/*!
+ * @brief Calculate a 64-bit hash from generic data, using FNV-1a. Use this
+ * instead of the 32-bit hashes if the hash identifies data that is stored
+ * persistently.
+ */
+hash64 hash64_fnv1a(const void* key, int len);
+
 uint32_t
 hash32_jenkins_hashword(const uint32_t* k, uintptr_t length, uint32_t initval);
 uint32_t hash32_jenkins_hashlittle(
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "csfg/config.h"
+#include "csfg/util/strview.h"
+
+/*
+ * Bounded cache of text measurements, keyed by font, font size and string.
+ * Laying out expressions and drawing graph labels measures the same short
+ * strings over and over, and every measurement goes through the font shaper.
+ * When the cache is full, the least recently used entry is replaced.
+ *
+ * The cache only stores numbers. Measuring is done by the caller, so it does
+ * not depend on a particular text rendering library.
+ */
+
+#define TEXT_CACHE_DEFAULT_CAPACITY 4096
+
+struct str;
+struct text_cache_hmap;
+struct text_cache_entry;
+
+struct text_extents
+{
+    double x_advance;
+    double width, height;
+};
+
+struct text_cache
+{
+    struct text_cache_hmap* map; /* Key -> index into "entries" */
+    struct text_cache_entry* entries;
+    struct str* key; /* Scratch buffer for building keys */
+    int capacity;
+    int free;     /* Unused entries, linked through "next" */
+    int mru, lru; /* Ends of the list of used entries */
+};
+
+/*!
+ * @brief Allocates space for "capacity" entries.
+ * @return Returns -1 if memory could not be allocated.
+ */
+int text_cache_init(struct text_cache* cache, int capacity);
+void text_cache_deinit(struct text_cache* cache);
+void text_cache_clear(struct text_cache* cache);
+int text_cache_count(const struct text_cache* cache);
+
+/*!
+ * @brief Looks up the extents of a string and marks the entry as the most
+ * recently used.
+ * @return Returns NULL if the string is not in the cache. The pointer is valid
+ * until the next insert.
+ */
+const struct text_extents* text_cache_find(
+    struct text_cache* cache,
+    struct strview font,
+    double size,
+    struct strview text);
+
+/*!
+ * @brief Stores the extents of a string, replacing the least recently used
+ * entry if the cache is full.
+ * @return Returns -1 if memory could not be allocated.
+ */
+int text_cache_insert(
+    struct text_cache* cache,
+    struct strview font,
+    double size,
+    struct strview text,
+    const struct text_extents* extents);
+
+/*!
+ * @brief Process-wide cache shared by everything that draws text, so plugins
+ * laying out the same identifiers don't measure them again. Created on first
+ * use with TEXT_CACHE_DEFAULT_CAPACITY entries and freed by csfg_deinit().
+ * @return Returns NULL if memory could not be allocated.
+ */
+struct text_cache* text_cache_shared(void);
+void text_cache_shared_deinit(void);
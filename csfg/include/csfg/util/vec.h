@@ -265,6 +265,16 @@
 #define VEC_DEFINE(prefix, T, bits) VEC_DEFINE_FULL(prefix, T, bits, 32, 2)
 
 #define VEC_DEFINE_FULL(prefix, T, bits, MIN_CAPACITY, EXPAND_FACTOR)          \
+    VEC_DEFINE_ALLOC(                                                          \
+        prefix, T, bits, MIN_CAPACITY, EXPAND_FACTOR, mem_realloc, mem_free)
+
+/*!
+ * @brief Same as VEC_DEFINE_FULL(), but the memory is managed with the
+ * functions REALLOC(ptr, size) and FREE(ptr), which must behave like realloc()
+ * and free().
+ */
+#define VEC_DEFINE_ALLOC(                                                      \
+    prefix, T, bits, MIN_CAPACITY, EXPAND_FACTOR, REALLOC, FREE)               \
     int prefix##_realloc(struct prefix** v, int##bits##_t elems)               \
     {                                                                          \
         int header, data;                                                      \
@@ -274,7 +284,7 @@
         {                                                                      \
             if (*v)                                                            \
             {                                                                  \
-                mem_free(*v);                                                  \
+                FREE(*v);                                                      \
                 *v = NULL;                                                     \
             }                                                                  \
             return 0;                                                          \
@@ -285,7 +295,7 @@
                                                                                \
         header = offsetof(struct prefix, data);                                \
         data   = sizeof(T) * elems;                                            \
-        new_v  = (struct prefix*)mem_realloc(*v, header + data);               \
+        new_v  = (struct prefix*)REALLOC(*v, header + data);                   \
         if (new_v == NULL)                                                     \
             return log_oom(header + data, "vec_realloc()");                    \
                                                                                \
@@ -302,7 +312,7 @@
     void prefix##_deinit(struct prefix* v)                                     \
     {                                                                          \
         if (v)                                                                 \
-            mem_free(v);                                                       \
+            FREE(v);                                                           \
     }                                                                          \
     void prefix##_compact(struct prefix** v)                                   \
     {                                                                          \
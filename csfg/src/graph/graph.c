@@ -1,9 +1,10 @@
 #include "csfg/graph/graph.h"
 #include "csfg/symbolic/expr.h"
+#include "csfg/util/log.h"
 #include "csfg/util/str.h"
 
-VEC_DEFINE(csfg_node_vec, struct csfg_node, 16)
-VEC_DEFINE(csfg_edge_vec, struct csfg_edge, 16)
+VEC_DEFINE(csfg_node_vec, struct csfg_node, 32)
+VEC_DEFINE(csfg_edge_vec, struct csfg_edge, 32)
 
 /* -------------------------------------------------------------------------- */
 static int id_exists(const struct csfg_graph* g, uint16_t id)
@@ -18,9 +19,16 @@ static int id_exists(const struct csfg_graph* g, uint16_t id)
             return 1;
     return 0;
 }
-static uint16_t new_id(struct csfg_graph* g)
+static int new_id(struct csfg_graph* g)
 {
-    uint16_t id = g->id_counter++;
+    uint16_t id;
+
+    /* Every ID except CSFG_GRAPH_GC_ID is taken, so the search below would
+     * never terminate */
+    if (csfg_graph_node_count(g) + csfg_graph_edge_count(g) >= CSFG_GRAPH_GC_ID)
+        return log_err("Graph has no free node or edge ID left\n");
+
+    id = g->id_counter++;
     if (g->id_counter == CSFG_GRAPH_GC_ID)
         g->id_counter++;
     while (id_exists(g, id))
@@ -64,6 +72,7 @@ void csfg_graph_init(struct csfg_graph* g)
 {
     csfg_node_vec_init(&g->nodes);
     csfg_edge_vec_init(&g->edges);
+    g->id_counter = 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -93,20 +102,30 @@ void csfg_graph_clear(struct csfg_graph* g)
 int csfg_graph_add_node(struct csfg_graph* g, const char* name)
 {
     struct str* str;
+    int n_idx;
+
     str_init(&str);
     if (str_set_cstr(&str, name) != 0)
         return -1;
-    return csfg_graph_add_node_steal_name(g, str);
+    n_idx = csfg_graph_add_node_steal_name(g, str);
+    if (n_idx < 0)
+        str_deinit(str);
+    return n_idx;
 }
 
 /* -------------------------------------------------------------------------- */
 int csfg_graph_add_node_steal_name(struct csfg_graph* g, struct str* name)
 {
-    int n_idx           = vec_count(g->nodes);
-    struct csfg_node* n = csfg_node_vec_emplace(&g->nodes);
+    struct csfg_node* n;
+    int n_idx = vec_count(g->nodes);
+    int id    = new_id(g);
+    if (id < 0)
+        return -1;
+
+    n = csfg_node_vec_emplace(&g->nodes);
     if (n == NULL)
         return -1;
-    node_init(n, new_id(g), name);
+    node_init(n, id, name);
     return n_idx;
 }
 
@@ -118,12 +137,17 @@ int csfg_graph_add_edge(
     struct csfg_expr_pool* pool,
     int expr)
 {
-    int e_idx           = vec_count(g->edges);
-    struct csfg_edge* e = csfg_edge_vec_emplace(&g->edges);
+    struct csfg_edge* e;
+    int e_idx = vec_count(g->edges);
+    int id    = new_id(g);
+    if (id < 0)
+        return -1;
+
+    e = csfg_edge_vec_emplace(&g->edges);
     if (e == NULL)
         return -1;
 
-    edge_init(e, new_id(g), n_idx_from, n_idx_to, pool, expr);
+    edge_init(e, id, n_idx_from, n_idx_to, pool, expr);
     return e_idx;
 }
 
@@ -201,3 +225,33 @@ void csfg_graph_gc(struct csfg_graph* g)
         --n_idx;
     }
 }
+
+/* -------------------------------------------------------------------------- */
+hash32 csfg_graph_topology_hash(
+    const struct csfg_graph* g, int node_in, int node_out)
+{
+    const struct csfg_edge* e;
+    hash32 hash = csfg_graph_node_count(g);
+
+    hash = hash32_combine(hash, (hash32)node_in);
+    hash = hash32_combine(hash, (hash32)node_out);
+    csfg_graph_for_each_edge (g, e)
+    {
+        hash = hash32_combine(hash, (hash32)e->n_idx_from);
+        hash = hash32_combine(hash, (hash32)e->n_idx_to);
+    }
+
+    return hash;
+}
+
+/* -------------------------------------------------------------------------- */
+hash32 csfg_graph_edge_exprs_hash(const struct csfg_graph* g)
+{
+    const struct csfg_edge* e;
+    hash32 hash = csfg_graph_edge_count(g);
+
+    csfg_graph_for_each_edge (g, e)
+        hash = hash32_combine(hash, csfg_expr_hash(e->pool, e->expr));
+
+    return hash;
+}
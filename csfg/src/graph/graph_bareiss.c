@@ -0,0 +1,350 @@
+#include "csfg/graph/graph.h"
+#include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/mpoly.h"
+#include "csfg/util/mem.h"
+
+/*
+ * The node equations of a signal flow graph are
+ *
+ *   x_j = sum(g_ij * x_i) + u_j
+ *
+ * where g_ij is the gain of the edge from node i to node j, and u is a unit
+ * source injected into the input node. In matrix form this is (I - A^T) x = u.
+ * By Cramer's rule, x_out = det(M_out) / det(I - A^T), which is exactly what
+ * Mason's gain formula computes, but without enumerating loop combinations.
+ *
+ * The system is solved symbolically with fraction-free (Bareiss) elimination.
+ * Matrix entries are polynomials in which every edge gain is a placeholder
+ * variable (the edge index). This keeps all divisions exact. The edge
+ * expressions are only substituted once the final polynomials are known.
+ */
+
+struct matrix
+{
+    struct csfg_mpoly* data;
+    int* row_order;
+    int* col_order;
+    int n;
+};
+
+/* Column "n" is the right hand side */
+#define entry(m, r, c)                                                         \
+    (&(m)->data                                                                \
+          [(m)->row_order[r] * ((m)->n + 1)                                    \
+           + ((c) == (m)->n ? (m)->n : (m)->col_order[c])])
+
+/* -------------------------------------------------------------------------- */
+static int matrix_init(struct matrix* m, int n)
+{
+    int i;
+
+    m->n         = n;
+    m->data      = mem_alloc(sizeof(*m->data) * n * (n + 1));
+    m->row_order = mem_alloc(sizeof(int) * n);
+    m->col_order = mem_alloc(sizeof(int) * n);
+    if (m->data == NULL || m->row_order == NULL || m->col_order == NULL)
+        goto fail;
+
+    for (i = 0; i != n * (n + 1); ++i)
+        csfg_mpoly_init(&m->data[i]);
+    for (i = 0; i != n; ++i)
+        m->row_order[i] = m->col_order[i] = i;
+
+    return 0;
+
+fail:
+    if (m->col_order)
+        mem_free(m->col_order);
+    if (m->row_order)
+        mem_free(m->row_order);
+    if (m->data)
+        mem_free(m->data);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+static void matrix_deinit(struct matrix* m)
+{
+    int i;
+    for (i = 0; i != m->n * (m->n + 1); ++i)
+        csfg_mpoly_deinit(&m->data[i]);
+    mem_free(m->col_order);
+    mem_free(m->row_order);
+    mem_free(m->data);
+}
+
+/* -------------------------------------------------------------------------- */
+static int build_system(
+    struct matrix* m, const struct csfg_graph* graph, int node_in)
+{
+    const struct csfg_edge* edge;
+    struct csfg_mpoly gain, sum;
+    int i, e_idx;
+
+    for (i = 0; i != m->n; ++i)
+        if (csfg_mpoly_set_lit(entry(m, i, i), 1.0) != 0)
+            return -1;
+    if (csfg_mpoly_set_lit(entry(m, node_in, m->n), 1.0) != 0)
+        return -1;
+
+    csfg_mpoly_init(&gain);
+    csfg_mpoly_init(&sum);
+    csfg_graph_enumerate_edges (graph, e_idx, edge)
+    {
+        struct csfg_mpoly* a = entry(m, edge->n_idx_to, edge->n_idx_from);
+        if (csfg_mpoly_set_var(&gain, e_idx) != 0)
+            goto fail;
+        csfg_mpoly_scale(&gain, -1.0);
+        if (csfg_mpoly_add(&sum, a, &gain) != 0)
+            goto fail;
+        csfg_mpoly_swap(&sum, a);
+    }
+    csfg_mpoly_deinit(&sum);
+    csfg_mpoly_deinit(&gain);
+    return 0;
+
+fail:
+    csfg_mpoly_deinit(&sum);
+    csfg_mpoly_deinit(&gain);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+static int find_markowitz_pivot(const struct matrix* m, int k, int* pr, int* pc)
+{
+    int i, j;
+    long best = -1;
+
+    /* The last column is reserved for the output node */
+    for (i = k; i != m->n; ++i)
+    {
+        int row_count = 0;
+        for (j = k; j != m->n; ++j)
+            row_count += !csfg_mpoly_is_zero(entry(m, i, j));
+
+        for (j = k; j != m->n - 1; ++j)
+        {
+            long cost;
+            int r, col_count = 0;
+            const struct csfg_mpoly* a = entry(m, i, j);
+            if (csfg_mpoly_is_zero(a))
+                continue;
+
+            for (r = k; r != m->n; ++r)
+                col_count += !csfg_mpoly_is_zero(entry(m, r, j));
+
+            /* Markowitz count estimates the fill-in caused by this pivot.
+             * Ties are broken by preferring smaller polynomials */
+            cost = (long)(row_count - 1) * (col_count - 1) * 1024
+                   + csfg_mpoly_term_count(a);
+            if (best < 0 || cost < best)
+            {
+                best = cost;
+                *pr  = i;
+                *pc  = j;
+            }
+        }
+    }
+
+    return best < 0 ? -1 : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static int eliminate(struct matrix* m)
+{
+    struct csfg_mpoly prev, t1, t2, sum;
+    int i, j, k, tmp;
+
+    csfg_mpoly_init(&prev);
+    csfg_mpoly_init(&t1);
+    csfg_mpoly_init(&t2);
+    csfg_mpoly_init(&sum);
+    if (csfg_mpoly_set_lit(&prev, 1.0) != 0)
+        goto fail;
+
+    for (k = 0; k != m->n - 1; ++k)
+    {
+        const struct csfg_mpoly* pivot;
+        int pr, pc;
+        if (find_markowitz_pivot(m, k, &pr, &pc) != 0)
+            goto fail;
+
+        tmp              = m->row_order[k];
+        m->row_order[k]  = m->row_order[pr];
+        m->row_order[pr] = tmp;
+        tmp              = m->col_order[k];
+        m->col_order[k]  = m->col_order[pc];
+        m->col_order[pc] = tmp;
+        pivot            = entry(m, k, k);
+
+        /* a_ij = (a_kk * a_ij - a_ik * a_kj) / prev_pivot */
+        for (i = k + 1; i != m->n; ++i)
+        {
+            struct csfg_mpoly* a_ik = entry(m, i, k);
+            for (j = k + 1; j != m->n + 1; ++j)
+            {
+                struct csfg_mpoly* a_ij = entry(m, i, j);
+                const struct csfg_mpoly* a_kj = entry(m, k, j);
+                int zero_product =
+                    csfg_mpoly_is_zero(a_ik) || csfg_mpoly_is_zero(a_kj);
+                if (csfg_mpoly_is_zero(a_ij) && zero_product)
+                    continue;
+
+                if (csfg_mpoly_mul(&t1, pivot, a_ij) != 0)
+                    goto fail;
+                if (!zero_product)
+                {
+                    if (csfg_mpoly_mul(&t2, a_ik, a_kj) != 0)
+                        goto fail;
+                    csfg_mpoly_scale(&t2, -1.0);
+                    if (csfg_mpoly_add(&sum, &t1, &t2) != 0)
+                        goto fail;
+                    csfg_mpoly_swap(&sum, &t1);
+                }
+                if (csfg_mpoly_div_exact(a_ij, &t1, &prev) != 0)
+                    goto fail;
+            }
+            csfg_mpoly_clear(a_ik);
+        }
+
+        if (csfg_mpoly_copy(&prev, pivot) != 0)
+            goto fail;
+    }
+
+    csfg_mpoly_deinit(&sum);
+    csfg_mpoly_deinit(&t2);
+    csfg_mpoly_deinit(&t1);
+    csfg_mpoly_deinit(&prev);
+    return 0;
+
+fail:
+    csfg_mpoly_deinit(&sum);
+    csfg_mpoly_deinit(&t2);
+    csfg_mpoly_deinit(&t1);
+    csfg_mpoly_deinit(&prev);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+static int edge_expr_gain(struct csfg_expr_pool** pool, int edge_idx, void* user)
+{
+    const struct csfg_graph* graph = user;
+    const struct csfg_edge* edge   = vec_get(graph->edges, edge_idx);
+    return csfg_expr_dup_recurse_from(pool, &edge->pool, edge->expr);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_bareiss(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    int node_in,
+    int node_out)
+{
+    return csfg_graph_bareiss_with(
+        graph, pool, node_in, node_out, edge_expr_gain, (void*)graph);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_bareiss_with(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    int node_in,
+    int node_out,
+    csfg_graph_edge_gain_func edge_gain,
+    void* user)
+{
+    struct matrix m;
+    struct csfg_mpoly *num, *den;
+    const struct csfg_mpoly_term* t;
+    int n = csfg_graph_node_count(graph);
+    int num_expr, den_expr;
+
+    if (node_in < 0 || node_out < 0 || node_in >= n || node_out >= n)
+        return -1;
+    /* Edge indices are used as polynomial variables */
+    if (csfg_graph_edge_count(graph) > INT16_MAX)
+        return -1;
+
+    if (matrix_init(&m, n) != 0)
+        return -1;
+    if (build_system(&m, graph, node_in) != 0)
+        goto fail;
+
+    /* Move the output node into the last column so it is eliminated last. The
+     * last row is then det * x_out = det(M_out) */
+    m.col_order[node_out] = n - 1;
+    m.col_order[n - 1]    = node_out;
+    if (eliminate(&m) != 0)
+        goto fail;
+
+    num = entry(&m, n - 1, n);
+    den = entry(&m, n - 1, n - 1);
+    if (csfg_mpoly_is_zero(den))
+        goto fail;
+
+    /* Row and column swaps may have flipped the sign of the determinant.
+     * Normalize it so the constant term is positive, same as Mason's formula.
+     * Constant terms always sort first. */
+    t = vec_first(den->terms);
+    if (t->count == 0 && t->coeff < 0.0)
+    {
+        csfg_mpoly_scale(num, -1.0);
+        csfg_mpoly_scale(den, -1.0);
+    }
+
+    /* Edge indices are the polynomial variables, so the callbacks have the
+     * same signature */
+    num_expr = csfg_mpoly_to_expr_with(num, pool, edge_gain, user);
+    den_expr = csfg_mpoly_to_expr_with(den, pool, edge_gain, user);
+    if (num_expr < 0 || den_expr < 0)
+        goto fail;
+
+    matrix_deinit(&m);
+    return csfg_expr_div(pool, num_expr, den_expr);
+
+fail:
+    matrix_deinit(&m);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_transfer_function(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    const struct csfg_path_vec* paths,
+    const struct csfg_path_vec* loops,
+    int node_in,
+    int node_out)
+{
+    return csfg_graph_transfer_function_with(
+        graph,
+        pool,
+        paths,
+        loops,
+        node_in,
+        node_out,
+        edge_expr_gain,
+        (void*)graph);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_transfer_function_with(
+    const struct csfg_graph* graph,
+    struct csfg_expr_pool** pool,
+    const struct csfg_path_vec* paths,
+    const struct csfg_path_vec* loops,
+    int node_in,
+    int node_out,
+    csfg_graph_edge_gain_func edge_gain,
+    void* user)
+{
+    if (csfg_paths_count(loops) > CSFG_GRAPH_MASON_MAX_LOOPS)
+    {
+        int expr = csfg_graph_bareiss_with(
+            graph, pool, node_in, node_out, edge_gain, user);
+        if (expr > -1)
+            return expr;
+    }
+
+    return csfg_graph_mason_with(graph, pool, paths, loops, edge_gain, user);
+}
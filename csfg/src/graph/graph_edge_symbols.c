@@ -0,0 +1,81 @@
+#include "csfg/graph/graph.h"
+#include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
+#include "csfg/symbolic/var_table.h"
+#include <stdio.h>
+
+/* -------------------------------------------------------------------------- */
+static struct strview edge_symbol_name(char* buf, int edge_idx)
+{
+    /* The parser does not accept brackets in identifiers, so the symbol can't
+     * clash with variables used in edge expressions */
+    sprintf(buf, "G[%d]", edge_idx);
+    return cstr_view(buf);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_edge_symbol(
+    struct csfg_expr_pool** pool, int edge_idx, void* user)
+{
+    char buf[16];
+    (void)user;
+    return csfg_expr_var(pool, edge_symbol_name(buf, edge_idx));
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_edge_symbol_id(int edge_idx)
+{
+    char buf[16];
+    return csfg_symbol_intern(edge_symbol_name(buf, edge_idx));
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_edge_symbol_index(int symbol)
+{
+    int edge_idx;
+    char end;
+    if (sscanf(csfg_symbol_cstr(symbol), "G[%d%c", &edge_idx, &end) != 2)
+        return -1;
+    return end == ']' ? edge_idx : -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_edge_symbol_set(
+    const struct csfg_graph* graph, struct csfg_var_table* vt, int edge_idx)
+{
+    char buf[16];
+    int expr;
+    struct csfg_expr_pool* pool;
+    const struct csfg_edge* edge = vec_get(graph->edges, edge_idx);
+
+    if (edge->expr < 0)
+        return -1;
+
+    csfg_expr_pool_init(&pool);
+    expr = csfg_expr_dup_recurse_from(&pool, &edge->pool, edge->expr);
+    if (expr < 0)
+        goto fail;
+    if (csfg_var_table_set_expr(
+            vt, edge_symbol_name(buf, edge_idx), pool, expr) != 0)
+    {
+        goto fail;
+    }
+
+    return 0;
+
+fail:
+    csfg_expr_pool_deinit(pool);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_edge_symbol_table(
+    const struct csfg_graph* graph, struct csfg_var_table* vt)
+{
+    int i, result = 0;
+    csfg_var_table_clear(vt);
+    for (i = 0; i != csfg_graph_edge_count(graph); ++i)
+        if (csfg_graph_edge_symbol_set(graph, vt, i) != 0)
+            result = -1;
+    return result;
+}
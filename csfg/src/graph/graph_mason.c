@@ -12,19 +12,25 @@ static int touch_cache_idx(int i, int j, int N)
     return i * (2 * N - i - 1) / 2 + (j - i - 1);
 }
 
+/* -------------------------------------------------------------------------- */
+struct edge_gain
+{
+    csfg_graph_edge_gain_func func;
+    void*                     user;
+};
+
 /* -------------------------------------------------------------------------- */
 static int path_gain(
-    const struct csfg_graph* graph,
-    struct csfg_expr_pool**  pool,
-    struct csfg_path         path)
+    const struct edge_gain* gain,
+    struct csfg_expr_pool** pool,
+    struct csfg_path        path)
 {
     const int* edge_idx;
     int        expr = -1;
 
     for (edge_idx = path.edge_idxs; *edge_idx != -1; ++edge_idx)
     {
-        const struct csfg_edge* edge = vec_get(graph->edges, *edge_idx);
-        int factor = csfg_expr_dup_recurse_from(pool, &edge->pool, edge->expr);
+        int factor = gain->func(pool, *edge_idx, gain->user);
         if (expr == -1)
             expr = factor;
         else
@@ -37,6 +43,7 @@ static int path_gain(
 /* -------------------------------------------------------------------------- */
 static int determinant(
     const struct csfg_graph*    graph,
+    const struct edge_gain*     gain,
     struct csfg_expr_pool**     pool,
     const struct csfg_path_vec* loops)
 {
@@ -58,7 +65,7 @@ static int determinant(
      *   1 - (L1 + L2 + ... + Li) where Li is the loop gain at index i.
      */
     csfg_paths_for_each (loops, path)
-        det = csfg_expr_sub(pool, det, path_gain(graph, pool, path));
+        det = csfg_expr_sub(pool, det, path_gain(gain, pool, path));
     if (loop_count < 2)
         return det;
 
@@ -125,13 +132,13 @@ static int determinant(
             /* The current combination of loops do not touch each other, so
              * multiply their gains together. */
             combined_gain_expr =
-                path_gain(graph, pool, csfg_paths_get(loops, lcomb[0]));
+                path_gain(gain, pool, csfg_paths_get(loops, lcomb[0]));
             for (i = 1; i != k; ++i)
             {
                 combined_gain_expr = csfg_expr_mul(
                     pool,
                     combined_gain_expr,
-                    path_gain(graph, pool, csfg_paths_get(loops, lcomb[i])));
+                    path_gain(gain, pool, csfg_paths_get(loops, lcomb[i])));
             }
 
             /* Now, add or subtract it to/from the final expression */
@@ -177,16 +184,40 @@ alloc_touch_cache_failed:
     return -1;
 }
 
+/* -------------------------------------------------------------------------- */
+static int edge_expr_gain(struct csfg_expr_pool** pool, int edge_idx, void* user)
+{
+    const struct csfg_graph* graph = user;
+    const struct csfg_edge*  edge  = vec_get(graph->edges, edge_idx);
+    return csfg_expr_dup_recurse_from(pool, &edge->pool, edge->expr);
+}
+
 /* -------------------------------------------------------------------------- */
 int csfg_graph_mason(
     const struct csfg_graph*    graph,
     struct csfg_expr_pool**     pool,
     const struct csfg_path_vec* paths,
     const struct csfg_path_vec* loops)
+{
+    return csfg_graph_mason_with(
+        graph, pool, paths, loops, edge_expr_gain, (void*)graph);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_graph_mason_with(
+    const struct csfg_graph*    graph,
+    struct csfg_expr_pool**     pool,
+    const struct csfg_path_vec* paths,
+    const struct csfg_path_vec* loops,
+    csfg_graph_edge_gain_func   edge_gain,
+    void*                       user)
 {
     int                   gain_expr, expr;
     struct csfg_path      path;
     struct csfg_path_vec* nontouching_loops;
+    struct edge_gain      gain;
+    gain.func = edge_gain;
+    gain.user = user;
     csfg_path_vec_init(&nontouching_loops);
 
     expr = -1;
@@ -201,8 +232,8 @@ int csfg_graph_mason(
 
         gain_expr = csfg_expr_mul(
             pool,
-            path_gain(graph, pool, path),
-            determinant(graph, pool, nontouching_loops));
+            path_gain(&gain, pool, path),
+            determinant(graph, &gain, pool, nontouching_loops));
         if (expr == -1)
             expr = gain_expr;
         else
@@ -213,7 +244,7 @@ int csfg_graph_mason(
     }
 
     csfg_path_vec_deinit(nontouching_loops);
-    return csfg_expr_div(pool, expr, determinant(graph, pool, loops));
+    return csfg_expr_div(pool, expr, determinant(graph, &gain, pool, loops));
 
 fail:
     csfg_path_vec_deinit(nontouching_loops);
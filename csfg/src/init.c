@@ -1,6 +1,8 @@
 #include "csfg/init.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/util/backtrace.h"
 #include "csfg/util/log.h"
+#include "csfg/util/text_cache.h"
 #include "csfg/util/tracker.h"
 #include "mathomatic/am.h"
 
@@ -29,6 +31,8 @@ init_backtrace_failed:
 void csfg_deinit(void)
 {
     free_mem();
+    csfg_symbols_deinit();
+    text_cache_shared_deinit();
     trackers_deinit_tls();
     backtrace_deinit();
 }
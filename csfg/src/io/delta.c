@@ -0,0 +1,130 @@
+#include "csfg/io/delta.h"
+#include "csfg/io/deserialize.h"
+#include "csfg/io/serialize.h"
+#include "csfg/util/log.h"
+#include "csfg/util/mem.h"
+#include <string.h>
+
+/* -------------------------------------------------------------------------- */
+static uint32_t hash_block(const uint8_t* p)
+{
+    uint32_t w[DELTA_BLOCK_SIZE / 4];
+    uint32_t h = 0;
+    int i;
+    memcpy(w, p, DELTA_BLOCK_SIZE);
+    for (i = 0; i != DELTA_BLOCK_SIZE / 4; ++i)
+        h = (h ^ w[i]) * 0x9E3779B1;
+    return h ^ (h >> 15);
+}
+
+/* -------------------------------------------------------------------------- */
+static int emit_literal(struct serializer** delta, const uint8_t* data, int len)
+{
+    if (len == 0)
+        return 0;
+    if (serialize_lu32(delta, (uint32_t)len << 1) != 0)
+        return -1;
+    return serialize_data(delta, data, len);
+}
+
+/* -------------------------------------------------------------------------- */
+int delta_encode(
+    struct serializer** delta,
+    const void* src_data,
+    int src_len,
+    const void* dst_data,
+    int dst_len)
+{
+    const uint8_t* src = src_data;
+    const uint8_t* dst = dst_data;
+    int* table;
+    int i, j, lit_start, table_size;
+
+    /* Only block-aligned positions of "src" are indexed. Every match at least
+     * DELTA_BLOCK_SIZE * 2 bytes long contains an aligned block, so it is
+     * still found */
+    table_size = 64;
+    while (table_size < src_len / DELTA_BLOCK_SIZE * 2)
+        table_size *= 2;
+    table = mem_alloc(sizeof(*table) * table_size);
+    if (table == NULL)
+        return log_oom(sizeof(*table) * table_size, "delta_encode()");
+    for (i = 0; i != table_size; ++i)
+        table[i] = -1;
+    for (i = 0; i + DELTA_BLOCK_SIZE <= src_len; i += DELTA_BLOCK_SIZE)
+        table[hash_block(src + i) & (table_size - 1)] = i;
+
+    lit_start = 0;
+    j         = 0;
+    while (j + DELTA_BLOCK_SIZE <= dst_len)
+    {
+        int len;
+        i = table[hash_block(dst + j) & (table_size - 1)];
+        if (i < 0 || memcmp(src + i, dst + j, DELTA_BLOCK_SIZE) != 0)
+        {
+            j++;
+            continue;
+        }
+
+        /* Grow the match in both directions. Going backwards takes bytes
+         * from the pending literal */
+        while (i > 0 && j > lit_start && src[i - 1] == dst[j - 1])
+            i--, j--;
+        len = DELTA_BLOCK_SIZE;
+        while (i + len < src_len && j + len < dst_len &&
+               src[i + len] == dst[j + len])
+            len++;
+
+        if (emit_literal(delta, dst + lit_start, j - lit_start) != 0 ||
+            serialize_lu32(delta, ((uint32_t)len << 1) | 1) != 0 ||
+            serialize_lu32(delta, i) != 0)
+            goto fail;
+
+        j += len;
+        lit_start = j;
+    }
+
+    if (emit_literal(delta, dst + lit_start, dst_len - lit_start) != 0)
+        goto fail;
+
+    mem_free(table);
+    return 0;
+
+fail:
+    mem_free(table);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int delta_apply(
+    struct serializer** dst,
+    const void* src,
+    int src_len,
+    const void* delta,
+    int delta_len)
+{
+    struct deserializer des = deserializer(delta, delta_len);
+    while (deserializer_bytes_left(&des) > 0)
+    {
+        uint32_t op = deserialize_lu32(&des);
+        int len     = (int)(op >> 1);
+        const void* data;
+
+        if (op & 1)
+        {
+            uint32_t offset = deserialize_lu32(&des);
+            if (offset > (uint32_t)src_len || (uint32_t)len > src_len - offset)
+                return log_err("Delta copies past the end of the source\n");
+            data = (const uint8_t*)src + offset;
+        }
+        else
+            data = deserialize_data1(&des, len);
+
+        if (deserializer_err(&des))
+            return log_err("Delta is truncated\n");
+        if (serialize_data(dst, data, len) != 0)
+            return -1;
+    }
+
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include "csfg/config.h"
 #include "csfg/io/deserialize.h"
 #include <string.h>
 
@@ -83,6 +84,16 @@ float deserialize_lf32(struct deserializer* des)
     return value;
 }
 
+/* -------------------------------------------------------------------------- */
+double deserialize_lf64(struct deserializer* des)
+{
+    double value;
+    uint64_t u64 = deserialize_lu32(des);
+    u64 |= (uint64_t)deserialize_lu32(des) << 32;
+    memcpy(&value, &u64, 8);
+    return value;
+}
+
 /* -------------------------------------------------------------------------- */
 const char* deserialize_cstr(struct deserializer* des)
 {
@@ -93,6 +104,73 @@ const char* deserialize_cstr(struct deserializer* des)
     return cstr;
 }
 
+/* -------------------------------------------------------------------------- */
+static const uint8_t* array_data(struct deserializer* des, int count, int size)
+{
+    if (count < 0 || count > (des->size - des->read_offset) / size)
+    {
+        des->err = 1;
+        return NULL;
+    }
+    des->read_offset += count * size;
+    return (const uint8_t*)des->data + des->read_offset - count * size;
+}
+
+/* -------------------------------------------------------------------------- */
+void deserialize_lu16_array(struct deserializer* des, uint16_t* dst, int count)
+{
+    const uint8_t* p = array_data(des, count, 2);
+    if (p == NULL)
+        return;
+#if defined(CSFG_BIG_ENDIAN)
+    for (; count--; p += 2)
+        *dst++ = (uint16_t)(p[0] | (p[1] << 8));
+#else
+    memcpy(dst, p, count * 2);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+void deserialize_lu32_array(struct deserializer* des, uint32_t* dst, int count)
+{
+    const uint8_t* p = array_data(des, count, 4);
+    if (p == NULL)
+        return;
+#if defined(CSFG_BIG_ENDIAN)
+    for (; count--; p += 4)
+        *dst++ = ((uint32_t)p[0] << 0) | ((uint32_t)p[1] << 8) |
+                 ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+#else
+    memcpy(dst, p, count * 4);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+void deserialize_li32_array(struct deserializer* des, int32_t* dst, int count)
+{
+    deserialize_lu32_array(des, (uint32_t*)dst, count);
+}
+
+/* -------------------------------------------------------------------------- */
+void deserialize_lf64_array(struct deserializer* des, double* dst, int count)
+{
+    const uint8_t* p = array_data(des, count, 8);
+    if (p == NULL)
+        return;
+#if defined(CSFG_BIG_ENDIAN)
+    for (; count--; p += 8)
+    {
+        uint64_t u64 = 0;
+        int i;
+        for (i = 7; i >= 0; --i)
+            u64 = (u64 << 8) | p[i];
+        memcpy(dst++, &u64, 8);
+    }
+#else
+    memcpy(dst, p, count * 8);
+#endif
+}
+
 /* -------------------------------------------------------------------------- */
 int deserializer_err(const struct deserializer* des)
 {
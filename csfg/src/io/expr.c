@@ -2,6 +2,7 @@
 #include "csfg/io/io.h"
 #include "csfg/io/serialize.h"
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 
 /* -------------------------------------------------------------------------- */
 static int
@@ -21,13 +22,11 @@ serialize_expr_pool(struct serializer** ser, const struct csfg_expr_pool* pool)
         {
             case CSFG_EXPR_GC: CSFG_DEBUG_ASSERT(0); return -1;
             case CSFG_EXPR_LIT:
-                err += serialize_lf32(ser, pool->nodes[n].value.lit);
+                err += serialize_lf64(ser, csfg_expr_lit_value(pool, n));
                 break;
             case CSFG_EXPR_VAR:
                 err += serialize_cstr(
-                    ser,
-                    strlist_cstr(
-                        pool->var_names, pool->nodes[n].value.var_idx));
+                    ser, csfg_symbol_cstr(pool->nodes[n].value));
                 break;
             case CSFG_EXPR_INF:
             case CSFG_EXPR_NEG:
@@ -41,65 +40,105 @@ serialize_expr_pool(struct serializer** ser, const struct csfg_expr_pool* pool)
 }
 
 /* -------------------------------------------------------------------------- */
-static int save_expr_recurse(
-    struct serializer** ser, const struct csfg_expr_pool* pool, int expr)
+/*
+ * Version 2 stores the node types in post-order. The number of children each
+ * node has follows from its type, so the tree can be rebuilt with a stack and
+ * no child indices have to be stored. The literal values are written as one
+ * array:
+ *
+ *   lu32 node count N (0 if there is no expression)
+ *   u8   types[N]
+ *   lu32 literal count L, lf64 literals[L]
+ *   lu32 variable count V, cstr names[V]
+ *
+ * The n-th LIT/VAR node uses the n-th literal/name.
+ */
+struct flat_expr
 {
-    enum csfg_expr_type type;
-    int left, right, var_idx, err = 0;
-    uint8_t active_children;
+    double* lits;
+    int32_t* vars;
+    uint8_t* types;
+    int count, lit_count, var_count;
+};
 
+static int count_nodes(const struct csfg_expr_pool* pool, int expr)
+{
     if (expr < 0)
         return 0;
+    return 1 + count_nodes(pool, pool->nodes[expr].child[0]) +
+           count_nodes(pool, pool->nodes[expr].child[1]);
+}
 
-    type  = (enum csfg_expr_type)pool->nodes[expr].type;
-    left  = pool->nodes[expr].child[0];
-    right = pool->nodes[expr].child[1];
-
-    active_children = (left > -1 ? 0x01 : 0x00) | (right > -1 ? 0x02 : 0x00);
-
-    err += serialize_u8(ser, type);
-    err += serialize_u8(ser, active_children);
-
-    switch (type)
-    {
-        case CSFG_EXPR_GC: CSFG_DEBUG_ASSERT(0); return -1;
-        case CSFG_EXPR_LIT:
-            err += serialize_lf32(ser, pool->nodes[expr].value.lit);
-            break;
-        case CSFG_EXPR_VAR:
-            var_idx = pool->nodes[expr].value.var_idx;
-            err += serialize_cstr(ser, strlist_cstr(pool->var_names, var_idx));
-            break;
-        case CSFG_EXPR_INF:
-        case CSFG_EXPR_NEG:
-        case CSFG_EXPR_ADD:
-        case CSFG_EXPR_MUL:
-        case CSFG_EXPR_POW: break;
-    }
-
-    if (left > -1)
-        err += save_expr_recurse(ser, pool, left);
-    if (right > -1)
-        err += save_expr_recurse(ser, pool, right);
+static void
+flatten(const struct csfg_expr_pool* pool, int expr, struct flat_expr* flat)
+{
+    if (pool->nodes[expr].child[0] > -1)
+        flatten(pool, pool->nodes[expr].child[0], flat);
+    if (pool->nodes[expr].child[1] > -1)
+        flatten(pool, pool->nodes[expr].child[1], flat);
 
-    return err;
+    flat->types[flat->count++] = pool->nodes[expr].type;
+    if (pool->nodes[expr].type == CSFG_EXPR_LIT)
+        flat->lits[flat->lit_count++] = csfg_expr_lit_value(pool, expr);
+    if (pool->nodes[expr].type == CSFG_EXPR_VAR)
+        flat->vars[flat->var_count++] = pool->nodes[expr].value;
 }
+
 int csfg_io_expr_save(
     struct serializer** ser, const struct csfg_expr_pool* pool, int expr)
 {
-    const uint8_t version = 0;
-    int err               = 0;
+    struct flat_expr flat;
+    void* mem;
+    int i, size;
 
-    err += serialize_u8(ser, version);
-    err += serialize_u8(ser, expr > -1 ? 1 : 0);
-    err += save_expr_recurse(ser, pool, expr);
+    const uint8_t version = 2;
+    const int count       = count_nodes(pool, expr);
 
-    return err;
+    if (serialize_u8(ser, version) != 0)
+        return -1;
+    if (count == 0)
+        return serialize_lu32(ser, 0);
+
+    size = (sizeof(double) + sizeof(int32_t) + 1) * count;
+    mem  = mem_alloc(size);
+    if (mem == NULL)
+        return log_oom(size, "csfg_io_expr_save()");
+    flat.lits      = mem;
+    flat.vars      = (int32_t*)(flat.lits + count);
+    flat.types     = (uint8_t*)(flat.vars + count);
+    flat.count     = 0;
+    flat.lit_count = 0;
+    flat.var_count = 0;
+    flatten(pool, expr, &flat);
+
+    if (serialize_lu32(ser, count) != 0 ||
+        serialize_data(ser, flat.types, count) != 0 ||
+        serialize_lu32(ser, flat.lit_count) != 0 ||
+        serialize_lf64_array(ser, flat.lits, flat.lit_count) != 0 ||
+        serialize_lu32(ser, flat.var_count) != 0)
+        goto fail;
+    for (i = 0; i != flat.var_count; ++i)
+        if (serialize_cstr(ser, csfg_symbol_cstr(flat.vars[i])) != 0)
+            goto fail;
+
+    mem_free(mem);
+    return 0;
+
+fail:
+    mem_free(mem);
+    return -1;
 }
 
 /* -------------------------------------------------------------------------- */
-static int load_0_recurse(
-    struct deserializer* des, struct csfg_expr_pool** pool, int* expr)
+/*
+ * Version 0 stored literals as 32-bit floats. Version 1 stores doubles, the
+ * format is otherwise the same.
+ */
+static int load_recurse(
+    struct deserializer* des,
+    struct csfg_expr_pool** pool,
+    int* expr,
+    uint8_t version)
 {
     enum csfg_expr_type type = deserialize_u8(des);
     uint8_t active_children  = deserialize_u8(des);
@@ -108,7 +147,9 @@ static int load_0_recurse(
     {
         case CSFG_EXPR_GC: return log_err("GC node read!\n");
         case CSFG_EXPR_LIT:
-            *expr = csfg_expr_lit(pool, deserialize_lf32(des));
+            *expr = csfg_expr_lit(
+                pool,
+                version == 0 ? deserialize_lf32(des) : deserialize_lf64(des));
             if (*expr < 0)
                 return -1;
             if (active_children)
@@ -132,7 +173,7 @@ static int load_0_recurse(
             int left;
             if (active_children & 0x02)
                 return log_err("NEG cannot have a right-side child!\n");
-            if (load_0_recurse(des, pool, &left) != 0)
+            if (load_recurse(des, pool, &left, version) != 0)
                 return -1;
             *expr = csfg_expr_neg(pool, left);
             if (*expr < 0)
@@ -145,9 +186,9 @@ static int load_0_recurse(
             int left, right;
             if (active_children != 0x03)
                 return log_err("binop must have both left/right children!\n");
-            if (load_0_recurse(des, pool, &left) != 0)
+            if (load_recurse(des, pool, &left, version) != 0)
                 return -1;
-            if (load_0_recurse(des, pool, &right) != 0)
+            if (load_recurse(des, pool, &right, version) != 0)
                 return -1;
             *expr = csfg_expr_binop(pool, type, left, right);
             if (*expr < 0)
@@ -158,13 +199,16 @@ static int load_0_recurse(
 
     return log_err("Invalid node type read: %d\n", type);
 }
-static int
-load_0(struct deserializer* des, struct csfg_expr_pool** pool, int* expr)
+static int load(
+    struct deserializer* des,
+    struct csfg_expr_pool** pool,
+    int* expr,
+    uint8_t version)
 {
     int have_expr = deserialize_u8(des);
     if (have_expr)
     {
-        if (load_0_recurse(des, pool, expr) != 0)
+        if (load_recurse(des, pool, expr, version) != 0)
             return -1;
         return csfg_expr_integrity_check(*pool, *expr);
     }
@@ -172,6 +216,108 @@ load_0(struct deserializer* des, struct csfg_expr_pool** pool, int* expr)
     return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+static int load_2(
+    struct deserializer* des, struct csfg_expr_pool** pool, int* expr)
+{
+    const uint8_t* types;
+    int* stack;
+    double* lits;
+    int i, count, lit_count, var_count, lit_idx, var_idx, top;
+
+    *expr = -1;
+    count = (int)deserialize_lu32(des);
+    if (deserializer_err(des))
+        return log_err("Failed to read node count: EOF\n");
+    if (count == 0)
+        return 0;
+    if (count < 0 || count > deserializer_bytes_left(des))
+        return log_err("Read implausible node count: %d\n", count);
+    types = deserialize_data1(des, count);
+
+    lit_count = (int)deserialize_lu32(des);
+    if (deserializer_err(des) || lit_count < 0 || lit_count > count)
+        return log_err("Read implausible literal count: %d\n", lit_count);
+
+    /* The stack never holds more entries than there are nodes */
+    lits = mem_alloc(sizeof(*lits) * lit_count + sizeof(*stack) * count);
+    if (lits == NULL)
+        return log_oom(
+            sizeof(*lits) * lit_count + sizeof(*stack) * count,
+            "csfg_io_expr_load()");
+    stack = (int*)(lits + lit_count);
+    deserialize_lf64_array(des, lits, lit_count);
+
+    var_count = (int)deserialize_lu32(des);
+    if (deserializer_err(des))
+    {
+        log_err("Expression data is truncated\n");
+        goto fail;
+    }
+
+    lit_idx = 0;
+    var_idx = 0;
+    top     = 0;
+    for (i = 0; i != count; ++i)
+    {
+        int n;
+        switch ((enum csfg_expr_type)types[i])
+        {
+            case CSFG_EXPR_LIT:
+                if (lit_idx >= lit_count)
+                    goto invalid_node;
+                n = csfg_expr_lit(pool, lits[lit_idx++]);
+                break;
+            case CSFG_EXPR_VAR:
+                if (var_idx++ >= var_count)
+                    goto invalid_node;
+                n = csfg_expr_var(pool, cstr_view(deserialize_cstr(des)));
+                break;
+            case CSFG_EXPR_INF: n = csfg_expr_inf(pool); break;
+            case CSFG_EXPR_NEG:
+                if (top < 1)
+                    goto invalid_node;
+                n = csfg_expr_neg(pool, stack[--top]);
+                break;
+            case CSFG_EXPR_ADD:
+            case CSFG_EXPR_MUL:
+            case CSFG_EXPR_POW:
+                if (top < 2)
+                    goto invalid_node;
+                top -= 2;
+                n = csfg_expr_binop(
+                    pool,
+                    (enum csfg_expr_type)types[i],
+                    stack[top],
+                    stack[top + 1]);
+                break;
+            case CSFG_EXPR_GC:
+            default: goto invalid_node;
+        }
+
+        if (n < 0)
+            goto fail;
+        stack[top++] = n;
+    }
+
+    if (top != 1 || lit_idx != lit_count || var_idx != var_count ||
+        deserializer_err(des))
+    {
+        log_err("Expression data is inconsistent\n");
+        goto fail;
+    }
+
+    *expr = stack[0];
+    mem_free(lits);
+    return csfg_expr_integrity_check(*pool, *expr);
+
+invalid_node:
+    log_err("Invalid node read: type %d\n", types[i]);
+fail:
+    mem_free(lits);
+    return -1;
+}
+
 /* -------------------------------------------------------------------------- */
 int csfg_io_expr_load(
     struct deserializer* des, struct csfg_expr_pool** pool, int* expr)
@@ -182,7 +328,9 @@ int csfg_io_expr_load(
 
     switch (version)
     {
-        case 0x00: return load_0(des, pool, expr);
+        case 0x00:
+        case 0x01: return load(des, pool, expr, version);
+        case 0x02: return load_2(des, pool, expr);
     }
 
     return log_err("Unsupported format version: %d\n", version);
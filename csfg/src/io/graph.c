@@ -2,9 +2,43 @@
 #include "csfg/io/deserialize.h"
 #include "csfg/io/io.h"
 #include "csfg/io/serialize.h"
+#include "csfg/platform/mfile.h"
 #include "csfg/symbolic/expr.h"
+#include "csfg/util/bm.h"
 #include "csfg/util/str.h"
 
+/*
+ * Version 1 is a chunked format. All offsets are relative to the version byte
+ * and all values are little endian:
+ *
+ *   u8   version
+ *   lu32 total size in bytes, including the version byte
+ *   li32 node_in, node_out
+ *   lu32 chunk count
+ *   chunk count * { lu32 tag, lu32 offset, lu32 size }
+ *
+ * The node and edge tables consist of a lu32 count followed by fixed-size
+ * records, so they can be bounds-checked once and then decoded in a single
+ * pass. Node names and edge expressions are stored in separate blobs and are
+ * referenced by offset, so the loader can read them through zero-copy views
+ * into the (possibly memory-mapped) buffer. Unknown chunks are skipped.
+ */
+#define CHUNK_TAG(a, b, c, d)                                                  \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) |            \
+     ((uint32_t)(d) << 24))
+#define CHUNK_NODES CHUNK_TAG('N', 'O', 'D', 'E')
+#define CHUNK_EDGES CHUNK_TAG('E', 'D', 'G', 'E')
+#define CHUNK_NAMES CHUNK_TAG('N', 'A', 'M', 'E')
+#define CHUNK_EXPRS CHUNK_TAG('E', 'X', 'P', 'R')
+
+/* Sizes are in lu32 words */
+#define HEADER_WORDS 4
+#define CHUNK_WORDS  3
+#define NODE_WORDS   5
+#define EDGE_WORDS   7
+#define CHUNK_COUNT  4
+#define MAX_CHUNKS   64
+
 /* -------------------------------------------------------------------------- */
 int csfg_io_graph_save(
     struct serializer** ser,
@@ -12,38 +46,102 @@ int csfg_io_graph_save(
     int node_in,
     int node_out)
 {
+    uint32_t header[HEADER_WORDS + CHUNK_WORDS * CHUNK_COUNT];
     const struct csfg_node* n;
     const struct csfg_edge* e;
+    struct serializer* exprs;
+    uint32_t *records, *record;
+    int names_size, nodes_offset, edges_offset, names_offset, exprs_offset;
+    int name_offset, total_size, words;
 
-    const uint8_t version = 0;
-    int err               = 0;
+    const int node_count = csfg_graph_node_count(graph);
+    const int edge_count = csfg_graph_edge_count(graph);
 
-    err += serialize_u8(ser, version);
+    words   = NODE_WORDS * node_count + EDGE_WORDS * edge_count + 1;
+    records = mem_alloc(sizeof(*records) * words);
+    if (records == NULL)
+        return log_oom(sizeof(*records) * words, "csfg_io_graph_save()");
 
-    err += serialize_li16(ser, node_in);
-    err += serialize_li16(ser, node_out);
-
-    err += serialize_li16(ser, csfg_graph_node_count(graph));
-    csfg_graph_for_each_node (graph, n)
+    /* Expressions don't have a known size, so they are serialized into a
+     * separate buffer first. This way the offsets in the edge table are known
+     * before anything is written */
+    serializer_init(&exprs);
+    record = records + NODE_WORDS * node_count;
+    csfg_graph_for_each_edge (graph, e)
     {
-        err += serialize_lu16(ser, n->id);
-        err += serialize_cstr(ser, str_cstr(n->name));
-        err += serialize_li16(ser, n->x);
-        err += serialize_li16(ser, n->y);
+        int expr_offset = vec_count(exprs);
+        if (csfg_io_expr_save(&exprs, e->pool, e->expr) != 0)
+            goto save_failed;
+
+        record[0] = e->id;
+        record[1] = e->n_idx_from;
+        record[2] = e->n_idx_to;
+        record[3] = (uint32_t)e->x;
+        record[4] = (uint32_t)e->y;
+        record[5] = expr_offset;
+        record[6] = vec_count(exprs) - expr_offset;
+        record += EDGE_WORDS;
     }
 
-    err += serialize_li16(ser, csfg_graph_edge_count(graph));
-    csfg_graph_for_each_edge (graph, e)
+    name_offset = 0;
+    record      = records;
+    csfg_graph_for_each_node (graph, n)
     {
-        err += serialize_lu16(ser, e->id);
-        err += serialize_li16(ser, e->n_idx_from);
-        err += serialize_li16(ser, e->n_idx_to);
-        err += serialize_li16(ser, e->x);
-        err += serialize_li16(ser, e->y);
-        err += csfg_io_expr_save(ser, e->pool, e->expr);
+        record[0] = n->id;
+        record[1] = (uint32_t)n->x;
+        record[2] = (uint32_t)n->y;
+        record[3] = name_offset;
+        record[4] = str_len(n->name);
+        name_offset += str_len(n->name) + 1;
+        record += NODE_WORDS;
     }
+    names_size = name_offset;
 
-    return err;
+    nodes_offset = 1 + 4 * (HEADER_WORDS + CHUNK_WORDS * CHUNK_COUNT);
+    edges_offset = nodes_offset + 4 + 4 * NODE_WORDS * node_count;
+    names_offset = edges_offset + 4 + 4 * EDGE_WORDS * edge_count;
+    exprs_offset = names_offset + names_size;
+    total_size   = exprs_offset + vec_count(exprs);
+
+    header[0]  = total_size;
+    header[1]  = (uint32_t)node_in;
+    header[2]  = (uint32_t)node_out;
+    header[3]  = CHUNK_COUNT;
+    header[4]  = CHUNK_NODES;
+    header[5]  = nodes_offset;
+    header[6]  = edges_offset - nodes_offset;
+    header[7]  = CHUNK_EDGES;
+    header[8]  = edges_offset;
+    header[9]  = names_offset - edges_offset;
+    header[10] = CHUNK_NAMES;
+    header[11] = names_offset;
+    header[12] = names_size;
+    header[13] = CHUNK_EXPRS;
+    header[14] = exprs_offset;
+    header[15] = vec_count(exprs);
+
+    if (serialize_reserve(ser, total_size) != 0)
+        goto save_failed;
+    serialize_u8(ser, 1); /* version */
+    serialize_lu32_array(ser, header, CSFG_ARRAY_SIZE(header));
+    serialize_lu32(ser, node_count);
+    serialize_lu32_array(ser, records, NODE_WORDS * node_count);
+    serialize_lu32(ser, edge_count);
+    serialize_lu32_array(
+        ser, records + NODE_WORDS * node_count, EDGE_WORDS * edge_count);
+    csfg_graph_for_each_node (graph, n)
+        serialize_data(ser, str_cstr(n->name), str_len(n->name) + 1);
+    if (vec_count(exprs) > 0)
+        serialize_data(ser, vec_data(exprs), vec_count(exprs));
+
+    serializer_deinit(exprs);
+    mem_free(records);
+    return 0;
+
+save_failed:
+    serializer_deinit(exprs);
+    mem_free(records);
+    return -1;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -115,6 +213,246 @@ static int load_0(
     return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+static int find_chunk(
+    const uint32_t* table,
+    int chunk_count,
+    const struct deserializer* blob,
+    uint32_t tag,
+    const char* name,
+    struct deserializer* chunk)
+{
+    int i;
+    for (i = 0; i != chunk_count; ++i)
+    {
+        const uint32_t* entry = table + CHUNK_WORDS * i;
+        if (entry[0] != tag)
+            continue;
+
+        if (entry[1] > (uint32_t)blob->size ||
+            entry[2] > blob->size - entry[1])
+            return log_err("Chunk %s exceeds the size of the data\n", name);
+        *chunk = deserializer(blob->data + entry[1], (int)entry[2]);
+        return 0;
+    }
+
+    return log_err("Missing chunk %s\n", name);
+}
+
+/* -------------------------------------------------------------------------- */
+static uint32_t* read_table(struct deserializer* chunk, int words, int* count)
+{
+    uint32_t* records;
+
+    *count = (int)deserialize_lu32(chunk);
+    if (deserializer_err(chunk) || *count < 0 ||
+        *count > deserializer_bytes_left(chunk) / (4 * words))
+    {
+        log_err("Read implausible record count: %d\n", *count);
+        return NULL;
+    }
+
+    records = mem_alloc(sizeof(*records) * (words * *count + 1));
+    if (records == NULL)
+    {
+        log_oom(sizeof(*records) * (words * *count + 1), "read_table()");
+        return NULL;
+    }
+
+    deserialize_lu32_array(chunk, records, words * *count);
+    return records;
+}
+
+/* -------------------------------------------------------------------------- */
+static int load_1(
+    struct deserializer* des,
+    struct csfg_graph* graph,
+    int* node_in,
+    int* node_out)
+{
+    uint32_t header[HEADER_WORDS];
+    uint32_t table[CHUNK_WORDS * MAX_CHUNKS];
+    struct deserializer blob, nodes_chunk, edges_chunk, names_chunk;
+    struct deserializer exprs_chunk;
+    uint32_t *nodes, *edges;
+    int i, start, chunk_count, node_count, edge_count;
+    uint16_t max_id = 0;
+
+    /* The version byte was already consumed */
+    start = des->read_offset - 1;
+    deserialize_lu32_array(des, header, HEADER_WORDS);
+    if (deserializer_err(des))
+        return log_err("Failed to read header: EOF\n");
+
+    chunk_count = (int)header[3];
+    if (chunk_count < 0 || chunk_count > MAX_CHUNKS)
+        return log_err("Read implausible chunk count: %d\n", chunk_count);
+    deserialize_lu32_array(des, table, CHUNK_WORDS * chunk_count);
+    if (deserializer_err(des))
+        return log_err("Failed to read chunk table: EOF\n");
+
+    if (header[0] < (uint32_t)(des->read_offset - start) ||
+        header[0] > (uint32_t)(des->size - start))
+        return log_err("Graph data is truncated\n");
+    blob             = deserializer(des->data + start, (int)header[0]);
+    des->read_offset = start + (int)header[0];
+
+    *node_in  = (int32_t)header[1];
+    *node_out = (int32_t)header[2];
+
+    if (find_chunk(
+            table, chunk_count, &blob, CHUNK_NODES, "NODE", &nodes_chunk) ||
+        find_chunk(
+            table, chunk_count, &blob, CHUNK_EDGES, "EDGE", &edges_chunk) ||
+        find_chunk(
+            table, chunk_count, &blob, CHUNK_NAMES, "NAME", &names_chunk) ||
+        find_chunk(
+            table, chunk_count, &blob, CHUNK_EXPRS, "EXPR", &exprs_chunk))
+        return -1;
+
+    nodes = read_table(&nodes_chunk, NODE_WORDS, &node_count);
+    if (nodes == NULL)
+        goto read_nodes_failed;
+    edges = read_table(&edges_chunk, EDGE_WORDS, &edge_count);
+    if (edges == NULL)
+        goto read_edges_failed;
+
+    /* Reserve both vectors up front, so the records can be written in place
+     * without going through csfg_graph_add_node()/add_edge(), which search
+     * for a free ID every time */
+    if (csfg_node_vec_realloc(&graph->nodes, node_count) != 0 ||
+        csfg_edge_vec_realloc(&graph->edges, edge_count) != 0)
+        goto fail;
+
+    for (i = 0; i != node_count; ++i)
+    {
+        const uint32_t* record = nodes + NODE_WORDS * i;
+        struct csfg_node* n;
+        struct str* name;
+
+        if (record[3] > (uint32_t)names_chunk.size ||
+            record[4] >= names_chunk.size - record[3])
+        {
+            log_err("Node %d has an invalid name\n", i);
+            goto fail;
+        }
+
+        str_init(&name);
+        if (str_set(&name, names_chunk.data + record[3], record[4]) != 0)
+        {
+            str_deinit(name);
+            goto fail;
+        }
+
+        if (record[0] > CSFG_GRAPH_GC_ID)
+        {
+            log_err("Node %d has an invalid ID\n", i);
+            str_deinit(name);
+            goto fail;
+        }
+
+        n       = csfg_node_vec_emplace_no_realloc(graph->nodes);
+        n->name = name;
+        n->id   = (uint16_t)record[0];
+        n->x    = (int32_t)record[1];
+        n->y    = (int32_t)record[2];
+        if (max_id < n->id && n->id != CSFG_GRAPH_GC_ID)
+            max_id = n->id;
+    }
+
+    for (i = 0; i != edge_count; ++i)
+    {
+        const uint32_t* record = edges + EDGE_WORDS * i;
+        struct deserializer expr_des;
+        struct csfg_expr_pool* pool;
+        struct csfg_edge* e;
+        int expr;
+
+        if (record[0] > CSFG_GRAPH_GC_ID)
+        {
+            log_err("Edge %d has an invalid ID\n", i);
+            goto fail;
+        }
+        if (record[1] >= (uint32_t)node_count ||
+            record[2] >= (uint32_t)node_count)
+        {
+            log_err("Edge %d connects to an invalid node\n", i);
+            goto fail;
+        }
+        if (record[5] > (uint32_t)exprs_chunk.size ||
+            record[6] > exprs_chunk.size - record[5])
+        {
+            log_err("Edge %d has an invalid expression\n", i);
+            goto fail;
+        }
+
+        expr_des = deserializer(exprs_chunk.data + record[5], (int)record[6]);
+        csfg_expr_pool_init(&pool);
+        if (csfg_io_expr_load(&expr_des, &pool, &expr) != 0)
+        {
+            csfg_expr_pool_deinit(pool);
+            goto fail;
+        }
+
+        e             = csfg_edge_vec_emplace_no_realloc(graph->edges);
+        e->pool       = pool;
+        e->expr       = expr;
+        e->id         = (uint16_t)record[0];
+        e->n_idx_from = (int)record[1];
+        e->n_idx_to   = (int)record[2];
+        e->x          = (int32_t)record[3];
+        e->y          = (int32_t)record[4];
+        if (max_id < e->id && e->id != CSFG_GRAPH_GC_ID)
+            max_id = e->id;
+    }
+
+    graph->id_counter = max_id + 1;
+    if (graph->id_counter == CSFG_GRAPH_GC_ID)
+        graph->id_counter++;
+
+    mem_free(edges);
+    mem_free(nodes);
+    return 0;
+
+fail:
+    mem_free(edges);
+read_edges_failed:
+    mem_free(nodes);
+read_nodes_failed:
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+static int check_unique_ids(const struct csfg_graph* graph)
+{
+    const struct csfg_node* n;
+    const struct csfg_edge* e;
+    struct bm* used;
+    int i;
+
+    used = bm_create(CSFG_GRAPH_GC_ID);
+    if (used == NULL)
+        return log_oom(CSFG_GRAPH_GC_ID / 8, "check_unique_ids()");
+
+    /* Elements marked as deleted all share the same ID */
+    csfg_graph_enumerate_nodes (graph, i, n)
+        if (n->id != CSFG_GRAPH_GC_ID && bm_set_and_test(used, n->id))
+            goto node_not_unique;
+    csfg_graph_enumerate_edges (graph, i, e)
+        if (e->id != CSFG_GRAPH_GC_ID && bm_set_and_test(used, e->id))
+            goto edge_not_unique;
+
+    bm_deinit(used);
+    return 0;
+
+node_not_unique:
+    bm_deinit(used);
+    return log_err("Node %d has a duplicate ID: %d\n", i, n->id);
+edge_not_unique:
+    bm_deinit(used);
+    return log_err("Edge %d has a duplicate ID: %d\n", i, e->id);
+}
+
 /* -------------------------------------------------------------------------- */
 int csfg_io_graph_load(
     struct deserializer* des,
@@ -122,6 +460,7 @@ int csfg_io_graph_load(
     int* node_in,
     int* node_out)
 {
+    int result;
     uint8_t version = deserialize_u8(des);
     if (deserializer_err(des))
         return log_err("Failed to read version: EOF\n");
@@ -129,8 +468,62 @@ int csfg_io_graph_load(
     csfg_graph_clear(graph);
     switch (version)
     {
-        case 0x00: return load_0(des, graph, node_in, node_out);
+        case 0x00: result = load_0(des, graph, node_in, node_out); break;
+        case 0x01: result = load_1(des, graph, node_in, node_out); break;
+        default  : return log_err("Unsupported format version: %d\n", version);
     }
 
-    return log_err("Unsupported format version: %d\n", version);
+    /* Both versions store the IDs as they were, so they are only checked once
+     * everything is loaded */
+    if (result == 0)
+        result = check_unique_ids(graph);
+
+    return result;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_io_graph_save_file(
+    const char* filepath,
+    const struct csfg_graph* graph,
+    int node_in,
+    int node_out)
+{
+    struct mfile mf;
+    struct serializer* ser;
+
+    serializer_init(&ser);
+    if (csfg_io_graph_save(&ser, graph, node_in, node_out) != 0)
+        goto save_failed;
+    if (mfile_map_overwrite(&mf, vec_count(ser), filepath) != 0)
+        goto save_failed;
+
+    memcpy(mf.address, ser->data, ser->count);
+    mfile_unmap(&mf);
+    serializer_deinit(ser);
+    return 0;
+
+save_failed:
+    serializer_deinit(ser);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_io_graph_load_file(
+    const char* filepath,
+    struct csfg_graph* graph,
+    int* node_in,
+    int* node_out)
+{
+    struct mfile mf;
+    struct deserializer des;
+    int result;
+
+    if (mfile_map_read(&mf, filepath, 1) != 0)
+        return -1;
+
+    des    = deserializer(mf.address, mf.size);
+    result = csfg_io_graph_load(&des, graph, node_in, node_out);
+
+    mfile_unmap(&mf);
+    return result;
 }
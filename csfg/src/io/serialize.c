@@ -1,17 +1,44 @@
+#include "csfg/config.h"
 #include "csfg/io/serialize.h"
 #include "csfg/util/str.h"
 #include "csfg/util/strlist.h"
 
 VEC_DEFINE(serializer, uint8_t, 32)
 
+/* -------------------------------------------------------------------------- */
+uint8_t* serialize_emplace(struct serializer** ser, int len)
+{
+    uint8_t* p;
+    int count = vec_count(*ser);
+    if (count + len > vec_capacity(*ser))
+    {
+        int capacity = vec_capacity(*ser) ? vec_capacity(*ser) : 32;
+        while (capacity < count + len)
+            capacity *= 2;
+        if (serializer_realloc(ser, capacity) != 0)
+            return NULL;
+    }
+
+    p = vec_data(*ser) + count;
+    (*ser)->count += len;
+    return p;
+}
+
+/* -------------------------------------------------------------------------- */
+int serialize_reserve(struct serializer** ser, int len)
+{
+    if (vec_count(*ser) + len <= vec_capacity(*ser))
+        return 0;
+    return serializer_realloc(ser, vec_count(*ser) + len);
+}
+
 /* -------------------------------------------------------------------------- */
 int serialize_data(struct serializer** ser, const void* data, int len)
 {
-    const uint8_t* p = data;
-    if (serializer_realloc(ser, vec_count(*ser) + len) != 0)
+    uint8_t* p = serialize_emplace(ser, len);
+    if (p == NULL)
         return -1;
-    while (len--)
-        serializer_push(ser, *p++);
+    memcpy(p, data, len);
     return 0;
 }
 
@@ -28,12 +55,18 @@ int serialize_u8(struct serializer** ser, uint8_t value)
 }
 
 /* -------------------------------------------------------------------------- */
+static void put_lu16(uint8_t* p, uint16_t value)
+{
+    p[0] = (value >> 0) & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+}
 int serialize_lu16(struct serializer** ser, uint16_t value)
 {
-    uint8_t data[2];
-    data[0] = (value >> 0) & 0xFF;
-    data[1] = (value >> 8) & 0xFF;
-    return serialize_data(ser, data, 2);
+    uint8_t* p = serialize_emplace(ser, 2);
+    if (p == NULL)
+        return -1;
+    put_lu16(p, value);
+    return 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -43,14 +76,20 @@ int serialize_li16(struct serializer** ser, int16_t value)
 }
 
 /* -------------------------------------------------------------------------- */
+static void put_lu32(uint8_t* p, uint32_t value)
+{
+    p[0] = (value >> 0) & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = (value >> 24) & 0xFF;
+}
 int serialize_lu32(struct serializer** ser, uint32_t value)
 {
-    uint8_t data[4];
-    data[0] = (value >> 0) & 0xFF;
-    data[1] = (value >> 8) & 0xFF;
-    data[2] = (value >> 16) & 0xFF;
-    data[3] = (value >> 24) & 0xFF;
-    return serialize_data(ser, data, 4);
+    uint8_t* p = serialize_emplace(ser, 4);
+    if (p == NULL)
+        return -1;
+    put_lu32(p, value);
+    return 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -67,8 +106,88 @@ int serialize_lf32(struct serializer** ser, float value)
     return serialize_lu32(ser, u32);
 }
 
+/* -------------------------------------------------------------------------- */
+static void put_lu64(uint8_t* p, uint64_t value)
+{
+    put_lu32(p + 0, (uint32_t)(value & 0xFFFFFFFF));
+    put_lu32(p + 4, (uint32_t)(value >> 32));
+}
+int serialize_lf64(struct serializer** ser, double value)
+{
+    uint64_t u64;
+    uint8_t* p = serialize_emplace(ser, 8);
+    if (p == NULL)
+        return -1;
+    memcpy(&u64, &value, 8);
+    put_lu64(p, u64);
+    return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 int serialize_cstr(struct serializer** ser, const char* cstr)
 {
     return serialize_data(ser, cstr, strlen(cstr) + 1);
 }
+
+/* -------------------------------------------------------------------------- */
+/*
+ * The serialized format is little endian, so on little endian machines arrays
+ * can be copied as-is. Big endian machines convert each element.
+ */
+int serialize_lu16_array(
+    struct serializer** ser, const uint16_t* values, int count)
+{
+    uint8_t* p = serialize_emplace(ser, count * 2);
+    if (p == NULL)
+        return -1;
+#if defined(CSFG_BIG_ENDIAN)
+    for (; count--; p += 2)
+        put_lu16(p, *values++);
+#else
+    memcpy(p, values, count * 2);
+#endif
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int serialize_lu32_array(
+    struct serializer** ser, const uint32_t* values, int count)
+{
+    uint8_t* p = serialize_emplace(ser, count * 4);
+    if (p == NULL)
+        return -1;
+#if defined(CSFG_BIG_ENDIAN)
+    for (; count--; p += 4)
+        put_lu32(p, *values++);
+#else
+    memcpy(p, values, count * 4);
+#endif
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int serialize_li32_array(
+    struct serializer** ser, const int32_t* values, int count)
+{
+    return serialize_lu32_array(ser, (const uint32_t*)values, count);
+}
+
+/* -------------------------------------------------------------------------- */
+int serialize_lf64_array(
+    struct serializer** ser, const double* values, int count)
+{
+    uint8_t* p = serialize_emplace(ser, count * 8);
+    if (p == NULL)
+        return -1;
+#if defined(CSFG_BIG_ENDIAN)
+    for (; count--; p += 8)
+    {
+        uint64_t u64;
+        memcpy(&u64, values++, 8);
+        put_lu64(p, u64);
+    }
+#else
+    memcpy(p, values, count * 8);
+#endif
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "csfg/numeric/fft.h"
+
+/* -------------------------------------------------------------------------- */
+static void bit_reverse_permute(struct csfg_complex* data, int n)
+{
+    int i, j = 0;
+    for (i = 1; i < n; ++i)
+    {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+
+        if (i < j)
+        {
+            struct csfg_complex tmp = data[i];
+            data[i]                 = data[j];
+            data[j]                 = tmp;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+static int transform(struct csfg_complex* data, int n, double sign)
+{
+    int len, i, k;
+
+    if (n < 1 || (n & (n - 1)) != 0)
+        return -1;
+
+    bit_reverse_permute(data, n);
+
+    for (len = 2; len <= n; len <<= 1)
+    {
+        double angle = sign * 2.0 * M_PI / len;
+        struct csfg_complex w_len = csfg_complex(cos(angle), sin(angle));
+        for (i = 0; i < n; i += len)
+        {
+            struct csfg_complex w = csfg_complex(1.0, 0.0);
+            for (k = 0; k != len / 2; ++k)
+            {
+                struct csfg_complex u = data[i + k];
+                struct csfg_complex v =
+                    csfg_complex_mul(data[i + k + len / 2], w);
+                data[i + k]           = csfg_complex_add(u, v);
+                data[i + k + len / 2] = csfg_complex_sub(u, v);
+                w                     = csfg_complex_mul(w, w_len);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_fft(struct csfg_complex* data, int n)
+{
+    return transform(data, n, -1.0);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_ifft(struct csfg_complex* data, int n)
+{
+    int i;
+    if (transform(data, n, 1.0) != 0)
+        return -1;
+    for (i = 0; i != n; ++i)
+    {
+        data[i].real /= n;
+        data[i].imag /= n;
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_fft_size(int n)
+{
+    int size = 1;
+    while (size < n)
+        size <<= 1;
+    return size;
+}
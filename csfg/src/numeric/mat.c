@@ -5,7 +5,7 @@
 #include <stddef.h>
 #include <string.h>
 
-VEC_DEFINE(csfg_mat_reorder, int8_t, 8)
+VEC_DEFINE(csfg_mat_reorder, int16_t, 16)
 
 /* -------------------------------------------------------------------------- */
 void csfg_mat_init(struct csfg_mat** mat)
@@ -84,6 +84,7 @@ int csfg_mat_reorder_identity(
     if (csfg_mat_reorder_realloc(reorder, csfg_mat_rows(mat)) != 0)
         return -1;
 
+    csfg_mat_reorder_clear(*reorder);
     for (i = 0; i != csfg_mat_rows(mat); ++i)
         csfg_mat_reorder_push_no_realloc(*reorder, i);
 
@@ -220,13 +221,13 @@ int csfg_mat_mul(
     int r, c, i;
 
     CSFG_DEBUG_ASSERT(csfg_mat_cols(a) == csfg_mat_rows(b));
-    if (csfg_mat_realloc(out, csfg_mat_cols(a), csfg_mat_rows(b)) != 0)
+    if (csfg_mat_realloc(out, csfg_mat_rows(a), csfg_mat_cols(b)) != 0)
         return -1;
 
     csfg_mat_zero(*out);
     for (r = 0; r != csfg_mat_rows(*out); ++r)
         for (c = 0; c != csfg_mat_cols(*out); ++c)
-            for (i = 0; i != csfg_mat_rows(*out); ++i)
+            for (i = 0; i != csfg_mat_cols(a); ++i)
             {
                 struct csfg_complex* entry = csfg_mat_get(*out, r, c);
                 struct csfg_complex  product = csfg_complex_mul(
@@ -0,0 +1,89 @@
+#include "csfg/numeric/mat.h"
+
+/* With a norm of at most 0.5, 18 terms bring the truncation error below
+ * 0.5^18/18! which is far below double precision */
+#define TAYLOR_TERMS 18
+
+/* -------------------------------------------------------------------------- */
+static double norm_inf(const struct csfg_mat* mat)
+{
+    double norm = 0.0;
+    int    r, c;
+    for (r = 0; r != csfg_mat_rows(mat); ++r)
+    {
+        double row = 0.0;
+        for (c = 0; c != csfg_mat_cols(mat); ++c)
+            row += csfg_complex_mag(*csfg_mat_get(mat, r, c));
+        if (!isfinite(row))
+            return row;
+        if (norm < row)
+            norm = row;
+    }
+    return norm;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mat_expm(struct csfg_mat** out, const struct csfg_mat* in)
+{
+    struct csfg_mat *    scaled, *term, *tmp, *swap;
+    struct csfg_complex* c;
+    double               norm;
+    int                  i, k, squarings;
+
+    CSFG_DEBUG_ASSERT(csfg_mat_rows(in) == csfg_mat_cols(in));
+
+    norm = norm_inf(in);
+    if (!isfinite(norm))
+        return -1;
+    for (squarings = 0; norm > 0.5; norm /= 2)
+        squarings++;
+
+    csfg_mat_init(&scaled);
+    csfg_mat_init(&term);
+    csfg_mat_init(&tmp);
+    if (csfg_mat_realloc(&scaled, csfg_mat_rows(in), csfg_mat_cols(in)) != 0 ||
+        csfg_mat_realloc(&term, csfg_mat_rows(in), csfg_mat_cols(in)) != 0 ||
+        csfg_mat_realloc(out, csfg_mat_rows(in), csfg_mat_cols(in)) != 0)
+        goto fail;
+
+    csfg_mat_copy(scaled, in);
+    csfg_mat_for_each (scaled, c)
+    {
+        c->real = ldexp(c->real, -squarings);
+        c->imag = ldexp(c->imag, -squarings);
+    }
+
+    /* e^M = I + M + M^2/2! + M^3/3! + ... */
+    csfg_mat_identity(term);
+    csfg_mat_identity(*out);
+    for (k = 1; k != TAYLOR_TERMS; ++k)
+    {
+        if (csfg_mat_mul(&tmp, term, scaled) != 0)
+            goto fail;
+        swap = term, term = tmp, tmp = swap;
+        for (i = 0; i != csfg_mat_rows(in) * csfg_mat_cols(in); ++i)
+        {
+            term->data[i].real /= k;
+            term->data[i].imag /= k;
+            (*out)->data[i] = csfg_complex_add((*out)->data[i], term->data[i]);
+        }
+    }
+
+    for (; squarings > 0; --squarings)
+    {
+        if (csfg_mat_mul(&tmp, *out, *out) != 0)
+            goto fail;
+        csfg_mat_copy(*out, tmp);
+    }
+
+    csfg_mat_deinit(tmp);
+    csfg_mat_deinit(term);
+    csfg_mat_deinit(scaled);
+    return 0;
+
+fail:
+    csfg_mat_deinit(tmp);
+    csfg_mat_deinit(term);
+    csfg_mat_deinit(scaled);
+    return -1;
+}
@@ -1,24 +1,166 @@
 #include "csfg/numeric/mat.h"
+#include "csfg/util/mem.h"
+#include <math.h>
+
+/* Number of columns factored together in one panel. The rows of a panel and
+ * of the block of U next to it stay in cache while the rest of the matrix is
+ * updated. */
+#define BLOCK 32
+
+/*
+ * The matrix is factored in split form: the real and imaginary parts are
+ * stored in two separate row-major arrays. The inner loops then run over
+ * contiguous doubles, which the compiler can vectorize, instead of over
+ * interleaved complex numbers.
+ */
+struct split
+{
+    double* re;
+    double* im;
+    int     n;
+};
+
+/* -------------------------------------------------------------------------- */
+/* y -= s*x on "count" complex values */
+static void row_sub_scaled(
+    double*       yr,
+    double*       yi,
+    const double* xr,
+    const double* xi,
+    double        sr,
+    double        si,
+    int           count)
+{
+    int j;
+    for (j = 0; j < count; ++j)
+    {
+        double r = xr[j];
+        double i = xi[j];
+        yr[j] -= sr * r - si * i;
+        yi[j] -= sr * i + si * r;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+static void swap_rows(
+    struct split* A, struct csfg_mat_reorder* reorder, int r1, int r2)
+{
+    double* r1r = A->re + r1 * A->n;
+    double* r1i = A->im + r1 * A->n;
+    double* r2r = A->re + r2 * A->n;
+    double* r2i = A->im + r2 * A->n;
+    int     j, tmp_idx;
+
+    for (j = 0; j != A->n; ++j)
+    {
+        double tr = r1r[j], ti = r1i[j];
+        r1r[j] = r2r[j], r1i[j] = r2i[j];
+        r2r[j] = tr, r2i[j] = ti;
+    }
+
+    tmp_idx               = *vec_get(reorder, r1);
+    *vec_get(reorder, r1) = *vec_get(reorder, r2);
+    *vec_get(reorder, r2) = tmp_idx;
+}
 
 /* -------------------------------------------------------------------------- */
-static int
-reorder_rows_if_necessary(struct csfg_mat* M, struct csfg_mat_reorder* reorder)
+/* Returns the row at or below "k" with the largest magnitude in column "k",
+ * or -1 if the column is zero. hypot() is used, because squaring underflows
+ * for entries below 1e-154, which do occur in large graphs. */
+static int find_pivot(const struct split* A, int k)
 {
-    int i, r;
-    for (i = 0; i != csfg_mat_rows(M); ++i)
+    double max = 0.0;
+    int    i, pivot = -1;
+
+    for (i = k; i != A->n; ++i)
     {
-        if (fabs(csfg_mat_get(M, i, i)->real) > 1e-6)
-            continue;
+        double re  = A->re[i * A->n + k];
+        double im  = A->im[i * A->n + k];
+        double mag = hypot(re, im);
+        if (max < mag)
+        {
+            max   = mag;
+            pivot = i;
+        }
+    }
 
-        for (r = i + 1; r < csfg_mat_rows(M); ++r)
-            if (fabs(csfg_mat_get(M, r, i)->real) > 1e-6)
+    return pivot;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Right-looking blocked LU decomposition with partial pivoting. For each
+ * panel of BLOCK columns:
+ *
+ *   [A11 A12]   [L11    ] [U11 U12]
+ *   [A21 A22] = [L21  I ] [     S ]
+ *
+ * 1) The panel [A11; A21] is factored column by column, choosing the row
+ *    with the largest magnitude as the pivot. Swaps are applied to whole
+ *    rows.
+ * 2) U12 = L11^-1 * A12
+ * 3) S = A22 - L21 * U12, which is factored by the next panels.
+ *
+ * L (without its unit diagonal) and U overwrite A.
+ */
+static int factor(struct split* A, struct csfg_mat_reorder* reorder)
+{
+    int n = A->n;
+    int k0, kb, k, i, p, end, cols;
+
+    for (k0 = 0; k0 < n; k0 += BLOCK)
+    {
+        kb  = n - k0 < BLOCK ? n - k0 : BLOCK;
+        end = k0 + kb;
+
+        for (k = k0; k != end; ++k)
+        {
+            const double*       ukr = A->re + k * n;
+            const double*       uki = A->im + k * n;
+            struct csfg_complex pivot;
+
+            p = find_pivot(A, k);
+            if (p < 0)
+                return -1;
+            if (p != k)
+                swap_rows(A, reorder, k, p);
+
+            /* The multipliers are only computed O(n^2) times, so they use a
+             * proper division rather than a reciprocal */
+            pivot = csfg_complex(ukr[k], uki[k]);
+            for (i = k + 1; i < n; ++i)
             {
-                csfg_mat_swap_rows(M, reorder, i, r);
-                break;
+                double*             rr = A->re + i * n;
+                double*             ri = A->im + i * n;
+                struct csfg_complex l  = csfg_complex_div(
+                    csfg_complex(rr[k], ri[k]), pivot);
+                rr[k] = l.real;
+                ri[k] = l.imag;
+                row_sub_scaled(
+                    rr + k + 1, ri + k + 1, ukr + k + 1, uki + k + 1, l.real,
+                    l.imag, end - k - 1);
             }
-        if (r >= csfg_mat_rows(M))
-            return -1;
+        }
+
+        cols = n - end;
+        if (cols == 0)
+            break;
+
+        for (k = k0; k != end; ++k)
+            for (i = k + 1; i != end; ++i)
+                row_sub_scaled(
+                    A->re + i * n + end, A->im + i * n + end,
+                    A->re + k * n + end, A->im + k * n + end,
+                    A->re[i * n + k], A->im[i * n + k], cols);
+
+        for (i = end; i != n; ++i)
+            for (k = k0; k != end; ++k)
+                row_sub_scaled(
+                    A->re + i * n + end, A->im + i * n + end,
+                    A->re + k * n + end, A->im + k * n + end,
+                    A->re[i * n + k], A->im[i * n + k], cols);
     }
+
     return 0;
 }
 
@@ -29,34 +171,47 @@ int csfg_mat_lu_decomposition(
     struct csfg_mat_reorder** reorder,
     const struct csfg_mat*    input)
 {
-    struct csfg_mat *L, *U;
-    int              i, j;
+    struct split A;
+    int          n = csfg_mat_rows(input);
+    int          r, c, result;
 
-    if (csfg_mat_realloc(Lp, csfg_mat_rows(input), csfg_mat_cols(input)) != 0 ||
-        csfg_mat_realloc(Up, csfg_mat_rows(input), csfg_mat_cols(input)) != 0 ||
+    CSFG_DEBUG_ASSERT(csfg_mat_rows(input) == csfg_mat_cols(input));
+
+    if (csfg_mat_realloc(Lp, n, n) != 0 || csfg_mat_realloc(Up, n, n) != 0 ||
         csfg_mat_reorder_identity(reorder, input) != 0)
     {
         return -1;
     }
-    L = *Lp;
-    U = *Up;
-
-    csfg_mat_identity(L);
-    csfg_mat_copy(U, input);
+    if (n == 0)
+        return 0;
 
-    if (reorder_rows_if_necessary(U, *reorder) != 0)
+    A.n  = n;
+    A.re = mem_alloc((int)sizeof(double) * n * n * 2);
+    if (A.re == NULL)
         return -1;
+    A.im = A.re + n * n;
 
-    for (i = 0; i != csfg_mat_rows(U); ++i)
-        for (j = i + 1; j < csfg_mat_rows(U); ++j)
+    for (r = 0; r != n; ++r)
+        for (c = 0; c != n; ++c)
         {
-            struct csfg_complex c0, c1, factor;
-            c0 = *csfg_mat_get(U, i, i);
-            c1 = *csfg_mat_get(U, j, i);
-            factor = csfg_complex_div(c1, c0);
-            csfg_mat_r1_sub_r2_mul_s_store_r1(U, j, i, factor);
-            *csfg_mat_get(L, j, i) = factor;
+            A.re[r * n + c] = csfg_mat_get(input, r, c)->real;
+            A.im[r * n + c] = csfg_mat_get(input, r, c)->imag;
         }
 
-    return 0;
+    result = factor(&A, *reorder);
+
+    if (result == 0)
+        for (r = 0; r != n; ++r)
+            for (c = 0; c != n; ++c)
+            {
+                struct csfg_complex v = csfg_complex(
+                    A.re[r * n + c], A.im[r * n + c]);
+                struct csfg_complex zero = csfg_complex(0, 0);
+                struct csfg_complex one  = csfg_complex(1, 0);
+                *csfg_mat_get(*Lp, r, c) = c < r ? v : c == r ? one : zero;
+                *csfg_mat_get(*Up, r, c) = c < r ? zero : v;
+            }
+
+    mem_free(A.re);
+    return result;
 }
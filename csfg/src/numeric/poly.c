@@ -1,10 +1,12 @@
 #include "csfg/numeric/poly.h"
 #include "csfg/symbolic/expr.h"
 #include "csfg/symbolic/poly_expr.h"
+#include "csfg/symbolic/var_table.h"
+#include "csfg/util/mem.h"
 
-VEC_DEFINE(csfg_cpoly, struct csfg_complex, 8)
-VEC_DEFINE(csfg_rpoly, struct csfg_complex, 8)
-VEC_DEFINE(csfg_pfd_poly, struct csfg_pfd, 8)
+VEC_DEFINE(csfg_cpoly, struct csfg_complex, 16)
+VEC_DEFINE(csfg_rpoly, struct csfg_complex, 16)
+VEC_DEFINE(csfg_pfd_poly, struct csfg_pfd, 16)
 
 /* -------------------------------------------------------------------------- */
 int csfg_cpoly_from_symbolic(
@@ -14,19 +16,27 @@ int csfg_cpoly_from_symbolic(
     const struct csfg_poly_expr* symbolic)
 {
     const struct csfg_coeff_expr* coeff;
+    double* values;
+    int count;
 
     csfg_cpoly_clear(*poly);
     if (csfg_cpoly_realloc(poly, vec_count(symbolic)) != 0)
         return -1;
 
+    /* Evaluate each parameter once instead of once per occurrence */
+    count = csfg_var_table_eval_symbols(vt, &values);
+    if (count < 0)
+        return -1;
+
     vec_for_each (symbolic, coeff)
     {
         double value = coeff->factor;
         if (coeff->expr > -1)
-            value *= csfg_expr_eval(pool, coeff->expr, vt);
+            value *= csfg_expr_eval_symbols(pool, coeff->expr, values, count);
         csfg_cpoly_push(poly, csfg_complex(value, 0.0));
     }
 
+    mem_free(values);
     return 0;
 }
 
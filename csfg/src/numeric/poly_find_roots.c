@@ -1,15 +1,8 @@
 #include "csfg/numeric/poly.h"
 #include <math.h>
-#include <stdlib.h>
 
 static const double EPSILON = 1e-15;
 
-/* -------------------------------------------------------------------------- */
-static double rand_float(void)
-{
-    return (double)rand() / RAND_MAX;
-}
-
 /* -------------------------------------------------------------------------- */
 static int near(double a, double b, double c, double d, double tol)
 {
@@ -94,25 +87,13 @@ calc_numerator(const struct csfg_cpoly* coeffs, struct csfg_complex root)
 static struct csfg_complex
 calc_reciprocal(struct csfg_complex num, struct csfg_complex den)
 {
-    double k1, k2, k3;
-
-    k1 = den.real * den.real + den.imag * den.imag;
-    if (fabs(k1) > EPSILON)
-    {
-        den.real /= k1;
-        den.imag /= -k1;
-    }
-    else
-    {
-        den.real = 1.0;
-        den.imag = 0.0;
-    }
-
-    k1 = num.real * (den.real + den.imag);
-    k2 = den.real * (num.imag - num.real);
-    k3 = den.imag * (num.real + num.imag);
+    /* The denominator is a product of n-1 root distances, which drops far
+     * below EPSILON for high degrees even though the roots are still distinct.
+     * Only skip the division if two guesses coincide. */
+    if (den.real == 0.0 && den.imag == 0.0)
+        return num;
 
-    return csfg_complex(k1 - k3, k1 + k2);
+    return csfg_complex_div(num, den);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -254,16 +235,19 @@ int csfg_cpoly_find_roots(
     /* Pick default initial guess if unspecified */
     if (vec_count(*roots) == 0)
     {
-        double t, c, r;
-        if (csfg_rpoly_realloc(roots, vec_count(coeffs) - 1) != 0)
+        double a, r;
+        int    n = vec_count(coeffs) - 1;
+        if (csfg_rpoly_realloc(roots, n) != 0)
             return -1;
 
+        /* Evenly spaced on a circle enclosing all roots, starting in the left
+         * half plane. The odd offset keeps the guesses off the real axis and
+         * away from symmetric roots. */
         r = bound(coeffs);
-        for (i = 0; i < vec_count(coeffs) - 1; ++i)
+        for (i = 0; i < n; ++i)
         {
-            t = rand_float() * r;
-            c = cos(rand_float() * 2.0 * M_PI);
-            csfg_rpoly_push(roots, csfg_complex(t * c, t * sqrt(1.0 - c * c)));
+            a = 2.0 * M_PI * i / n + M_PI / 2.0 + 0.4;
+            csfg_rpoly_push(roots, csfg_complex(r * cos(a), r * sin(a)));
         }
     }
 
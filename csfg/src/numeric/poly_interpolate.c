@@ -0,0 +1,60 @@
+#include "csfg/numeric/fft.h"
+#include "csfg/numeric/poly.h"
+#include "csfg/util/log.h"
+
+/* -------------------------------------------------------------------------- */
+int csfg_cpoly_interpolate_circle(
+    struct csfg_cpoly** poly,
+    struct csfg_complex* samples,
+    int n,
+    double radius,
+    double phase)
+{
+    int j, count;
+    double max_mag = 0.0;
+
+    /*
+     * With w = exp(2*pi*i/n) the samples are
+     *
+     *   p(s_k) = sum_j c_j * (radius * exp(i*phase))^j * w^(j*k)
+     *
+     * which is an (unnormalized) inverse DFT of the scaled coefficients.
+     */
+    if (n > CSFG_CPOLY_MAX_COEFFS)
+        return log_err(
+            "Can't interpolate %d coefficients, at most %d are supported\n",
+            n,
+            CSFG_CPOLY_MAX_COEFFS);
+    if (csfg_fft(samples, n) != 0)
+        return -1;
+
+    for (j = 0; j != n; ++j)
+    {
+        double scale = n * pow(radius, j);
+        struct csfg_complex c = csfg_complex_div(
+            samples[j],
+            csfg_complex(scale * cos(j * phase), scale * sin(j * phase)));
+
+        /* The coefficients of a real system are real */
+        samples[j] = csfg_complex(c.real, 0.0);
+        if (max_mag < fabs(c.real) * pow(radius, j))
+            max_mag = fabs(c.real) * pow(radius, j);
+    }
+
+    /* Coefficients that are negligible compared to the rest of the polynomial
+     * are numerical noise */
+    for (count = n; count > 1; --count)
+        if (fabs(samples[count - 1].real) * pow(radius, count - 1)
+            >= max_mag * 1e-9)
+        {
+            break;
+        }
+
+    csfg_cpoly_clear(*poly);
+    if (csfg_cpoly_realloc(poly, count) != 0)
+        return -1;
+    for (j = 0; j != count; ++j)
+        csfg_cpoly_push(poly, samples[j]);
+
+    return 0;
+}
@@ -1,5 +1,6 @@
-#include "csfg/numeric/mat.h"
 #include "csfg/numeric/poly.h"
+#include "csfg/util/log.h"
+#include "csfg/util/mem.h"
 
 /* -------------------------------------------------------------------------- */
 static int push_unique_roots(
@@ -52,60 +53,82 @@ static int push_repeated_roots(struct csfg_pfd_poly** pfd_terms)
 }
 
 /* -------------------------------------------------------------------------- */
-static void expand_term(
-    struct csfg_mat* mat, const struct csfg_pfd_poly* pfd_terms, int term_idx)
+/*
+ * Computes the first "m" Taylor coefficients of the numerator at "p",
+ *
+ *   N(p+h) = c0 + c1*h + c2*h^2 + ...
+ *
+ * by repeated synthetic division. "tmp" must hold as many values as the
+ * numerator has coefficients.
+ */
+static void taylor_shift(
+    struct csfg_complex*     c,
+    struct csfg_complex*     tmp,
+    const struct csfg_cpoly* numerator,
+    struct csfg_complex      p,
+    int                      m)
 {
-    int                    i, c, coeffs;
-    const struct csfg_pfd *term, *my_term;
-
-    CSFG_DEBUG_ASSERT(vec_count(pfd_terms) >= 2);
+    int d = vec_count(numerator) - 1;
+    int i, k;
 
-    coeffs = 0;
-    my_term = vec_get(pfd_terms, term_idx);
-    vec_enumerate (pfd_terms, i, term)
+    for (i = 0; i <= d; ++i)
+        tmp[i] = *vec_get(numerator, i);
+    for (k = 0; k != m; ++k)
     {
-        if (i == term_idx)
-            continue;
-
-        if (coeffs == 0)
-            *csfg_mat_get(mat, coeffs++, term_idx) = csfg_complex_neg(term->p);
-
-        if (csfg_complex_eq(my_term->p, term->p))
-            if (my_term->n >= term->n)
-                continue;
-
-        if (coeffs == 1)
-        {
-            *csfg_mat_get(mat, coeffs++, term_idx) = csfg_complex(1, 0);
-            continue;
-        }
-
-        *csfg_mat_get(mat, coeffs, term_idx) =
-            *csfg_mat_get(mat, coeffs - 1, term_idx);
-        coeffs++;
-
-        for (c = coeffs - 2; c >= 1; --c)
-        {
-            struct csfg_complex c0 = *csfg_mat_get(mat, c - 1, term_idx);
-            struct csfg_complex c1 = *csfg_mat_get(mat, c, term_idx);
-            *csfg_mat_get(mat, c, term_idx) =
-                csfg_complex_sub(c0, csfg_complex_mul(c1, term->p));
-        }
-        *csfg_mat_get(mat, 0, term_idx) = csfg_complex_neg(
-            csfg_complex_mul(*csfg_mat_get(mat, 0, term_idx), term->p));
+        for (i = d - 1; i >= k; --i)
+            tmp[i] = csfg_complex_add(tmp[i], csfg_complex_mul(p, tmp[i + 1]));
+        c[k] = k <= d ? tmp[k] : csfg_complex(0, 0);
     }
 }
 
 /* -------------------------------------------------------------------------- */
+/*
+ * Divides the truncated series c(h) by (h + a) in-place, i.e. solves
+ * (h + a) * y(h) = c(h) for the first "m" coefficients of y.
+ */
 static void
-populate_matrix(struct csfg_mat* mat, const struct csfg_pfd_poly* pfd_terms)
+series_div_linear(struct csfg_complex* c, struct csfg_complex a, int m)
 {
-    int                    c;
-    const struct csfg_pfd* term;
+    int k;
+    c[0] = csfg_complex_div(c[0], a);
+    for (k = 1; k < m; ++k)
+        c[k] = csfg_complex_div(csfg_complex_sub(c[k], c[k - 1]), a);
+}
 
-    csfg_mat_zero(mat);
-    vec_enumerate (pfd_terms, c, term)
-        (void)term, expand_term(mat, pfd_terms, c);
+/* -------------------------------------------------------------------------- */
+/*
+ * Computes the residues of all terms belonging to the pole "p" with
+ * multiplicity "m". Writing the rest of the function as
+ *
+ *                N(s)
+ *   g(s) = ---------------   so that   T(s) = g(s) / (s-p)^m
+ *          prod (s-q)^n(q)
+ *
+ * the coefficient of 1/(s-p)^(m-k) is the k-th Taylor coefficient of g at p,
+ * g^(k)(p)/k!. For simple poles this is just N(p)/D'(p). The series of g is
+ * obtained from the Taylor series of N by dividing by (h + p - q) once for
+ * each other pole q, which costs O(m) per pole.
+ */
+static void residues(
+    struct csfg_complex*        c,
+    struct csfg_complex*        tmp,
+    const struct csfg_cpoly*    numerator,
+    const struct csfg_pfd_poly* pfd_terms,
+    int                         unique_count,
+    const struct csfg_pfd*      pole)
+{
+    const struct csfg_pfd* other;
+    int                    i, j;
+
+    taylor_shift(c, tmp, numerator, pole->p, pole->n);
+    for (i = 0; i != unique_count; ++i)
+    {
+        other = vec_get(pfd_terms, i);
+        if (other == pole)
+            continue;
+        for (j = 0; j != other->n; ++j)
+            series_div_linear(c, csfg_complex_sub(pole->p, other->p), pole->n);
+    }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -123,15 +146,9 @@ int csfg_rpoly_partial_fraction_decomposition(
     const struct csfg_cpoly* numerator,
     const struct csfg_rpoly* denominator)
 {
-    struct csfg_mat *        in, *out, *L, *U;
-    struct csfg_mat_reorder* reorder;
-    int                      pfd_term_count, i;
-
-    csfg_mat_init(&in);
-    csfg_mat_init(&out);
-    csfg_mat_init(&L);
-    csfg_mat_init(&U);
-    csfg_mat_reorder_init(&reorder);
+    struct csfg_complex* c;
+    struct csfg_pfd*     term;
+    int                  unique_count, i, j;
 
     csfg_pfd_poly_clear(*pfd_terms);
     if (vec_count(numerator) >= vec_count(denominator) + 1)
@@ -140,56 +157,104 @@ int csfg_rpoly_partial_fraction_decomposition(
             "currently not supported\n");
 
     if (push_unique_roots(pfd_terms, denominator) != 0)
-        goto fail;
+        return -1;
+    unique_count = vec_count(*pfd_terms);
     if (push_repeated_roots(pfd_terms) != 0)
-        goto fail;
+        return -1;
 
-    if (vec_count(*pfd_terms) == 1)
+    /* Room for the series of the highest multiplicity, and for a copy of the
+     * numerator */
+    c = mem_alloc(
+        (int)sizeof(*c) * (vec_count(denominator) + vec_count(numerator) + 1));
+    if (c == NULL)
+        return -1;
+
+    for (i = 0; i != unique_count; ++i)
     {
+        const struct csfg_pfd* pole = vec_get(*pfd_terms, i);
         if (vec_count(numerator) == 0)
-            vec_first(*pfd_terms)->A = csfg_complex(0, 0);
-        else
-            vec_first(*pfd_terms)->A = *vec_first(numerator);
-    }
-    else
-    {
-        pfd_term_count = vec_count(*pfd_terms);
-        if (csfg_mat_realloc(&in, pfd_term_count, pfd_term_count) != 0)
-            goto fail;
-
-        populate_matrix(in, *pfd_terms);
-        if (csfg_mat_lu_decomposition(&L, &U, &reorder, in) != 0)
-            goto fail;
-
-        if (csfg_mat_realloc(&in, pfd_term_count, 1) != 0 ||
-            csfg_mat_realloc(&out, pfd_term_count, 1) != 0)
-            goto fail;
-        for (i = 0; i != pfd_term_count; ++i)
         {
-            struct csfg_complex value = i < vec_count(numerator)
-                                            ? *vec_get(numerator, i)
-                                            : csfg_complex(0, 0);
-            *csfg_mat_get(in, i, 0) = value;
+            for (j = 0; j != pole->n; ++j)
+                c[j] = csfg_complex(0, 0);
         }
-        csfg_mat_solve_linear_lu(out, in, L, U, reorder);
-        for (i = 0; i != pfd_term_count; ++i)
-            vec_get(*pfd_terms, i)->A = *csfg_mat_get(out, i, 0);
+        else
+            residues(
+                c, c + pole->n, numerator, *pfd_terms, unique_count, pole);
+
+        /* Term i has the full multiplicity. Terms with lower powers of the
+         * same pole were appended by push_repeated_roots() */
+        vec_for_each (*pfd_terms, term)
+            if (csfg_complex_eq(term->p, pole->p))
+                term->A = c[pole->n - term->n];
     }
 
+    mem_free(c);
     csfg_pfd_poly_retain(*pfd_terms, eliminate_zero_terms, NULL);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static int add_term(
+    struct csfg_pfd_poly** pfd_terms,
+    struct csfg_complex    A,
+    struct csfg_complex    p,
+    int                    n)
+{
+    struct csfg_pfd* term;
+
+    vec_for_each (*pfd_terms, term)
+        if (term->n == n && csfg_complex_eq(term->p, p))
+        {
+            term->A = csfg_complex_add(term->A, A);
+            return 0;
+        }
 
-    csfg_mat_reorder_deinit(reorder);
-    csfg_mat_deinit(U);
-    csfg_mat_deinit(L);
-    csfg_mat_deinit(out);
-    csfg_mat_deinit(in);
+    term = csfg_pfd_poly_emplace(pfd_terms);
+    if (term == NULL)
+        return -1;
+    term->A = A;
+    term->p = p;
+    term->n = n;
     return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_pfd_poly_div_s(
+    struct csfg_pfd_poly** out, const struct csfg_pfd_poly* in)
+{
+    const struct csfg_pfd* term;
+    struct csfg_complex    zero = csfg_complex(0, 0);
 
-fail:
-    csfg_mat_reorder_deinit(reorder);
-    csfg_mat_deinit(U);
-    csfg_mat_deinit(L);
-    csfg_mat_deinit(out);
-    csfg_mat_deinit(in);
-    return -1;
+    csfg_pfd_poly_clear(*out);
+    vec_for_each (in, term)
+    {
+        struct csfg_complex inv_p, coeff;
+        int                 k;
+
+        if (csfg_complex_eq(term->p, zero))
+        {
+            if (add_term(out, term->A, zero, term->n + 1) != 0)
+                return -1;
+            continue;
+        }
+
+        /*
+         *      A         A*(-1)^n     n      A*(-1)^(n-k)
+         * ---------- = ---------- + sum  --------------------
+         * s*(s-p)^n      s*p^n      k=1  p^(n-k+1) * (s-p)^k
+         */
+        inv_p = csfg_complex_div(csfg_complex(1, 0), term->p);
+        coeff = csfg_complex_mul(term->A, inv_p);
+        for (k = term->n; k >= 1; --k)
+        {
+            if (add_term(out, coeff, term->p, k) != 0)
+                return -1;
+            coeff = csfg_complex_neg(csfg_complex_mul(coeff, inv_p));
+        }
+        if (add_term(out, csfg_complex_mul(coeff, term->p), zero, 1) != 0)
+            return -1;
+    }
+
+    csfg_pfd_poly_retain(*out, eliminate_zero_terms, NULL);
+    return 0;
 }
@@ -0,0 +1,176 @@
+#include "csfg/numeric/pyramid.h"
+#include "csfg/util/log.h"
+#include "csfg/util/mem.h"
+#include <math.h>
+
+/* -------------------------------------------------------------------------- */
+static void set_empty(struct csfg_minmax* b)
+{
+    b->min = HUGE_VAL;
+    b->max = -HUGE_VAL;
+}
+
+/* -------------------------------------------------------------------------- */
+static void include_value(struct csfg_minmax* b, double y)
+{
+    if (b->min > y)
+        b->min = y;
+    if (b->max < y)
+        b->max = y;
+}
+
+/* -------------------------------------------------------------------------- */
+static void include_range(struct csfg_minmax* b, const struct csfg_minmax* r)
+{
+    if (b->min > r->min)
+        b->min = r->min;
+    if (b->max < r->max)
+        b->max = r->max;
+}
+
+/* -------------------------------------------------------------------------- */
+static int clamp_index(double i, int count)
+{
+    if (i < 0.0)
+        return 0;
+    if (i > count - 1)
+        return count - 1;
+    return (int)i;
+}
+
+/* -------------------------------------------------------------------------- */
+void csfg_pyramid_init(struct csfg_pyramid* pyr)
+{
+    pyr->data    = NULL;
+    pyr->levels  = 0;
+    pyr->x_start = 0.0;
+    pyr->x_end   = 0.0;
+}
+
+/* -------------------------------------------------------------------------- */
+void csfg_pyramid_deinit(struct csfg_pyramid* pyr)
+{
+    if (pyr->data != NULL)
+        mem_free(pyr->data);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_pyramid_build(
+    struct csfg_pyramid* pyr,
+    const double*        x,
+    const double*        y,
+    int                  n,
+    int                  buckets)
+{
+    struct csfg_minmax* data;
+    struct csfg_minmax* level;
+    double              width;
+    int                 size, total, i, j, k, l;
+
+    if (n < 2 || !(x[n - 1] > x[0]) || buckets < 1)
+        return -1;
+
+    for (size = 1, l = 1; size < buckets && l < CSFG_PYRAMID_MAX_LEVELS;
+         size <<= 1)
+        l++;
+    total = 2 * size - 1;
+
+    data = mem_realloc(pyr->data, (int)sizeof(*data) * total);
+    if (data == NULL)
+        return log_oom((int)sizeof(*data) * total, "csfg_pyramid_build()");
+    pyr->data    = data;
+    pyr->levels  = l;
+    pyr->x_start = x[0];
+    pyr->x_end   = x[n - 1];
+
+    for (i = 0, j = 0; i != l; ++i)
+    {
+        pyr->offset[i] = j;
+        pyr->count[i]  = size >> i;
+        j += size >> i;
+    }
+
+    for (i = 0; i != size; ++i)
+        set_empty(&data[i]);
+
+    /* Clip every segment to the buckets it passes through */
+    width = (pyr->x_end - pyr->x_start) / size;
+    for (k = 0; k != n - 1; ++k)
+    {
+        double x0 = x[k], x1 = x[k + 1];
+        double y0 = y[k], y1 = y[k + 1];
+        int    first, last;
+        if (!isfinite(y0) || !isfinite(y1) || !(x1 > x0))
+            continue;
+
+        first = clamp_index(floor((x0 - pyr->x_start) / width), size);
+        last  = clamp_index(floor((x1 - pyr->x_start) / width), size);
+        for (i = first; i <= last; ++i)
+        {
+            double a = pyr->x_start + i * width;
+            double b = a + width;
+            if (a < x0)
+                a = x0;
+            if (b > x1)
+                b = x1;
+            include_value(&data[i], y0 + (y1 - y0) * (a - x0) / (x1 - x0));
+            include_value(&data[i], y0 + (y1 - y0) * (b - x0) / (x1 - x0));
+        }
+    }
+
+    for (i = 1; i != l; ++i)
+    {
+        level = data + pyr->offset[i];
+        for (j = 0; j != pyr->count[i]; ++j)
+        {
+            level[j] = data[pyr->offset[i - 1] + 2 * j];
+            include_range(&level[j], &data[pyr->offset[i - 1] + 2 * j + 1]);
+        }
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void csfg_pyramid_query(
+    const struct csfg_pyramid* pyr,
+    double                     x_start,
+    double                     x_end,
+    struct csfg_minmax*        out,
+    int                        n)
+{
+    const struct csfg_minmax* level;
+    double                    step, width;
+    int                       b, i, l, level_count;
+
+    if (pyr->levels == 0)
+    {
+        for (b = 0; b < n; ++b)
+            set_empty(&out[b]);
+        return;
+    }
+
+    /* Pick the coarsest level that still resolves the requested buckets */
+    step  = (x_end - x_start) / n;
+    width = (pyr->x_end - pyr->x_start) / pyr->count[0];
+    for (l = 0; l + 1 < pyr->levels && width * 2 <= step; ++l)
+        width *= 2;
+    level       = pyr->data + pyr->offset[l];
+    level_count = pyr->count[l];
+
+    for (b = 0; b < n; ++b)
+    {
+        double a = x_start + b * step;
+        double e = a + step;
+        int    first, last;
+
+        set_empty(&out[b]);
+        if (e <= pyr->x_start || a >= pyr->x_end)
+            continue;
+
+        first = clamp_index(floor((a - pyr->x_start) / width), level_count);
+        last  = clamp_index(ceil((e - pyr->x_start) / width) - 1, level_count);
+        for (i = first; i <= last; ++i)
+            include_range(&out[b], &level[i]);
+    }
+}
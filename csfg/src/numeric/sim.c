@@ -0,0 +1,590 @@
+#include "csfg/numeric/sim.h"
+#include "csfg/numeric/ss.h"
+#include "csfg/numeric/tf.h"
+#include "csfg/util/log.h"
+#include "csfg/util/mem.h"
+#include <math.h>
+
+VEC_DEFINE(csfg_biquad_vec, struct csfg_biquad, 16)
+
+/* -------------------------------------------------------------------------- */
+static void bilinear(
+    struct csfg_biquad* q,
+    const double*       b,
+    const double*       a,
+    int                 order,
+    double              dt)
+{
+    double k = 2.0 / dt;
+    double a0;
+
+    if (order == 1)
+    {
+        a0    = a[0] + a[1] * k;
+        q->b0 = (b[0] + b[1] * k) / a0;
+        q->b1 = (b[0] - b[1] * k) / a0;
+        q->b2 = 0.0;
+        q->a1 = (a[0] - a[1] * k) / a0;
+        q->a2 = 0.0;
+        return;
+    }
+
+    a0    = a[0] + a[1] * k + a[2] * k * k;
+    q->b0 = (b[0] + b[1] * k + b[2] * k * k) / a0;
+    q->b1 = (2 * b[0] - 2 * b[2] * k * k) / a0;
+    q->b2 = (b[0] - b[1] * k + b[2] * k * k) / a0;
+    q->a1 = (2 * a[0] - 2 * a[2] * k * k) / a0;
+    q->a2 = (a[0] - a[1] * k + a[2] * k * k) / a0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Realizes the cascade of continuous sections as a single system. Each
+ * section is in controllable canonical form and is driven by the output of
+ * the previous one, so A is block lower triangular with the sections on its
+ * diagonal.
+ */
+static int
+realize_cascade(struct csfg_ss* ss, const struct csfg_sos_vec* sections)
+{
+    const struct csfg_sos* sos;
+    double                 d = 1.0;
+    int                    i, n = 0, offset = 0;
+
+    vec_for_each (sections, sos)
+        n += sos->a[2] != 0.0 ? 2 : 1;
+
+    if (csfg_mat_realloc(&ss->A, n, n) != 0 ||
+        csfg_mat_realloc(&ss->B, n, 1) != 0 ||
+        csfg_mat_realloc(&ss->C, 1, n) != 0 ||
+        csfg_mat_realloc(&ss->D, 1, 1) != 0)
+        return -1;
+    csfg_mat_zero(ss->A);
+    csfg_mat_zero(ss->B);
+    csfg_mat_zero(ss->C);
+
+    /* C and d describe the output of the sections realized so far */
+    vec_for_each (sections, sos)
+    {
+        int    order = sos->a[2] != 0.0 ? 2 : 1;
+        int    last  = offset + order - 1;
+        double an    = sos->a[order];
+        double bn    = sos->b[order] / an;
+
+        /* The input of the section drives its last state */
+        for (i = 0; i != offset; ++i)
+            *csfg_mat_get(ss->A, last, i) = *csfg_mat_get(ss->C, 0, i);
+        csfg_mat_get(ss->B, last, 0)->real = d;
+        for (i = 0; i != order; ++i)
+        {
+            csfg_mat_get(ss->A, last, offset + i)->real = -sos->a[i] / an;
+            if (offset + i != last)
+                csfg_mat_get(ss->A, offset + i, offset + i + 1)->real = 1.0;
+        }
+
+        for (i = 0; i != offset; ++i)
+            csfg_mat_get(ss->C, 0, i)->real *= bn;
+        for (i = 0; i != order; ++i)
+            csfg_mat_get(ss->C, 0, offset + i)->real =
+                (sos->b[i] - bn * sos->a[i]) / an;
+        d *= bn;
+        offset += order;
+    }
+
+    *csfg_mat_get(ss->D, 0, 0) = csfg_complex(d, 0.0);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Discretizes the system exactly for a step of dt, in terms of the delta
+ * operator w = (z - 1)/dt:
+ *
+ *       [A*dt  I*dt]    [Phi  Omega]
+ *   exp([          ]) = [          ]   Omega = integral(e^(A*tau), 0, dt)
+ *       [ 0     0  ]    [ 0     I  ]
+ *
+ *   Psi = (Phi - I)/dt = A*Omega/dt    gamma = Omega*B/dt
+ *
+ * Phi approaches I for small steps, whereas Psi approaches A. Computing Psi
+ * without the subtraction keeps its precision, and the roots in w are as
+ * well-conditioned as the continuous ones.
+ */
+static int discretize_delta(
+    struct csfg_mat**     Psi,
+    struct csfg_mat**     gamma,
+    const struct csfg_ss* ss,
+    double                dt)
+{
+    struct csfg_mat*     M;
+    struct csfg_mat*     E;
+    struct csfg_mat*     Omega;
+    struct csfg_complex* c;
+    int                  n = csfg_mat_rows(ss->A);
+    int                  r, col, result = -1;
+
+    csfg_mat_init(&M);
+    csfg_mat_init(&E);
+    csfg_mat_init(&Omega);
+    if (csfg_mat_realloc(&M, 2 * n, 2 * n) != 0 ||
+        csfg_mat_realloc(&Omega, n, n) != 0)
+        goto out;
+
+    csfg_mat_zero(M);
+    for (r = 0; r != n; ++r)
+    {
+        for (col = 0; col != n; ++col)
+            csfg_mat_get(M, r, col)->real =
+                csfg_mat_get(ss->A, r, col)->real * dt;
+        csfg_mat_get(M, r, n + r)->real = dt;
+    }
+    if (csfg_mat_expm(&E, M) != 0)
+        goto out;
+    for (r = 0; r != n; ++r)
+        for (col = 0; col != n; ++col)
+            *csfg_mat_get(Omega, r, col) = *csfg_mat_get(E, r, n + col);
+
+    if (csfg_mat_mul(Psi, ss->A, Omega) != 0 ||
+        csfg_mat_mul(gamma, Omega, ss->B) != 0)
+        goto out;
+    csfg_mat_for_each (*Psi, c)
+        c->real /= dt;
+    csfg_mat_for_each (*gamma, c)
+        c->real /= dt;
+    result = 0;
+
+out:
+    csfg_mat_deinit(Omega);
+    csfg_mat_deinit(E);
+    csfg_mat_deinit(M);
+    return result;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Computes the characteristic polynomial of Psi from its diagonal blocks,
+ * which are the sections of the cascade, and collects its roots.
+ */
+static int delta_poles(
+    double*                    den,
+    struct csfg_rpoly**        poles,
+    const struct csfg_mat*     Psi,
+    const struct csfg_sos_vec* sections)
+{
+    const struct csfg_sos* sos;
+    double                 f[3];
+    int                    i, j, deg = 0, offset = 0;
+
+    den[0] = 1.0;
+    vec_for_each (sections, sos)
+    {
+        double p00   = csfg_mat_get(Psi, offset, offset)->real;
+        int    order = sos->a[2] != 0.0 ? 2 : 1;
+
+        if (order == 1)
+        {
+            f[0] = -p00;
+            f[1] = 1.0;
+            if (csfg_rpoly_push(poles, csfg_complex(p00, 0.0)) != 0)
+                return -1;
+        }
+        else
+        {
+            struct csfg_complex r1, r2;
+            double              p01, p10, p11, tr, det, disc, root;
+
+            p01  = csfg_mat_get(Psi, offset, offset + 1)->real;
+            p10  = csfg_mat_get(Psi, offset + 1, offset)->real;
+            p11  = csfg_mat_get(Psi, offset + 1, offset + 1)->real;
+            tr   = p00 + p11;
+            det  = p00 * p11 - p01 * p10;
+            disc = tr * tr / 4 - det;
+            root = sqrt(fabs(disc));
+            f[0] = det;
+            f[1] = -tr;
+            f[2] = 1.0;
+            r1   = csfg_complex(tr / 2, root);
+            r2   = csfg_complex(tr / 2, -root);
+            if (disc >= 0.0)
+            {
+                r1 = csfg_complex(tr / 2 + root, 0.0);
+                r2 = csfg_complex(tr / 2 - root, 0.0);
+            }
+            if (csfg_rpoly_push(poles, r1) != 0 ||
+                csfg_rpoly_push(poles, r2) != 0)
+                return -1;
+        }
+
+        /* den *= f */
+        for (i = deg + order; i >= 0; --i)
+        {
+            double acc = 0.0;
+            for (j = 0; j <= order; ++j)
+                if (i - j >= 0 && i - j <= deg)
+                    acc += den[i - j] * f[j];
+            den[i] = acc;
+        }
+        deg += order;
+        offset += order;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Computes the numerator of the discrete transfer function in w,
+ *
+ *   num(w) = C*adj(w*I - Psi)*gamma + D*den(w)
+ *
+ * from the Markov parameters h_j = C*Psi^j*gamma, using
+ *
+ *   adj(w*I - Psi) / den(w) = sum(Psi^j / w^(j+1))
+ *
+ * Returns the number of coefficients.
+ */
+static int delta_numerator(
+    double*                num,
+    const double*          den,
+    const struct csfg_ss*  ss,
+    const struct csfg_mat* Psi,
+    const struct csfg_mat* gamma)
+{
+    struct csfg_mat* v;
+    struct csfg_mat* tmp;
+    struct csfg_mat* swap;
+    double           d = csfg_mat_get(ss->D, 0, 0)->real;
+    int              n = csfg_mat_rows(Psi);
+    int              i, j, count = -1;
+
+    csfg_mat_init(&v);
+    csfg_mat_init(&tmp);
+    if (csfg_mat_realloc(&v, n, 1) != 0)
+        goto out;
+    csfg_mat_copy(v, gamma);
+
+    for (i = 0; i != n + 1; ++i)
+        num[i] = d * den[i];
+    for (j = 0; j != n; ++j)
+    {
+        double h = 0.0;
+        for (i = 0; i != n; ++i)
+            h += csfg_mat_get(ss->C, 0, i)->real * csfg_mat_get(v, i, 0)->real;
+        for (i = 0; i + j + 1 <= n; ++i)
+            num[i] += den[i + j + 1] * h;
+
+        if (csfg_mat_mul(&tmp, Psi, v) != 0)
+            goto out;
+        swap = v, v = tmp, tmp = swap;
+    }
+
+    count = n + 1;
+    while (count > 1 && num[count - 1] == 0.0)
+        count--;
+
+out:
+    csfg_mat_deinit(tmp);
+    csfg_mat_deinit(v);
+    return count;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Finds the roots of a monic numerator. Systems with many more poles than
+ * zeros have sampling zeros far out at about -1/dt, so the coefficients span
+ * many orders of magnitude. The root finder works with absolute tolerances,
+ * so the variable is scaled until the product of the roots has a magnitude
+ * of 1 first.
+ */
+static int delta_zeros(
+    struct csfg_rpoly** zeros,
+    struct csfg_cpoly** poly,
+    const double*       num,
+    int                 count)
+{
+    struct csfg_complex* r;
+    double               scale = 1.0;
+    int                  i;
+
+    if (count > 1 && num[0] != 0.0)
+        scale = pow(fabs(num[0]), 1.0 / (count - 1));
+
+    csfg_cpoly_clear(*poly);
+    for (i = 0; i != count; ++i)
+    {
+        double c = num[i] * pow(scale, i - count + 1);
+        if (csfg_cpoly_push(poly, csfg_complex(c, 0.0)) != 0)
+            return -1;
+    }
+    if (csfg_cpoly_find_roots(zeros, *poly, 0, 0.0) != 0)
+        return -1;
+    vec_for_each (*zeros, r)
+    {
+        r->real *= scale;
+        r->imag *= scale;
+    }
+
+    for (i = 0; i != count; ++i)
+        *vec_get(*poly, i) = csfg_complex(num[i], 0.0);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Substitutes w = (z - 1)/dt into a monic factor in w and multiplies by
+ * dt^order, which yields a monic polynomial in z. The coefficients are
+ * written in descending powers of z. Returns the order.
+ */
+static int delta_to_z(double* z, const double* c, double dt)
+{
+    z[0] = 1.0;
+    if (c[2] != 0.0)
+    {
+        z[1] = c[1] * dt - 2.0;
+        z[2] = 1.0 - c[1] * dt + c[0] * dt * dt;
+        return 2;
+    }
+    if (c[1] != 0.0)
+    {
+        z[1] = c[0] * dt - 1.0;
+        return 1;
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static int
+push_delta_section(struct csfg_sim* sim, const struct csfg_sos* sos)
+{
+    struct csfg_biquad* q;
+    double              num[3], den[3], b[3] = {0.0, 0.0, 0.0};
+    int                 i, m, k;
+
+    m = delta_to_z(num, sos->b, sim->dt);
+    k = delta_to_z(den, sos->a, sim->dt);
+    if (m > k)
+        return log_err("Discretized section has more zeros than poles\n");
+    if (k == 0)
+        return 0;
+
+    /* Divide numerator and denominator by z^k */
+    for (i = 0; i <= m; ++i)
+        b[k - m + i] = num[i];
+
+    q = csfg_biquad_vec_emplace(&sim->sections);
+    if (q == NULL)
+        return -1;
+    q->b0 = b[0];
+    q->b1 = b[1];
+    q->b2 = b[2];
+    q->a1 = den[1];
+    q->a2 = k == 2 ? den[2] : 0.0;
+    q->z1 = 0.0;
+    q->z2 = 0.0;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Discretizes the whole cascade at once, so the hold applies to the input of
+ * the system and not to the input of each section. The poles of the discrete
+ * system are known from the sections, but its zeros are not, so they are
+ * found from the numerator polynomial and paired with the poles again.
+ */
+static int zoh(struct csfg_sim* sim, const struct csfg_sos_vec* sections)
+{
+    struct csfg_ss         ss;
+    struct csfg_tf         delta;
+    struct csfg_mat*       Psi;
+    struct csfg_mat*       gamma;
+    struct csfg_sos_vec*   delta_sections;
+    const struct csfg_sos* sos;
+    double*                den;
+    double*                num;
+    double                 lead;
+    int                    i, n, count, result = -1;
+
+    csfg_ss_init(&ss);
+    csfg_tf_init(&delta);
+    csfg_mat_init(&Psi);
+    csfg_mat_init(&gamma);
+    csfg_sos_vec_init(&delta_sections);
+    den = NULL;
+
+    if (realize_cascade(&ss, sections) != 0)
+        goto out;
+    if (discretize_delta(&Psi, &gamma, &ss, sim->dt) != 0)
+        goto out;
+
+    n   = csfg_mat_rows(ss.A);
+    den = mem_alloc((int)sizeof(double) * (n + 1) * 2);
+    if (den == NULL)
+        goto out;
+    num = den + n + 1;
+    if (delta_poles(den, &delta.poles, Psi, sections) != 0)
+        goto out;
+    count = delta_numerator(num, den, &ss, Psi, gamma);
+    if (count < 0)
+        goto out;
+
+    /* The sections cancel each other out */
+    lead = num[count - 1];
+    if (lead == 0.0)
+    {
+        sim->gain = 0.0;
+        result    = 0;
+        goto out;
+    }
+    for (i = 0; i != count; ++i)
+        num[i] /= lead;
+    if (delta_zeros(&delta.zeros, &delta.num, num, count) != 0)
+        goto out;
+    for (i = 0; i != n + 1; ++i)
+        if (csfg_cpoly_push(&delta.den, csfg_complex(den[i], 0.0)) != 0)
+            goto out;
+    switch (csfg_tf_factor_sections(&delta_sections, &delta))
+    {
+        case 0: break;
+        case 1:
+            log_err("Can't factor the discretized system into sections\n");
+            goto out;
+        default: goto out;
+    }
+
+    /* Each factor in w was scaled by dt^order when converted to z */
+    sim->gain *= lead * pow(sim->dt, n - (count - 1));
+    vec_for_each (delta_sections, sos)
+        if (push_delta_section(sim, sos) != 0)
+            goto out;
+    result = 0;
+
+out:
+    if (den)
+        mem_free(den);
+    csfg_sos_vec_deinit(delta_sections);
+    csfg_mat_deinit(gamma);
+    csfg_mat_deinit(Psi);
+    csfg_tf_deinit(&delta);
+    csfg_ss_deinit(&ss);
+    return result;
+}
+
+/* -------------------------------------------------------------------------- */
+static int push_section(struct csfg_sim* sim, const struct csfg_sos* sos)
+{
+    int                 order = sos->a[2] != 0.0 ? 2 : 1;
+    struct csfg_biquad* q     = csfg_biquad_vec_emplace(&sim->sections);
+    if (q == NULL)
+        return -1;
+
+    bilinear(q, sos->b, sos->a, order, sim->dt);
+    q->z1 = 0.0;
+    q->z2 = 0.0;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_sim_from_tf(
+    struct csfg_sim*         sim,
+    const struct csfg_tf*    tf,
+    double                   dt,
+    enum csfg_discretization method)
+{
+    struct csfg_sos_vec*       local;
+    const struct csfg_sos_vec* sections = tf->sections;
+    const struct csfg_sos*     sos;
+    struct csfg_complex        gain;
+    int                        result;
+
+    csfg_biquad_vec_clear(sim->sections);
+    sim->gain = 0.0;
+    sim->dt   = dt;
+
+    if (!(dt > 0.0) || vec_count(tf->den) == 0)
+        return -1;
+    if (vec_count(tf->poles) != vec_count(tf->den) - 1 ||
+        vec_count(tf->zeros) !=
+            (vec_count(tf->num) > 0 ? vec_count(tf->num) - 1 : 0))
+        return log_err("Transfer function is missing poles or zeros\n");
+    if (vec_count(tf->zeros) > vec_count(tf->poles))
+        return log_err("Can't simulate an improper transfer function\n");
+
+    /* The factors are monic, so the leading coefficients end up in the gain */
+    if (vec_count(tf->num) == 0)
+        return 0;
+    gain = csfg_complex_div(
+        csfg_complex_mul(tf->factor, *vec_last(tf->num)), *vec_last(tf->den));
+    sim->gain = gain.real;
+
+    /* Reuse the sections of the transfer function if they were computed */
+    csfg_sos_vec_init(&local);
+    if (vec_count(sections) == 0 && vec_count(tf->poles) > 0)
+    {
+        result = csfg_tf_factor_sections(&local, tf);
+        if (result > 0)
+            log_err("Can't factor the transfer function into real "
+                    "sections\n");
+        if (result != 0)
+            goto fail;
+        sections = local;
+    }
+
+    switch (method)
+    {
+        case CSFG_BILINEAR:
+            vec_for_each (sections, sos)
+                if (push_section(sim, sos) != 0)
+                    goto fail;
+            break;
+        case CSFG_ZOH:
+            if (vec_count(sections) > 0 && zoh(sim, sections) != 0)
+                goto fail;
+            break;
+    }
+
+    csfg_sos_vec_deinit(local);
+    return 0;
+
+fail:
+    csfg_sos_vec_deinit(local);
+    csfg_biquad_vec_clear(sim->sections);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+void csfg_sim_reset(struct csfg_sim* sim)
+{
+    struct csfg_biquad* q;
+    vec_for_each (sim->sections, q)
+        q->z1 = q->z2 = 0.0;
+}
+
+/* -------------------------------------------------------------------------- */
+void csfg_sim_run(struct csfg_sim* sim, const double* in, double* out, int n)
+{
+    struct csfg_biquad* q;
+    int                 i;
+
+    for (i = 0; i < n; ++i)
+        out[i] = in[i] * sim->gain;
+
+    /* Run each section over the whole buffer instead of each sample through
+     * all sections. The coefficients and state stay in registers and the
+     * buffer is streamed through once per section. */
+    vec_for_each (sim->sections, q)
+    {
+        double b0 = q->b0, b1 = q->b1, b2 = q->b2;
+        double a1 = q->a1, a2 = q->a2;
+        double z1 = q->z1, z2 = q->z2;
+        for (i = 0; i < n; ++i)
+        {
+            double x = out[i];
+            double y = b0 * x + z1;
+            z1       = b1 * x - a1 * y + z2;
+            z2       = b2 * x - a2 * y;
+            out[i]   = y;
+        }
+        q->z1 = z1;
+        q->z2 = z2;
+    }
+}
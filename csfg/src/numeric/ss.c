@@ -0,0 +1,222 @@
+#include "csfg/numeric/ss.h"
+#include "csfg/numeric/tf.h"
+#include "csfg/util/log.h"
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Allocates the matrices for n states and normalizes the coefficients so the
+ * denominator is monic. Afterwards, a[i] holds the denominator coefficients
+ * and C holds the numerator coefficients with the feedthrough removed,
+ * b[i] - bn*a[i].
+ */
+static int prepare(
+    struct csfg_ss* ss, const struct csfg_tf* tf, struct csfg_complex* gain)
+{
+    int n = vec_count(tf->den) - 1;
+    int i;
+
+    if (n < 0)
+        return -1;
+    if (vec_count(tf->num) > n + 1)
+        return log_err(
+            "Can't realize an improper transfer function in state space\n");
+
+    if (csfg_mat_realloc(&ss->A, n, n) != 0 ||
+        csfg_mat_realloc(&ss->B, n, 1) != 0 ||
+        csfg_mat_realloc(&ss->C, 1, n) != 0 ||
+        csfg_mat_realloc(&ss->D, 1, 1) != 0)
+        return -1;
+    csfg_mat_zero(ss->A);
+    csfg_mat_zero(ss->B);
+    csfg_mat_zero(ss->C);
+    csfg_mat_zero(ss->D);
+
+    *gain = csfg_complex_div(tf->factor, *vec_last(tf->den));
+    if (vec_count(tf->num) == n + 1)
+        *csfg_mat_get(ss->D, 0, 0) =
+            csfg_complex_mul(*vec_last(tf->num), *gain);
+
+    for (i = 0; i != n; ++i)
+    {
+        struct csfg_complex a = csfg_complex_div(
+            *vec_get(tf->den, i), *vec_last(tf->den));
+        struct csfg_complex b = i < vec_count(tf->num)
+                                    ? csfg_complex_mul(
+                                          *vec_get(tf->num, i), *gain)
+                                    : csfg_complex(0, 0);
+        *csfg_mat_get(ss->C, 0, i) = csfg_complex_sub(
+            b, csfg_complex_mul(*csfg_mat_get(ss->D, 0, 0), a));
+        /* Stored temporarily in the last row of A */
+        *csfg_mat_get(ss->A, n - 1, i) = csfg_complex_neg(a);
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_ss_from_tf_controllable(struct csfg_ss* ss, const struct csfg_tf* tf)
+{
+    struct csfg_complex gain;
+    int                 i, n;
+
+    if (prepare(ss, tf, &gain) != 0)
+        return -1;
+
+    n = csfg_mat_rows(ss->A);
+    for (i = 0; i + 1 < n; ++i)
+        *csfg_mat_get(ss->A, i, i + 1) = csfg_complex(1, 0);
+    if (n > 0)
+        *csfg_mat_get(ss->B, n - 1, 0) = csfg_complex(1, 0);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_ss_from_tf_observable(struct csfg_ss* ss, const struct csfg_tf* tf)
+{
+    struct csfg_complex gain;
+    int                 i, n;
+
+    if (prepare(ss, tf, &gain) != 0)
+        return -1;
+
+    /* Transpose the last row of A into the last column, and C into B */
+    n = csfg_mat_rows(ss->A);
+    for (i = 0; i != n; ++i)
+    {
+        struct csfg_complex a = *csfg_mat_get(ss->A, n - 1, i);
+        *csfg_mat_get(ss->A, n - 1, i) = csfg_complex(0, 0);
+        *csfg_mat_get(ss->A, i, n - 1) = a;
+
+        *csfg_mat_get(ss->B, i, 0) = *csfg_mat_get(ss->C, 0, i);
+        *csfg_mat_get(ss->C, 0, i) = csfg_complex(0, 0);
+    }
+    for (i = 0; i + 1 < n; ++i)
+        *csfg_mat_get(ss->A, i + 1, i) = csfg_complex(1, 0);
+    if (n > 0)
+        *csfg_mat_get(ss->C, 0, n - 1) = csfg_complex(1, 0);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Discretizes the system exactly for a step of dt:
+ *
+ *       [A*dt  B*dt]   [Phi  Gamma]
+ *   exp([        ]) = [          ]
+ *       [ 0     0  ]   [ 0     1  ]
+ *
+ * where Phi = e^(A*dt) and Gamma = integral(e^(A*tau), 0, dt)*B. The result
+ * is written to E.
+ */
+static int discretize(struct csfg_mat** E, const struct csfg_ss* ss, double dt)
+{
+    struct csfg_mat* M;
+    int              n = csfg_mat_rows(ss->A);
+    int              r, c, result;
+
+    csfg_mat_init(&M);
+    if (csfg_mat_realloc(&M, n + 1, n + 1) != 0)
+        return -1;
+
+    csfg_mat_zero(M);
+    for (r = 0; r != n; ++r)
+    {
+        for (c = 0; c != n; ++c)
+        {
+            *csfg_mat_get(M, r, c) = *csfg_mat_get(ss->A, r, c);
+            csfg_mat_get(M, r, c)->real *= dt;
+            csfg_mat_get(M, r, c)->imag *= dt;
+        }
+        *csfg_mat_get(M, r, n) = *csfg_mat_get(ss->B, r, 0);
+        csfg_mat_get(M, r, n)->real *= dt;
+        csfg_mat_get(M, r, n)->imag *= dt;
+    }
+
+    result = csfg_mat_expm(E, M);
+    csfg_mat_deinit(M);
+    return result;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Iterates x <- Phi*x + Gamma*u and writes y = Re(C*x + D*u) for each sample.
+ * The impulse response starts at x = B with u = 0, the step response starts
+ * at x = 0 with u = 1.
+ */
+static int simulate(
+    const struct csfg_ss* ss, double dt, double* out, int count, int step)
+{
+    struct csfg_mat* E;
+    struct csfg_mat* x;
+    struct csfg_mat* next;
+    struct csfg_mat* swap;
+    int              n = csfg_mat_rows(ss->A);
+    int              k, r, c;
+
+    if (!(dt > 0.0))
+        return -1;
+
+    csfg_mat_init(&E);
+    csfg_mat_init(&x);
+    csfg_mat_init(&next);
+    if (discretize(&E, ss, dt) != 0 || csfg_mat_realloc(&x, n, 1) != 0 ||
+        csfg_mat_realloc(&next, n, 1) != 0)
+        goto fail;
+
+    if (step)
+        csfg_mat_zero(x);
+    else
+        csfg_mat_copy(x, ss->B);
+
+    for (k = 0; k < count; ++k)
+    {
+        struct csfg_complex y =
+            step ? *csfg_mat_get(ss->D, 0, 0) : csfg_complex(0, 0);
+        for (c = 0; c != n; ++c)
+            y = csfg_complex_add(
+                y,
+                csfg_complex_mul(
+                    *csfg_mat_get(ss->C, 0, c), *csfg_mat_get(x, c, 0)));
+        out[k] = y.real;
+
+        for (r = 0; r != n; ++r)
+        {
+            struct csfg_complex acc =
+                step ? *csfg_mat_get(E, r, n) : csfg_complex(0, 0);
+            for (c = 0; c != n; ++c)
+                acc = csfg_complex_add(
+                    acc,
+                    csfg_complex_mul(
+                        *csfg_mat_get(E, r, c), *csfg_mat_get(x, c, 0)));
+            *csfg_mat_get(next, r, 0) = acc;
+        }
+        swap = x, x = next, next = swap;
+    }
+
+    csfg_mat_deinit(next);
+    csfg_mat_deinit(x);
+    csfg_mat_deinit(E);
+    return 0;
+
+fail:
+    csfg_mat_deinit(next);
+    csfg_mat_deinit(x);
+    csfg_mat_deinit(E);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_ss_impulse_response(
+    const struct csfg_ss* ss, double dt, double* out, int n)
+{
+    return simulate(ss, dt, out, n, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_ss_step_response(
+    const struct csfg_ss* ss, double dt, double* out, int n)
+{
+    return simulate(ss, dt, out, n, 1);
+}
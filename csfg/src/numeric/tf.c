@@ -20,6 +20,8 @@ int csfg_tf_from_symbolic(
 
     csfg_cpoly_find_roots(&tf->zeros, tf->num, 0, 0.0);
     csfg_cpoly_find_roots(&tf->poles, tf->den, 0, 0.0);
+    if (csfg_tf_factor_sections(&tf->sections, tf) < 0)
+        return -1;
 
     return 0;
 }
@@ -97,13 +99,46 @@ int csfg_tf_interesting_time_interval(
     return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+static struct csfg_complex
+eval_sections(const struct csfg_tf* tf, struct csfg_complex s)
+{
+    const struct csfg_sos* sos;
+    struct csfg_complex    result;
+    struct csfg_complex    s2 = csfg_complex_mul(s, s);
+
+    if (vec_count(tf->num) == 0)
+        return csfg_complex(0, 0);
+
+    /* The sections are monic, so the leading coefficients go into the gain */
+    result = csfg_complex_div(
+        csfg_complex_mul(tf->factor, *vec_last(tf->num)), *vec_last(tf->den));
+    vec_for_each (tf->sections, sos)
+    {
+        struct csfg_complex num = csfg_complex(
+            sos->b[0] + sos->b[1] * s.real + sos->b[2] * s2.real,
+            sos->b[1] * s.imag + sos->b[2] * s2.imag);
+        struct csfg_complex den = csfg_complex(
+            sos->a[0] + sos->a[1] * s.real + sos->a[2] * s2.real,
+            sos->a[1] * s.imag + sos->a[2] * s2.imag);
+        result = csfg_complex_mul(result, csfg_complex_div(num, den));
+    }
+
+    return result;
+}
+
 /* -------------------------------------------------------------------------- */
 struct csfg_complex
 csfg_tf_eval(const struct csfg_tf* tf, struct csfg_complex s)
 {
-    struct csfg_complex num = csfg_cpoly_eval(tf->num, s);
-    struct csfg_complex den = csfg_cpoly_eval(tf->den, s);
-    struct csfg_complex c1  = csfg_complex_mul(num, tf->factor);
-    struct csfg_complex c2  = csfg_complex_div(c1, den);
+    struct csfg_complex num, den, c1, c2;
+
+    if (vec_count(tf->sections) > 0)
+        return eval_sections(tf, s);
+
+    num = csfg_cpoly_eval(tf->num, s);
+    den = csfg_cpoly_eval(tf->den, s);
+    c1  = csfg_complex_mul(num, tf->factor);
+    c2  = csfg_complex_div(c1, den);
     return c2;
 }
@@ -0,0 +1,208 @@
+#include "csfg/numeric/tf.h"
+#include <stdlib.h>
+
+VEC_DEFINE(csfg_bode_vec, struct csfg_bode_point, 32)
+
+VEC_DECLARE(bode_grid_vec, double, 32)
+VEC_DEFINE(bode_grid_vec, double, 32)
+
+/* Points per decade of the initial grid */
+#define COARSE_PER_DECADE 10
+/* Each interval of the initial grid is halved at most this many times */
+#define MAX_REFINE_DEPTH 12
+/* Zeros and poles on the imaginary axis would otherwise produce infinities */
+#define MAG_DB_LIMIT 400.0
+
+/* Where to place extra samples around a lightly damped pole or zero, in
+ * multiples of |Re(p)| away from |Im(p)|. The magnitude of a pole pair is
+ * roughly 3dB below its peak at one |Re(p)| away */
+static const double cluster_offsets[] = {
+    -8.0, -4.0, -2.0, -1.0, -0.5, 0.0, 0.5, 1.0, 2.0, 4.0, 8.0};
+
+/* -------------------------------------------------------------------------- */
+static double wrap_phase(double a)
+{
+    return a - 2 * M_PI * floor((a + M_PI) / (2 * M_PI));
+}
+
+/* -------------------------------------------------------------------------- */
+static struct csfg_bode_point eval_point(const struct csfg_tf* tf, double log_f)
+{
+    struct csfg_bode_point pt;
+    struct csfg_complex    y =
+        csfg_tf_eval(tf, csfg_complex(0.0, pow(10.0, log_f)));
+
+    pt.log_f  = log_f;
+    pt.mag_db = 20.0 * log10(csfg_complex_mag(y));
+    pt.phase  = csfg_complex_phase(y);
+
+    if (!(pt.mag_db < MAG_DB_LIMIT))
+        pt.mag_db = MAG_DB_LIMIT;
+    if (pt.mag_db < -MAG_DB_LIMIT)
+        pt.mag_db = -MAG_DB_LIMIT;
+    if (isnan(pt.phase))
+        pt.phase = 0.0;
+
+    return pt;
+}
+
+/* -------------------------------------------------------------------------- */
+static int deviates(
+    const struct csfg_bode_point* a,
+    const struct csfg_bode_point* m,
+    const struct csfg_bode_point* b,
+    double                        tolerance_db,
+    double                        tolerance_rad)
+{
+    double expected_phase = a->phase + wrap_phase(b->phase - a->phase) / 2;
+    double error_db       = fabs(m->mag_db - (a->mag_db + b->mag_db) / 2);
+    double error_rad      = fabs(wrap_phase(m->phase - expected_phase));
+    return error_db > tolerance_db || error_rad > tolerance_rad;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Appends the points in (a, b], inserting midpoints where the response is
+ * not close enough to a straight line */
+static int refine(
+    struct csfg_bode_vec** points,
+    const struct csfg_tf*  tf,
+    struct csfg_bode_point a,
+    struct csfg_bode_point b,
+    double                 tolerance_db,
+    double                 tolerance_rad,
+    int                    depth)
+{
+    struct csfg_bode_point m;
+
+    if (depth < MAX_REFINE_DEPTH)
+    {
+        m = eval_point(tf, (a.log_f + b.log_f) / 2);
+        if (deviates(&a, &m, &b, tolerance_db, tolerance_rad))
+        {
+            if (refine(
+                    points, tf, a, m, tolerance_db, tolerance_rad, depth + 1) !=
+                0)
+                return -1;
+            return refine(
+                points, tf, m, b, tolerance_db, tolerance_rad, depth + 1);
+        }
+    }
+
+    return csfg_bode_vec_push(points, b);
+}
+
+/* -------------------------------------------------------------------------- */
+static int compare_doubles(const void* a, const void* b)
+{
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/* -------------------------------------------------------------------------- */
+static int push_clusters(
+    struct bode_grid_vec**   grid,
+    const struct csfg_rpoly* roots,
+    double                   f_start,
+    double                   f_end)
+{
+    const struct csfg_complex* c;
+    int                        i;
+    int n = (int)(sizeof(cluster_offsets) / sizeof(*cluster_offsets));
+
+    vec_for_each (roots, c)
+    {
+        double center = fabs(c->imag);
+        double width  = fabs(c->real);
+
+        /* Well damped and real roots only bend the curve gently, which the
+         * refinement handles on its own */
+        if (center == 0.0 || width >= center)
+            continue;
+
+        for (i = 0; i != n; ++i)
+        {
+            double f = center + cluster_offsets[i] * width;
+            if (f <= f_start || f >= f_end)
+                continue;
+            if (bode_grid_vec_push(grid, log10(f)) != 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_tf_bode(
+    struct csfg_bode_vec** points,
+    const struct csfg_tf*  tf,
+    double                 f_start,
+    double                 f_end,
+    double                 tolerance_db,
+    double                 tolerance_rad)
+{
+    struct bode_grid_vec*   grid;
+    struct csfg_bode_point  prev, next;
+    struct csfg_bode_point* pt;
+    double                  log_start, log_end, last;
+    int                     i, n;
+
+    csfg_bode_vec_clear(*points);
+    if (!(f_start > 0.0) || !(f_end > f_start) || isinf(f_end))
+        return -1;
+
+    log_start = log10(f_start);
+    log_end   = log10(f_end);
+
+    bode_grid_vec_init(&grid);
+
+    n = (int)ceil((log_end - log_start) * COARSE_PER_DECADE);
+    if (n < 1)
+        n = 1;
+    for (i = 0; i < n; ++i)
+        if (bode_grid_vec_push(
+                &grid, log_start + (log_end - log_start) * i / n) != 0)
+            goto fail;
+    if (bode_grid_vec_push(&grid, log_end) != 0)
+        goto fail;
+
+    if (push_clusters(&grid, tf->poles, f_start, f_end) != 0)
+        goto fail;
+    if (push_clusters(&grid, tf->zeros, f_start, f_end) != 0)
+        goto fail;
+
+    qsort(grid->data, grid->count, sizeof(double), compare_doubles);
+
+    prev = eval_point(tf, log_start);
+    if (csfg_bode_vec_push(points, prev) != 0)
+        goto fail;
+    last = log_start;
+    for (i = 1; i != vec_count(grid); ++i)
+    {
+        if (*vec_get(grid, i) - last < 1e-9)
+            continue;
+        last = *vec_get(grid, i);
+
+        next = eval_point(tf, last);
+        if (refine(points, tf, prev, next, tolerance_db, tolerance_rad, 0) !=
+            0)
+            goto fail;
+        prev = next;
+    }
+
+    /* Points are dense enough now that consecutive phases are much less than
+     * pi apart, so unwrapping can't pick the wrong branch */
+    for (i = 1; i != vec_count(*points); ++i)
+    {
+        pt = vec_get(*points, i);
+        pt->phase = pt[-1].phase + wrap_phase(pt->phase - pt[-1].phase);
+    }
+
+    bode_grid_vec_deinit(grid);
+    return 0;
+
+fail:
+    bode_grid_vec_deinit(grid);
+    return -1;
+}
@@ -0,0 +1,892 @@
+#include "csfg/graph/graph.h"
+#include "csfg/numeric/fft.h"
+#include "csfg/numeric/mat.h"
+#include "csfg/numeric/tf.h"
+#include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/tf_expr.h"
+#include "csfg/util/log.h"
+#include "csfg/util/mem.h"
+#include <math.h>
+
+/*
+ * Rotates the sample points slightly away from the real and imaginary axes.
+ * Poles and zeros of real systems often lie exactly on these axes, and an
+ * edge gain must never be evaluated at one of its own poles.
+ */
+#define SAMPLE_PHASE_OFFSET 0.1
+
+struct edge_poly
+{
+    struct csfg_cpoly* num;
+    struct csfg_cpoly* den;
+};
+
+struct sample_ctx
+{
+    struct csfg_mat *M, *L, *U, *in, *out;
+    struct csfg_mat_reorder* reorder;
+    int* tmp;
+    /* Largest magnitude of the output signal relative to the other node
+     * signals over all samples */
+    double max_output;
+};
+
+/* -------------------------------------------------------------------------- */
+static int degree(const struct csfg_cpoly* poly)
+{
+    int n = vec_count(poly) - 1;
+    while (n > 0 && vec_get(poly, n)->real == 0.0)
+        n--;
+    return n;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Converts every edge expression into a rational function of "s" with numeric
+ * coefficients.
+ */
+static int eval_edge_polys(
+    struct edge_poly* edges,
+    const struct csfg_graph* graph,
+    const struct csfg_var_table* substitutions,
+    const struct csfg_var_table* parameters)
+{
+    const struct csfg_edge* edge;
+    struct csfg_expr_pool* pool;
+    struct csfg_tf_expr tf_expr;
+    int e_idx;
+
+    csfg_expr_pool_init(&pool);
+    csfg_tf_expr_init(&tf_expr);
+
+    csfg_graph_enumerate_edges (graph, e_idx, edge)
+    {
+        int expr = csfg_expr_dup_recurse_from(&pool, &edge->pool, edge->expr);
+        if (expr > -1 && substitutions != NULL)
+            expr = csfg_expr_insert_substitutions(&pool, expr, substitutions);
+        if (expr < 0)
+            goto fail;
+
+        csfg_tf_expr_clear(&tf_expr);
+        if (csfg_expr_to_rational(&tf_expr, &pool, expr, "s") != 0)
+            goto fail;
+
+        if (csfg_cpoly_from_symbolic(
+                &edges[e_idx].num, pool, parameters, tf_expr.num) != 0)
+            goto fail;
+        if (csfg_cpoly_from_symbolic(
+                &edges[e_idx].den, pool, parameters, tf_expr.den) != 0)
+            goto fail;
+
+        /* A zero gain has an empty numerator */
+        if (vec_count(edges[e_idx].num) == 0)
+            if (csfg_cpoly_push(&edges[e_idx].num, csfg_complex(0, 0)) != 0)
+                goto fail;
+        if (vec_count(edges[e_idx].den) == 0)
+            goto fail;
+
+        csfg_expr_pool_clear(pool);
+    }
+
+    csfg_tf_expr_deinit(&tf_expr);
+    csfg_expr_pool_deinit(pool);
+    return 0;
+
+fail:
+    csfg_tf_expr_deinit(&tf_expr);
+    csfg_expr_pool_deinit(pool);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Row j of the node equations is multiplied by the product of the
+ * denominators of all edges going into node j, which turns every entry into a
+ * polynomial. The degree of the determinant (and of the numerator, by Cramer's
+ * rule) is then bounded by the sum of the highest degree of each row.
+ */
+static int degree_bound(
+    const struct edge_poly* edges, const struct csfg_graph* graph)
+{
+    const struct csfg_edge* edge;
+    int n_idx, e_idx;
+    int bound = 0;
+
+    for (n_idx = 0; n_idx != csfg_graph_node_count(graph); ++n_idx)
+    {
+        int den_degree = 0, excess = 0;
+        csfg_graph_enumerate_edges (graph, e_idx, edge)
+        {
+            int d;
+            if (edge->n_idx_to != n_idx)
+                continue;
+            d = degree(edges[e_idx].num) - degree(edges[e_idx].den);
+            den_degree += degree(edges[e_idx].den);
+            if (excess < d)
+                excess = d;
+        }
+        bound += den_degree + excess;
+    }
+
+    return bound;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Interpolation is best conditioned if the sample circle has roughly the same
+ * radius as the roots of the system. The magnitude of the roots of each edge
+ * polynomial is estimated from its lowest and highest coefficients.
+ */
+static double sample_radius(
+    const struct edge_poly* edges, const struct csfg_graph* graph)
+{
+    int e_idx, i;
+    double log_sum = 0.0;
+    int count      = 0;
+
+    for (e_idx = 0; e_idx != csfg_graph_edge_count(graph); ++e_idx)
+        for (i = 0; i != 2; ++i)
+        {
+            const struct csfg_cpoly* p =
+                i ? edges[e_idx].den : edges[e_idx].num;
+            int n     = degree(p);
+            double c0 = fabs(vec_first(p)->real);
+            double cn = fabs(vec_get(p, n)->real);
+            if (n == 0 || c0 == 0.0)
+                continue;
+            log_sum += log(c0 / cn) / n;
+            count++;
+        }
+
+    if (count == 0)
+        return 1.0;
+    return exp(log_sum / count);
+}
+
+/* -------------------------------------------------------------------------- */
+static int permutation_sign(const struct csfg_mat_reorder* reorder, int* tmp)
+{
+    int i, sign = 1;
+    for (i = 0; i != vec_count(reorder); ++i)
+        tmp[i] = *vec_get(reorder, i);
+    for (i = 0; i != vec_count(reorder); ++i)
+        while (tmp[i] != i)
+        {
+            int j  = tmp[i];
+            tmp[i] = tmp[j];
+            tmp[j] = j;
+            sign   = -sign;
+        }
+    return sign;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Solves the node equations (I - A^T)x = u at the point "s" and returns the
+ * values of the (row-scaled) numerator and denominator polynomials at "s".
+ */
+static int sample(
+    struct sample_ctx* ctx,
+    struct csfg_complex* num,
+    struct csfg_complex* den,
+    const struct edge_poly* edges,
+    const struct csfg_graph* graph,
+    int node_in,
+    int node_out,
+    struct csfg_complex s)
+{
+    const struct csfg_edge* edge;
+    struct csfg_complex det, den_product;
+    double output, max_signal;
+    int i, e_idx;
+
+    den_product = csfg_complex(1.0, 0.0);
+    csfg_mat_identity(ctx->M);
+    csfg_graph_enumerate_edges (graph, e_idx, edge)
+    {
+        struct csfg_complex* m =
+            csfg_mat_get(ctx->M, edge->n_idx_to, edge->n_idx_from);
+        struct csfg_complex n = csfg_cpoly_eval(edges[e_idx].num, s);
+        struct csfg_complex d = csfg_cpoly_eval(edges[e_idx].den, s);
+        *m          = csfg_complex_sub(*m, csfg_complex_div(n, d));
+        den_product = csfg_complex_mul(den_product, d);
+    }
+
+    if (csfg_mat_lu_decomposition(&ctx->L, &ctx->U, &ctx->reorder, ctx->M)
+        != 0)
+    {
+        return -1;
+    }
+
+    csfg_mat_zero(ctx->in);
+    *csfg_mat_get(ctx->in, node_in, 0) = csfg_complex(1.0, 0.0);
+    csfg_mat_solve_linear_lu(ctx->out, ctx->in, ctx->L, ctx->U, ctx->reorder);
+
+    det = csfg_complex(permutation_sign(ctx->reorder, ctx->tmp), 0.0);
+    for (i = 0; i != csfg_mat_rows(ctx->U); ++i)
+        det = csfg_complex_mul(det, *csfg_mat_get(ctx->U, i, i));
+
+    max_signal = 0.0;
+    for (i = 0; i != csfg_mat_rows(ctx->out); ++i)
+        if (max_signal < csfg_complex_mag(*csfg_mat_get(ctx->out, i, 0)))
+            max_signal = csfg_complex_mag(*csfg_mat_get(ctx->out, i, 0));
+    output = csfg_complex_mag(*csfg_mat_get(ctx->out, node_out, 0));
+    if (ctx->max_output < output / max_signal)
+        ctx->max_output = output / max_signal;
+
+    *den = csfg_complex_mul(det, den_product);
+    *num = csfg_complex_mul(*csfg_mat_get(ctx->out, node_out, 0), *den);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Coefficients that are too small compared to the rest of the polynomial are
+ * lost in the interpolation, which happens when the degree is high or the
+ * roots are spread out. They only matter away from the sample circle, so the
+ * result is compared against the graph inside and outside of the circle. The
+ * points are in the right half-plane, far from the poles of stable systems.
+ */
+static int interpolation_is_accurate(
+    struct sample_ctx* ctx,
+    const struct csfg_tf* tf,
+    const struct edge_poly* edges,
+    const struct csfg_graph* graph,
+    int node_in,
+    int node_out,
+    double r)
+{
+    static const double scales[3] = {0.1, 1.0, 10.0};
+    int i;
+
+    for (i = 0; i != 3; ++i)
+    {
+        struct csfg_complex num, den, expected, actual;
+        double err, mag;
+        double x              = r * scales[i] * M_SQRT1_2;
+        struct csfg_complex s = csfg_complex(x, x);
+        if (sample(ctx, &num, &den, edges, graph, node_in, node_out, s) != 0)
+            return -1;
+
+        expected = csfg_complex_div(num, den);
+        actual   = csfg_complex_div(
+            csfg_cpoly_eval(tf->num, s), csfg_cpoly_eval(tf->den, s));
+        err = csfg_complex_mag(csfg_complex_sub(expected, actual));
+        mag = csfg_complex_mag(expected) + csfg_complex_mag(actual);
+        if (!(err <= mag * 1e-6))
+            return 0;
+    }
+
+    return 1;
+}
+
+/* -------------------------------------------------------------------------- */
+static int rebuild_from_roots(
+    struct csfg_cpoly** poly, const struct csfg_rpoly* roots)
+{
+    const struct csfg_complex* root;
+    int i;
+
+    csfg_cpoly_clear(*poly);
+    if (csfg_cpoly_push(poly, csfg_complex(1.0, 0.0)) != 0)
+        return -1;
+
+    /* Multiply by (s - root) for each root */
+    vec_for_each (roots, root)
+    {
+        if (csfg_cpoly_push(poly, csfg_complex(0.0, 0.0)) != 0)
+            return -1;
+        for (i = vec_count(*poly) - 1; i > 0; --i)
+            *vec_get(*poly, i) = csfg_complex_sub(
+                *vec_get(*poly, i - 1),
+                csfg_complex_mul(*root, *vec_get(*poly, i)));
+        *vec_get(*poly, 0) =
+            csfg_complex_neg(csfg_complex_mul(*root, *vec_get(*poly, 0)));
+    }
+
+    /* Complex roots come in conjugate pairs, so the result is real */
+    for (i = 0; i != vec_count(*poly); ++i)
+        vec_get(*poly, i)->imag = 0.0;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * The root finder works with absolute tolerances, so the monic polynomial is
+ * rescaled to have its roots around the unit circle first.
+ */
+static int find_roots(
+    struct csfg_rpoly** roots, const struct csfg_cpoly* poly, double r)
+{
+    struct csfg_cpoly* scaled;
+    struct csfg_complex* root;
+    int i, n = vec_count(poly) - 1;
+
+    csfg_cpoly_init(&scaled);
+    for (i = 0; i <= n; ++i)
+    {
+        struct csfg_complex c = *vec_get(poly, i);
+        double scale          = pow(r, i - n);
+        if (csfg_cpoly_push(
+                &scaled, csfg_complex(c.real * scale, c.imag * scale)) != 0)
+            goto fail;
+    }
+    if (csfg_cpoly_find_roots(roots, scaled, 0, 0.0) != 0)
+        goto fail;
+
+    vec_for_each (*roots, root)
+        *root = csfg_complex(root->real * r, root->imag * r);
+    csfg_cpoly_deinit(scaled);
+    return 0;
+
+fail:
+    csfg_cpoly_deinit(scaled);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Counts the roots within "radius" of "center" and computes their mean.
+ */
+static int cluster_mean(
+    struct csfg_complex* mean,
+    const struct csfg_rpoly* roots,
+    struct csfg_complex center,
+    double radius)
+{
+    const struct csfg_complex* root;
+    int count = 0;
+
+    *mean = csfg_complex(0.0, 0.0);
+    vec_for_each (roots, root)
+        if (csfg_complex_mag(csfg_complex_sub(*root, center)) <= radius)
+        {
+            *mean = csfg_complex_add(*mean, *root);
+            count++;
+        }
+
+    if (count > 0)
+        *mean = csfg_complex(mean->real / count, mean->imag / count);
+    return count;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Replaces the roots within "radius" of "center" with "count" copies of
+ * "value".
+ */
+static int replace_cluster(
+    struct csfg_rpoly** roots,
+    struct csfg_complex center,
+    double radius,
+    struct csfg_complex value,
+    int count)
+{
+    int i;
+
+    for (i = 0; i != vec_count(*roots); ++i)
+        if (csfg_complex_mag(csfg_complex_sub(*vec_get(*roots, i), center))
+            <= radius)
+        {
+            csfg_rpoly_erase(*roots, i--);
+        }
+
+    while (count--)
+        if (csfg_rpoly_push(roots, value) != 0)
+            return -1;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Evaluates the derivative of the given order at "s". The sum of the
+ * magnitudes of all terms is returned in "mag", which is what rounding errors
+ * are relative to.
+ */
+static struct csfg_complex eval_derivative(
+    const struct csfg_cpoly* poly,
+    int order,
+    struct csfg_complex s,
+    double* mag)
+{
+    struct csfg_complex result = csfg_complex(0.0, 0.0);
+    int i, j;
+
+    *mag = 0.0;
+    for (i = vec_count(poly) - 1; i >= order; --i)
+    {
+        double scale = 1.0;
+        for (j = 0; j != order; ++j)
+            scale *= i - j;
+        result = csfg_complex_add(
+            csfg_complex_mul(result, s),
+            csfg_complex_mul(*vec_get(poly, i), csfg_complex(scale, 0.0)));
+        *mag = *mag * csfg_complex_mag(s)
+               + csfg_complex_mag(*vec_get(poly, i)) * scale;
+    }
+
+    return result;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * A root of multiplicity m is a simple root of the (m-1)th derivative, where
+ * Newton's method converges quickly and accurately.
+ */
+static struct csfg_complex refine_repeated_root(
+    const struct csfg_cpoly* poly, struct csfg_complex root, int multiplicity)
+{
+    double mag;
+    int i;
+
+    for (i = 0; i != 20; ++i)
+    {
+        struct csfg_complex step = csfg_complex_div(
+            eval_derivative(poly, multiplicity - 1, root, &mag),
+            eval_derivative(poly, multiplicity, root, &mag));
+        if (!isfinite(step.real) || !isfinite(step.imag))
+            break;
+        root = csfg_complex_sub(root, step);
+        if (csfg_complex_mag(step) <= csfg_complex_mag(root) * 1e-15)
+            break;
+    }
+
+    return root;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Close but distinct roots also form a cluster. Only if the lower derivatives
+ * vanish as well, up to rounding errors, is it a repeated root.
+ */
+static int is_repeated_root(
+    const struct csfg_cpoly* poly, struct csfg_complex root, int multiplicity)
+{
+    double mag;
+    int i;
+
+    for (i = 0; i < multiplicity - 1; ++i)
+        if (csfg_complex_mag(eval_derivative(poly, i, root, &mag))
+            > mag * 1e-10)
+        {
+            return 0;
+        }
+
+    return 1;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Durand-Kerner spreads a root of multiplicity m out into a cluster of m roots
+ * with an error of roughly eps^(1/m). Clusters that are repeated roots are
+ * replaced by their refined center. Larger clusters are tried first, because
+ * part of a repeated root also passes is_repeated_root().
+ */
+static void polish_repeated_roots(
+    struct csfg_rpoly* roots, const struct csfg_cpoly* poly)
+{
+    static const double sizes[3] = {1e-1, 1e-2, 1e-3};
+    struct csfg_complex* root;
+    int i, j;
+
+    for (i = 0; i != vec_count(roots); ++i)
+        for (j = 0; j != 3; ++j)
+        {
+            struct csfg_complex seed = *vec_get(roots, i);
+            struct csfg_complex mean;
+            double radius = csfg_complex_mag(seed) * sizes[j] + 1e-12;
+            int count     = cluster_mean(&mean, roots, seed, radius);
+            if (count < 2)
+                continue;
+
+            mean = refine_repeated_root(poly, mean, count);
+            if (!is_repeated_root(poly, mean, count))
+                continue;
+
+            vec_for_each (roots, root)
+                if (csfg_complex_mag(csfg_complex_sub(*root, seed)) <= radius)
+                    *root = mean;
+            break;
+        }
+}
+
+/* -------------------------------------------------------------------------- */
+static int copy_roots(struct csfg_rpoly** dst, const struct csfg_rpoly* src)
+{
+    const struct csfg_complex* root;
+    csfg_rpoly_clear(*dst);
+    vec_for_each (src, root)
+        if (csfg_rpoly_push(dst, *root) != 0)
+            return -1;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Compares the monic numerator and denominator with the products of the
+ * given roots, at the same points as interpolation_is_accurate().
+ */
+static int roots_match_polynomials(
+    const struct csfg_rpoly* zeros,
+    const struct csfg_rpoly* poles,
+    const struct csfg_tf* tf,
+    double r)
+{
+    static const double scales[3] = {0.1, 1.0, 10.0};
+    const struct csfg_complex* root;
+    int i;
+
+    for (i = 0; i != 3; ++i)
+    {
+        struct csfg_complex expected, actual;
+        double err, mag;
+        double x              = r * scales[i] * M_SQRT1_2;
+        struct csfg_complex s = csfg_complex(x, x);
+
+        expected = csfg_complex_div(
+            csfg_cpoly_eval(tf->num, s), csfg_cpoly_eval(tf->den, s));
+        actual = csfg_complex(1.0, 0.0);
+        vec_for_each (zeros, root)
+            actual = csfg_complex_mul(actual, csfg_complex_sub(s, *root));
+        vec_for_each (poles, root)
+            actual = csfg_complex_div(actual, csfg_complex_sub(s, *root));
+
+        err = csfg_complex_mag(csfg_complex_sub(expected, actual));
+        mag = csfg_complex_mag(expected);
+        if (!(err <= mag * 1e-6))
+            return 0;
+    }
+
+    return 1;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Tries to cancel the cluster of zeros around "seed" against a cluster of
+ * poles with the same center. The roots of a cluster are spread out further
+ * the higher its multiplicity, so increasingly large clusters are tried.
+ * Returns 1 if roots were cancelled.
+ */
+static int cancel_cluster(
+    struct csfg_rpoly** zeros,
+    struct csfg_rpoly** poles,
+    const struct csfg_tf* tf,
+    struct csfg_complex seed)
+{
+    static const double sizes[3] = {1e-3, 1e-2, 1e-1};
+    int i;
+
+    for (i = 0; i != 3; ++i)
+    {
+        struct csfg_complex center, zero_mean, pole_mean, mean;
+        double radius  = csfg_complex_mag(seed) * sizes[i] + 1e-12;
+        int zero_count = cluster_mean(&center, *zeros, seed, radius);
+        int pole_count = cluster_mean(&pole_mean, *poles, center, radius);
+        int common     = zero_count < pole_count ? zero_count : pole_count;
+        if (common == 0)
+            continue;
+
+        zero_mean = refine_repeated_root(tf->num, center, zero_count);
+        pole_mean = refine_repeated_root(tf->den, pole_mean, pole_count);
+        if (!is_repeated_root(tf->num, zero_mean, zero_count))
+            continue;
+        if (!is_repeated_root(tf->den, pole_mean, pole_count))
+            continue;
+        if (csfg_complex_mag(csfg_complex_sub(zero_mean, pole_mean))
+            > csfg_complex_mag(zero_mean) * 1e-6 + 1e-12)
+        {
+            continue;
+        }
+
+        mean = csfg_complex_add(
+            csfg_complex_mul(zero_mean, csfg_complex(zero_count, 0.0)),
+            csfg_complex_mul(pole_mean, csfg_complex(pole_count, 0.0)));
+        mean = csfg_complex_div(mean, csfg_complex(zero_count + pole_count, 0));
+        if (replace_cluster(zeros, seed, radius, mean, zero_count - common)
+            != 0)
+        {
+            return -1;
+        }
+        if (replace_cluster(poles, center, radius, mean, pole_count - common)
+            != 0)
+        {
+            return -1;
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Repeated roots are only found roughly, so the copies of a common factor
+ * don't match closely enough to be cancelled in pairs. They are cancelled as
+ * clusters instead. The result is only used if it still matches the
+ * polynomials.
+ */
+static int
+cancel_common_clusters(struct csfg_tf* tf, double r, int* cancelled)
+{
+    struct csfg_rpoly *zeros, *poles;
+    int z;
+    int result = -1;
+
+    csfg_rpoly_init(&zeros);
+    csfg_rpoly_init(&poles);
+    if (copy_roots(&zeros, tf->zeros) != 0)
+        goto out;
+    if (copy_roots(&poles, tf->poles) != 0)
+        goto out;
+
+    for (z = 0; z < vec_count(zeros); ++z)
+    {
+        int changed = cancel_cluster(&zeros, &poles, tf, *vec_get(zeros, z));
+        if (changed < 0)
+            goto out;
+        /* The indices changed */
+        if (changed)
+            z = -1;
+    }
+
+    result = 0;
+    if (vec_count(zeros) == vec_count(tf->zeros))
+        goto out;
+    if (!roots_match_polynomials(zeros, poles, tf, r))
+        goto out;
+
+    if (copy_roots(&tf->zeros, zeros) != 0)
+        result = -1;
+    if (copy_roots(&tf->poles, poles) != 0)
+        result = -1;
+    *cancelled = 1;
+
+out:
+    csfg_rpoly_deinit(poles);
+    csfg_rpoly_deinit(zeros);
+    return result;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Row scaling introduces the denominator of every edge into both numerator
+ * and denominator. Most of these cancel, so matching roots are removed.
+ */
+static int cancel_common_roots(struct csfg_tf* tf, double r)
+{
+    int z, p, cancelled = 0;
+
+    /* Clusters first, otherwise single copies of a repeated root could pair
+     * up by chance and leave the inaccurate rest of the cluster behind */
+    if (cancel_common_clusters(tf, r, &cancelled) != 0)
+        return -1;
+
+    for (z = 0; z != vec_count(tf->zeros); ++z)
+        for (p = 0; p != vec_count(tf->poles); ++p)
+        {
+            struct csfg_complex a = *vec_get(tf->zeros, z);
+            struct csfg_complex b = *vec_get(tf->poles, p);
+            double mag            = csfg_complex_mag(a) + csfg_complex_mag(b);
+            if (csfg_complex_mag(csfg_complex_sub(a, b)) > mag * 1e-6 + 1e-12)
+                continue;
+
+            csfg_rpoly_erase(tf->zeros, z--);
+            csfg_rpoly_erase(tf->poles, p);
+            cancelled = 1;
+            break;
+        }
+
+    if (!cancelled)
+        return 0;
+
+    if (rebuild_from_roots(&tf->num, tf->zeros) != 0)
+        return -1;
+    if (rebuild_from_roots(&tf->den, tf->poles) != 0)
+        return -1;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static void clear_tf(struct csfg_tf* tf)
+{
+    tf->factor = csfg_complex(1.0, 0.0);
+    csfg_cpoly_clear(tf->num);
+    csfg_cpoly_clear(tf->den);
+    csfg_rpoly_clear(tf->zeros);
+    csfg_rpoly_clear(tf->poles);
+    csfg_sos_vec_clear(tf->sections);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_tf_from_graph(
+    struct csfg_tf* tf,
+    const struct csfg_graph* graph,
+    int node_in,
+    int node_out,
+    const struct csfg_var_table* substitutions,
+    const struct csfg_var_table* parameters)
+{
+    struct sample_ctx ctx;
+    struct edge_poly* edges;
+    struct csfg_complex* samples;
+    double r;
+    int e_idx, k, N;
+    int node_count = csfg_graph_node_count(graph);
+    int edge_count = csfg_graph_edge_count(graph);
+    int result     = -1;
+
+    clear_tf(tf);
+
+    if (node_in < 0 || node_out < 0 || node_in >= node_count ||
+        node_out >= node_count)
+    {
+        return log_err(
+            "Input node %d or output node %d doesn't exist in the graph\n",
+            node_in,
+            node_out);
+    }
+    /* LU reorder indices are 16-bit */
+    if (node_count > INT16_MAX)
+        return log_err(
+            "Can't solve a graph with %d nodes, at most %d are supported\n",
+            node_count,
+            INT16_MAX);
+
+    edges = mem_alloc(sizeof(*edges) * (edge_count + 1));
+    if (edges == NULL)
+        goto alloc_edges_failed;
+    for (e_idx = 0; e_idx != edge_count; ++e_idx)
+    {
+        csfg_cpoly_init(&edges[e_idx].num);
+        csfg_cpoly_init(&edges[e_idx].den);
+    }
+
+    csfg_mat_init(&ctx.M);
+    csfg_mat_init(&ctx.L);
+    csfg_mat_init(&ctx.U);
+    csfg_mat_init(&ctx.in);
+    csfg_mat_init(&ctx.out);
+    csfg_mat_reorder_init(&ctx.reorder);
+    samples        = NULL;
+    ctx.max_output = 0.0;
+    ctx.tmp        = mem_alloc(sizeof(int) * node_count);
+    if (ctx.tmp == NULL)
+        goto fail;
+    if (csfg_mat_realloc(&ctx.M, node_count, node_count) != 0 ||
+        csfg_mat_realloc(&ctx.in, node_count, 1) != 0 ||
+        csfg_mat_realloc(&ctx.out, node_count, 1) != 0)
+    {
+        goto fail;
+    }
+
+    if (eval_edge_polys(edges, graph, substitutions, parameters) != 0)
+        goto fail;
+
+    /* The polynomials have at most N coefficients. Sample count is rounded up
+     * for the FFT. Coefficient vectors are limited in size. */
+    N = csfg_fft_size(degree_bound(edges, graph) + 1);
+    if (N > CSFG_CPOLY_MAX_COEFFS)
+    {
+        log_err(
+            "Can't interpolate a transfer function with %d coefficients, at "
+            "most %d are supported\n",
+            N,
+            CSFG_CPOLY_MAX_COEFFS);
+        goto fail;
+    }
+    r = sample_radius(edges, graph);
+
+    samples = mem_alloc(sizeof(*samples) * N * 2);
+    if (samples == NULL)
+        goto fail;
+
+    for (k = 0; k != N; ++k)
+    {
+        double angle = 2.0 * M_PI * k / N + SAMPLE_PHASE_OFFSET;
+        struct csfg_complex s = csfg_complex(r * cos(angle), r * sin(angle));
+        if (sample(
+                &ctx,
+                &samples[k],
+                &samples[N + k],
+                edges,
+                graph,
+                node_in,
+                node_out,
+                s) != 0)
+        {
+            log_err("Can't solve the node equations of the graph, they are "
+                    "singular at s=%g%+gj\n",
+                    s.real,
+                    s.imag);
+            goto fail;
+        }
+    }
+
+    /* No forward path from input to output. The output is then only
+     * rounding noise compared to the other signals in the graph */
+    if (ctx.max_output <= 1e-12)
+    {
+        log_err("There is no path from input node %d to output node %d\n",
+                node_in,
+                node_out);
+        goto fail;
+    }
+
+    if (csfg_cpoly_interpolate_circle(
+            &tf->num, samples, N, r, SAMPLE_PHASE_OFFSET) != 0)
+        goto fail;
+    if (csfg_cpoly_interpolate_circle(
+            &tf->den, samples + N, N, r, SAMPLE_PHASE_OFFSET) != 0)
+        goto fail;
+    switch (interpolation_is_accurate(
+        &ctx, tf, edges, graph, node_in, node_out, r))
+    {
+        case 1: break;
+        case 0:
+            log_err(
+                "Can't interpolate the transfer function accurately, the "
+                "coefficients span too many orders of magnitude\n");
+            goto fail;
+        default: goto fail;
+    }
+
+    /* Need to be monic polynomials for find_roots() */
+    tf->factor = csfg_cpoly_monic(tf->den);
+    tf->factor = csfg_complex_div(tf->factor, csfg_cpoly_monic(tf->num));
+
+    if (find_roots(&tf->zeros, tf->num, r) != 0)
+        goto fail;
+    if (find_roots(&tf->poles, tf->den, r) != 0)
+        goto fail;
+    polish_repeated_roots(tf->zeros, tf->num);
+    polish_repeated_roots(tf->poles, tf->den);
+    if (cancel_common_roots(tf, r) != 0)
+        goto fail;
+    if (csfg_tf_factor_sections(&tf->sections, tf) < 0)
+        goto fail;
+
+    result = 0;
+
+fail:
+    if (samples)
+        mem_free(samples);
+    if (ctx.tmp)
+        mem_free(ctx.tmp);
+    csfg_mat_reorder_deinit(ctx.reorder);
+    csfg_mat_deinit(ctx.out);
+    csfg_mat_deinit(ctx.in);
+    csfg_mat_deinit(ctx.U);
+    csfg_mat_deinit(ctx.L);
+    csfg_mat_deinit(ctx.M);
+    for (e_idx = 0; e_idx != edge_count; ++e_idx)
+    {
+        csfg_cpoly_deinit(edges[e_idx].den);
+        csfg_cpoly_deinit(edges[e_idx].num);
+    }
+    mem_free(edges);
+alloc_edges_failed:
+    if (result != 0)
+        clear_tf(tf);
+    return result;
+}
@@ -0,0 +1,352 @@
+#include "csfg/numeric/tf.h"
+#include "csfg/util/mem.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+VEC_DEFINE(csfg_sos_vec, struct csfg_sos, 16)
+
+/*
+ * Real monic factor of a polynomial in s, c0 + c1*s + c2*s^2. Linear
+ * factors have c2 = 0 and c1 = 1.
+ */
+struct factor
+{
+    double c[3];
+    double w; /* Natural frequency, used to pair zeros with poles */
+    int    order;
+    int    taken;
+};
+
+VEC_DECLARE(factor_vec, struct factor, 16)
+VEC_DEFINE(factor_vec, struct factor, 16)
+
+VEC_DECLARE(real_vec, double, 16)
+VEC_DEFINE(real_vec, double, 16)
+
+/* -------------------------------------------------------------------------- */
+static int
+push_factor(struct factor_vec** factors, double c0, double c1, int order)
+{
+    struct factor* f = factor_vec_emplace(factors);
+    if (f == NULL)
+        return -1;
+    f->c[0]  = c0;
+    f->c[1]  = c1;
+    f->c[2]  = order == 2 ? 1.0 : 0.0;
+    f->w     = order == 2 ? sqrt(fabs(c0)) : fabs(c0);
+    f->order = order;
+    f->taken = 0;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static int compare_abs(const void* a, const void* b)
+{
+    double da = fabs(*(const double*)a);
+    double db = fabs(*(const double*)b);
+    return (da > db) - (da < db);
+}
+
+/* -------------------------------------------------------------------------- */
+static int compare_factors(const void* a, const void* b)
+{
+    double wa = ((const struct factor*)a)->w;
+    double wb = ((const struct factor*)b)->w;
+    return (wa > wb) - (wa < wb);
+}
+
+/* -------------------------------------------------------------------------- */
+static void sort_factors(struct factor_vec* factors)
+{
+    if (vec_count(factors) > 0)
+        qsort(
+            factors->data,
+            vec_count(factors),
+            sizeof(struct factor),
+            compare_factors);
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Splits a list of roots into real quadratic factors, one for each conjugate
+ * pair and one for each pair of real roots, and at most one linear factor.
+ * The roots come from an iterative solver, so conjugates are matched by
+ * proximity rather than by exact equality.
+ */
+static int collect_factors(
+    struct factor_vec** factors, const struct csfg_rpoly* roots)
+{
+    struct csfg_complex* r;
+    struct real_vec*     reals;
+    double               re, im;
+    int                  i, j, n, best;
+
+    n = vec_count(roots);
+    if (n == 0)
+        return 0;
+
+    r = mem_alloc((int)sizeof(*r) * n);
+    if (r == NULL)
+        return -1;
+    memcpy(r, roots->data, sizeof(*r) * n);
+    real_vec_init(&reals);
+
+    while (n > 0)
+    {
+        struct csfg_complex p         = r[--n];
+        double              tol       = 1e-9 * (1.0 + csfg_complex_mag(p));
+        double              best_dist = HUGE_VAL;
+
+        if (fabs(p.imag) <= tol)
+        {
+            if (real_vec_push(&reals, p.real) != 0)
+                goto fail;
+            continue;
+        }
+
+        best = -1;
+        for (i = 0; i != n; ++i)
+        {
+            double dist = csfg_complex_mag(
+                csfg_complex_sub(r[i], csfg_complex(p.real, -p.imag)));
+            if (r[i].imag * p.imag < 0.0 && dist < best_dist)
+            {
+                best      = i;
+                best_dist = dist;
+            }
+        }
+
+        if (best < 0)
+        {
+            /* Clustered roots are only found to a fraction of double
+             * precision and may end up without a partner. The coefficients
+             * are known to be real, so the imaginary part is just noise. */
+            if (real_vec_push(&reals, p.real) != 0)
+                goto fail;
+            continue;
+        }
+
+        re      = (p.real + r[best].real) / 2;
+        im      = (fabs(p.imag) + fabs(r[best].imag)) / 2;
+        r[best] = r[--n];
+        if (push_factor(factors, re * re + im * im, -2 * re, 2) != 0)
+            goto fail;
+    }
+
+    /* Pair real roots of similar magnitude */
+    if (vec_count(reals) > 0)
+        qsort(reals->data, vec_count(reals), sizeof(double), compare_abs);
+    for (j = 0; j + 1 < vec_count(reals); j += 2)
+    {
+        double r1 = *vec_get(reals, j);
+        double r2 = *vec_get(reals, j + 1);
+        if (push_factor(factors, r1 * r2, -(r1 + r2), 2) != 0)
+            goto fail;
+    }
+    if (j < vec_count(reals))
+        if (push_factor(factors, -*vec_get(reals, j), 1.0, 1) != 0)
+            goto fail;
+
+    real_vec_deinit(reals);
+    mem_free(r);
+    return 0;
+
+fail:
+    real_vec_deinit(reals);
+    mem_free(r);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Returns the free pole factor of the given order that is closest in
+ * frequency to w */
+static struct factor*
+find_free_pole(struct factor_vec* poles, int order, double w)
+{
+    struct factor* f;
+    struct factor* best      = NULL;
+    double         best_dist = HUGE_VAL;
+
+    vec_for_each (poles, f)
+    {
+        double dist = fabs(f->w - w) / (f->w + w + DBL_MIN);
+        if (f->taken || f->order != order)
+            continue;
+        if (dist < best_dist)
+        {
+            best      = f;
+            best_dist = dist;
+        }
+    }
+
+    return best;
+}
+
+/* -------------------------------------------------------------------------- */
+static int push_section(
+    struct csfg_sos_vec** sections,
+    const struct factor*  zero,
+    const struct factor*  pole)
+{
+    static const double one[3] = {1.0, 0.0, 0.0};
+    struct csfg_sos*    sos    = csfg_sos_vec_emplace(sections);
+    if (sos == NULL)
+        return -1;
+
+    memcpy(sos->b, zero ? zero->c : one, sizeof(sos->b));
+    memcpy(sos->a, pole ? pole->c : one, sizeof(sos->a));
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Coefficients are considered real if their imaginary parts are negligible
+ * compared to the largest coefficient */
+static int has_real_coefficients(const struct csfg_cpoly* poly)
+{
+    const struct csfg_complex* c;
+    double                     max_real = 0.0, max_imag = 0.0;
+
+    vec_for_each (poly, c)
+    {
+        if (max_real < fabs(c->real))
+            max_real = fabs(c->real);
+        if (max_imag < fabs(c->imag))
+            max_imag = fabs(c->imag);
+    }
+
+    return max_imag <= max_real * 1e-12;
+}
+
+/* -------------------------------------------------------------------------- */
+static struct csfg_complex
+eval_factor(const double* c, struct csfg_complex s)
+{
+    struct csfg_complex s2 = csfg_complex_mul(s, s);
+    return csfg_complex(
+        c[0] + c[1] * s.real + c[2] * s2.real, c[1] * s.imag + c[2] * s2.imag);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Geometric mean of the magnitudes of the nonzero roots, computed from the
+ * coefficients so it doesn't depend on the roots being correct */
+static double root_scale(const struct csfg_cpoly* poly)
+{
+    int n = vec_count(poly) - 1;
+    int low;
+
+    for (low = 0; low < n; ++low)
+        if (csfg_complex_mag(*vec_get(poly, low)) != 0.0)
+            break;
+    if (low >= n)
+        return 1.0;
+
+    return pow(
+        csfg_complex_mag(*vec_get(poly, low)) /
+            csfg_complex_mag(*vec_last(poly)),
+        1.0 / (n - low));
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * The root finder can fail on polynomials whose coefficients span many orders
+ * of magnitude, e.g. high-order filters with realistic cutoff frequencies or
+ * clusters of repeated poles. Sections built from such roots describe a
+ * different system, so they are compared with the polynomials at a few
+ * points around the poles. Points on the positive real axis and in the right
+ * half plane are used, where the denominator of a stable system has no
+ * cancellation and can be trusted.
+ */
+static int sections_match_polynomials(
+    const struct csfg_sos_vec* sections, const struct csfg_tf* tf)
+{
+    static const double angles[3] = {0.0, M_PI / 4, 0.0};
+    static const double scales[3] = {0.5, 1.0, 2.0};
+    const struct csfg_sos* sos;
+    double                 rho;
+    int                    i;
+
+    if (vec_count(tf->num) == 0)
+        return 1;
+
+    rho = root_scale(vec_count(tf->den) > 1 ? tf->den : tf->num);
+    for (i = 0; i != 3; ++i)
+    {
+        double              r = rho * scales[i];
+        struct csfg_complex s =
+            csfg_complex(r * cos(angles[i]), r * sin(angles[i]));
+        struct csfg_complex expected = csfg_complex_div(
+            csfg_cpoly_eval(tf->num, s), csfg_cpoly_eval(tf->den, s));
+        struct csfg_complex actual = csfg_complex_div(
+            *vec_last(tf->num), *vec_last(tf->den));
+        double              err, mag;
+
+        vec_for_each (sections, sos)
+            actual = csfg_complex_mul(
+                actual,
+                csfg_complex_div(
+                    eval_factor(sos->b, s), eval_factor(sos->a, s)));
+
+        err = csfg_complex_mag(csfg_complex_sub(actual, expected));
+        mag = csfg_complex_mag(expected);
+        if (!(err <= mag * 1e-4))
+            return 0;
+    }
+
+    return 1;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_tf_factor_sections(
+    struct csfg_sos_vec** sections, const struct csfg_tf* tf)
+{
+    struct factor_vec* pole_factors;
+    struct factor_vec* zero_factors;
+    struct factor*     pole;
+    struct factor*     zero;
+    int                result = -1;
+
+    csfg_sos_vec_clear(*sections);
+    if (!has_real_coefficients(tf->num) || !has_real_coefficients(tf->den))
+        return 1;
+
+    factor_vec_init(&pole_factors);
+    factor_vec_init(&zero_factors);
+    if (collect_factors(&pole_factors, tf->poles) != 0 ||
+        collect_factors(&zero_factors, tf->zeros) != 0)
+        goto out;
+    sort_factors(pole_factors);
+    sort_factors(zero_factors);
+
+    /* Give each zero factor a pole factor of similar frequency. This keeps
+     * the gain of each section close to 1 and avoids overflowing
+     * intermediate results. Linear zeros prefer the linear pole, if there
+     * is one. For proper transfer functions every zero finds a pole. */
+    vec_for_each (zero_factors, zero)
+    {
+        pole = NULL;
+        if (zero->order == 1)
+            pole = find_free_pole(pole_factors, 1, zero->w);
+        if (pole == NULL)
+            pole = find_free_pole(pole_factors, 2, zero->w);
+        if (pole == NULL)
+            pole = find_free_pole(pole_factors, 1, zero->w);
+        if (pole != NULL)
+            pole->taken = 1;
+        if (push_section(sections, zero, pole) != 0)
+            goto out;
+    }
+    vec_for_each (pole_factors, pole)
+        if (!pole->taken)
+            if (push_section(sections, NULL, pole) != 0)
+                goto out;
+    result = sections_match_polynomials(*sections, tf) ? 0 : 1;
+
+out:
+    if (result != 0)
+        csfg_sos_vec_clear(*sections);
+    factor_vec_deinit(zero_factors);
+    factor_vec_deinit(pole_factors);
+    return result;
+}
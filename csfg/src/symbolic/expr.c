@@ -1,6 +1,8 @@
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/tf_expr.h"
 #include "csfg/symbolic/var_table.h"
+#include "csfg/util/arena.h"
 #include "csfg/util/mem.h"
 #include <assert.h>
 #include <stddef.h>
@@ -14,9 +16,19 @@ void csfg_expr_pool_init(struct csfg_expr_pool** pool)
 /* -------------------------------------------------------------------------- */
 void csfg_expr_pool_deinit(struct csfg_expr_pool* pool)
 {
-    if (pool != NULL)
+    if (pool == NULL)
+        return;
+
+    if (pool->arena != NULL)
+    {
+        if (pool->lits != NULL)
+            arena_free(pool->arena, pool->lits);
+        arena_free(pool->arena, pool);
+    }
+    else
     {
-        strlist_deinit(pool->var_names);
+        if (pool->lits != NULL)
+            mem_free(pool->lits);
         mem_free(pool);
     }
 }
@@ -26,16 +38,33 @@ void csfg_expr_pool_clear(struct csfg_expr_pool* pool)
 {
     if (pool != NULL)
     {
-        pool->count = 0;
-        strlist_clear(pool->var_names);
+        pool->count     = 0;
+        pool->lit_count = 0;
     }
 }
 
 /* -------------------------------------------------------------------------- */
-static void pool_init(struct csfg_expr_pool* pool)
+static void pool_init(struct csfg_expr_pool* pool, struct arena* arena)
 {
-    pool->count = 0;
-    strlist_init(&pool->var_names);
+    pool->lits         = NULL;
+    pool->count        = 0;
+    pool->lit_count    = 0;
+    pool->lit_capacity = 0;
+    pool->arena        = arena;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_expr_pool_init_arena(
+    struct csfg_expr_pool** pool, struct arena* arena)
+{
+    int header = offsetof(struct csfg_expr_pool, nodes);
+    int data   = sizeof(struct csfg_expr_node) * 16;
+    *pool      = arena_alloc(arena, header + data);
+    if (*pool == NULL)
+        return -1;
+    pool_init(*pool, arena);
+    (*pool)->capacity = 16;
+    return 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -51,11 +80,13 @@ int csfg_expr_new(
         new_cap  = *pool ? (*pool)->capacity * 2 : 16;
         header   = offsetof(struct csfg_expr_pool, nodes);
         data     = sizeof(struct csfg_expr_node) * new_cap;
-        new_pool = mem_realloc(*pool, header + data);
+        new_pool = *pool && (*pool)->arena
+                       ? arena_realloc((*pool)->arena, *pool, header + data)
+                       : mem_realloc(*pool, header + data);
         if (new_pool == NULL)
             return -1;
         if (*pool == NULL)
-            pool_init(new_pool);
+            pool_init(new_pool, NULL);
         new_pool->capacity = new_cap;
         *pool              = new_pool;
     }
@@ -70,6 +101,31 @@ int csfg_expr_new(
     return n;
 }
 
+/* -------------------------------------------------------------------------- */
+static double* realloc_lits(struct csfg_expr_pool* pool, int capacity)
+{
+    int bytes = sizeof(double) * capacity;
+    return pool->arena ? arena_realloc(pool->arena, pool->lits, bytes)
+                       : mem_realloc(pool->lits, bytes);
+}
+
+/* -------------------------------------------------------------------------- */
+static int add_lit(struct csfg_expr_pool* pool, double value)
+{
+    if (pool->lit_count == pool->lit_capacity)
+    {
+        int new_cap      = pool->lit_capacity ? pool->lit_capacity * 2 : 8;
+        double* new_lits = realloc_lits(pool, new_cap);
+        if (new_lits == NULL)
+            return -1;
+        pool->lits         = new_lits;
+        pool->lit_capacity = new_cap;
+    }
+
+    pool->lits[pool->lit_count] = value;
+    return pool->lit_count++;
+}
+
 /* -------------------------------------------------------------------------- */
 static int insert_substitutions(
     struct csfg_expr_pool** pool,
@@ -85,9 +141,8 @@ static int insert_substitutions(
     entry = NULL;
     if ((*pool)->nodes[expr].type == CSFG_EXPR_VAR)
     {
-        int var_idx             = (*pool)->nodes[expr].value.var_idx;
-        struct strview var_name = strlist_view((*pool)->var_names, var_idx);
-        entry                   = csfg_var_hmap_find(vt->map, var_name);
+        int var_idx = (*pool)->nodes[expr].value;
+        entry = csfg_var_hmap_find(vt->map, csfg_symbol_view(var_idx));
     }
 
     if (entry != NULL && entry->pool->nodes[entry->expr].type != CSFG_EXPR_INF)
@@ -168,11 +223,30 @@ fail:
 /* -------------------------------------------------------------------------- */
 int csfg_expr_lit(struct csfg_expr_pool** pool, double value)
 {
+    int lit;
     int n = csfg_expr_new(pool, CSFG_EXPR_LIT, -1, -1);
     if (n == -1)
         return -1;
 
-    (*pool)->nodes[n].value.lit = value;
+    lit = add_lit(*pool, value);
+    if (lit < 0)
+    {
+        csfg_expr_mark_deleted_shallow(*pool, n);
+        return -1;
+    }
+    (*pool)->nodes[n].value = lit;
+
+    return n;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_expr_symbol(struct csfg_expr_pool** pool, int id)
+{
+    int n = csfg_expr_new(pool, CSFG_EXPR_VAR, -1, -1);
+    if (n == -1)
+        return -1;
+
+    (*pool)->nodes[n].value = id;
 
     return n;
 }
@@ -209,13 +283,18 @@ int csfg_expr_neg(struct csfg_expr_pool** pool, int child)
 /* -------------------------------------------------------------------------- */
 int csfg_expr_set_lit(struct csfg_expr_pool* pool, int n, double value)
 {
+    int lit;
     if (n == -1)
         return -1;
 
-    pool->nodes[n].type      = CSFG_EXPR_LIT;
-    pool->nodes[n].child[0]  = -1;
-    pool->nodes[n].child[1]  = -1;
-    pool->nodes[n].value.lit = value;
+    lit = add_lit(pool, value);
+    if (lit < 0)
+        return -1;
+
+    pool->nodes[n].type     = CSFG_EXPR_LIT;
+    pool->nodes[n].child[0] = -1;
+    pool->nodes[n].child[1] = -1;
+    pool->nodes[n].value    = lit;
 
     return n;
 }
@@ -223,22 +302,15 @@ int csfg_expr_set_lit(struct csfg_expr_pool* pool, int n, double value)
 /* -------------------------------------------------------------------------- */
 int csfg_expr_set_var(struct csfg_expr_pool* pool, int n, struct strview name)
 {
-    int i;
-    struct strview str;
+    int id;
 
     if (n == -1)
         return -1;
 
-    strlist_for_each (pool->var_names, i, str)
-        if (strview_eq(str, name))
-        {
-            pool->nodes[n].value.var_idx = i;
-            return 0;
-        }
-
-    pool->nodes[n].value.var_idx = strlist_count(pool->var_names);
-    if (strlist_add_view(&pool->var_names, name) != 0)
+    id = csfg_symbol_intern(name);
+    if (id < 0)
         return -1;
+    pool->nodes[n].value = id;
 
     return 0;
 }
@@ -388,16 +460,16 @@ int csfg_expr_dup_shallow_from(
     switch ((enum csfg_expr_type)(*src)->nodes[n].type)
     {
         case CSFG_EXPR_GC: break;
-        case CSFG_EXPR_LIT:
-            (*dst)->nodes[dup].value = (*src)->nodes[n].value;
-            break;
-        case CSFG_EXPR_VAR: {
-            int orig_idx        = (*src)->nodes[n].value.var_idx;
-            struct strview orig = strlist_view((*src)->var_names, orig_idx);
-            if (csfg_expr_set_var(*dst, dup, orig) == -1)
+        case CSFG_EXPR_LIT: {
+            int lit = add_lit(*dst, csfg_expr_lit_value(*src, n));
+            if (lit < 0)
                 return -1;
+            (*dst)->nodes[dup].value = lit;
             break;
         }
+        case CSFG_EXPR_VAR:
+            (*dst)->nodes[dup].value = (*src)->nodes[n].value;
+            break;
         case CSFG_EXPR_INF: break;
         case CSFG_EXPR_NEG: break;
         case CSFG_EXPR_ADD: break;
@@ -444,6 +516,45 @@ void csfg_expr_mark_deleted_recursive(struct csfg_expr_pool* pool, int n)
     csfg_expr_mark_deleted_shallow(pool, n);
 }
 
+/* -------------------------------------------------------------------------- */
+static void gc_lits(struct csfg_expr_pool* pool)
+{
+    int n, live, bytes;
+    double* lits;
+
+    live = 0;
+    for (n = 0; n != pool->count; ++n)
+        if (pool->nodes[n].type == CSFG_EXPR_LIT)
+            live++;
+
+    /* Not worth reallocating the table for a few unused entries */
+    if (pool->lit_count < live * 2 + 16)
+        return;
+
+    /* Shared entries are duplicated in the new table, which is harmless. If
+     * the allocation fails, the unused entries are simply kept */
+    bytes = sizeof(double) * (live + 1);
+    lits  = pool->arena ? arena_alloc(pool->arena, bytes) : mem_alloc(bytes);
+    if (lits == NULL)
+        return;
+
+    live = 0;
+    for (n = 0; n != pool->count; ++n)
+        if (pool->nodes[n].type == CSFG_EXPR_LIT)
+        {
+            lits[live]           = csfg_expr_lit_value(pool, n);
+            pool->nodes[n].value = live++;
+        }
+
+    if (pool->arena)
+        arena_free(pool->arena, pool->lits);
+    else
+        mem_free(pool->lits);
+    pool->lits         = lits;
+    pool->lit_count    = live;
+    pool->lit_capacity = live + 1;
+}
+
 /* -------------------------------------------------------------------------- */
 int csfg_expr_gc(struct csfg_expr_pool* pool, int root)
 {
@@ -470,6 +581,9 @@ int csfg_expr_gc(struct csfg_expr_pool* pool, int root)
         n--;
     }
 
+    if (pool != NULL)
+        gc_lits(pool);
+
     return root;
 }
 
@@ -590,18 +704,15 @@ int csfg_expr_equal(
     {
         case CSFG_EXPR_GC: break;
         case CSFG_EXPR_LIT:
-            if (pool1->nodes[expr1].value.lit != pool2->nodes[expr2].value.lit)
+            if (csfg_expr_lit_value(pool1, expr1)
+                != csfg_expr_lit_value(pool2, expr2))
                 return 0;
             break;
-        case CSFG_EXPR_VAR: {
-            struct strview s1 = strlist_view(
-                pool1->var_names, pool1->nodes[expr1].value.var_idx);
-            struct strview s2 = strlist_view(
-                pool2->var_names, pool2->nodes[expr2].value.var_idx);
-            if (!strview_eq(s1, s2))
+        case CSFG_EXPR_VAR:
+            if (pool1->nodes[expr1].value
+                != pool2->nodes[expr2].value)
                 return 0;
             break;
-        }
         case CSFG_EXPR_INF:
         case CSFG_EXPR_NEG:
         case CSFG_EXPR_ADD:
@@ -624,6 +735,49 @@ int csfg_expr_equal(
     return 1;
 }
 
+/* -------------------------------------------------------------------------- */
+hash32 csfg_expr_hash(const struct csfg_expr_pool* pool, int expr)
+{
+    hash32 hash;
+    const struct csfg_expr_node* node;
+
+    if (expr < 0)
+        return 0;
+
+    node = &pool->nodes[expr];
+    hash = node->type;
+    switch ((enum csfg_expr_type)node->type)
+    {
+        case CSFG_EXPR_GC: break;
+        case CSFG_EXPR_LIT: {
+            /* 0.0 and -0.0 compare equal */
+            double lit = csfg_expr_lit_value(pool, expr);
+            if (lit == 0.0)
+                lit = 0.0;
+            hash = hash32_combine(hash, hash32_jenkins_oaat(&lit, sizeof(lit)));
+            break;
+        }
+        case CSFG_EXPR_VAR: {
+            /* Hash the name rather than the ID. IDs depend on the order in
+             * which names were interned and are not stable across runs */
+            struct strview name = csfg_symbol_view(node->value);
+            hash                = hash32_combine(
+                hash,
+                hash32_jenkins_oaat(strview_data(name), strview_len(name)));
+            break;
+        }
+        case CSFG_EXPR_INF:
+        case CSFG_EXPR_NEG:
+        case CSFG_EXPR_ADD:
+        case CSFG_EXPR_MUL:
+        case CSFG_EXPR_POW: break;
+    }
+
+    hash = hash32_combine(hash, csfg_expr_hash(pool, node->child[0]));
+    hash = hash32_combine(hash, csfg_expr_hash(pool, node->child[1]));
+    return hash;
+}
+
 /* -------------------------------------------------------------------------- */
 int csfg_expr_count(const struct csfg_expr_pool* pool, int expr)
 {
@@ -667,13 +821,15 @@ int csfg_expr_lexicographical_compare(
     {
         case CSFG_EXPR_GC: return 0;
         case CSFG_EXPR_LIT:
-            return (int)(pool->nodes[a].value.lit - pool->nodes[b].value.lit);
+            return (int)(csfg_expr_lit_value(pool, a)
+                         - csfg_expr_lit_value(pool, b));
         case CSFG_EXPR_VAR: {
-            int var_idx_a        = pool->nodes[a].value.var_idx;
-            int var_idx_b        = pool->nodes[b].value.var_idx;
-            struct strview var_a = strlist_view(pool->var_names, var_idx_a);
-            struct strview var_b = strlist_view(pool->var_names, var_idx_b);
-            return -strview_lexicographic_compare(var_a, var_b);
+            int var_idx_a = pool->nodes[a].value;
+            int var_idx_b = pool->nodes[b].value;
+            if (var_idx_a == var_idx_b)
+                return 0;
+            return -strview_lexicographic_compare(
+                csfg_symbol_view(var_idx_a), csfg_symbol_view(var_idx_b));
         }
         case CSFG_EXPR_INF: return 0;
         case CSFG_EXPR_NEG:
@@ -1,4 +1,5 @@
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/var_table.h"
 #include "csfg/util/str.h"
 #include <assert.h>
@@ -11,7 +12,7 @@ eval(struct csfg_expr_pool* pool, int n, const struct csfg_var_table* vt)
     switch ((enum csfg_expr_type)pool->nodes[n].type)
     {
         case CSFG_EXPR_GC : break;
-        case CSFG_EXPR_LIT: return pool->nodes[n].value.lit;
+        case CSFG_EXPR_LIT: return csfg_expr_lit_value(pool, n);
         case CSFG_EXPR_VAR: {
             double result;
             if (pool->nodes[n].visited)
@@ -19,8 +20,7 @@ eval(struct csfg_expr_pool* pool, int n, const struct csfg_var_table* vt)
 
             pool->nodes[n].visited = 1;
             result                 = csfg_var_table_eval(
-                vt,
-                strlist_view(pool->var_names, pool->nodes[n].value.var_idx));
+                vt, csfg_symbol_view(pool->nodes[n].value));
             pool->nodes[n].visited = 0;
 
             return result;
@@ -62,6 +62,48 @@ double csfg_expr_eval(
     return eval(pool, root, vt);
 }
 
+/* -------------------------------------------------------------------------- */
+static double eval_symbols(
+    const struct csfg_expr_pool* pool, int n, const double* values, int count)
+{
+    const struct csfg_expr_node* node = &pool->nodes[n];
+    switch ((enum csfg_expr_type)node->type)
+    {
+        case CSFG_EXPR_GC : break;
+        case CSFG_EXPR_LIT: return csfg_expr_lit_value(pool, n);
+        case CSFG_EXPR_VAR:
+            return node->value < count ? values[node->value]
+                                               : NAN;
+        case CSFG_EXPR_INF: return INFINITY;
+        case CSFG_EXPR_NEG:
+            return -eval_symbols(pool, node->child[0], values, count);
+        case CSFG_EXPR_ADD:
+            return eval_symbols(pool, node->child[0], values, count) +
+                   eval_symbols(pool, node->child[1], values, count);
+        case CSFG_EXPR_MUL:
+            return eval_symbols(pool, node->child[0], values, count) *
+                   eval_symbols(pool, node->child[1], values, count);
+        case CSFG_EXPR_POW:
+            return pow(
+                eval_symbols(pool, node->child[0], values, count),
+                eval_symbols(pool, node->child[1], values, count));
+    }
+
+    return NAN;
+}
+
+/* -------------------------------------------------------------------------- */
+double csfg_expr_eval_symbols(
+    const struct csfg_expr_pool* pool,
+    int root,
+    const double* values,
+    int count)
+{
+    if (pool == NULL || root == -1)
+        return NAN;
+    return eval_symbols(pool, root, values, count);
+}
+
 /* -------------------------------------------------------------------------- */
 static int has_any_op_as_parent(const struct csfg_expr_pool* pool, int n)
 {
@@ -111,7 +153,7 @@ int csfg_expr_to_str(
     {
         case CSFG_EXPR_GC : break;
         case CSFG_EXPR_LIT: {
-            double value = pool->nodes[expr].value.lit;
+            double value = csfg_expr_lit_value(pool, expr);
             if (isinf(value))
             {
                 if (str_append_cstr(str, "oo") != 0)
@@ -131,9 +173,8 @@ int csfg_expr_to_str(
         }
 
         case CSFG_EXPR_VAR: {
-            int var_idx          = pool->nodes[expr].value.var_idx;
-            const char* var_name = strlist_cstr(pool->var_names, var_idx);
-            if (str_append_cstr(str, var_name) != 0)
+            int var_idx = pool->nodes[expr].value;
+            if (str_append_cstr(str, csfg_symbol_cstr(var_idx)) != 0)
                 return -1;
             break;
         }
@@ -198,7 +198,9 @@ static int parse_unary(struct parser* p, struct csfg_expr_pool** pool)
             return -1;
         if ((*pool)->nodes[fact].type == CSFG_EXPR_LIT)
         {
-            (*pool)->nodes[fact].value.lit = -(*pool)->nodes[fact].value.lit;
+            /* The literal was just parsed, so no other node shares its
+             * entry and it can be negated in place */
+            (*pool)->lits[(*pool)->nodes[fact].value] *= -1.0;
             return fact;
         }
         return csfg_expr_neg(pool, fact);
@@ -1,4 +1,5 @@
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/util/vec.h"
 #include "mathomatic/externs.h"
 #include "mathomatic/simplify.h"
@@ -27,7 +28,7 @@ static int expr_to_mathomatic_equation(
                 return -1;
             tok->kind           = CONSTANT;
             tok->level          = depth;
-            tok->token.constant = pool->nodes[expr].value.lit;
+            tok->token.constant = csfg_expr_lit_value(pool, expr);
             break;
         case CSFG_EXPR_VAR:
             /* Mathomatic stores variable names in a global array called
@@ -35,15 +36,16 @@ static int expr_to_mathomatic_equation(
              * mathomatic would use malloc() to create an entry, but it looks
              * like none of the important operations cause any reallocations,
              * so we can just copy over our pointers instead of having to copy
-             * over our strings.
+             * over our strings. Symbol IDs are used as the index, so the
+             * variables map back to the same symbols.
              */
-            var_idx = pool->nodes[expr].value.var_idx;
+            var_idx = pool->nodes[expr].value;
             if (var_idx >= MAX_VAR_NAMES)
                 return log_err(
                     "Variable at idx=%d exceeds mathomatic's maximum variable storage size of %d\n",
                     var_idx,
                     MAX_VAR_NAMES);
-            var_names[var_idx] = strlist_data(pool->var_names, var_idx);
+            var_names[var_idx] = (char*)csfg_symbol_cstr(var_idx);
 
             tok = token_vec_emplace(eq);
             if (tok == NULL)
@@ -139,7 +141,7 @@ static int mathomatic_equation_to_expr_recurse(
                 expr = csfg_expr_new(pool, CSFG_EXPR_VAR, -1, -1);
                 if (expr < 0)
                     return -1;
-                (*pool)->nodes[expr].value.var_idx =
+                (*pool)->nodes[expr].value =
                     tok->token.variable - VAR_OFFSET;
 
                 ++*idx;
@@ -189,7 +191,7 @@ static void unlink_variable_names_from_mathomatic(
         case CSFG_EXPR_GC : CSFG_DEBUG_ASSERT(0); break;
         case CSFG_EXPR_LIT: break;
         case CSFG_EXPR_VAR:
-            var_idx            = pool->nodes[expr].value.var_idx;
+            var_idx            = pool->nodes[expr].value;
             var_names[var_idx] = NULL;
             break;
         case CSFG_EXPR_INF : break;
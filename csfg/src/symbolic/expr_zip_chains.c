@@ -46,7 +46,7 @@ static int is_identity(
 {
     if (pool->nodes[expr].type != CSFG_EXPR_LIT)
         return 0;
-    return pool->nodes[expr].value.lit == identity_value_for_type(op_type);
+    return csfg_expr_lit_value(pool, expr) == identity_value_for_type(op_type);
 }
 
 /* -------------------------------------------------------------------------- */
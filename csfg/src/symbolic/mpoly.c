@@ -0,0 +1,646 @@
+#include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/mpoly.h"
+#include "csfg/symbolic/symbol.h"
+#include "csfg/symbolic/var_table.h"
+#include "csfg/util/arena.h"
+#include <math.h>
+
+VEC_DEFINE_SCRATCH(csfg_mpoly_factors, struct csfg_mpoly_factor, 32)
+VEC_DEFINE_SCRATCH(csfg_mpoly_terms, struct csfg_mpoly_term, 32)
+
+#define term_factors(mp, t) (vec_data((mp)->factors) + (t)->first)
+
+/* -------------------------------------------------------------------------- */
+static int degree(const struct csfg_mpoly* mp, const struct csfg_mpoly_term* t)
+{
+    int i, d = 0;
+    for (i = 0; i != t->count; ++i)
+        d += term_factors(mp, t)[i].exp;
+    return d;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Graded order: Monomials are first compared by total degree, then by their
+ * exponent vectors. Because neither comparison changes when both monomials are
+ * multiplied by the same monomial, multiplying a sorted polynomial by a single
+ * term yields a sorted polynomial.
+ */
+static int mono_compare(
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly_term* ta,
+    const struct csfg_mpoly* b,
+    const struct csfg_mpoly_term* tb)
+{
+    const struct csfg_mpoly_factor* fa = term_factors(a, ta);
+    const struct csfg_mpoly_factor* fb = term_factors(b, tb);
+    int i = 0, j = 0;
+    int cmp = degree(a, ta) - degree(b, tb);
+    if (cmp != 0)
+        return cmp;
+
+    while (i != ta->count || j != tb->count)
+    {
+        if (j == tb->count || (i != ta->count && fa[i].var < fb[j].var))
+            return fa[i].exp;
+        if (i == ta->count || fb[j].var < fa[i].var)
+            return -fb[j].exp;
+        if (fa[i].exp != fb[j].exp)
+            return fa[i].exp - fb[j].exp;
+        i++, j++;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static int push_term(
+    struct csfg_mpoly* out,
+    double coeff,
+    const struct csfg_mpoly_factor* factors,
+    int count)
+{
+    int i;
+    struct csfg_mpoly_term* t;
+
+    t = csfg_mpoly_terms_emplace(&out->terms);
+    if (t == NULL)
+        return -1;
+    t->coeff = coeff;
+    t->first = vec_count(out->factors);
+    t->count = count;
+
+    for (i = 0; i != count; ++i)
+        if (csfg_mpoly_factors_push(&out->factors, factors[i]) != 0)
+            return -1;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Pushes the product of two monomials. Factors that cancel out are dropped */
+static int push_term_product(
+    struct csfg_mpoly* out,
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly_term* ta,
+    const struct csfg_mpoly* b,
+    const struct csfg_mpoly_term* tb)
+{
+    struct csfg_mpoly_factor f;
+    struct csfg_mpoly_term* t;
+    const struct csfg_mpoly_factor* fa = term_factors(a, ta);
+    const struct csfg_mpoly_factor* fb = term_factors(b, tb);
+    int i = 0, j = 0;
+    int first = vec_count(out->factors);
+
+    while (i != ta->count || j != tb->count)
+    {
+        if (j == tb->count || (i != ta->count && fa[i].var < fb[j].var))
+            f = fa[i++];
+        else if (i == ta->count || fb[j].var < fa[i].var)
+            f = fb[j++];
+        else
+        {
+            /* Exponents are 16-bit, same as the variable indices */
+            int exp = fa[i].exp + fb[j].exp;
+            if (exp > INT16_MAX || exp < INT16_MIN)
+                return -1;
+            f.var = fa[i].var;
+            f.exp = (int16_t)exp;
+            i++, j++;
+            if (f.exp == 0)
+                continue;
+        }
+
+        if (csfg_mpoly_factors_push(&out->factors, f) != 0)
+            return -1;
+    }
+
+    t = csfg_mpoly_terms_emplace(&out->terms);
+    if (t == NULL)
+        return -1;
+    t->coeff = ta->coeff * tb->coeff;
+    t->first = first;
+    t->count = vec_count(out->factors) - first;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mpoly_copy(struct csfg_mpoly* dst, const struct csfg_mpoly* src)
+{
+    const struct csfg_mpoly_term* t;
+    csfg_mpoly_clear(dst);
+    vec_for_each (src->terms, t)
+        if (push_term(dst, t->coeff, term_factors(src, t), t->count) != 0)
+            return -1;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void csfg_mpoly_swap(struct csfg_mpoly* a, struct csfg_mpoly* b)
+{
+    csfg_mpoly_terms_swap(&a->terms, &b->terms);
+    csfg_mpoly_factors_swap(&a->factors, &b->factors);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mpoly_set_lit(struct csfg_mpoly* mp, double value)
+{
+    csfg_mpoly_clear(mp);
+    if (value == 0.0)
+        return 0;
+    return push_term(mp, value, NULL, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mpoly_set_var(struct csfg_mpoly* mp, int var_idx)
+{
+    struct csfg_mpoly_factor f;
+    if (var_idx < 0 || var_idx > INT16_MAX)
+        return -1;
+
+    f.var = (int16_t)var_idx;
+    f.exp = 1;
+    csfg_mpoly_clear(mp);
+    return push_term(mp, 1.0, &f, 1);
+}
+
+/* -------------------------------------------------------------------------- */
+void csfg_mpoly_scale(struct csfg_mpoly* mp, double factor)
+{
+    struct csfg_mpoly_term* t;
+    if (factor == 0.0)
+    {
+        csfg_mpoly_clear(mp);
+        return;
+    }
+    vec_for_each (mp->terms, t)
+        t->coeff *= factor;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mpoly_add(
+    struct csfg_mpoly* out,
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly* b)
+{
+    int i = 0, j = 0;
+    CSFG_DEBUG_ASSERT(out != a && out != b);
+
+    csfg_mpoly_clear(out);
+    while (i != vec_count(a->terms) || j != vec_count(b->terms))
+    {
+        const struct csfg_mpoly_term *ta, *tb;
+        int cmp;
+
+        if (j == vec_count(b->terms))
+            cmp = -1;
+        else if (i == vec_count(a->terms))
+            cmp = 1;
+        else
+            cmp = mono_compare(
+                a, vec_get(a->terms, i), b, vec_get(b->terms, j));
+
+        if (cmp < 0)
+        {
+            ta = vec_get(a->terms, i);
+            i++;
+            if (push_term(out, ta->coeff, term_factors(a, ta), ta->count) != 0)
+                return -1;
+        }
+        else if (cmp > 0)
+        {
+            tb = vec_get(b->terms, j);
+            j++;
+            if (push_term(out, tb->coeff, term_factors(b, tb), tb->count) != 0)
+                return -1;
+        }
+        else
+        {
+            double coeff;
+            ta    = vec_get(a->terms, i);
+            tb    = vec_get(b->terms, j);
+            coeff = ta->coeff + tb->coeff;
+            i++, j++;
+            if (coeff == 0.0)
+                continue;
+            if (push_term(out, coeff, term_factors(a, ta), ta->count) != 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mpoly_mul(
+    struct csfg_mpoly* out,
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly* b)
+{
+    const struct csfg_mpoly_term *ta, *tb;
+    struct csfg_mpoly row, acc;
+    CSFG_DEBUG_ASSERT(out != a && out != b);
+
+    csfg_mpoly_clear(out);
+    if (csfg_mpoly_is_zero(a) || csfg_mpoly_is_zero(b))
+        return 0;
+
+    csfg_mpoly_init(&row);
+    csfg_mpoly_init(&acc);
+
+    /* Each row ta*b is already sorted, so the product is accumulated by
+     * merging rows into the result */
+    vec_for_each (a->terms, ta)
+    {
+        csfg_mpoly_clear(&row);
+        vec_for_each (b->terms, tb)
+            if (push_term_product(&row, a, ta, b, tb) != 0)
+                goto fail;
+
+        if (csfg_mpoly_add(&acc, out, &row) != 0)
+            goto fail;
+        csfg_mpoly_swap(&acc, out);
+    }
+
+    csfg_mpoly_deinit(&acc);
+    csfg_mpoly_deinit(&row);
+    return 0;
+
+fail:
+    csfg_mpoly_deinit(&acc);
+    csfg_mpoly_deinit(&row);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Pushes the quotient of two monomials, or fails if "tb" does not divide "ta" */
+static int push_term_quotient(
+    struct csfg_mpoly* out,
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly_term* ta,
+    const struct csfg_mpoly* b,
+    const struct csfg_mpoly_term* tb)
+{
+    struct csfg_mpoly_factor f;
+    struct csfg_mpoly_term* t;
+    const struct csfg_mpoly_factor* fa = term_factors(a, ta);
+    const struct csfg_mpoly_factor* fb = term_factors(b, tb);
+    int i = 0, j = 0;
+    int first = vec_count(out->factors);
+
+    while (i != ta->count || j != tb->count)
+    {
+        if (j == tb->count || (i != ta->count && fa[i].var < fb[j].var))
+            f = fa[i++];
+        else if (i == ta->count || fb[j].var < fa[i].var)
+            return -1;
+        else
+        {
+            f.var = fa[i].var;
+            f.exp = fa[i].exp - fb[j].exp;
+            i++, j++;
+            if (f.exp < 0)
+                return -1;
+            if (f.exp == 0)
+                continue;
+        }
+
+        if (csfg_mpoly_factors_push(&out->factors, f) != 0)
+            return -1;
+    }
+
+    t = csfg_mpoly_terms_emplace(&out->terms);
+    if (t == NULL)
+        return -1;
+    t->coeff = ta->coeff / tb->coeff;
+    t->first = first;
+    t->count = vec_count(out->factors) - first;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mpoly_div_exact(
+    struct csfg_mpoly* out,
+    const struct csfg_mpoly* a,
+    const struct csfg_mpoly* b)
+{
+    const struct csfg_mpoly_term *lead_b, *tb;
+    struct csfg_mpoly rem, row, acc;
+    CSFG_DEBUG_ASSERT(out != a && out != b);
+
+    csfg_mpoly_clear(out);
+    if (csfg_mpoly_is_zero(b))
+        return -1;
+    lead_b = vec_last(b->terms);
+
+    csfg_mpoly_init(&rem);
+    csfg_mpoly_init(&row);
+    csfg_mpoly_init(&acc);
+    if (csfg_mpoly_copy(&rem, a) != 0)
+        goto fail;
+
+    /*
+     * Long division: The leading term of the remainder divided by the leading
+     * term of "b" is the next term of the quotient. Quotient terms are found
+     * in descending order, so "out" is reversed at the end. The leading terms
+     * are removed explicitly instead of relying on the floating point
+     * subtraction to produce an exact zero.
+     */
+    while (!csfg_mpoly_is_zero(&rem))
+    {
+        const struct csfg_mpoly_term* lead_r = vec_last(rem.terms);
+        const struct csfg_mpoly_term* q;
+        if (push_term_quotient(out, &rem, lead_r, b, lead_b) != 0)
+            goto fail;
+        q = vec_last(out->terms);
+
+        csfg_mpoly_clear(&row);
+        for (tb = vec_data(b->terms); tb != lead_b; ++tb)
+            if (push_term_product(&row, out, q, b, tb) != 0)
+                goto fail;
+        csfg_mpoly_scale(&row, -1.0);
+
+        csfg_mpoly_terms_pop(rem.terms);
+        if (csfg_mpoly_add(&acc, &rem, &row) != 0)
+            goto fail;
+        csfg_mpoly_swap(&acc, &rem);
+    }
+
+    csfg_mpoly_terms_reverse(out->terms);
+
+    csfg_mpoly_deinit(&acc);
+    csfg_mpoly_deinit(&row);
+    csfg_mpoly_deinit(&rem);
+    return 0;
+
+fail:
+    csfg_mpoly_deinit(&acc);
+    csfg_mpoly_deinit(&row);
+    csfg_mpoly_deinit(&rem);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mpoly_pow(
+    struct csfg_mpoly* out, const struct csfg_mpoly* base, int exp)
+{
+    struct csfg_mpoly tmp, square;
+    CSFG_DEBUG_ASSERT(out != base);
+
+    if (exp == 0)
+        return csfg_mpoly_set_lit(out, 1.0);
+
+    if (exp < 0)
+    {
+        struct csfg_mpoly_term* t;
+        int i, rc;
+
+        /* (c*a^i*b^j)^-k = (1/c * a^-i * b^-j)^k */
+        if (csfg_mpoly_term_count(base) != 1)
+            return -1;
+        if (csfg_mpoly_copy(out, base) != 0)
+            return -1;
+        t        = vec_first(out->terms);
+        t->coeff = 1.0 / t->coeff;
+        for (i = 0; i != t->count; ++i)
+        {
+            if (term_factors(out, t)[i].exp == INT16_MIN)
+                return -1;
+            term_factors(out, t)[i].exp = -term_factors(out, t)[i].exp;
+        }
+
+        csfg_mpoly_init(&tmp);
+        csfg_mpoly_swap(&tmp, out);
+        rc = csfg_mpoly_pow(out, &tmp, -exp);
+        csfg_mpoly_deinit(&tmp);
+        return rc;
+    }
+
+    /* Exponentiation by squaring */
+    csfg_mpoly_init(&tmp);
+    csfg_mpoly_init(&square);
+    if (csfg_mpoly_set_lit(out, 1.0) != 0)
+        goto fail;
+    if (csfg_mpoly_copy(&square, base) != 0)
+        goto fail;
+    while (1)
+    {
+        if (exp & 1)
+        {
+            if (csfg_mpoly_mul(&tmp, out, &square) != 0)
+                goto fail;
+            csfg_mpoly_swap(&tmp, out);
+        }
+        exp >>= 1;
+        if (exp == 0)
+            break;
+        if (csfg_mpoly_mul(&tmp, &square, &square) != 0)
+            goto fail;
+        csfg_mpoly_swap(&tmp, &square);
+    }
+    csfg_mpoly_deinit(&square);
+    csfg_mpoly_deinit(&tmp);
+    return 0;
+
+fail:
+    csfg_mpoly_deinit(&square);
+    csfg_mpoly_deinit(&tmp);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_mpoly_equal(const struct csfg_mpoly* a, const struct csfg_mpoly* b)
+{
+    int i;
+    if (vec_count(a->terms) != vec_count(b->terms))
+        return 0;
+
+    for (i = 0; i != vec_count(a->terms); ++i)
+    {
+        const struct csfg_mpoly_term* ta = vec_get(a->terms, i);
+        const struct csfg_mpoly_term* tb = vec_get(b->terms, i);
+        if (ta->coeff != tb->coeff)
+            return 0;
+        if (ta->count != tb->count)
+            return 0;
+        if (mono_compare(a, ta, b, tb) != 0)
+            return 0;
+    }
+
+    return 1;
+}
+
+/* -------------------------------------------------------------------------- */
+static int from_expr_binop(
+    struct csfg_mpoly* mp,
+    const struct csfg_expr_pool* pool,
+    int left,
+    int right,
+    int (*op)(
+        struct csfg_mpoly*, const struct csfg_mpoly*, const struct csfg_mpoly*))
+{
+    struct csfg_mpoly lhs, rhs;
+    csfg_mpoly_init(&lhs);
+    csfg_mpoly_init(&rhs);
+
+    if (csfg_mpoly_from_expr(&lhs, pool, left) != 0)
+        goto fail;
+    if (csfg_mpoly_from_expr(&rhs, pool, right) != 0)
+        goto fail;
+    if (op(mp, &lhs, &rhs) != 0)
+        goto fail;
+
+    csfg_mpoly_deinit(&rhs);
+    csfg_mpoly_deinit(&lhs);
+    return 0;
+
+fail:
+    csfg_mpoly_deinit(&rhs);
+    csfg_mpoly_deinit(&lhs);
+    return -1;
+}
+int csfg_mpoly_from_expr(
+    struct csfg_mpoly* mp, const struct csfg_expr_pool* pool, int expr)
+{
+    int left, right;
+
+    CSFG_DEBUG_ASSERT(expr > -1);
+    left  = pool->nodes[expr].child[0];
+    right = pool->nodes[expr].child[1];
+
+    switch ((enum csfg_expr_type)pool->nodes[expr].type)
+    {
+        case CSFG_EXPR_GC: break;
+        case CSFG_EXPR_LIT:
+            return csfg_mpoly_set_lit(mp, csfg_expr_lit_value(pool, expr));
+        case CSFG_EXPR_VAR:
+            return csfg_mpoly_set_var(mp, pool->nodes[expr].value);
+        case CSFG_EXPR_INF: break;
+        case CSFG_EXPR_NEG:
+            if (csfg_mpoly_from_expr(mp, pool, left) != 0)
+                return -1;
+            csfg_mpoly_scale(mp, -1.0);
+            return 0;
+        case CSFG_EXPR_ADD:
+            return from_expr_binop(mp, pool, left, right, csfg_mpoly_add);
+        case CSFG_EXPR_MUL:
+            return from_expr_binop(mp, pool, left, right, csfg_mpoly_mul);
+        case CSFG_EXPR_POW: {
+            struct csfg_mpoly base;
+            double value;
+            int k, rc;
+
+            if (pool->nodes[right].type != CSFG_EXPR_LIT)
+                return -1;
+            value = csfg_expr_lit_value(pool, right);
+            if (!(fabs(value) <= INT16_MAX))
+                return -1;
+            k = (int)round(value);
+            if (fabs(value - (double)k) >= 0.0000001)
+                return -1;
+
+            csfg_mpoly_init(&base);
+            rc = csfg_mpoly_from_expr(&base, pool, left);
+            if (rc == 0)
+                rc = csfg_mpoly_pow(mp, &base, k);
+            csfg_mpoly_deinit(&base);
+            return rc;
+        }
+    }
+
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+static int monomial_to_expr(
+    struct csfg_expr_pool** pool,
+    const struct csfg_mpoly* mp,
+    const struct csfg_mpoly_term* t,
+    csfg_mpoly_var_to_expr_func var_to_expr,
+    void* user)
+{
+    int i, expr = -1;
+    for (i = 0; i != t->count; ++i)
+    {
+        struct csfg_mpoly_factor f = term_factors(mp, t)[i];
+        int factor = var_to_expr(pool, f.var, user);
+        if (f.exp != 1)
+            factor = csfg_expr_pow(pool, factor, csfg_expr_lit(pool, f.exp));
+
+        expr = expr == -1 ? factor : csfg_expr_mul(pool, expr, factor);
+        if (expr < 0)
+            return -1;
+    }
+    return expr;
+}
+static int pool_var_to_expr(struct csfg_expr_pool** pool, int var, void* user)
+{
+    (void)user;
+    return csfg_expr_symbol(pool, var);
+}
+int csfg_mpoly_to_expr(
+    const struct csfg_mpoly* mp, struct csfg_expr_pool** pool)
+{
+    return csfg_mpoly_to_expr_with(mp, pool, pool_var_to_expr, NULL);
+}
+int csfg_mpoly_to_expr_with(
+    const struct csfg_mpoly* mp,
+    struct csfg_expr_pool** pool,
+    csfg_mpoly_var_to_expr_func var_to_expr,
+    void* user)
+{
+    const struct csfg_mpoly_term* t;
+    int expr = -1;
+
+    if (csfg_mpoly_is_zero(mp))
+        return csfg_expr_lit(pool, 0.0);
+
+    vec_for_each (mp->terms, t)
+    {
+        int term;
+        if (t->count == 0)
+            term = csfg_expr_lit(pool, t->coeff);
+        else if (t->coeff == 1.0)
+            term = monomial_to_expr(pool, mp, t, var_to_expr, user);
+        else if (t->coeff == -1.0)
+            term = csfg_expr_neg(
+                pool, monomial_to_expr(pool, mp, t, var_to_expr, user));
+        else
+            term = csfg_expr_mul(
+                pool,
+                csfg_expr_lit(pool, t->coeff),
+                monomial_to_expr(pool, mp, t, var_to_expr, user));
+
+        expr = expr == -1 ? term : csfg_expr_add(pool, expr, term);
+        if (expr < 0)
+            return -1;
+    }
+
+    return expr;
+}
+
+/* -------------------------------------------------------------------------- */
+double csfg_mpoly_eval(
+    const struct csfg_mpoly* mp, const struct csfg_var_table* vt)
+{
+    const struct csfg_mpoly_term* t;
+    double result = 0.0;
+
+    vec_for_each (mp->terms, t)
+    {
+        int i;
+        double value = t->coeff;
+        for (i = 0; i != t->count; ++i)
+        {
+            struct csfg_mpoly_factor f = term_factors(mp, t)[i];
+            struct strview name        = csfg_symbol_view(f.var);
+            value *= pow(csfg_var_table_eval(vt, name), f.exp);
+        }
+        result += value;
+    }
+
+    return result;
+}
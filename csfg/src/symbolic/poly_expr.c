@@ -1,8 +1,11 @@
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/mpoly.h"
 #include "csfg/symbolic/poly_expr.h"
+#include "csfg/util/arena.h"
+#include "csfg/util/mem.h"
 #include "csfg/util/str.h"
 
-VEC_DEFINE(csfg_poly_expr, struct csfg_coeff_expr, 8)
+VEC_DEFINE_SCRATCH(csfg_poly_expr, struct csfg_coeff_expr, 16)
 
 /* -------------------------------------------------------------------------- */
 static int set_coeff(struct csfg_coeff_expr* c, double factor, int expr)
@@ -210,7 +213,12 @@ int csfg_poly_expr_copy(
 }
 
 /* -------------------------------------------------------------------------- */
-int csfg_poly_expr_add(
+/*
+ * Fallback for coefficients that are not polynomials in the circuit
+ * parameters, such as divisions by sums. The coefficient expressions are
+ * combined into larger expressions.
+ */
+static int add_exprs(
     struct csfg_expr_pool** pool,
     struct csfg_poly_expr** out,
     const struct csfg_poly_expr* p1,
@@ -250,7 +258,7 @@ int csfg_poly_expr_add(
 }
 
 /* -------------------------------------------------------------------------- */
-int csfg_poly_expr_mul(
+static int mul_exprs(
     struct csfg_expr_pool** pool,
     struct csfg_poly_expr** out,
     const struct csfg_poly_expr* p1,
@@ -289,6 +297,212 @@ int csfg_poly_expr_mul(
     return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+static void mpolys_free(struct csfg_mpoly* mps, int count)
+{
+    int i;
+    for (i = 0; i != count; ++i)
+        csfg_mpoly_deinit(&mps[i]);
+    mem_free(mps);
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Converts every coefficient, including its factor, into a sparse polynomial
+ * in the circuit parameters. Returns NULL if a coefficient can't be
+ * represented this way.
+ */
+static struct csfg_mpoly* mpolys_from_poly(
+    const struct csfg_expr_pool* pool, const struct csfg_poly_expr* p)
+{
+    struct csfg_mpoly* mps;
+    const struct csfg_coeff_expr* c;
+    int i;
+
+    mps = mem_alloc(sizeof(*mps) * (vec_count(p) + 1));
+    if (mps == NULL)
+        return NULL;
+    for (i = 0; i != vec_count(p); ++i)
+        csfg_mpoly_init(&mps[i]);
+
+    vec_enumerate (p, i, c)
+    {
+        if (c->factor == 0.0 || c->expr < 0)
+        {
+            if (csfg_mpoly_set_lit(&mps[i], c->factor) != 0)
+                goto fail;
+            continue;
+        }
+        if (csfg_mpoly_from_expr(&mps[i], pool, c->expr) != 0)
+            goto fail;
+        csfg_mpoly_scale(&mps[i], c->factor);
+    }
+
+    return mps;
+
+fail:
+    mpolys_free(mps, vec_count(p));
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Converts a result back into a coefficient. The constant of a single term
+ * becomes the factor, as with mul_coeffs(). Sums keep their constants in the
+ * expression and have a factor of 1, as with add_coeffs().
+ */
+static int coeff_from_mpoly(
+    struct csfg_expr_pool** pool,
+    struct csfg_coeff_expr* coeff,
+    struct csfg_mpoly* mp)
+{
+    const struct csfg_mpoly_term* t;
+    double factor;
+    int expr;
+
+    if (csfg_mpoly_is_zero(mp))
+        return set_coeff(coeff, 0.0, -1);
+
+    t      = vec_first(mp->terms);
+    factor = 1.0;
+    if (csfg_mpoly_term_count(mp) == 1)
+    {
+        if (t->count == 0)
+            return set_coeff(coeff, t->coeff, -1);
+        factor = t->coeff;
+        csfg_mpoly_scale(mp, 1.0 / factor);
+    }
+
+    expr = csfg_mpoly_to_expr(mp, pool);
+    return set_and_check_coeff(coeff, factor, expr);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_poly_expr_add(
+    struct csfg_expr_pool** pool,
+    struct csfg_poly_expr** out,
+    const struct csfg_poly_expr* p1,
+    const struct csfg_poly_expr* p2)
+{
+    struct csfg_mpoly *m1, *m2;
+    struct csfg_mpoly zero, sum;
+    int i, count;
+    int result = -1;
+
+    count = vec_count(p1) > vec_count(p2) ? vec_count(p1) : vec_count(p2);
+    csfg_poly_expr_clear(*out);
+    if (csfg_poly_expr_realloc(out, count) != 0)
+        return -1;
+
+    /* Only the resulting expressions outlive this function */
+    arena_scratch_begin();
+    m1 = mpolys_from_poly(*pool, p1);
+    m2 = m1 ? mpolys_from_poly(*pool, p2) : NULL;
+    if (m2 == NULL)
+    {
+        if (m1)
+            mpolys_free(m1, vec_count(p1));
+        arena_scratch_end();
+        return add_exprs(pool, out, p1, p2);
+    }
+
+    csfg_mpoly_init(&zero);
+    csfg_mpoly_init(&sum);
+    for (i = 0; i != count; ++i)
+    {
+        struct csfg_coeff_expr coeff;
+        if (csfg_mpoly_add(
+                &sum,
+                i < vec_count(p1) ? &m1[i] : &zero,
+                i < vec_count(p2) ? &m2[i] : &zero)
+            != 0)
+        {
+            goto out;
+        }
+        if (coeff_from_mpoly(pool, &coeff, &sum) != 0)
+            goto out;
+        /* This can't fail because we realloc'd earlier */
+        csfg_poly_expr_push_no_realloc(*out, coeff);
+    }
+    result = 0;
+
+out:
+    csfg_mpoly_deinit(&sum);
+    csfg_mpoly_deinit(&zero);
+    mpolys_free(m2, vec_count(p2));
+    mpolys_free(m1, vec_count(p1));
+    arena_scratch_end();
+    return result;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_poly_expr_mul(
+    struct csfg_expr_pool** pool,
+    struct csfg_poly_expr** out,
+    const struct csfg_poly_expr* p1,
+    const struct csfg_poly_expr* p2)
+{
+    struct csfg_mpoly *m1, *m2;
+    struct csfg_mpoly acc, product, sum;
+    int i, i1, count;
+    int result = -1;
+
+    count = vec_count(p1) + vec_count(p2) - 1;
+    if (vec_count(p1) == 0 || vec_count(p2) == 0)
+        count = 0;
+    csfg_poly_expr_clear(*out);
+    if (csfg_poly_expr_realloc(out, count) != 0)
+        return -1;
+
+    /* Only the resulting expressions outlive this function */
+    arena_scratch_begin();
+    m1 = mpolys_from_poly(*pool, p1);
+    m2 = m1 ? mpolys_from_poly(*pool, p2) : NULL;
+    if (m2 == NULL)
+    {
+        if (m1)
+            mpolys_free(m1, vec_count(p1));
+        arena_scratch_end();
+        return mul_exprs(pool, out, p1, p2);
+    }
+
+    csfg_mpoly_init(&acc);
+    csfg_mpoly_init(&product);
+    csfg_mpoly_init(&sum);
+    for (i = 0; i != count; ++i)
+    {
+        struct csfg_coeff_expr coeff;
+
+        csfg_mpoly_clear(&acc);
+        for (i1 = 0; i1 != vec_count(p1); ++i1)
+        {
+            int i2 = i - i1;
+            if (i2 < 0 || i2 >= vec_count(p2))
+                continue;
+            if (csfg_mpoly_mul(&product, &m1[i1], &m2[i2]) != 0)
+                goto out;
+            if (csfg_mpoly_add(&sum, &acc, &product) != 0)
+                goto out;
+            csfg_mpoly_swap(&sum, &acc);
+        }
+
+        if (coeff_from_mpoly(pool, &coeff, &acc) != 0)
+            goto out;
+        /* This can't fail because we realloc'd earlier */
+        csfg_poly_expr_push_no_realloc(*out, coeff);
+    }
+    result = 0;
+
+out:
+    csfg_mpoly_deinit(&sum);
+    csfg_mpoly_deinit(&product);
+    csfg_mpoly_deinit(&acc);
+    mpolys_free(m2, vec_count(p2));
+    mpolys_free(m1, vec_count(p1));
+    arena_scratch_end();
+    return result;
+}
+
 /* -------------------------------------------------------------------------- */
 int csfg_poly_expr_div(
     struct csfg_expr_pool** pool,
@@ -361,38 +575,104 @@ int csfg_poly_expr_gcd(
     const struct csfg_poly_expr* p1,
     const struct csfg_poly_expr* p2)
 {
-    const struct csfg_coeff_expr* c;
-    struct csfg_poly_expr *next_gcd, *tmp;
-    csfg_poly_expr_init(&next_gcd);
+    struct csfg_poly_expr *cur_gcd, *next_gcd, *tmp;
+    int rc;
     CSFG_DEBUG_ASSERT(vec_count(*gcd) == 0);
 
-    if (csfg_poly_expr_realloc(gcd, vec_count(p2)) != 0 ||
-        csfg_poly_expr_realloc(&next_gcd, vec_count(p1)) != 0)
-        goto realloc_failed;
-
-    vec_for_each (p1, c)
-        csfg_poly_expr_push_no_realloc(next_gcd, *c);
-    vec_for_each (p2, c)
-        csfg_poly_expr_push_no_realloc(*gcd, *c);
+    /* The intermediate remainders are temporaries */
+    arena_scratch_begin();
+    csfg_poly_expr_init(&cur_gcd);
+    csfg_poly_expr_init(&next_gcd);
 
-    while (1)
+    rc = csfg_poly_expr_copy(&next_gcd, p1);
+    if (rc == 0)
+        rc = csfg_poly_expr_copy(&cur_gcd, p2);
+    while (rc == 0)
     {
-        csfg_poly_expr_div(pool, NULL, &next_gcd, next_gcd, *gcd);
+        csfg_poly_expr_div(pool, NULL, &next_gcd, next_gcd, cur_gcd);
         if (csfg_poly_expr_degree(next_gcd) <= 0)
             break;
         tmp      = next_gcd;
-        next_gcd = *gcd;
-        *gcd     = tmp;
+        next_gcd = cur_gcd;
+        cur_gcd  = tmp;
     }
+    arena_scratch_end();
+
+    if (rc == 0)
+        rc = csfg_poly_expr_copy(gcd, cur_gcd);
 
     csfg_poly_expr_deinit(next_gcd);
+    csfg_poly_expr_deinit(cur_gcd);
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_coeff_expr_canonicalize(
+    struct csfg_expr_pool** pool, struct csfg_coeff_expr* coeff)
+{
+    struct csfg_mpoly mp;
+    const struct csfg_mpoly_term* lead;
+    double factor;
+    int expr;
+
+    if (coeff->expr < 0)
+        return 0;
+
+    /* Only the resulting expression and factor outlive this function */
+    arena_scratch_begin();
+    csfg_mpoly_init(&mp);
+    if (csfg_mpoly_from_expr(&mp, *pool, coeff->expr) != 0)
+        goto fail;
+    csfg_mpoly_scale(&mp, coeff->factor);
+
+    if (csfg_mpoly_is_zero(&mp))
+    {
+        csfg_mpoly_deinit(&mp);
+        arena_scratch_end();
+        *coeff = csfg_coeff_expr(0.0, -1);
+        return 0;
+    }
+
+    /* 3*a*b -> factor=3, expr=a*b
+     * 2*a + 4*b -> factor=4, expr=0.5*a + b */
+    lead   = vec_last(mp.terms);
+    factor = lead->coeff;
+    if (csfg_mpoly_term_count(&mp) == 1 && lead->count == 0)
+    {
+        csfg_mpoly_deinit(&mp);
+        arena_scratch_end();
+        *coeff = csfg_coeff_expr(factor, -1);
+        return 0;
+    }
+
+    csfg_mpoly_scale(&mp, 1.0 / factor);
+    expr = csfg_mpoly_to_expr(&mp, pool);
+    if (expr < 0)
+        goto fail;
+
+    csfg_mpoly_deinit(&mp);
+    arena_scratch_end();
+    *coeff = csfg_coeff_expr(factor, expr);
     return 0;
 
-realloc_failed:
-    csfg_poly_expr_deinit(next_gcd);
+fail:
+    csfg_mpoly_deinit(&mp);
+    arena_scratch_end();
     return -1;
 }
 
+/* -------------------------------------------------------------------------- */
+int csfg_poly_expr_canonicalize(
+    struct csfg_expr_pool** pool, struct csfg_poly_expr* poly)
+{
+    struct csfg_coeff_expr* c;
+    int failed = 0;
+    vec_for_each (poly, c)
+        if (csfg_coeff_expr_canonicalize(pool, c) != 0)
+            failed++;
+    return failed;
+}
+
 /* -------------------------------------------------------------------------- */
 int csfg_poly_expr_to_str(
     struct str** str,
@@ -29,7 +29,7 @@ static int expand_constant_exponents(struct csfg_expr_pool** pool)
         if ((*pool)->nodes[exp].type != CSFG_EXPR_LIT)
             continue;
 
-        value = (*pool)->nodes[exp].value.lit;
+        value = csfg_expr_lit_value(*pool, exp);
         if (!is_almost_integer(value, 0.0000001))
             continue;
 
@@ -22,7 +22,7 @@ static int find_power_with_negative_constant_exponent(
         int exp = pool->nodes[n].child[1];
         if (pool->nodes[exp].type != CSFG_EXPR_LIT)
             return -1;
-        if (pool->nodes[exp].value.lit >= 0.0)
+        if (csfg_expr_lit_value(pool, exp) >= 0.0)
             return -1;
         return n;
     }
@@ -55,7 +55,7 @@ static int factor_common_denominator(struct csfg_expr_pool** pool)
             continue;
 
         exp     = (*pool)->nodes[pow].child[1];
-        neg_exp = -(*pool)->nodes[exp].value.lit;
+        neg_exp = -csfg_expr_lit_value(*pool, exp);
 
         product = csfg_expr_find_parent(*pool, pow);
         if ((*pool)->nodes[product].type == CSFG_EXPR_MUL)
@@ -19,7 +19,9 @@ static int eval_subtrees(struct csfg_expr_pool** pool)
             (*pool)->nodes[left].type == CSFG_EXPR_LIT &&
             (*pool)->nodes[right].type == CSFG_EXPR_LIT)
         {
-            csfg_expr_set_lit(*pool, n, csfg_expr_eval(*pool, n, NULL));
+            if (csfg_expr_set_lit(*pool, n, csfg_expr_eval(*pool, n, NULL))
+                < 0)
+                return -1;
             csfg_expr_mark_deleted_recursive(*pool, left);
             csfg_expr_mark_deleted_recursive(*pool, right);
             modified = 1;
@@ -30,7 +32,9 @@ static int eval_subtrees(struct csfg_expr_pool** pool)
             right == -1 && left != -1 &&
             (*pool)->nodes[left].type == CSFG_EXPR_LIT)
         {
-            csfg_expr_set_lit(*pool, n, csfg_expr_eval(*pool, n, NULL));
+            if (csfg_expr_set_lit(*pool, n, csfg_expr_eval(*pool, n, NULL))
+                < 0)
+                return -1;
             csfg_expr_mark_deleted_recursive(*pool, left);
             modified = 1;
         }
@@ -104,12 +108,13 @@ static int combine_constants(struct csfg_expr_pool** pool)
             continue;
 
         if (op_type == CSFG_EXPR_ADD)
-            combined_value = (*pool)->nodes[constant].value.lit +
-                             (*pool)->nodes[match].value.lit;
+            combined_value = csfg_expr_lit_value(*pool, constant) +
+                             csfg_expr_lit_value(*pool, match);
         else
-            combined_value = (*pool)->nodes[constant].value.lit *
-                             (*pool)->nodes[match].value.lit;
-        csfg_expr_set_lit(*pool, constant, combined_value);
+            combined_value = csfg_expr_lit_value(*pool, constant) *
+                             csfg_expr_lit_value(*pool, match);
+        if (csfg_expr_set_lit(*pool, constant, combined_value) < 0)
+            return -1;
         csfg_expr_collapse_sibling_into_parent(*pool, match);
         modified = 1;
     }
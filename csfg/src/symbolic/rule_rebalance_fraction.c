@@ -40,7 +40,7 @@ static int move_reciprocs(
     if ((*from)->nodes[exp].type != CSFG_EXPR_LIT)
         return 0;
 
-    value = (*from)->nodes[exp].value.lit;
+    value = csfg_expr_lit_value(*from, exp);
     if (value >= 0.0)
         return 0;
 
@@ -56,9 +56,10 @@ static int move_reciprocs(
         return -1;
     }
 
+    if (csfg_expr_set_lit(*from, from_root, 1.0) < 0)
+        return -1;
     csfg_expr_mark_deleted_recursive(*from, base);
     csfg_expr_mark_deleted_shallow(*from, exp);
-    csfg_expr_set_lit(*from, from_root, 1.0);
 
     return 1;
 }
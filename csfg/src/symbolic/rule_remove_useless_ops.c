@@ -79,8 +79,8 @@ static int remove_double_reciprocs(struct csfg_expr_pool** pool)
             continue;
         }
 
-        if (!floats_equal((*pool)->nodes[exp1].value.lit, -1.0, 0.0000001) ||
-            !floats_equal((*pool)->nodes[exp2].value.lit, -1.0, 0.0000001))
+        if (!floats_equal(csfg_expr_lit_value(*pool, exp1), -1.0, 0.0000001) ||
+            !floats_equal(csfg_expr_lit_value(*pool, exp2), -1.0, 0.0000001))
         {
             continue;
         }
@@ -108,14 +108,14 @@ static int remove_zero_summands(struct csfg_expr_pool** pool)
             continue;
 
         if ((*pool)->nodes[left].type == CSFG_EXPR_LIT &&
-            floats_equal((*pool)->nodes[left].value.lit, 0.0, 0.0000001))
+            floats_equal(csfg_expr_lit_value(*pool, left), 0.0, 0.0000001))
         {
             csfg_expr_collapse_into_parent(*pool, right, n);
             modified = 1;
         }
         else if (
             (*pool)->nodes[right].type == CSFG_EXPR_LIT &&
-            floats_equal((*pool)->nodes[right].value.lit, 0.0, 0.0000001))
+            floats_equal(csfg_expr_lit_value(*pool, right), 0.0, 0.0000001))
         {
             csfg_expr_collapse_into_parent(*pool, left, n);
             modified = 1;
@@ -143,7 +143,7 @@ static int remove_one_products(struct csfg_expr_pool** pool)
             if ((*pool)->nodes[child].type != CSFG_EXPR_LIT)
                 continue;
 
-            value = (*pool)->nodes[child].value.lit;
+            value = csfg_expr_lit_value(*pool, child);
             if (floats_equal(value, 1.0, 0.0000001))
             {
                 csfg_expr_collapse_into_parent(*pool, sibling, n);
@@ -178,7 +178,7 @@ static int remove_one_and_zero_exponents(struct csfg_expr_pool** pool)
         if ((*pool)->nodes[right].type != CSFG_EXPR_LIT)
             continue;
 
-        value = (*pool)->nodes[right].value.lit;
+        value = csfg_expr_lit_value(*pool, right);
         if (floats_equal(value, 1.0, 0.0000001))
         {
             csfg_expr_collapse_into_parent(*pool, left, n);
@@ -186,9 +186,10 @@ static int remove_one_and_zero_exponents(struct csfg_expr_pool** pool)
         }
         else if (floats_equal(value, 0.0, 0.0000001))
         {
+            if (csfg_expr_set_lit(*pool, n, 1.0) < 0)
+                return -1;
             csfg_expr_mark_deleted_recursive(*pool, left);
             csfg_expr_mark_deleted_shallow(*pool, right);
-            csfg_expr_set_lit(*pool, n, 1.0);
             modified = 1;
         }
     }
@@ -197,16 +198,18 @@ static int remove_one_and_zero_exponents(struct csfg_expr_pool** pool)
 }
 
 /* -------------------------------------------------------------------------- */
-static void replace_node_with_one(struct csfg_expr_pool** pool, int n)
+static int replace_node_with_one(struct csfg_expr_pool** pool, int n)
 {
     int left = (*pool)->nodes[n].child[0];
     int right = (*pool)->nodes[n].child[1];
+    if (csfg_expr_set_lit(*pool, n, 1.0) < 0)
+        return -1;
+
     if (left > -1)
         csfg_expr_mark_deleted_recursive(*pool, left);
     if (right > -1)
         csfg_expr_mark_deleted_recursive(*pool, right);
-
-    csfg_expr_set_lit(*pool, n, 1.0);
+    return 0;
 }
 static int
 find_common_products(struct csfg_expr_pool** pool, int expr1, int expr2)
@@ -214,8 +217,10 @@ find_common_products(struct csfg_expr_pool** pool, int expr1, int expr2)
     int left, right, rc;
     if (csfg_expr_equal(*pool, expr1, *pool, expr2))
     {
-        replace_node_with_one(pool, expr1);
-        replace_node_with_one(pool, expr2);
+        if (replace_node_with_one(pool, expr1) != 0)
+            return -1;
+        if (replace_node_with_one(pool, expr2) != 0)
+            return -1;
         return 1;
     }
 
@@ -260,7 +265,7 @@ static int cancel_products(struct csfg_expr_pool** pool)
         if ((*pool)->nodes[right].type != CSFG_EXPR_LIT)
             continue;
 
-        value = (*pool)->nodes[right].value.lit;
+        value = csfg_expr_lit_value(*pool, right);
         if (!floats_equal(value, -1.0, 0.0000001))
             continue;
 
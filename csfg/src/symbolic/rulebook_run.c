@@ -1,6 +1,7 @@
 #include "csfg/config.h"
 #include "csfg/symbolic/expr.h"
 #include "csfg/symbolic/rulebook.h"
+#include "csfg/util/arena.h"
 #include <assert.h>
 #include <math.h>
 #include <stddef.h>
@@ -14,7 +15,7 @@ VEC_DECLARE(node_idx_vec, int, 16)
 VEC_DEFINE(node_idx_vec, int, 16)
 
 VEC_DECLARE(permutation_vec, int, 16)
-VEC_DEFINE(permutation_vec, int, 16)
+VEC_DEFINE_SCRATCH(permutation_vec, int, 16)
 
 enum match_result
 {
@@ -32,7 +33,7 @@ struct match_info
 };
 
 VEC_DECLARE(match_info_vec, struct match_info, 8)
-VEC_DEFINE(match_info_vec, struct match_info, 8)
+VEC_DEFINE_SCRATCH(match_info_vec, struct match_info, 8)
 
 /* -------------------------------------------------------------------------- */
 #if DEBUG_PRINTF == 1
@@ -173,14 +174,14 @@ static int remove_zero_summands(struct csfg_expr_pool** pool)
             continue;
 
         if ((*pool)->nodes[left].type == CSFG_EXPR_LIT &&
-            floats_equal((*pool)->nodes[left].value.lit, 0.0, 0.0000001))
+            floats_equal(csfg_expr_lit_value(*pool, left), 0.0, 0.0000001))
         {
             csfg_expr_collapse_into_parent(*pool, right, n);
             modified = 1;
         }
         else if (
             (*pool)->nodes[right].type == CSFG_EXPR_LIT &&
-            floats_equal((*pool)->nodes[right].value.lit, 0.0, 0.0000001))
+            floats_equal(csfg_expr_lit_value(*pool, right), 0.0, 0.0000001))
         {
             csfg_expr_collapse_into_parent(*pool, left, n);
             modified = 1;
@@ -208,7 +209,7 @@ static int remove_one_products(struct csfg_expr_pool** pool)
             if ((*pool)->nodes[child].type != CSFG_EXPR_LIT)
                 continue;
 
-            value = (*pool)->nodes[child].value.lit;
+            value = csfg_expr_lit_value(*pool, child);
             if (floats_equal(value, 1.0, 0.0000001))
             {
                 csfg_expr_collapse_into_parent(*pool, sibling, n);
@@ -283,19 +284,19 @@ static enum match_result match_subtree(
 
             if (match_info_add(
                     matched_nodes,
-                    search_node->value.var_idx,
+                    search_node->value,
                     search_expr,
                     target_expr) != 0)
                 return MATCH_OOM;
 
             /* We can key on var_idx here instead of having to compare strings,
-             * because csfg_expr_pool::var_names guarantees uniqueness. Both
-             * structs point into the same varnames strlist */
+             * because variable names are interned in the global symbol table
+             * (see csfg/symbolic/symbol.h) */
 
             /* If the search pattern uses the same variable again, then we must
              * check if the last subtree is the same as this subtree. */
             vec_enumerate (*matched_nodes, i, match_info)
-                if (match_info->var_idx == search_node->value.var_idx)
+                if (match_info->var_idx == search_node->value)
                     if (!csfg_expr_equal(
                             target_pool,
                             target_expr,
@@ -310,7 +311,8 @@ static enum match_result match_subtree(
 
         case CSFG_EXPR_LIT: {
             if (target_node->type != search_node->type ||
-                target_node->value.lit != search_node->value.lit)
+                csfg_expr_lit_value(target_pool, target_expr)
+                    != csfg_expr_lit_value(ruleset_pool, search_expr))
                 return MATCH_NONE;
             return MATCH_FOUND;
         }
@@ -614,7 +616,8 @@ static int dup_replace_tree(
     {
         case CSFG_EXPR_GC: CSFG_DEBUG_ASSERT(0); break;
         case CSFG_EXPR_LIT:
-            return csfg_expr_lit(target_pool, replace_node->value.lit);
+            return csfg_expr_lit(
+                target_pool, csfg_expr_lit_value(ruleset_pool, replace_expr));
         case CSFG_EXPR_INF: return csfg_expr_inf(target_pool);
         case CSFG_EXPR_NEG:
             return csfg_expr_neg(
@@ -644,11 +647,7 @@ static int dup_replace_tree(
             const struct match_info* match_info;
             vec_for_each (matched_nodes, match_info)
             {
-                int replace_var = replace_node->value.var_idx;
-                int match_var   = match_info->var_idx;
-                if (strview_eq(
-                        strlist_view(ruleset_pool->var_names, replace_var),
-                        strlist_view(ruleset_pool->var_names, match_var)))
+                if (replace_node->value == match_info->var_idx)
                 {
                     return csfg_expr_dup_recurse(
                         target_pool, match_info->target_node);
@@ -845,6 +844,7 @@ int csfg_rulebook_run(
     CSFG_DEBUG_ASSERT(expr != NULL);
     CSFG_DEBUG_ASSERT(csfg_expr_is_canonicalized(*pool, *expr));
 
+    arena_scratch_begin();
     match_info_vec_init(&matched_nodes);
     permutation_vec_init(&permutations);
     debug_depth_reset();
@@ -884,10 +884,12 @@ int csfg_rulebook_run(
 
     match_info_vec_deinit(matched_nodes);
     permutation_vec_deinit(permutations);
+    arena_scratch_end();
     return modified;
 
 fail:
     match_info_vec_deinit(matched_nodes);
     permutation_vec_deinit(permutations);
+    arena_scratch_end();
     return -1;
 }
@@ -0,0 +1,70 @@
+#include "csfg/symbolic/symbol.h"
+#include "csfg/util/hmap_str.h"
+#include "csfg/util/strlist.h"
+
+HMAP_DECLARE_STR(static, symbol_hmap, int, 32)
+HMAP_DEFINE_STR(static, symbol_hmap, int, 32)
+
+/* IDs index into "names". The map is only used to find existing names */
+static struct strlist* names;
+static struct symbol_hmap* ids;
+
+/* -------------------------------------------------------------------------- */
+int csfg_symbol_intern(struct strview name)
+{
+    int* id;
+
+    /* Looking the name up first also makes it safe to intern a view returned
+     * by csfg_symbol_view(), which strlist_add_view() would invalidate */
+    id = symbol_hmap_find(ids, name);
+    if (id != NULL)
+        return *id;
+
+    if (strlist_add_view(&names, name) != 0)
+        return -1;
+    id = symbol_hmap_emplace_new(&ids, strlist_view(names, names->count - 1));
+    if (id == NULL)
+    {
+        strlist_erase(names, names->count - 1);
+        return -1;
+    }
+    *id = names->count - 1;
+
+    return *id;
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_symbol_find(struct strview name)
+{
+    int* id = symbol_hmap_find(ids, name);
+    return id ? *id : -1;
+}
+
+/* -------------------------------------------------------------------------- */
+struct strview csfg_symbol_view(int id)
+{
+    CSFG_DEBUG_ASSERT(id >= 0 && id < strlist_count(names));
+    return strlist_view(names, id);
+}
+
+/* -------------------------------------------------------------------------- */
+const char* csfg_symbol_cstr(int id)
+{
+    CSFG_DEBUG_ASSERT(id >= 0 && id < strlist_count(names));
+    return strlist_cstr(names, id);
+}
+
+/* -------------------------------------------------------------------------- */
+int csfg_symbol_count(void)
+{
+    return strlist_count(names);
+}
+
+/* -------------------------------------------------------------------------- */
+void csfg_symbols_deinit(void)
+{
+    symbol_hmap_deinit(ids);
+    strlist_deinit(names);
+    symbol_hmap_init(&ids);
+    strlist_init(&names);
+}
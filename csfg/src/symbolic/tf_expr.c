@@ -1,8 +1,10 @@
 #include "csfg/symbolic/expr.h"
 #include "csfg/symbolic/rulebook.h"
 #include "csfg/symbolic/rules.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/tf_expr.h"
 #include "csfg/symbolic/var_table.h"
+#include "csfg/util/arena.h"
 #include <math.h>
 
 /* -------------------------------------------------------------------------- */
@@ -33,7 +35,7 @@ static int csfg_expr_to_rational_recurse(
     {
         case CSFG_EXPR_GC : assert(0); break;
         case CSFG_EXPR_LIT: {
-            double value = (*pool)->nodes[expr].value.lit;
+            double value = csfg_expr_lit_value(*pool, expr);
             if (csfg_poly_expr_push(&tf->num, csfg_coeff_expr(value, -1)) != 0)
                 return -1;
             if (csfg_poly_expr_push(&tf->den, csfg_coeff_expr(1.0, -1)) != 0)
@@ -50,8 +52,8 @@ static int csfg_expr_to_rational_recurse(
         }
 
         case CSFG_EXPR_VAR: {
-            int var_idx = (*pool)->nodes[expr].value.var_idx;
-            var         = strlist_view((*pool)->var_names, var_idx);
+            int var_idx = (*pool)->nodes[expr].value;
+            var         = csfg_symbol_view(var_idx);
             if (strview_eq_cstr(var, variable))
             {
                 /* 0 + 1*s */
@@ -74,7 +76,7 @@ static int csfg_expr_to_rational_recurse(
         }
 
         case CSFG_EXPR_NEG: {
-            if (csfg_expr_to_rational(tf, pool, left, variable) != 0)
+            if (csfg_expr_to_rational_recurse(tf, pool, left, variable) != 0)
                 return -1;
             vec_for_each (tf->num, coeff)
                 coeff->factor *= -1;
@@ -90,12 +92,12 @@ static int csfg_expr_to_rational_recurse(
              */
 
             /* lhs */
-            rc = csfg_expr_to_rational(&r1, pool, left, variable);
+            rc = csfg_expr_to_rational_recurse(&r1, pool, left, variable);
             if (rc != 0)
                 return -1;
 
             /* rhs */
-            rc = csfg_expr_to_rational(&r2, pool, right, variable);
+            rc = csfg_expr_to_rational_recurse(&r2, pool, right, variable);
             if (rc != 0)
                 return -1;
 
@@ -131,12 +133,12 @@ static int csfg_expr_to_rational_recurse(
              */
 
             /* lhs */
-            rc = csfg_expr_to_rational(&r1, pool, left, variable);
+            rc = csfg_expr_to_rational_recurse(&r1, pool, left, variable);
             if (rc != 0)
                 return -1;
 
             /* rhs */
-            rc = csfg_expr_to_rational(&r2, pool, right, variable);
+            rc = csfg_expr_to_rational_recurse(&r2, pool, right, variable);
             if (rc != 0)
                 return -1;
 
@@ -163,7 +165,7 @@ static int csfg_expr_to_rational_recurse(
             if ((*pool)->nodes[right].type != CSFG_EXPR_LIT)
                 return -1;
 
-            value = (*pool)->nodes[right].value.lit;
+            value = csfg_expr_lit_value(*pool, right);
             k     = (int)round(value);
             if (fabs(value - (double)k) >= 0.0000001)
                 return -1;
@@ -181,7 +183,7 @@ static int csfg_expr_to_rational_recurse(
 
             if (k > 0)
             {
-                rc = csfg_expr_to_rational(&r1, pool, left, variable);
+                rc = csfg_expr_to_rational_recurse(&r1, pool, left, variable);
                 if (rc != 0)
                     return -1;
 
@@ -203,7 +205,7 @@ static int csfg_expr_to_rational_recurse(
             }
             else if (k < 0)
             {
-                rc = csfg_expr_to_rational(&r2, pool, left, variable);
+                rc = csfg_expr_to_rational_recurse(&r2, pool, left, variable);
                 if (rc != 0)
                     return -1;
 
@@ -240,8 +242,25 @@ int csfg_expr_to_rational(
     int expr,
     const char* variable)
 {
-    csfg_tf_expr_clear(tf);
-    return csfg_expr_to_rational_recurse(tf, pool, expr, variable);
+    struct csfg_tf_expr result;
+    int rc;
+
+    /* Every node creates a pair of intermediate polynomials. Only the result
+     * is copied out of the scratch scope */
+    arena_scratch_begin();
+    csfg_tf_expr_init(&result);
+    rc = csfg_expr_to_rational_recurse(&result, pool, expr, variable);
+    arena_scratch_end();
+
+    if (rc == 0)
+        rc = csfg_poly_expr_copy(&tf->num, result.num);
+    if (rc == 0)
+        rc = csfg_poly_expr_copy(&tf->den, result.den);
+    if (rc != 0)
+        csfg_tf_expr_clear(tf);
+
+    csfg_tf_expr_deinit(&result);
+    return rc;
 }
 
 /* -------------------------------------------------------------------------- */
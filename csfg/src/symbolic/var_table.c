@@ -1,5 +1,7 @@
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/var_table.h"
+#include "csfg/util/str.h"
 #include <math.h>
 
 HMAP_DEFINE_STR(extern, csfg_var_hmap, struct csfg_var_table_entry, 16)
@@ -53,7 +55,7 @@ static int var_table_populate(
     if (pool->nodes[n].type != CSFG_EXPR_VAR)
         return 0;
 
-    name = strlist_view(pool->var_names, pool->nodes[n].value.var_idx);
+    name = csfg_symbol_view(pool->nodes[n].value);
     switch (csfg_var_hmap_emplace_or_get(&vt->map, name, &entry))
     {
         case HMAP_OOM: return -1;
@@ -63,7 +65,7 @@ static int var_table_populate(
             /* If the user has tweaked this value, leave it as-is */
             CSFG_DEBUG_ASSERT(
                 entry->pool->nodes[entry->expr].type == CSFG_EXPR_LIT);
-            if (entry->pool->nodes[entry->expr].value.lit != default_value)
+            if (csfg_expr_lit_value(entry->pool, entry->expr) != default_value)
                 return 0;
 
             /* Otherwise set it to the default value */
@@ -215,3 +217,52 @@ double csfg_var_table_eval(const struct csfg_var_table* vt, struct strview name)
 
     return csfg_expr_eval(pool, expr, vt);
 }
+
+/* -------------------------------------------------------------------------- */
+int csfg_var_table_eval_symbols(
+    const struct csfg_var_table* vt, double** values)
+{
+    int slot, id;
+    const struct str* name;
+    const struct csfg_var_table_entry* entry;
+    int count = csfg_symbol_count();
+
+    *values = mem_alloc(sizeof(double) * (count + 1));
+    if (*values == NULL)
+        return log_oom(
+            sizeof(double) * (count + 1), "csfg_var_table_eval_symbols()");
+    for (id = 0; id != count; ++id)
+        (*values)[id] = NAN;
+
+    hmap_for_each (vt->map, slot, name, entry)
+    {
+        (void)slot;
+        id = csfg_symbol_find(str_view(name));
+        if (id >= 0)
+            (*values)[id] = csfg_expr_eval(entry->pool, entry->expr, vt);
+    }
+
+    return count;
+}
+
+/* -------------------------------------------------------------------------- */
+hash32 csfg_var_table_hash(const struct csfg_var_table* vt)
+{
+    int slot;
+    const struct str* name;
+    const struct csfg_var_table_entry* entry;
+    hash32 hash = 0;
+
+    /* The iteration order depends on the insertion history of the table, so
+     * the entry hashes are combined in an order-independent way */
+    hmap_for_each (vt->map, slot, name, entry)
+    {
+        hash32 name_hash =
+            hash32_jenkins_oaat(str_cstr(name), str_len(name));
+        (void)slot;
+        hash += hash32_combine(
+            name_hash, csfg_expr_hash(entry->pool, entry->expr));
+    }
+
+    return hash;
+}
@@ -0,0 +1,294 @@
+#include "csfg/util/arena.h"
+#include "csfg/util/log.h"
+#include "csfg/util/mem.h"
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Every allocation is preceded by a header. The union ensures that the data
+ * following it is suitably aligned */
+union arena_header
+{
+    struct
+    {
+        int size_class; /* -1 for large allocations */
+        int size;       /* Requested size of large allocations */
+    } h;
+    double align_double;
+    void* align_ptr;
+};
+
+struct arena_block
+{
+    struct arena_block* next;
+    int used;
+};
+
+struct arena_large
+{
+    struct arena_large* next;
+    struct arena_large* prev;
+    union arena_header header;
+};
+
+/* Size of the block header, rounded up so the data is aligned */
+#define BLOCK_HEADER_SIZE                                                      \
+    ((sizeof(struct arena_block) + sizeof(union arena_header) - 1)             \
+     / sizeof(union arena_header) * sizeof(union arena_header))
+#define BLOCK_DATA(b) ((char*)(b) + BLOCK_HEADER_SIZE)
+
+static struct arena* scratch;
+static int scratch_depth;
+
+/* -------------------------------------------------------------------------- */
+static int size_class(int size)
+{
+    int c = ARENA_MIN_CLASS;
+    while ((1 << c) < size)
+        if (++c > ARENA_MAX_CLASS)
+            return -1;
+    return c;
+}
+
+/* -------------------------------------------------------------------------- */
+static void add_bytes(struct arena* a, int bytes)
+{
+    a->stats.bytes_in_use += bytes;
+    if (a->stats.peak_bytes < a->stats.bytes_in_use)
+        a->stats.peak_bytes = a->stats.bytes_in_use;
+}
+
+/* -------------------------------------------------------------------------- */
+static int next_block(struct arena* a)
+{
+    struct arena_block* b;
+
+    /* Blocks are kept after a reset */
+    if (a->current != NULL && a->current->next != NULL)
+    {
+        a->current       = a->current->next;
+        a->current->used = 0;
+        return 0;
+    }
+
+    b = mem_alloc(BLOCK_HEADER_SIZE + ARENA_BLOCK_SIZE);
+    if (b == NULL)
+        return log_oom(BLOCK_HEADER_SIZE + ARENA_BLOCK_SIZE, "arena_alloc()");
+    a->stats.heap_allocs++;
+
+    b->next = NULL;
+    b->used = 0;
+    if (a->current != NULL)
+        a->current->next = b;
+    else
+        a->blocks = b;
+    a->current = b;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static void* bump(struct arena* a, int size)
+{
+    char* p;
+    if (a->current == NULL || a->current->used + size > ARENA_BLOCK_SIZE)
+        if (next_block(a) != 0)
+            return NULL;
+
+    p = BLOCK_DATA(a->current) + a->current->used;
+    a->current->used += size;
+    return p;
+}
+
+/* -------------------------------------------------------------------------- */
+static void* alloc_large(struct arena* a, int size)
+{
+    int header_size = offsetof(struct arena_large, header)
+                      + sizeof(union arena_header);
+    struct arena_large* large = mem_alloc(header_size + size);
+    if (large == NULL)
+        return NULL;
+    a->stats.heap_allocs++;
+
+    large->header.h.size_class = -1;
+    large->header.h.size       = size;
+    large->prev                = NULL;
+    large->next                = a->large;
+    if (a->large != NULL)
+        a->large->prev = large;
+    a->large = large;
+
+    add_bytes(a, size);
+    return &large->header + 1;
+}
+
+/* -------------------------------------------------------------------------- */
+static void free_large(struct arena* a, union arena_header* header)
+{
+    struct arena_large* large =
+        (struct arena_large*)((char*)header
+                              - offsetof(struct arena_large, header));
+
+    if (large->prev != NULL)
+        large->prev->next = large->next;
+    else
+        a->large = large->next;
+    if (large->next != NULL)
+        large->next->prev = large->prev;
+
+    a->stats.bytes_in_use -= header->h.size;
+    mem_free(large);
+}
+
+/* -------------------------------------------------------------------------- */
+void arena_init(struct arena* a)
+{
+    memset(a, 0, sizeof(*a));
+}
+
+/* -------------------------------------------------------------------------- */
+void arena_deinit(struct arena* a)
+{
+    arena_reset(a);
+    while (a->blocks != NULL)
+    {
+        struct arena_block* next = a->blocks->next;
+        mem_free(a->blocks);
+        a->blocks = next;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+void arena_reset(struct arena* a)
+{
+    while (a->large != NULL)
+        free_large(a, &a->large->header);
+
+    memset(a->free_lists, 0, sizeof(a->free_lists));
+    a->current = a->blocks;
+    if (a->current != NULL)
+        a->current->used = 0;
+    a->stats.bytes_in_use = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void* arena_alloc(struct arena* a, int size)
+{
+    union arena_header* header;
+    int c = size_class(size);
+
+    a->stats.allocs++;
+    if (c < 0)
+        return alloc_large(a, size);
+
+    if (a->free_lists[c] != NULL)
+    {
+        void* p          = a->free_lists[c];
+        a->free_lists[c] = *(void**)p;
+        a->stats.reuses++;
+        add_bytes(a, 1 << c);
+        return p;
+    }
+
+    header = bump(a, sizeof(union arena_header) + (1 << c));
+    if (header == NULL)
+        return NULL;
+    header->h.size_class = c;
+    header->h.size       = 0;
+
+    add_bytes(a, 1 << c);
+    return header + 1;
+}
+
+/* -------------------------------------------------------------------------- */
+void* arena_realloc(struct arena* a, void* p, int new_size)
+{
+    union arena_header* header;
+    void* new_p;
+    int old_size;
+
+    if (p == NULL)
+        return arena_alloc(a, new_size);
+
+    header   = (union arena_header*)p - 1;
+    old_size = header->h.size_class < 0 ? header->h.size
+                                        : 1 << header->h.size_class;
+    if (new_size <= old_size)
+        return p;
+
+    new_p = arena_alloc(a, new_size);
+    if (new_p == NULL)
+        return NULL;
+    memcpy(new_p, p, old_size);
+    arena_free(a, p);
+
+    return new_p;
+}
+
+/* -------------------------------------------------------------------------- */
+void arena_free(struct arena* a, void* p)
+{
+    union arena_header* header = (union arena_header*)p - 1;
+    int c                      = header->h.size_class;
+
+    a->stats.frees++;
+    if (c < 0)
+    {
+        free_large(a, header);
+        return;
+    }
+
+    *(void**)p       = a->free_lists[c];
+    a->free_lists[c] = p;
+    a->stats.bytes_in_use -= 1 << c;
+}
+
+/* -------------------------------------------------------------------------- */
+int arena_owns(const struct arena* a, const void* p)
+{
+    const struct arena_block* b;
+    const struct arena_large* large;
+
+    for (b = a->blocks; b != NULL; b = b->next)
+        if ((const char*)p >= BLOCK_DATA(b) &&
+            (const char*)p < BLOCK_DATA(b) + ARENA_BLOCK_SIZE)
+            return 1;
+    for (large = a->large; large != NULL; large = large->next)
+        if (p == (const void*)(&large->header + 1))
+            return 1;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+struct arena* arena_scratch_set(struct arena* a)
+{
+    struct arena* prev = scratch;
+    scratch            = a;
+    return prev;
+}
+void arena_scratch_begin(void)
+{
+    scratch_depth++;
+}
+void arena_scratch_end(void)
+{
+    CSFG_DEBUG_ASSERT(scratch_depth > 0);
+    scratch_depth--;
+}
+
+/* -------------------------------------------------------------------------- */
+void* arena_scratch_realloc(void* p, int size)
+{
+    if (scratch != NULL &&
+        (p == NULL ? scratch_depth > 0 : arena_owns(scratch, p)))
+        return arena_realloc(scratch, p, size);
+    return mem_realloc(p, size);
+}
+void arena_scratch_free(void* p)
+{
+    if (scratch != NULL && arena_owns(scratch, p))
+        arena_free(scratch, p);
+    else
+        mem_free(p);
+}
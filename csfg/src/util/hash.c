@@ -18,6 +18,19 @@ hash32 hash32_jenkins_oaat(const void* key, int len)
     return hash;
 }
 
+/* -------------------------------------------------------------------------- */
+hash64 hash64_fnv1a(const void* key, int len)
+{
+    const uint8_t* p = (const uint8_t*)key;
+    hash64 hash      = ((hash64)0xcbf29ce4 << 32) | 0x84222325;
+    while (len--)
+    {
+        hash ^= *p++;
+        hash *= ((hash64)0x00000100 << 32) | 0x000001b3;
+    }
+    return hash;
+}
+
 /* -------------------------------------------------------------------------- */
 #if ODBUTIL_SIZEOF_VOID_P == 8
 hash32 hash32_ptr(const void* ptr, int len)
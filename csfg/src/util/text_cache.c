@@ -0,0 +1,218 @@
+#include "csfg/util/hmap_str.h"
+#include "csfg/util/mem.h"
+#include "csfg/util/str.h"
+#include "csfg/util/text_cache.h"
+
+HMAP_DECLARE_STR(static, text_cache_hmap, int, 32)
+HMAP_DEFINE_STR(static, text_cache_hmap, int, 32)
+
+struct text_cache_entry
+{
+    struct text_extents extents;
+    struct str* key;
+    int prev, next;
+};
+
+static struct text_cache shared;
+static int shared_initialized;
+
+/* -------------------------------------------------------------------------- */
+static void reset_lists(struct text_cache* cache)
+{
+    int i;
+    for (i = 0; i != cache->capacity; ++i)
+    {
+        cache->entries[i].prev = -1;
+        cache->entries[i].next = i + 1 < cache->capacity ? i + 1 : -1;
+    }
+    cache->free = cache->capacity > 0 ? 0 : -1;
+    cache->mru  = -1;
+    cache->lru  = -1;
+}
+
+/* -------------------------------------------------------------------------- */
+static void unlink_entry(struct text_cache* cache, int i)
+{
+    struct text_cache_entry* e = &cache->entries[i];
+
+    if (e->prev > -1)
+        cache->entries[e->prev].next = e->next;
+    else
+        cache->mru = e->next;
+    if (e->next > -1)
+        cache->entries[e->next].prev = e->prev;
+    else
+        cache->lru = e->prev;
+}
+
+/* -------------------------------------------------------------------------- */
+static void push_front(struct text_cache* cache, int i)
+{
+    struct text_cache_entry* e = &cache->entries[i];
+
+    e->prev = -1;
+    e->next = cache->mru;
+    if (cache->mru > -1)
+        cache->entries[cache->mru].prev = i;
+    else
+        cache->lru = i;
+    cache->mru = i;
+}
+
+/* -------------------------------------------------------------------------- */
+static int build_key(
+    struct text_cache* cache,
+    struct strview font,
+    double size,
+    struct strview text)
+{
+    /* The text comes last, so it may contain the separator without making
+     * keys ambiguous */
+    return str_fmt(
+        &cache->key,
+        "%.*s\x1f%g\x1f%.*s",
+        font.len,
+        font.data + font.off,
+        size,
+        text.len,
+        text.data + text.off);
+}
+
+/* -------------------------------------------------------------------------- */
+int text_cache_init(struct text_cache* cache, int capacity)
+{
+    int i;
+
+    text_cache_hmap_init(&cache->map);
+    str_init(&cache->key);
+    cache->capacity = capacity;
+    cache->entries  = mem_alloc(sizeof(*cache->entries) * capacity);
+    if (cache->entries == NULL)
+    {
+        str_deinit(cache->key);
+        return -1;
+    }
+
+    for (i = 0; i != capacity; ++i)
+        str_init(&cache->entries[i].key);
+    reset_lists(cache);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void text_cache_deinit(struct text_cache* cache)
+{
+    int i;
+    for (i = 0; i != cache->capacity; ++i)
+        str_deinit(cache->entries[i].key);
+    mem_free(cache->entries);
+    str_deinit(cache->key);
+    text_cache_hmap_deinit(cache->map);
+}
+
+/* -------------------------------------------------------------------------- */
+void text_cache_clear(struct text_cache* cache)
+{
+    text_cache_hmap_clear(cache->map);
+    reset_lists(cache);
+}
+
+/* -------------------------------------------------------------------------- */
+int text_cache_count(const struct text_cache* cache)
+{
+    return hmap_count(cache->map);
+}
+
+/* -------------------------------------------------------------------------- */
+const struct text_extents* text_cache_find(
+    struct text_cache* cache,
+    struct strview font,
+    double size,
+    struct strview text)
+{
+    int* idx;
+
+    if (build_key(cache, font, size, text) != 0)
+        return NULL;
+    idx = text_cache_hmap_find(cache->map, str_view(cache->key));
+    if (idx == NULL)
+        return NULL;
+
+    unlink_entry(cache, *idx);
+    push_front(cache, *idx);
+
+    return &cache->entries[*idx].extents;
+}
+
+/* -------------------------------------------------------------------------- */
+int text_cache_insert(
+    struct text_cache* cache,
+    struct strview font,
+    double size,
+    struct strview text,
+    const struct text_extents* extents)
+{
+    int i;
+    int* idx;
+    struct text_cache_entry* e;
+
+    if (cache->capacity <= 0)
+        return 0;
+
+    if (build_key(cache, font, size, text) != 0)
+        return -1;
+    idx = text_cache_hmap_find(cache->map, str_view(cache->key));
+    if (idx != NULL)
+    {
+        cache->entries[*idx].extents = *extents;
+        unlink_entry(cache, *idx);
+        push_front(cache, *idx);
+        return 0;
+    }
+
+    /* Evict before inserting into the map, because erasing may move the
+     * values around */
+    if (cache->free < 0)
+    {
+        i = cache->lru;
+        unlink_entry(cache, i);
+        text_cache_hmap_erase(cache->map, str_view(cache->entries[i].key));
+        cache->entries[i].next = -1;
+        cache->free            = i;
+    }
+
+    i = cache->free;
+    e = &cache->entries[i];
+    if (str_set_view(&e->key, str_view(cache->key)) != 0)
+        return -1;
+    if (text_cache_hmap_insert_new(&cache->map, str_view(e->key), i) != 0)
+        return -1;
+
+    cache->free = e->next;
+    e->extents  = *extents;
+    push_front(cache, i);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+struct text_cache* text_cache_shared(void)
+{
+    if (!shared_initialized)
+    {
+        if (text_cache_init(&shared, TEXT_CACHE_DEFAULT_CAPACITY) != 0)
+            return NULL;
+        shared_initialized = 1;
+    }
+
+    return &shared;
+}
+
+/* -------------------------------------------------------------------------- */
+void text_cache_shared_deinit(void)
+{
+    if (shared_initialized)
+        text_cache_deinit(&shared);
+    shared_initialized = 0;
+}
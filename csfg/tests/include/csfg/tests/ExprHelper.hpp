@@ -64,7 +64,7 @@ struct ExprHelper
             return false;
 
         return NodeEq(pool, n, CSFG_EXPR_LIT) &&
-               pool->nodes[n].value.lit == value;
+               csfg_expr_lit_value(pool, n) == value;
     }
 
     bool
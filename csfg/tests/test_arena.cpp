@@ -0,0 +1,154 @@
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/tf_expr.h"
+#include "csfg/util/arena.h"
+}
+
+#define NAME test_arena
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override { arena_init(&a); }
+    void TearDown() override { arena_deinit(&a); }
+
+    struct arena a;
+};
+
+TEST_F(NAME, freed_allocations_are_reused)
+{
+    void* p1 = arena_alloc(&a, 100);
+    ASSERT_TRUE(p1 != nullptr);
+    arena_free(&a, p1);
+
+    /* Same size class */
+    void* p2 = arena_alloc(&a, 120);
+    ASSERT_EQ(p1, p2);
+    ASSERT_EQ(a.stats.allocs, 2);
+    ASSERT_EQ(a.stats.reuses, 1);
+    ASSERT_EQ(a.stats.heap_allocs, 1);
+}
+
+TEST_F(NAME, realloc_preserves_data)
+{
+    int i;
+    int* p = (int*)arena_alloc(&a, sizeof(int) * 10);
+    for (i = 0; i != 10; ++i)
+        p[i] = i;
+
+    p = (int*)arena_realloc(&a, p, sizeof(int) * 1000);
+    ASSERT_TRUE(p != nullptr);
+    for (i = 0; i != 10; ++i)
+        ASSERT_EQ(p[i], i);
+
+    /* Larger than the largest size class */
+    p = (int*)arena_realloc(&a, p, 1 << (ARENA_MAX_CLASS + 1));
+    ASSERT_TRUE(p != nullptr);
+    for (i = 0; i != 10; ++i)
+        ASSERT_EQ(p[i], i);
+    ASSERT_EQ(a.stats.heap_allocs, 2);
+}
+
+TEST_F(NAME, reset_keeps_blocks)
+{
+    int i, cycle;
+    for (cycle = 0; cycle != 10; ++cycle)
+    {
+        for (i = 0; i != 1000; ++i)
+            ASSERT_TRUE(arena_alloc(&a, 1024) != nullptr);
+        arena_alloc(&a, ARENA_BLOCK_SIZE * 2);
+        arena_reset(&a);
+        ASSERT_EQ(a.stats.bytes_in_use, 0);
+    }
+
+    /* 1000 KiB needs 4 blocks. The large allocation is not kept */
+    ASSERT_EQ(a.stats.allocs, 10 * 1001);
+    ASSERT_EQ(a.stats.heap_allocs, 4 + 10);
+}
+
+TEST_F(NAME, expr_pool)
+{
+    struct csfg_expr_pool* pool;
+    int cycle;
+
+    for (cycle = 0; cycle != 10; ++cycle)
+    {
+        ASSERT_EQ(csfg_expr_pool_init_arena(&pool, &a), 0);
+        int expr = csfg_expr_parse(
+            &pool, cstr_view("a*b + 2^3 - 1/(4+c) + d*e*f - g/h"));
+        ASSERT_GE(expr, 0);
+        ASSERT_GT(pool->capacity, 16);
+        csfg_expr_pool_deinit(pool);
+        arena_reset(&a);
+    }
+
+    ASSERT_EQ(a.stats.heap_allocs, 1);
+}
+
+TEST_F(NAME, scratch_vectors_outside_of_scope_stay_on_heap)
+{
+    struct csfg_poly_expr *heap, *tmp;
+    struct arena* prev = arena_scratch_set(&a);
+
+    csfg_poly_expr_init(&heap);
+    csfg_poly_expr_init(&tmp);
+    ASSERT_EQ(csfg_poly_expr_push(&heap, csfg_coeff_expr(1.0, -1)), 0);
+
+    arena_scratch_begin();
+    ASSERT_EQ(csfg_poly_expr_realloc(&heap, 100), 0);
+    ASSERT_EQ(csfg_poly_expr_push(&tmp, csfg_coeff_expr(2.0, -1)), 0);
+    ASSERT_FALSE(arena_owns(&a, heap));
+    ASSERT_TRUE(arena_owns(&a, tmp));
+    arena_scratch_end();
+
+    /* Memory is returned to where it came from */
+    csfg_poly_expr_deinit(tmp);
+    csfg_poly_expr_deinit(heap);
+    ASSERT_EQ(a.stats.bytes_in_use, 0);
+
+    arena_scratch_set(prev);
+}
+
+TEST_F(NAME, expr_to_rational_temporaries_are_taken_from_scratch)
+{
+    struct csfg_expr_pool* pool;
+    struct csfg_tf_expr expected, tf;
+    struct arena* prev;
+    int expr, i;
+
+    csfg_expr_pool_init(&pool);
+    csfg_tf_expr_init(&expected);
+    csfg_tf_expr_init(&tf);
+    expr = csfg_expr_parse(
+        &pool,
+        cstr_view("1/(1/(s-1)^2 - 1/(a+4)) + b*s/(s^2 + c*s + d) - s^3/e"));
+    ASSERT_GE(expr, 0);
+    ASSERT_EQ(csfg_expr_to_rational(&expected, &pool, expr, "s"), 0);
+
+    prev = arena_scratch_set(&a);
+    ASSERT_EQ(csfg_expr_to_rational(&tf, &pool, expr, "s"), 0);
+    arena_scratch_set(prev);
+
+    /* Every intermediate polynomial would otherwise be a call to malloc() */
+    ASSERT_GT(a.stats.allocs, 20);
+    ASSERT_EQ(a.stats.heap_allocs, 1);
+    ASSERT_EQ(a.stats.bytes_in_use, 0);
+
+    /* The result is on the heap and survives a reset */
+    ASSERT_FALSE(arena_owns(&a, tf.num));
+    ASSERT_FALSE(arena_owns(&a, tf.den));
+    arena_reset(&a);
+    ASSERT_EQ(vec_count(tf.num), vec_count(expected.num));
+    ASSERT_EQ(vec_count(tf.den), vec_count(expected.den));
+    for (i = 0; i != vec_count(tf.num); ++i)
+        ASSERT_EQ(vec_get(tf.num, i)->factor, vec_get(expected.num, i)->factor);
+    for (i = 0; i != vec_count(tf.den); ++i)
+        ASSERT_EQ(vec_get(tf.den, i)->factor, vec_get(expected.den, i)->factor);
+
+    csfg_tf_expr_deinit(&tf);
+    csfg_tf_expr_deinit(&expected);
+    csfg_expr_pool_deinit(pool);
+}
@@ -106,3 +106,21 @@ TEST_F(NAME, three_repeated_roots)
     EXPECT_THAT(*vec_get(roots, 1), ComplexEq(3.0, 0.0, epsilon));
     EXPECT_THAT(*vec_get(roots, 2), ComplexEq(3.0, 0.0, epsilon));
 }
+
+TEST_F(NAME, high_degree_roots_on_unit_circle)
+{
+    // 1 + x^70, the product of the root distances is far below 1e-15
+    csfg_cpoly_push(&coeffs, csfg_complex(1.0, 0.0));
+    for (int i = 0; i != 69; ++i)
+        csfg_cpoly_push(&coeffs, csfg_complex(0.0, 0.0));
+    csfg_cpoly_push(&coeffs, csfg_complex(1.0, 0.0));
+
+    csfg_cpoly_find_roots(&roots, coeffs, 0, 0.0);
+
+    ASSERT_EQ(vec_count(roots), 70);
+    for (int i = 0; i != 70; ++i)
+    {
+        struct csfg_complex r = *vec_get(roots, i);
+        EXPECT_NEAR(sqrt(r.real * r.real + r.imag * r.imag), 1.0, 1e-9);
+    }
+}
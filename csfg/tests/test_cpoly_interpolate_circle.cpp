@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <vector>
+
+extern "C" {
+#include "csfg/numeric/poly.h"
+}
+
+#define NAME test_cpoly_interpolate_circle
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override
+    {
+        csfg_cpoly_init(&expected);
+        csfg_cpoly_init(&poly);
+    }
+    void TearDown() override
+    {
+        csfg_cpoly_deinit(poly);
+        csfg_cpoly_deinit(expected);
+    }
+
+    void sample(struct csfg_complex* samples, int n, double r, double phi)
+    {
+        for (int k = 0; k != n; ++k)
+        {
+            double a   = 2 * M_PI * k / n + phi;
+            samples[k] = csfg_cpoly_eval(
+                expected, csfg_complex(r * cos(a), r * sin(a)));
+        }
+    }
+
+    struct csfg_cpoly* expected;
+    struct csfg_cpoly* poly;
+};
+
+TEST_F(NAME, recovers_coefficients)
+{
+    struct csfg_complex samples[8];
+    csfg_cpoly_push(&expected, csfg_complex(3, 0));
+    csfg_cpoly_push(&expected, csfg_complex(-2, 0));
+    csfg_cpoly_push(&expected, csfg_complex(0.5, 0));
+    csfg_cpoly_push(&expected, csfg_complex(7, 0));
+
+    sample(samples, 8, 1.0, 0.1);
+    ASSERT_EQ(csfg_cpoly_interpolate_circle(&poly, samples, 8, 1.0, 0.1), 0);
+    ASSERT_EQ(vec_count(poly), 4);
+    EXPECT_NEAR(vec_get(poly, 0)->real, 3, 1e-12);
+    EXPECT_NEAR(vec_get(poly, 1)->real, -2, 1e-12);
+    EXPECT_NEAR(vec_get(poly, 2)->real, 0.5, 1e-12);
+    EXPECT_NEAR(vec_get(poly, 3)->real, 7, 1e-12);
+}
+
+TEST_F(NAME, scaled_radius_keeps_small_coefficients)
+{
+    struct csfg_complex samples[4];
+    /* 1 + s*1e-3 + s^2*1e-6, roots at |s| = 1e3 */
+    csfg_cpoly_push(&expected, csfg_complex(1, 0));
+    csfg_cpoly_push(&expected, csfg_complex(1e-3, 0));
+    csfg_cpoly_push(&expected, csfg_complex(1e-6, 0));
+
+    sample(samples, 4, 1e3, 0.1);
+    ASSERT_EQ(csfg_cpoly_interpolate_circle(&poly, samples, 4, 1e3, 0.1), 0);
+    ASSERT_EQ(vec_count(poly), 3);
+    EXPECT_NEAR(vec_get(poly, 0)->real, 1, 1e-12);
+    EXPECT_NEAR(vec_get(poly, 1)->real, 1e-3, 1e-15);
+    EXPECT_NEAR(vec_get(poly, 2)->real, 1e-6, 1e-18);
+}
+
+TEST_F(NAME, non_power_of_two_fails)
+{
+    struct csfg_complex samples[3];
+    csfg_cpoly_push(&expected, csfg_complex(1, 0));
+    sample(samples, 3, 1.0, 0.0);
+    ASSERT_EQ(csfg_cpoly_interpolate_circle(&poly, samples, 3, 1.0, 0.0), -1);
+}
+
+TEST_F(NAME, more_coefficients_than_cpoly_holds_fails)
+{
+    std::vector<struct csfg_complex> samples(CSFG_CPOLY_MAX_COEFFS * 2);
+    csfg_cpoly_push(&expected, csfg_complex(1, 0));
+    sample(samples.data(), samples.size(), 1.0, 0.0);
+    ASSERT_EQ(
+        csfg_cpoly_interpolate_circle(
+            &poly, samples.data(), samples.size(), 1.0, 0.0),
+        -1);
+    ASSERT_EQ(vec_count(poly), 0);
+}
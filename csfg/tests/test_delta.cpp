@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include <string>
+
+extern "C" {
+#include "csfg/io/delta.h"
+#include "csfg/io/serialize.h"
+}
+
+#define NAME test_delta
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override
+    {
+        serializer_init(&delta);
+        serializer_init(&result);
+    }
+    void TearDown() override
+    {
+        serializer_deinit(result);
+        serializer_deinit(delta);
+    }
+
+    std::string apply(const std::string& src)
+    {
+        serializer_clear(result);
+        EXPECT_EQ(
+            delta_apply(
+                &result,
+                src.data(),
+                (int)src.size(),
+                vec_data(delta),
+                vec_count(delta)),
+            0);
+        return std::string((const char*)vec_data(result), vec_count(result));
+    }
+
+    struct serializer* delta;
+    struct serializer* result;
+};
+
+static std::string make_data(int len)
+{
+    std::string s;
+    unsigned    x = 12345;
+    for (int i = 0; i != len; ++i)
+    {
+        x = x * 1103515245 + 12345;
+        s.push_back((char)(x >> 16));
+    }
+    return s;
+}
+
+TEST_F(NAME, identical_buffers)
+{
+    std::string src = make_data(10000);
+    ASSERT_EQ(
+        delta_encode(
+            &delta, src.data(), (int)src.size(), src.data(), (int)src.size()),
+        0);
+    ASSERT_LE(vec_count(delta), 8);
+    ASSERT_EQ(apply(src), src);
+}
+
+TEST_F(NAME, small_change_gives_small_delta)
+{
+    std::string src = make_data(10000);
+    std::string dst = src;
+    dst[5000]       = ~dst[5000];
+    dst.insert(7000, "inserted");
+    dst.erase(100, 20);
+
+    ASSERT_EQ(
+        delta_encode(
+            &delta, src.data(), (int)src.size(), dst.data(), (int)dst.size()),
+        0);
+    ASSERT_LT(vec_count(delta), 200);
+    ASSERT_EQ(apply(src), dst);
+}
+
+TEST_F(NAME, unrelated_buffers)
+{
+    std::string src = make_data(100);
+    std::string dst = "completely different";
+    ASSERT_EQ(
+        delta_encode(
+            &delta, src.data(), (int)src.size(), dst.data(), (int)dst.size()),
+        0);
+    ASSERT_EQ(apply(src), dst);
+
+    serializer_clear(delta);
+    ASSERT_EQ(delta_encode(&delta, src.data(), (int)src.size(), "", 0), 0);
+    ASSERT_EQ(vec_count(delta), 0);
+    ASSERT_EQ(apply(src), "");
+}
+
+TEST_F(NAME, copy_past_end_is_rejected)
+{
+    std::string src = make_data(100);
+    ASSERT_EQ(
+        delta_encode(
+            &delta, src.data(), (int)src.size(), src.data(), (int)src.size()),
+        0);
+    serializer_clear(result);
+    ASSERT_EQ(
+        delta_apply(&result, src.data(), 50, vec_data(delta), vec_count(delta)),
+        -1);
+}
@@ -2,7 +2,9 @@
 
 extern "C" {
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/var_table.h"
+#include "csfg/util/mem.h"
 }
 
 #define NAME test_expr
@@ -72,7 +74,28 @@ TEST_F(NAME, float_numbers)
 {
     int e;
     ASSERT_GE(e = csfg_expr_parse(&p, cstr_view("(2.5-3.54*4.5)^2 + 4.2")), 0);
-    ASSERT_DOUBLE_EQ(csfg_expr_eval(p, e, NULL), 184.56489519844058);
+    ASSERT_DOUBLE_EQ(csfg_expr_eval(p, e, NULL), 184.5649);
+}
+
+TEST_F(NAME, literals_are_double_precision)
+{
+    int e;
+    ASSERT_GE(e = csfg_expr_lit(&p, 4.7e-12), 0);
+    ASSERT_EQ(csfg_expr_eval(p, e, NULL), 4.7e-12);
+}
+
+TEST_F(NAME, gc_removes_unused_literals)
+{
+    int i, e;
+    ASSERT_GE(e = csfg_expr_lit(&p, 3.3e-9), 0);
+    for (i = 0; i != 100; ++i)
+        csfg_expr_mark_deleted_shallow(p, csfg_expr_lit(&p, i));
+    ASSERT_EQ(p->lit_count, 101);
+
+    e = csfg_expr_gc(p, e);
+    ASSERT_EQ(p->count, 1);
+    ASSERT_EQ(p->lit_count, 1);
+    ASSERT_EQ(csfg_expr_lit_value(p, e), 3.3e-9);
 }
 
 TEST_F(NAME, infinity)
@@ -105,3 +128,67 @@ TEST_F(NAME, generate_variable_table)
     ASSERT_DOUBLE_EQ(csfg_var_table_eval(&vt, cstr_view("c")), 1);
     ASSERT_DOUBLE_EQ(csfg_var_table_eval(&vt, cstr_view("d")), 1);
 }
+
+TEST_F(NAME, evaluate_with_symbol_values)
+{
+    double* values;
+    int e, count;
+    ASSERT_GE(e = csfg_expr_parse(&p, cstr_view("(a+3*c)^d + e")), 0);
+    csfg_var_table_set_lit(&vt, cstr_view("a"), 2);
+    csfg_var_table_set_parse_expr(&vt, cstr_view("c"), cstr_view("d*2"));
+    csfg_var_table_set_lit(&vt, cstr_view("d"), 2);
+    csfg_var_table_set_lit(&vt, cstr_view("e"), 5);
+    ASSERT_GE(count = csfg_var_table_eval_symbols(&vt, &values), 0);
+    ASSERT_DOUBLE_EQ(csfg_expr_eval_symbols(p, e, values, count), 201);
+    mem_free(values);
+}
+
+TEST_F(NAME, variables_share_symbols_across_pools)
+{
+    struct csfg_expr_pool* p2;
+    int e1, e2;
+    csfg_expr_pool_init(&p2);
+    csfg_expr_parse(&p2, cstr_view("zz+b"));
+    ASSERT_GE(e1 = csfg_expr_parse(&p, cstr_view("b")), 0);
+    ASSERT_GE(e2 = csfg_expr_parse(&p2, cstr_view("b")), 0);
+    ASSERT_EQ(p->nodes[e1].value, p2->nodes[e2].value);
+    ASSERT_EQ(p->nodes[e1].value, csfg_symbol_find(cstr_view("b")));
+    ASSERT_TRUE(csfg_expr_equal(p, e1, p2, e2));
+
+    /* Interning a name returned by the table itself must not reallocate */
+    ASSERT_EQ(
+        csfg_symbol_intern(csfg_symbol_view(p->nodes[e1].value)),
+        p->nodes[e1].value);
+    csfg_expr_pool_deinit(p2);
+}
+
+TEST_F(NAME, hash_is_independent_of_pool)
+{
+    struct csfg_expr_pool* p2;
+    int e1, e2;
+    csfg_expr_pool_init(&p2);
+    csfg_expr_parse(&p2, cstr_view("b+c"));
+    ASSERT_GE(e1 = csfg_expr_parse(&p, cstr_view("a*(b+1)/c")), 0);
+    ASSERT_GE(e2 = csfg_expr_parse(&p2, cstr_view("a*(b+1)/c")), 0);
+    ASSERT_EQ(csfg_expr_hash(p, e1), csfg_expr_hash(p2, e2));
+    ASSERT_GE(e2 = csfg_expr_parse(&p2, cstr_view("a*(b+2)/c")), 0);
+    ASSERT_NE(csfg_expr_hash(p, e1), csfg_expr_hash(p2, e2));
+    ASSERT_GE(e2 = csfg_expr_parse(&p2, cstr_view("a*(d+1)/c")), 0);
+    ASSERT_NE(csfg_expr_hash(p, e1), csfg_expr_hash(p2, e2));
+    csfg_expr_pool_deinit(p2);
+}
+
+TEST_F(NAME, var_table_hash_is_independent_of_insertion_order)
+{
+    struct csfg_var_table vt2;
+    csfg_var_table_init(&vt2);
+    csfg_var_table_set_parse_expr(&vt, cstr_view("a"), cstr_view("x+1"));
+    csfg_var_table_set_lit(&vt, cstr_view("b"), 2);
+    csfg_var_table_set_lit(&vt2, cstr_view("b"), 2);
+    csfg_var_table_set_parse_expr(&vt2, cstr_view("a"), cstr_view("x+1"));
+    ASSERT_EQ(csfg_var_table_hash(&vt), csfg_var_table_hash(&vt2));
+
+    csfg_var_table_set_lit(&vt2, cstr_view("b"), 3);
+    ASSERT_NE(csfg_var_table_hash(&vt), csfg_var_table_hash(&vt2));
+    csfg_var_table_deinit(&vt2);
+}
@@ -2,6 +2,7 @@
 
 extern "C" {
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/var_table.h"
 }
 
@@ -37,9 +38,9 @@ TEST_F(NAME, simple)
 
     // Original expression should not be modified
     ASSERT_EQ(p->nodes[e1].type, CSFG_EXPR_VAR);
-    ASSERT_STREQ(strlist_cstr(p->var_names, p->nodes[e1].value.var_idx), "a");
+    ASSERT_STREQ(csfg_symbol_cstr(p->nodes[e1].value), "a");
     ASSERT_EQ(p->nodes[e2].type, CSFG_EXPR_VAR);
-    ASSERT_STREQ(strlist_cstr(p->var_names, p->nodes[e2].value.var_idx), "c");
+    ASSERT_STREQ(csfg_symbol_cstr(p->nodes[e2].value), "c");
 }
 
 TEST_F(NAME, with_cycles_fails)
@@ -55,5 +56,5 @@ TEST_F(NAME, with_cycles_fails)
 
     // Original expression should not be modified
     ASSERT_EQ(p->nodes[e].type, CSFG_EXPR_VAR);
-    ASSERT_STREQ(strlist_cstr(p->var_names, p->nodes[e].value.var_idx), "a");
+    ASSERT_STREQ(csfg_symbol_cstr(p->nodes[e].value), "a");
 }
@@ -30,21 +30,21 @@ const struct TestParam TEST_PARAMETERS[] = {
     {             "-a",                  "-a/1"},
     {             "-s",             "(0-1*s)/1"},
     {          "N1/D1",                 "N1/D1"},
-    {"(N1/D1)+(N2/D2)", "(N2*D1+N1*D2)/(D1*D2)"},
+    {"(N1/D1)+(N2/D2)", "(D1*N2+N1*D2)/(D1*D2)"},
     {"(N1/D1)*(N2/D2)",       "(N1*N2)/(D1*D2)"},
-    {     "(N1/D1)^-3", "(D1*D1*D1)/(N1*N1*N1)"},
-    {     "(N1/D1)^-2",       "(D1*D1)/(N1*N1)"},
+    {     "(N1/D1)^-3",             "D1^3/N1^3"},
+    {     "(N1/D1)^-2",             "D1^2/N1^2"},
     {     "(N1/D1)^-1",                 "D1/N1"},
     {      "(N1/D1)^0",                   "1/1"},
     {      "(N1/D1)^1",                 "N1/D1"},
-    {      "(N1/D1)^2",       "(N1*N1)/(D1*D1)"},
-    {      "(N1/D1)^3", "(N1*N1*N1)/(D1*D1*D1)"},
+    {      "(N1/D1)^2",             "N1^2/D1^2"},
+    {      "(N1/D1)^3",             "N1^3/D1^3"},
     // A few specific cases that caused problems in the past
     {  "1/(1/s - 1/a)",             "a*s/(a-s)"},
     // clang-format off
     {"1/(s/c+1)*1/((s/c)^2+s/c+1)",
-                          "c*(c*c*c) /"
-     "(c*(c*c*c) + (c*(c*c) + c*c*c)*s + (c*c+c*c)*s^2 + c*s^3)"},
+                          "c^4 /"
+     "(c^4 + c^3*2*s + c^2*2*s^2 + c*s^3)"},
     // clang-format on
 };
 
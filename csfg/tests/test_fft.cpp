@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include <math.h>
+
+extern "C" {
+#include "csfg/numeric/fft.h"
+}
+
+#define NAME test_fft
+
+using namespace testing;
+
+TEST(NAME, size_is_next_power_of_two)
+{
+    ASSERT_EQ(csfg_fft_size(1), 1);
+    ASSERT_EQ(csfg_fft_size(2), 2);
+    ASSERT_EQ(csfg_fft_size(3), 4);
+    ASSERT_EQ(csfg_fft_size(17), 32);
+    ASSERT_EQ(csfg_fft_size(64), 64);
+}
+
+TEST(NAME, non_power_of_two_fails)
+{
+    struct csfg_complex data[6];
+    ASSERT_EQ(csfg_fft(data, 6), -1);
+    ASSERT_EQ(csfg_ifft(data, 0), -1);
+}
+
+TEST(NAME, matches_naive_dft)
+{
+    struct csfg_complex data[16], expected[16];
+    int j, k;
+    for (k = 0; k != 16; ++k)
+        data[k] = csfg_complex(sin(k * 0.7) + k, cos(k * 1.3));
+
+    for (j = 0; j != 16; ++j)
+    {
+        expected[j] = csfg_complex(0, 0);
+        for (k = 0; k != 16; ++k)
+        {
+            double a    = -2 * M_PI * j * k / 16;
+            expected[j] = csfg_complex_add(
+                expected[j],
+                csfg_complex_mul(data[k], csfg_complex(cos(a), sin(a))));
+        }
+    }
+
+    ASSERT_EQ(csfg_fft(data, 16), 0);
+    for (j = 0; j != 16; ++j)
+    {
+        EXPECT_NEAR(data[j].real, expected[j].real, 1e-12);
+        EXPECT_NEAR(data[j].imag, expected[j].imag, 1e-12);
+    }
+}
+
+TEST(NAME, inverse_round_trip)
+{
+    struct csfg_complex data[32];
+    int k;
+    for (k = 0; k != 32; ++k)
+        data[k] = csfg_complex(k * 0.5 - 3, 1.0 / (k + 1));
+
+    ASSERT_EQ(csfg_fft(data, 32), 0);
+    ASSERT_EQ(csfg_ifft(data, 32), 0);
+    for (k = 0; k != 32; ++k)
+    {
+        EXPECT_NEAR(data[k].real, k * 0.5 - 3, 1e-12);
+        EXPECT_NEAR(data[k].imag, 1.0 / (k + 1), 1e-12);
+    }
+}
@@ -0,0 +1,186 @@
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "csfg/graph/graph.h"
+#include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/var_table.h"
+}
+
+#define NAME test_graph_bareiss
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override
+    {
+        csfg_graph_init(&g);
+        csfg_path_vec_init(&paths);
+        csfg_path_vec_init(&loops);
+        csfg_expr_pool_init(&pool);
+        csfg_var_table_init(&vt);
+    }
+    void TearDown() override
+    {
+        csfg_var_table_deinit(&vt);
+        csfg_expr_pool_deinit(pool);
+        csfg_path_vec_deinit(loops);
+        csfg_path_vec_deinit(paths);
+        csfg_graph_deinit(&g);
+    }
+
+    double mason(int n_in, int n_out)
+    {
+        csfg_path_vec_clear(paths);
+        csfg_path_vec_clear(loops);
+        if (csfg_graph_find_forward_paths(&g, &paths, n_in, n_out) != 0)
+            return -1;
+        if (csfg_graph_find_loops(&g, &loops) != 0)
+            return -1;
+        int expr = csfg_graph_mason(&g, &pool, paths, loops);
+        return csfg_expr_eval(pool, expr, &vt);
+    }
+
+    struct csfg_graph      g;
+    struct csfg_path_vec*  paths;
+    struct csfg_path_vec*  loops;
+    struct csfg_expr_pool* pool;
+    struct csfg_var_table  vt;
+};
+
+TEST_F(NAME, two_nontouching_loops)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    int n3 = csfg_graph_add_node(&g, "n3");
+    int n4 = csfg_graph_add_node(&g, "n4");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("G1"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n3, cstr_view("G2"));
+    csfg_graph_add_edge_parse_expr(&g, n3, n4, cstr_view("G3"));
+    csfg_graph_add_edge_parse_expr(&g, n4, n3, cstr_view("H3"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n1, cstr_view("H1"));
+    csfg_graph_add_edge_parse_expr(&g, n4, n1, cstr_view("H2"));
+
+    int expr = csfg_graph_bareiss(&g, &pool, n1, n4);
+    ASSERT_GE(expr, 0);
+
+    // clang-format off
+    double G1 = 3;  csfg_var_table_set_lit(&vt, cstr_view("G1"), G1);
+    double G2 = 5;  csfg_var_table_set_lit(&vt, cstr_view("G2"), G2);
+    double G3 = 7;  csfg_var_table_set_lit(&vt, cstr_view("G3"), G3);
+    double H1 = 11; csfg_var_table_set_lit(&vt, cstr_view("H1"), H1);
+    double H2 = 13; csfg_var_table_set_lit(&vt, cstr_view("H2"), H2);
+    double H3 = 17; csfg_var_table_set_lit(&vt, cstr_view("H3"), H3);
+    ASSERT_DOUBLE_EQ(csfg_expr_eval(pool, expr, &vt),
+                       -G1*G2*G3/
+        (G1*G2*G3*H2 - G1*G3*H1*H3 + G1*H1 + G3*H3 - 1)
+    );
+    // clang-format on
+    ASSERT_DOUBLE_EQ(csfg_expr_eval(pool, expr, &vt), mason(n1, n4));
+}
+
+TEST_F(NAME, active_lowpass_filter)
+{
+    int Vin  = csfg_graph_add_node(&g, "Vin");
+    int I2   = csfg_graph_add_node(&g, "I2");
+    int V2   = csfg_graph_add_node(&g, "V2");
+    int V3   = csfg_graph_add_node(&g, "V3");
+    int V4   = csfg_graph_add_node(&g, "V4");
+    int Vout = csfg_graph_add_node(&g, "Vout");
+    csfg_graph_add_edge_parse_expr(&g, Vin, I2, cstr_view("G1"));
+    csfg_graph_add_edge_parse_expr(&g, I2, V2, cstr_view("z2"));
+    csfg_graph_add_edge_parse_expr(&g, V2, V4, cstr_view("-1"));
+    csfg_graph_add_edge_parse_expr(&g, V3, V4, cstr_view("1"));
+    csfg_graph_add_edge_parse_expr(&g, V4, Vout, cstr_view("A"));
+    csfg_graph_add_edge_parse_expr(&g, Vout, I2, cstr_view("G2+s*C"));
+
+    int expr = csfg_graph_bareiss(&g, &pool, Vin, Vout);
+    ASSERT_GE(expr, 0);
+
+    // clang-format off
+    csfg_var_table_set_parse_expr(&vt, cstr_view("y2"), cstr_view("G1 + G2 + s*C"));
+    csfg_var_table_set_parse_expr(&vt, cstr_view("z2"), cstr_view("1/y2"));
+    double G1 = 3;  csfg_var_table_set_lit(&vt, cstr_view("G1"), G1);
+    double G2 = 5;  csfg_var_table_set_lit(&vt, cstr_view("G2"), G2);
+    double C  = 7;  csfg_var_table_set_lit(&vt, cstr_view("C"), C);
+    double s  = 11; csfg_var_table_set_lit(&vt, cstr_view("s"), s);
+    double A  = 13; csfg_var_table_set_lit(&vt, cstr_view("A"), A);
+    double z2 = 1.0 / (G1 + G2 + s*C);
+    ASSERT_DOUBLE_EQ(csfg_expr_eval(pool, expr, &vt),
+           (-G1*z2*A) /
+        (1 + A*(G2+s*C)*z2)
+    );
+    // clang-format on
+}
+
+TEST_F(NAME, self_loops_and_parallel_edges)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    int n3 = csfg_graph_add_node(&g, "n3");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("a"));
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("b"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n2, cstr_view("c"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n3, cstr_view("d"));
+    csfg_graph_add_edge_parse_expr(&g, n3, n2, cstr_view("e"));
+
+    int expr = csfg_graph_bareiss(&g, &pool, n1, n3);
+    ASSERT_GE(expr, 0);
+
+    csfg_var_table_set_lit(&vt, cstr_view("a"), 2);
+    csfg_var_table_set_lit(&vt, cstr_view("b"), 3);
+    csfg_var_table_set_lit(&vt, cstr_view("c"), 5);
+    csfg_var_table_set_lit(&vt, cstr_view("d"), 7);
+    csfg_var_table_set_lit(&vt, cstr_view("e"), 11);
+    /* (a+b)*d / (1 - c - d*e) */
+    ASSERT_DOUBLE_EQ(csfg_expr_eval(pool, expr, &vt), 5.0 * 7 / (1 - 5 - 77));
+}
+
+TEST_F(NAME, many_loops_matches_mason)
+{
+    char name[16];
+    int  i, nodes[8];
+    for (i = 0; i != 8; ++i)
+        nodes[i] = csfg_graph_add_node(&g, "n");
+
+    /* Ladder with feedback over one and two rungs */
+    for (i = 0; i != 7; ++i)
+    {
+        sprintf(name, "f%d", i);
+        csfg_graph_add_edge_parse_expr(
+            &g, nodes[i], nodes[i + 1], cstr_view(name));
+        csfg_var_table_set_lit(&vt, cstr_view(name), 1.0 + i * 0.25);
+        sprintf(name, "b%d", i);
+        csfg_graph_add_edge_parse_expr(
+            &g, nodes[i + 1], nodes[i], cstr_view(name));
+        csfg_var_table_set_lit(&vt, cstr_view(name), -0.5 - i * 0.125);
+    }
+    for (i = 0; i != 6; ++i)
+    {
+        sprintf(name, "h%d", i);
+        csfg_graph_add_edge_parse_expr(
+            &g, nodes[i + 2], nodes[i], cstr_view(name));
+        csfg_var_table_set_lit(&vt, cstr_view(name), 0.75 - i * 0.25);
+    }
+
+    double expected = mason(nodes[0], nodes[7]);
+    ASSERT_GT(csfg_paths_count(loops), CSFG_GRAPH_MASON_MAX_LOOPS);
+
+    int expr = csfg_graph_transfer_function(
+        &g, &pool, paths, loops, nodes[0], nodes[7]);
+    ASSERT_GE(expr, 0);
+    ASSERT_NEAR(csfg_expr_eval(pool, expr, &vt), expected, 1e-9);
+
+    expr = csfg_graph_bareiss(&g, &pool, nodes[0], nodes[7]);
+    ASSERT_GE(expr, 0);
+    ASSERT_NEAR(csfg_expr_eval(pool, expr, &vt), expected, 1e-9);
+}
+
+TEST_F(NAME, invalid_nodes)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("a"));
+    ASSERT_EQ(csfg_graph_bareiss(&g, &pool, -1, n2), -1);
+    ASSERT_EQ(csfg_graph_bareiss(&g, &pool, n1, -1), -1);
+}
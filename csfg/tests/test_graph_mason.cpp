@@ -3,6 +3,7 @@
 extern "C" {
 #include "csfg/graph/graph.h"
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/var_table.h"
 }
 
@@ -215,3 +216,74 @@ TEST_F(NAME, active_lowpass_filter)
     );
     // clang-format on
 }
+
+TEST_F(NAME, edge_symbols)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    int n3 = csfg_graph_add_node(&g, "n3");
+    int n4 = csfg_graph_add_node(&g, "n4");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("G1"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n3, cstr_view("G2"));
+    csfg_graph_add_edge_parse_expr(&g, n3, n4, cstr_view("G3"));
+    csfg_graph_add_edge_parse_expr(&g, n4, n3, cstr_view("H3"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n1, cstr_view("H1"));
+    csfg_graph_add_edge_parse_expr(&g, n4, n1, cstr_view("H2"));
+
+    ASSERT_EQ(csfg_graph_find_forward_paths(&g, &paths, n1, n4), 0);
+    ASSERT_EQ(csfg_graph_find_loops(&g, &loops), 0);
+    int expected = csfg_graph_mason(&g, &pool, paths, loops);
+    int skeleton = csfg_graph_mason_with(
+        &g, &pool, paths, loops, csfg_graph_edge_symbol, NULL);
+    ASSERT_GE(expected, 0);
+    ASSERT_GE(skeleton, 0);
+
+    /* Edge gains are substituted after Mason's formula was evaluated */
+    struct csfg_var_table edges;
+    csfg_var_table_init(&edges);
+    ASSERT_EQ(csfg_graph_edge_symbol_table(&g, &edges), 0);
+    int expr = csfg_expr_insert_substitutions(&pool, skeleton, &edges);
+    csfg_var_table_deinit(&edges);
+    ASSERT_GE(expr, 0);
+
+    // clang-format off
+    csfg_var_table_set_lit(&vt, cstr_view("G1"), 3);
+    csfg_var_table_set_lit(&vt, cstr_view("G2"), 5);
+    csfg_var_table_set_lit(&vt, cstr_view("G3"), 7);
+    csfg_var_table_set_lit(&vt, cstr_view("H1"), 11);
+    csfg_var_table_set_lit(&vt, cstr_view("H2"), 13);
+    csfg_var_table_set_lit(&vt, cstr_view("H3"), 17);
+    // clang-format on
+    ASSERT_DOUBLE_EQ(
+        csfg_expr_eval(pool, expr, &vt), csfg_expr_eval(pool, expected, &vt));
+}
+
+TEST_F(NAME, edge_symbol_index)
+{
+    int expr = csfg_graph_edge_symbol(&pool, 42, NULL);
+    ASSERT_GE(expr, 0);
+    ASSERT_EQ(pool->nodes[expr].type, CSFG_EXPR_VAR);
+    EXPECT_EQ(pool->nodes[expr].value, csfg_graph_edge_symbol_id(42));
+    EXPECT_EQ(csfg_graph_edge_symbol_index(pool->nodes[expr].value), 42);
+
+    EXPECT_EQ(
+        csfg_graph_edge_symbol_index(csfg_symbol_intern(cstr_view("G"))), -1);
+    EXPECT_EQ(
+        csfg_graph_edge_symbol_index(csfg_symbol_intern(cstr_view("G1"))), -1);
+}
+
+TEST_F(NAME, edge_symbol_table_skips_invalid_edges)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("G1"));
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("G2"));
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("G3"));
+    vec_get(g.edges, 1)->expr = -1;
+
+    int expr;
+    ASSERT_EQ(csfg_graph_edge_symbol_table(&g, &vt), -1);
+    EXPECT_NE(csfg_var_table_get(&vt, cstr_view("G[0]"), &expr), nullptr);
+    EXPECT_EQ(csfg_var_table_get(&vt, cstr_view("G[1]"), &expr), nullptr);
+    EXPECT_NE(csfg_var_table_get(&vt, cstr_view("G[2]"), &expr), nullptr);
+}
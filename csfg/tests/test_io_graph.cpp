@@ -0,0 +1,200 @@
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "csfg/graph/graph.h"
+#include "csfg/io/deserialize.h"
+#include "csfg/io/io.h"
+#include "csfg/io/serialize.h"
+#include "csfg/symbolic/expr.h"
+#include "csfg/util/str.h"
+}
+
+#define NAME test_io_graph
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override
+    {
+        csfg_graph_init(&g);
+        csfg_graph_init(&loaded);
+        serializer_init(&ser);
+    }
+    void TearDown() override
+    {
+        serializer_deinit(ser);
+        csfg_graph_deinit(&loaded);
+        csfg_graph_deinit(&g);
+    }
+
+    struct csfg_graph  g;
+    struct csfg_graph  loaded;
+    struct serializer* ser;
+};
+
+TEST_F(NAME, round_trip)
+{
+    int n1 = csfg_graph_add_node(&g, "U");
+    int n2 = csfg_graph_add_node(&g, "Y");
+    int e1 = csfg_graph_add_edge_parse_expr(
+        &g, n1, n2, cstr_view("a*b/(s+2.5)"));
+    ASSERT_GE(e1, 0);
+    csfg_graph_get_node(&g, n2)->x = 100000;
+    csfg_graph_get_node(&g, n2)->y = -70000;
+    csfg_graph_get_edge(&g, e1)->x = 40000;
+
+    ASSERT_EQ(csfg_io_graph_save(&ser, &g, n1, n2), 0);
+
+    int node_in, node_out;
+    struct deserializer des = deserializer(vec_data(ser), vec_count(ser));
+    ASSERT_EQ(csfg_io_graph_load(&des, &loaded, &node_in, &node_out), 0);
+    ASSERT_EQ(deserializer_bytes_left(&des), 0);
+    ASSERT_EQ(node_in, n1);
+    ASSERT_EQ(node_out, n2);
+
+    ASSERT_EQ(csfg_graph_node_count(&loaded), 2);
+    ASSERT_EQ(csfg_graph_edge_count(&loaded), 1);
+    ASSERT_TRUE(str_eq_cstr(csfg_graph_get_node(&loaded, n2)->name, "Y"));
+    ASSERT_EQ(
+        csfg_graph_get_node(&loaded, n2)->id, csfg_graph_get_node(&g, n2)->id);
+    ASSERT_EQ(csfg_graph_get_node(&loaded, n2)->x, 100000);
+    ASSERT_EQ(csfg_graph_get_node(&loaded, n2)->y, -70000);
+    ASSERT_EQ(csfg_graph_get_edge(&loaded, e1)->x, 40000);
+    ASSERT_EQ(csfg_graph_get_edge(&loaded, e1)->n_idx_to, n2);
+    ASSERT_EQ(
+        csfg_graph_edge_exprs_hash(&loaded), csfg_graph_edge_exprs_hash(&g));
+
+    /* New IDs must not collide with loaded ones */
+    int      n3 = csfg_graph_add_node(&loaded, "Z");
+    uint16_t id = csfg_graph_get_node(&loaded, n3)->id;
+    ASSERT_NE(id, csfg_graph_get_node(&loaded, n1)->id);
+    ASSERT_NE(id, csfg_graph_get_node(&loaded, n2)->id);
+    ASSERT_NE(id, csfg_graph_get_edge(&loaded, e1)->id);
+}
+
+TEST_F(NAME, more_nodes_than_old_limit)
+{
+    int i;
+    int node_in, node_out;
+    for (i = 0; i != 12000; ++i)
+        ASSERT_GE(csfg_graph_add_node(&g, "N"), 0);
+    for (i = 0; i != 11999; ++i)
+        ASSERT_GE(
+            csfg_graph_add_edge_parse_expr(&g, i, i + 1, cstr_view("k")), 0);
+
+    ASSERT_EQ(csfg_io_graph_save(&ser, &g, 0, 11999), 0);
+    struct deserializer des = deserializer(vec_data(ser), vec_count(ser));
+    ASSERT_EQ(csfg_io_graph_load(&des, &loaded, &node_in, &node_out), 0);
+    ASSERT_EQ(csfg_graph_node_count(&loaded), 12000);
+    ASSERT_EQ(csfg_graph_edge_count(&loaded), 11999);
+    ASSERT_EQ(csfg_graph_get_edge(&loaded, 11111)->n_idx_from, 11111);
+    ASSERT_EQ(node_out, 11999);
+}
+
+TEST_F(NAME, truncated_data_is_rejected)
+{
+    int node_in, node_out;
+    csfg_graph_add_node(&g, "U");
+    csfg_graph_add_node(&g, "Y");
+    ASSERT_GE(csfg_graph_add_edge_parse_expr(&g, 0, 1, cstr_view("a")), 0);
+    ASSERT_EQ(csfg_io_graph_save(&ser, &g, 0, 1), 0);
+
+    struct deserializer des = deserializer(vec_data(ser), vec_count(ser) - 1);
+    ASSERT_EQ(csfg_io_graph_load(&des, &loaded, &node_in, &node_out), -1);
+}
+
+TEST_F(NAME, load_version_0)
+{
+    int node_in, node_out;
+    struct csfg_expr_pool* pool;
+    csfg_expr_pool_init(&pool);
+    int expr = csfg_expr_parse(&pool, cstr_view("a"));
+
+    serialize_u8(&ser, 0);
+    serialize_li16(&ser, 0);
+    serialize_li16(&ser, 1);
+    serialize_li16(&ser, 2);
+    serialize_lu16(&ser, 5);
+    serialize_cstr(&ser, "U");
+    serialize_li16(&ser, 10);
+    serialize_li16(&ser, 20);
+    serialize_lu16(&ser, 6);
+    serialize_cstr(&ser, "Y");
+    serialize_li16(&ser, 30);
+    serialize_li16(&ser, 40);
+    serialize_li16(&ser, 1);
+    serialize_lu16(&ser, 7);
+    serialize_li16(&ser, 0);
+    serialize_li16(&ser, 1);
+    serialize_li16(&ser, 50);
+    serialize_li16(&ser, 60);
+    csfg_io_expr_save(&ser, pool, expr);
+    csfg_expr_pool_deinit(pool);
+
+    struct deserializer des = deserializer(vec_data(ser), vec_count(ser));
+    ASSERT_EQ(csfg_io_graph_load(&des, &loaded, &node_in, &node_out), 0);
+    ASSERT_EQ(csfg_graph_node_count(&loaded), 2);
+    ASSERT_EQ(csfg_graph_edge_count(&loaded), 1);
+    ASSERT_EQ(csfg_graph_get_node(&loaded, 1)->id, 6);
+    ASSERT_EQ(csfg_graph_get_node(&loaded, 1)->y, 40);
+    ASSERT_EQ(csfg_graph_get_edge(&loaded, 0)->id, 7);
+    ASSERT_EQ(node_out, 1);
+}
+
+TEST_F(NAME, duplicate_ids_are_rejected)
+{
+    int node_in, node_out;
+    int n1 = csfg_graph_add_node(&g, "U");
+    int n2 = csfg_graph_add_node(&g, "Y");
+    int e1 = csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("a"));
+    ASSERT_GE(e1, 0);
+
+    /* Node and edge */
+    csfg_graph_get_edge(&g, e1)->id = csfg_graph_get_node(&g, n2)->id;
+    ASSERT_EQ(csfg_io_graph_save(&ser, &g, n1, n2), 0);
+    struct deserializer des = deserializer(vec_data(ser), vec_count(ser));
+    ASSERT_EQ(csfg_io_graph_load(&des, &loaded, &node_in, &node_out), -1);
+
+    /* Two nodes */
+    serializer_clear(ser);
+    csfg_graph_get_edge(&g, e1)->id = 100;
+    csfg_graph_get_node(&g, n2)->id = csfg_graph_get_node(&g, n1)->id;
+    ASSERT_EQ(csfg_io_graph_save(&ser, &g, n1, n2), 0);
+    des = deserializer(vec_data(ser), vec_count(ser));
+    ASSERT_EQ(csfg_io_graph_load(&des, &loaded, &node_in, &node_out), -1);
+
+    /* Deleted elements all share the same ID */
+    serializer_clear(ser);
+    csfg_graph_mark_node_deleted(&g, n2);
+    ASSERT_EQ(csfg_graph_get_node(&g, n2)->id, CSFG_GRAPH_GC_ID);
+    csfg_graph_mark_edge_deleted(&g, e1);
+    ASSERT_EQ(csfg_io_graph_save(&ser, &g, n1, n2), 0);
+    des = deserializer(vec_data(ser), vec_count(ser));
+    ASSERT_EQ(csfg_io_graph_load(&des, &loaded, &node_in, &node_out), 0);
+}
+
+TEST_F(NAME, no_free_id_left)
+{
+    int i;
+
+    /* Fill the ID space directly, adding every node through
+     * csfg_graph_add_node() searches the whole graph each time */
+    ASSERT_EQ(csfg_node_vec_realloc(&g.nodes, CSFG_GRAPH_GC_ID), 0);
+    for (i = 0; i != CSFG_GRAPH_GC_ID - 1; ++i)
+    {
+        struct csfg_node* n = csfg_node_vec_emplace_no_realloc(g.nodes);
+        memset(n, 0, sizeof(*n));
+        n->id = (uint16_t)i;
+    }
+    g.id_counter = CSFG_GRAPH_GC_ID - 1;
+
+    /* The last free ID */
+    ASSERT_EQ(csfg_graph_add_node(&g, "N"), CSFG_GRAPH_GC_ID - 1);
+    ASSERT_EQ(csfg_graph_get_node(&g, CSFG_GRAPH_GC_ID - 1)->id, 0xFFFE);
+
+    ASSERT_EQ(csfg_graph_add_node(&g, "N"), -1);
+    ASSERT_EQ(csfg_graph_add_edge_parse_expr(&g, 0, 1, cstr_view("a")), -1);
+    ASSERT_EQ(csfg_graph_node_count(&g), CSFG_GRAPH_GC_ID);
+    ASSERT_EQ(csfg_graph_edge_count(&g), 0);
+}
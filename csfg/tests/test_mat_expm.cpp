@@ -0,0 +1,85 @@
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "csfg/numeric/mat.h"
+}
+
+#define NAME test_mat_expm
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override
+    {
+        csfg_mat_init(&M);
+        csfg_mat_init(&E);
+    }
+    void TearDown() override
+    {
+        csfg_mat_deinit(E);
+        csfg_mat_deinit(M);
+    }
+
+    struct csfg_mat* M;
+    struct csfg_mat* E;
+};
+
+TEST_F(NAME, zero_matrix_is_identity)
+{
+    ASSERT_THAT(csfg_mat_realloc(&M, 3, 3), Eq(0));
+    csfg_mat_zero(M);
+    ASSERT_THAT(csfg_mat_expm(&E, M), Eq(0));
+
+    for (int r = 0; r != 3; ++r)
+        for (int c = 0; c != 3; ++c)
+        {
+            ASSERT_THAT(csfg_mat_get(E, r, c)->real, DoubleEq(r == c));
+            ASSERT_THAT(csfg_mat_get(E, r, c)->imag, DoubleEq(0.0));
+        }
+}
+
+TEST_F(NAME, diagonal_matrix)
+{
+    ASSERT_THAT(csfg_mat_realloc(&M, 3, 3), Eq(0));
+    csfg_mat_set_real(M, -1.0, 0.0, 0.0, 0.0, 2.5, 0.0, 0.0, 0.0, -30.0);
+    ASSERT_THAT(csfg_mat_expm(&E, M), Eq(0));
+
+    ASSERT_THAT(csfg_mat_get(E, 0, 0)->real, DoubleNear(exp(-1.0), 1e-15));
+    ASSERT_THAT(csfg_mat_get(E, 1, 1)->real, DoubleNear(exp(2.5), 1e-13));
+    ASSERT_THAT(csfg_mat_get(E, 2, 2)->real, DoubleNear(exp(-30.0), 1e-20));
+    ASSERT_THAT(csfg_mat_get(E, 0, 1)->real, DoubleEq(0.0));
+    ASSERT_THAT(csfg_mat_get(E, 1, 2)->real, DoubleEq(0.0));
+}
+
+TEST_F(NAME, nilpotent_matrix)
+{
+    ASSERT_THAT(csfg_mat_realloc(&M, 2, 2), Eq(0));
+    csfg_mat_set_real(M, 0.0, 7.0, 0.0, 0.0);
+    ASSERT_THAT(csfg_mat_expm(&E, M), Eq(0));
+
+    ASSERT_THAT(csfg_mat_get(E, 0, 0)->real, DoubleNear(1.0, 1e-14));
+    ASSERT_THAT(csfg_mat_get(E, 0, 1)->real, DoubleNear(7.0, 1e-13));
+    ASSERT_THAT(csfg_mat_get(E, 1, 0)->real, DoubleNear(0.0, 1e-14));
+    ASSERT_THAT(csfg_mat_get(E, 1, 1)->real, DoubleNear(1.0, 1e-14));
+}
+
+TEST_F(NAME, rotation)
+{
+    double t = 10.0;
+    ASSERT_THAT(csfg_mat_realloc(&M, 2, 2), Eq(0));
+    csfg_mat_set_real(M, 0.0, -t, t, 0.0);
+    ASSERT_THAT(csfg_mat_expm(&E, M), Eq(0));
+
+    ASSERT_THAT(csfg_mat_get(E, 0, 0)->real, DoubleNear(cos(t), 1e-12));
+    ASSERT_THAT(csfg_mat_get(E, 0, 1)->real, DoubleNear(-sin(t), 1e-12));
+    ASSERT_THAT(csfg_mat_get(E, 1, 0)->real, DoubleNear(sin(t), 1e-12));
+    ASSERT_THAT(csfg_mat_get(E, 1, 1)->real, DoubleNear(cos(t), 1e-12));
+}
+
+TEST_F(NAME, non_finite_fails)
+{
+    ASSERT_THAT(csfg_mat_realloc(&M, 2, 2), Eq(0));
+    csfg_mat_set_real(M, 0.0, NAN, 0.0, 0.0);
+    ASSERT_THAT(csfg_mat_expm(&E, M), Eq(-1));
+}
@@ -4,6 +4,10 @@ extern "C" {
 #include "csfg/numeric/mat.h"
 }
 
+#include <chrono>
+#include <cstdio>
+#include <random>
+
 #define NAME test_mat_lu_decomposition
 
 using namespace testing;
@@ -37,6 +41,29 @@ void AssertMatricesAreEqual(const csfg_mat* a, const csfg_mat* b)
         }
 }
 
+void AssertMatricesAreNear(const csfg_mat* a, const csfg_mat* b, double tol)
+{
+    ASSERT_EQ(csfg_mat_rows(a), csfg_mat_rows(b));
+    ASSERT_EQ(csfg_mat_cols(a), csfg_mat_cols(b));
+    for (int r = 0; r != csfg_mat_rows(a); ++r)
+        for (int c = 0; c != csfg_mat_cols(a); ++c)
+        {
+            ASSERT_NEAR(
+                csfg_mat_get(a, r, c)->real, csfg_mat_get(b, r, c)->real, tol);
+            ASSERT_NEAR(
+                csfg_mat_get(a, r, c)->imag, csfg_mat_get(b, r, c)->imag, tol);
+        }
+}
+
+void FillRandom(csfg_mat* M, unsigned seed)
+{
+    std::mt19937                           gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (int r = 0; r != csfg_mat_rows(M); ++r)
+        for (int c = 0; c != csfg_mat_cols(M); ++c)
+            *csfg_mat_get(M, r, c) = csfg_complex(dist(gen), dist(gen));
+}
+
 } // namespace
 
 struct NAME : public Test
@@ -105,8 +132,13 @@ TEST_F(NAME, example4)
 
     ASSERT_EQ(csfg_mat_lu_decomposition(&L, &U, &reorder, M), 0);
 
+    /* Column 1 has a larger entry below the diagonal after eliminating
+     * column 0 */
+    ASSERT_THAT(*vec_get(reorder, 1), Eq(2));
+
     csfg_mat_mul(&N, L, U);
-    AssertMatricesAreEqual(N, M);
+    csfg_mat_apply_reorder(N, reorder);
+    AssertMatricesAreNear(N, M, 1e-14);
 }
 
 TEST_F(NAME, lp2_repeated_roots)
@@ -155,3 +187,107 @@ TEST_F(NAME, ramp_response)
     csfg_mat_apply_reorder(N, reorder);
     AssertMatricesAreEqual(N, M);
 }
+
+TEST_F(NAME, pivots_on_largest_magnitude)
+{
+    csfg_mat_realloc(&M, 2, 2);
+    /* clang-format off */
+    csfg_mat_set_real(M,
+        1e-20, 1.0,
+        1.0,   1.0);
+    /* clang-format on */
+
+    ASSERT_EQ(csfg_mat_lu_decomposition(&L, &U, &reorder, M), 0);
+    ASSERT_THAT(*vec_get(reorder, 0), Eq(1));
+    ASSERT_THAT(*vec_get(reorder, 1), Eq(0));
+    ASSERT_THAT(*csfg_mat_get(U, 1, 1), ComplexEq(1.0, 0.0));
+
+    csfg_mat_mul(&N, L, U);
+    csfg_mat_apply_reorder(N, reorder);
+    AssertMatricesAreEqual(N, M);
+}
+
+TEST_F(NAME, pivots_on_imaginary_part)
+{
+    csfg_mat_realloc(&M, 2, 2);
+    csfg_mat_set_real(M, 0.0, 1.0, 0.0, 1.0);
+    csfg_mat_get(M, 1, 0)->imag = 2.0;
+
+    ASSERT_EQ(csfg_mat_lu_decomposition(&L, &U, &reorder, M), 0);
+    ASSERT_THAT(*vec_get(reorder, 0), Eq(1));
+
+    csfg_mat_mul(&N, L, U);
+    csfg_mat_apply_reorder(N, reorder);
+    AssertMatricesAreEqual(N, M);
+}
+
+TEST_F(NAME, singular_matrix_fails)
+{
+    csfg_mat_realloc(&M, 2, 2);
+    /* clang-format off */
+    csfg_mat_set_real(M,
+        1.0, 2.0,
+        2.0, 4.0);
+    /* clang-format on */
+
+    ASSERT_EQ(csfg_mat_lu_decomposition(&L, &U, &reorder, M), -1);
+}
+
+TEST_F(NAME, random_64x64)
+{
+    csfg_mat_realloc(&M, 64, 64);
+    FillRandom(M, 64);
+
+    ASSERT_EQ(csfg_mat_lu_decomposition(&L, &U, &reorder, M), 0);
+
+    csfg_mat_mul(&N, L, U);
+    csfg_mat_apply_reorder(N, reorder);
+    AssertMatricesAreNear(N, M, 1e-12);
+}
+
+TEST_F(NAME, random_250x250)
+{
+    /* Spans several panels, including a partial one */
+    csfg_mat_realloc(&M, 250, 250);
+    FillRandom(M, 250);
+
+    ASSERT_EQ(csfg_mat_lu_decomposition(&L, &U, &reorder, M), 0);
+
+    csfg_mat_mul(&N, L, U);
+    csfg_mat_apply_reorder(N, reorder);
+    AssertMatricesAreNear(N, M, 1e-11);
+}
+
+TEST_F(NAME, random_256x256)
+{
+    /* Spans several full panels. Row indices no longer fit into 8 bits. */
+    csfg_mat_realloc(&M, 256, 256);
+    FillRandom(M, 256);
+
+    ASSERT_EQ(csfg_mat_lu_decomposition(&L, &U, &reorder, M), 0);
+    ASSERT_THAT(vec_count(reorder), Eq(256));
+
+    csfg_mat_mul(&N, L, U);
+    csfg_mat_apply_reorder(N, reorder);
+    AssertMatricesAreNear(N, M, 1e-11);
+}
+
+/* Run with --gtest_also_run_disabled_tests */
+TEST_F(NAME, DISABLED_benchmark)
+{
+    for (int n : {64, 256})
+    {
+        int reps = n == 64 ? 2000 : 50;
+        csfg_mat_realloc(&M, n, n);
+        FillRandom(M, n);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i != reps; ++i)
+            ASSERT_EQ(csfg_mat_lu_decomposition(&L, &U, &reorder, M), 0);
+        auto end = std::chrono::steady_clock::now();
+
+        double us =
+            std::chrono::duration<double, std::micro>(end - start).count();
+        std::printf("%dx%d complex LU: %.1f us\n", n, n, us / reps);
+    }
+}
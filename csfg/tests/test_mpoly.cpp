@@ -0,0 +1,188 @@
+#include "csfg/tests/ExprHelper.hpp"
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/mpoly.h"
+#include "csfg/symbolic/poly_expr.h"
+#include "csfg/symbolic/var_table.h"
+}
+
+#define NAME test_mpoly
+
+using namespace testing;
+
+struct NAME : public Test, public ExprHelper
+{
+    void SetUp() override
+    {
+        csfg_expr_pool_init(&p);
+        csfg_var_table_init(&vt);
+        csfg_mpoly_init(&a);
+        csfg_mpoly_init(&b);
+        csfg_mpoly_init(&out);
+    }
+    void TearDown() override
+    {
+        csfg_mpoly_deinit(&out);
+        csfg_mpoly_deinit(&b);
+        csfg_mpoly_deinit(&a);
+        csfg_var_table_deinit(&vt);
+        csfg_expr_pool_deinit(p);
+    }
+
+    int from_str(struct csfg_mpoly* mp, const char* text)
+    {
+        int expr = csfg_expr_parse(&p, cstr_view(text));
+        if (expr < 0)
+            return -1;
+        return csfg_mpoly_from_expr(mp, p, expr);
+    }
+
+    struct csfg_expr_pool* p;
+    struct csfg_var_table vt;
+    struct csfg_mpoly a, b, out;
+};
+
+TEST_F(NAME, zero_has_no_terms)
+{
+    ASSERT_EQ(csfg_mpoly_set_lit(&a, 0.0), 0);
+    ASSERT_TRUE(csfg_mpoly_is_zero(&a));
+    ASSERT_EQ(from_str(&a, "x-x"), 0);
+    ASSERT_TRUE(csfg_mpoly_is_zero(&a));
+}
+
+TEST_F(NAME, like_terms_are_combined)
+{
+    ASSERT_EQ(from_str(&a, "a*b + 2*b*a + 3"), 0);
+    ASSERT_EQ(csfg_mpoly_term_count(&a), 2);
+}
+
+TEST_F(NAME, representation_is_canonical)
+{
+    ASSERT_EQ(from_str(&a, "(a+b)^2"), 0);
+    ASSERT_EQ(from_str(&b, "b*b + 2*a*b + a^2"), 0);
+    ASSERT_TRUE(csfg_mpoly_equal(&a, &b));
+    ASSERT_EQ(csfg_mpoly_term_count(&a), 3);
+}
+
+TEST_F(NAME, add_cancels_terms)
+{
+    ASSERT_EQ(from_str(&a, "a + b + 1"), 0);
+    ASSERT_EQ(from_str(&b, "-a - 1"), 0);
+    ASSERT_EQ(csfg_mpoly_add(&out, &a, &b), 0);
+    ASSERT_EQ(csfg_mpoly_term_count(&out), 1);
+}
+
+TEST_F(NAME, mul_difference_of_squares)
+{
+    ASSERT_EQ(from_str(&a, "a + b"), 0);
+    ASSERT_EQ(from_str(&b, "a - b"), 0);
+    ASSERT_EQ(csfg_mpoly_mul(&out, &a, &b), 0);
+    ASSERT_EQ(from_str(&a, "a^2 - b^2"), 0);
+    ASSERT_TRUE(csfg_mpoly_equal(&out, &a));
+}
+
+TEST_F(NAME, reciprocals_cancel)
+{
+    ASSERT_EQ(from_str(&a, "R1 / R1 + a*b/b"), 0);
+    ASSERT_EQ(from_str(&b, "1 + a"), 0);
+    ASSERT_TRUE(csfg_mpoly_equal(&a, &b));
+}
+
+TEST_F(NAME, negative_power_of_single_term)
+{
+    ASSERT_EQ(from_str(&a, "2*a*b^2"), 0);
+    ASSERT_EQ(csfg_mpoly_pow(&out, &a, -2), 0);
+    ASSERT_EQ(from_str(&b, "0.25*a^-2*b^-4"), 0);
+    ASSERT_TRUE(csfg_mpoly_equal(&out, &b));
+}
+
+TEST_F(NAME, exponent_overflow_fails)
+{
+    ASSERT_EQ(from_str(&a, "a^30000"), 0);
+    ASSERT_EQ(from_str(&b, "a^3000*b"), 0);
+    ASSERT_EQ(csfg_mpoly_mul(&out, &a, &b), -1);
+    ASSERT_EQ(from_str(&b, "a^-30000*b"), 0);
+    ASSERT_EQ(csfg_mpoly_mul(&out, &a, &b), 0);
+    ASSERT_EQ(from_str(&a, "b"), 0);
+    ASSERT_TRUE(csfg_mpoly_equal(&out, &a));
+
+    ASSERT_EQ(from_str(&a, "a^20000"), 0);
+    ASSERT_EQ(csfg_mpoly_pow(&out, &a, 2), -1);
+    ASSERT_EQ(csfg_mpoly_pow(&out, &a, -2), -1);
+    ASSERT_EQ(from_str(&a, "a^40000"), -1);
+}
+
+TEST_F(NAME, div_exact)
+{
+    ASSERT_EQ(from_str(&a, "a^3 - b^3"), 0);
+    ASSERT_EQ(from_str(&b, "a - b"), 0);
+    ASSERT_EQ(csfg_mpoly_div_exact(&out, &a, &b), 0);
+    ASSERT_EQ(from_str(&a, "a^2 + a*b + b^2"), 0);
+    ASSERT_TRUE(csfg_mpoly_equal(&out, &a));
+}
+
+TEST_F(NAME, div_exact_with_remainder_fails)
+{
+    ASSERT_EQ(from_str(&a, "a^2 + 1"), 0);
+    ASSERT_EQ(from_str(&b, "a + 1"), 0);
+    ASSERT_EQ(csfg_mpoly_div_exact(&out, &a, &b), -1);
+}
+
+TEST_F(NAME, division_by_sum_fails)
+{
+    ASSERT_EQ(from_str(&a, "1/(a+b)"), -1);
+    ASSERT_EQ(from_str(&a, "a^0.5"), -1);
+}
+
+TEST_F(NAME, round_trip_through_expr)
+{
+    int expr;
+    csfg_var_table_set_lit(&vt, cstr_view("a"), 3.0);
+    csfg_var_table_set_lit(&vt, cstr_view("b"), 5.0);
+    csfg_var_table_set_lit(&vt, cstr_view("c"), 7.0);
+
+    ASSERT_EQ(from_str(&a, "(a+b)*(a-c)^2 - 3/c + 4"), 0);
+    expr = csfg_mpoly_to_expr(&a, &p);
+    ASSERT_GE(expr, 0);
+
+    ASSERT_NEAR(csfg_expr_eval(p, expr, &vt), 132.0 - 3.0 / 7.0, 1e-9);
+    ASSERT_NEAR(csfg_mpoly_eval(&a, &vt), 132.0 - 3.0 / 7.0, 1e-9);
+
+    ASSERT_EQ(csfg_mpoly_from_expr(&b, p, expr), 0);
+    ASSERT_TRUE(csfg_mpoly_equal(&a, &b));
+}
+
+TEST_F(NAME, coeff_expr_canonicalize)
+{
+    struct csfg_coeff_expr c1, c2;
+    int e1 = csfg_expr_parse(&p, cstr_view("4*a*b + 2*b*b"));
+    int e2 = csfg_expr_parse(&p, cstr_view("b*(a+0.5*b)"));
+    c1     = csfg_coeff_expr(1, e1);
+    c2     = csfg_coeff_expr(4, e2);
+
+    ASSERT_EQ(csfg_coeff_expr_canonicalize(&p, &c1), 0);
+    ASSERT_EQ(csfg_coeff_expr_canonicalize(&p, &c2), 0);
+    ASSERT_DOUBLE_EQ(c1.factor, c2.factor);
+    ASSERT_TRUE(ExprEq(p, c1.expr, p, c2.expr));
+}
+
+TEST_F(NAME, coeff_expr_canonicalize_constant)
+{
+    struct csfg_coeff_expr c =
+        csfg_coeff_expr(2, csfg_expr_parse(&p, cstr_view("a*3/a")));
+    ASSERT_EQ(csfg_coeff_expr_canonicalize(&p, &c), 0);
+    ASSERT_DOUBLE_EQ(c.factor, 6.0);
+    ASSERT_EQ(c.expr, -1);
+}
+
+TEST_F(NAME, coeff_expr_canonicalize_failure_leaves_coeff_unchanged)
+{
+    int expr = csfg_expr_parse(&p, cstr_view("1/(a+b)"));
+    struct csfg_coeff_expr c = csfg_coeff_expr(2, expr);
+    ASSERT_EQ(csfg_coeff_expr_canonicalize(&p, &c), -1);
+    ASSERT_DOUBLE_EQ(c.factor, 2.0);
+    ASSERT_EQ(c.expr, expr);
+}
@@ -31,24 +31,32 @@ const struct TestParam TEST_PARAMETERS[] = {
     {{{0, "a"}}, {{0, "b"}},        {{0, ""}}},
 
     { {{1, ""}},  {{1, ""}},        {{2, ""}}},
-    {{{1, "a"}},  {{1, ""}},     {{1, "a+1"}}},
+    {{{1, "a"}},  {{1, ""}},     {{1, "1+a"}}},
     { {{1, ""}}, {{1, "b"}},     {{1, "1+b"}}},
-    {{{1, "a"}}, {{1, "b"}},     {{1, "a+b"}}},
+    {{{1, "a"}}, {{1, "b"}},     {{1, "b+a"}}},
 
     { {{1, ""}},  {{3, ""}},        {{4, ""}}},
-    {{{1, "a"}},  {{3, ""}},     {{1, "a+3"}}},
+    {{{1, "a"}},  {{3, ""}},     {{1, "3+a"}}},
     { {{1, ""}}, {{3, "b"}},   {{1, "1+3*b"}}},
-    {{{1, "a"}}, {{3, "b"}},   {{1, "a+3*b"}}},
+    {{{1, "a"}}, {{3, "b"}},   {{1, "3*b+a"}}},
 
     { {{5, ""}},  {{1, ""}},        {{6, ""}}},
-    {{{5, "a"}},  {{1, ""}},   {{1, "5*a+1"}}},
+    {{{5, "a"}},  {{1, ""}},   {{1, "1+5*a"}}},
     { {{5, ""}}, {{1, "b"}},     {{1, "5+b"}}},
-    {{{5, "a"}}, {{1, "b"}},   {{1, "5*a+b"}}},
+    {{{5, "a"}}, {{1, "b"}},   {{1, "b+5*a"}}},
 
     { {{5, ""}},  {{3, ""}},        {{8, ""}}},
-    {{{5, "a"}},  {{3, ""}},   {{1, "5*a+3"}}},
+    {{{5, "a"}},  {{3, ""}},   {{1, "3+5*a"}}},
     { {{5, ""}}, {{3, "b"}},   {{1, "5+3*b"}}},
-    {{{5, "a"}}, {{3, "b"}}, {{1, "5*a+3*b"}}},
+    {{{5, "a"}}, {{3, "b"}}, {{1, "3*b+5*a"}}},
+
+    // Like terms are combined
+    {{{1, "a"}}, {{2, "a"}},        {{3, "a"}}},
+    {{{1, "a+b"}}, {{-1, "b"}},     {{1, "a"}}},
+    {{{1, "a"}}, {{-1, "a"}},       {{0, ""}}},
+
+    // Not a polynomial in the parameters, the expressions are combined
+    {{{1, "1/(a+b)"}}, {{1, "c"}},  {{1, "1/(a+b)+c"}}},
 };
 
 std::ostream& operator<<(std::ostream& os, const std::vector<Coeff>& p)
@@ -53,10 +53,13 @@ const struct TestParam TEST_PARAMETERS[] = {
     // clang-format off
     {{{1, "a"}, {1, ""}},  // a + s
      {{1, "a*a*a"}, {1, "a*a"}, {1, "a"}}, // a^3 + s*a^2 + s^2*a
-     {{1, "a*(a*a*a)"}, {1, "a*(a*a)+a*a*a"}, {1, "a*a+a*a"}, {1, "a"}}},
+     {{1, "a^4"}, {2, "a^3"}, {2, "a^2"}, {1, "a"}}},
     {{{1, "a"}, {1, ""}},  // a + s
      {{1, "b*b*b"}, {1, "b*b"}, {1, "b"}}, // b^3 + s*b^2 + s^2*b
-     {{1, "a*(b*b*b)"}, {1, "a*(b*b)+b*b*b"}, {1, "a*b+b*b"}, {1, "b"}}},
+     {{1, "a*b^3"}, {1, "b^3+a*b^2"}, {1, "b^2+a*b"}, {1, "b"}}},
+    {{{1, "a"}, {-1, ""}},  // a - s
+     {{1, "a"}, {1, ""}},   // a + s
+     {{1, "a^2"}, {0, ""}, {-1, ""}}},
     // clang-format on
 };
 
@@ -150,5 +153,5 @@ TEST_F(NAME, multiple_same_polynomial_multiple_times)
     ASSERT_EQ(csfg_poly_expr_mul(&pool, &p2, p1, out), 0);
     ASSERT_EQ(csfg_poly_expr_mul(&pool, &out, p1, p2), 0);
 
-    ASSERT_TRUE(CoeffEq(pool, out, 0, 8.0, "s*(s*s*s)"));
+    ASSERT_TRUE(CoeffEq(pool, out, 0, 8.0, "s^4"));
 }
@@ -6,6 +6,8 @@ extern "C" {
 #include "csfg/numeric/poly.h"
 }
 
+#include <complex>
+
 #define NAME test_rpoly_partial_fraction_expansion
 
 using namespace testing;
@@ -59,6 +61,37 @@ struct NAME : public Test
         csfg_cpoly_deinit(num);
     }
 
+    /* Evaluates N(s) / (s^extra_zeros * prod(s-p)) */
+    std::complex<double> eval_rational(std::complex<double> s, int extra_zeros)
+    {
+        std::complex<double> result = 0.0;
+        for (int i = vec_count(num) - 1; i >= 0; --i)
+            result = result * s +
+                     std::complex<double>(
+                         vec_get(num, i)->real, vec_get(num, i)->imag);
+        for (int i = 0; i != vec_count(den); ++i)
+            result /= s - std::complex<double>(
+                              vec_get(den, i)->real, vec_get(den, i)->imag);
+        for (int i = 0; i != extra_zeros; ++i)
+            result /= s;
+        return result;
+    }
+
+    static std::complex<double>
+    eval_pfd(const struct csfg_pfd_poly* terms, std::complex<double> s)
+    {
+        std::complex<double> result = 0.0;
+        for (int i = 0; i != vec_count(terms); ++i)
+        {
+            const struct csfg_pfd* t = vec_get(terms, i);
+            result += std::complex<double>(t->A.real, t->A.imag) /
+                      std::pow(
+                          s - std::complex<double>(t->p.real, t->p.imag),
+                          t->n);
+        }
+        return result;
+    }
+
     struct csfg_cpoly*    num;
     struct csfg_rpoly*    den;
     struct csfg_pfd_poly* pfd;
@@ -369,3 +402,108 @@ TEST_F(NAME, lp2_repeated_roots)
             Field(&csfg_pfd::p, ComplexEq(-1, 0)),
             Field(&csfg_pfd::n, Eq(2)))));
 }
+
+TEST_F(NAME, mixed_repeated_and_complex_poles)
+{
+    /*
+     *          s^3 - 2*s + 5
+     * --------------------------------
+     * (s+1)^3 * (s^2+2s+5) * (s+3)^2
+     */
+    csfg_cpoly_push(&num, csfg_complex(5, 0));
+    csfg_cpoly_push(&num, csfg_complex(-2, 0));
+    csfg_cpoly_push(&num, csfg_complex(0, 0));
+    csfg_cpoly_push(&num, csfg_complex(1, 0));
+    csfg_rpoly_push(&den, csfg_complex(-1, 0));
+    csfg_rpoly_push(&den, csfg_complex(-1, 2));
+    csfg_rpoly_push(&den, csfg_complex(-3, 0));
+    csfg_rpoly_push(&den, csfg_complex(-1, 0));
+    csfg_rpoly_push(&den, csfg_complex(-1, -2));
+    csfg_rpoly_push(&den, csfg_complex(-1, 0));
+    csfg_rpoly_push(&den, csfg_complex(-3, 0));
+
+    ASSERT_EQ(csfg_rpoly_partial_fraction_decomposition(&pfd, num, den), 0);
+    ASSERT_EQ(vec_count(pfd), 7);
+
+    for (double w : {0.1, 0.7, 2.0, 13.0})
+    {
+        std::complex<double> s(0.3, w);
+        std::complex<double> expected = eval_rational(s, 0);
+        std::complex<double> actual   = eval_pfd(pfd, s);
+        ASSERT_THAT(actual.real(), DoubleNear(expected.real(), 1e-12));
+        ASSERT_THAT(actual.imag(), DoubleNear(expected.imag(), 1e-12));
+    }
+}
+
+TEST_F(NAME, div_s_one_pole)
+{
+    /*
+     *     1          1     1
+     * --------- = - --- + ---
+     * s * (s+1)     s+1    s
+     */
+    struct csfg_pfd_poly* step;
+    csfg_pfd_poly_init(&step);
+    csfg_cpoly_push(&num, csfg_complex(1, 0));
+    csfg_rpoly_push(&den, csfg_complex(-1, 0));
+
+    ASSERT_EQ(csfg_rpoly_partial_fraction_decomposition(&pfd, num, den), 0);
+    ASSERT_EQ(csfg_pfd_poly_div_s(&step, pfd), 0);
+
+    ASSERT_EQ(vec_count(step), 2);
+    EXPECT_THAT(
+        vec_get(step, 0),
+        Pointee(AllOf(
+            Field(&csfg_pfd::A, ComplexEq(-1, 0)),
+            Field(&csfg_pfd::p, ComplexEq(-1, 0)),
+            Field(&csfg_pfd::n, Eq(1)))));
+    EXPECT_THAT(
+        vec_get(step, 1),
+        Pointee(AllOf(
+            Field(&csfg_pfd::A, ComplexEq(1, 0)),
+            Field(&csfg_pfd::p, ComplexEq(0, 0)),
+            Field(&csfg_pfd::n, Eq(1)))));
+
+    csfg_pfd_poly_deinit(step);
+}
+
+TEST_F(NAME, div_s_matches_decomposition_with_extra_poles)
+{
+    /* Step and ramp of (s+4) / ((s+1)^2 * (s^2+s+1) * s) */
+    struct csfg_pfd_poly* step;
+    struct csfg_pfd_poly* ramp;
+    csfg_pfd_poly_init(&step);
+    csfg_pfd_poly_init(&ramp);
+    csfg_cpoly_push(&num, csfg_complex(4, 0));
+    csfg_cpoly_push(&num, csfg_complex(1, 0));
+    csfg_rpoly_push(&den, csfg_complex(-1, 0));
+    csfg_rpoly_push(&den, csfg_complex(-1, 0));
+    csfg_rpoly_push(&den, csfg_complex(-0.5, 0.866));
+    csfg_rpoly_push(&den, csfg_complex(-0.5, -0.866));
+    csfg_rpoly_push(&den, csfg_complex(0, 0));
+
+    ASSERT_EQ(csfg_rpoly_partial_fraction_decomposition(&pfd, num, den), 0);
+    ASSERT_EQ(csfg_pfd_poly_div_s(&step, pfd), 0);
+    ASSERT_EQ(csfg_pfd_poly_div_s(&ramp, step), 0);
+
+    /* The existing pole at 0 becomes a repeated pole */
+    ASSERT_EQ(vec_count(step), 6);
+    ASSERT_EQ(vec_count(ramp), 7);
+
+    for (double w : {0.1, 0.7, 2.0, 13.0})
+    {
+        std::complex<double> s(0.3, w);
+        std::complex<double> expected = eval_rational(s, 1);
+        std::complex<double> actual   = eval_pfd(step, s);
+        ASSERT_THAT(actual.real(), DoubleNear(expected.real(), 1e-12));
+        ASSERT_THAT(actual.imag(), DoubleNear(expected.imag(), 1e-12));
+
+        expected = eval_rational(s, 2);
+        actual   = eval_pfd(ramp, s);
+        ASSERT_THAT(actual.real(), DoubleNear(expected.real(), 1e-12));
+        ASSERT_THAT(actual.imag(), DoubleNear(expected.imag(), 1e-12));
+    }
+
+    csfg_pfd_poly_deinit(ramp);
+    csfg_pfd_poly_deinit(step);
+}
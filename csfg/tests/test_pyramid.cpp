@@ -0,0 +1,144 @@
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "csfg/numeric/pyramid.h"
+}
+
+#include <cmath>
+#include <vector>
+
+#define NAME test_pyramid
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override { csfg_pyramid_init(&pyr); }
+    void TearDown() override { csfg_pyramid_deinit(&pyr); }
+
+    void sample(double (*f)(double), double x_start, double x_end, int n)
+    {
+        x.resize(n);
+        y.resize(n);
+        for (int i = 0; i != n; ++i)
+        {
+            x[i] = x_start + (x_end - x_start) * i / (n - 1);
+            y[i] = f(x[i]);
+        }
+    }
+
+    /* Range of the samples with x_start <= x < x_end */
+    csfg_minmax brute_force(double x_start, double x_end)
+    {
+        csfg_minmax r = {HUGE_VAL, -HUGE_VAL};
+        for (size_t i = 0; i != x.size(); ++i)
+            if (x[i] >= x_start && x[i] < x_end)
+            {
+                r.min = std::min(r.min, y[i]);
+                r.max = std::max(r.max, y[i]);
+            }
+        return r;
+    }
+
+    struct csfg_pyramid pyr;
+    std::vector<double> x, y;
+};
+
+TEST_F(NAME, invalid_input)
+{
+    double x[] = {1.0, 1.0};
+    double y[] = {0.0, 1.0};
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x, y, 1, 16), Eq(-1));
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x, y, 2, 16), Eq(-1));
+    x[1] = 2.0;
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x, y, 2, 0), Eq(-1));
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x, y, 2, 16), Eq(0));
+}
+
+TEST_F(NAME, levels_halve_bucket_count)
+{
+    sample(sin, 0.0, 10.0, 1000);
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x.data(), y.data(), 1000, 100), Eq(0));
+    ASSERT_THAT(pyr.levels, Eq(8));
+    ASSERT_THAT(pyr.count[0], Eq(128));
+    ASSERT_THAT(pyr.count[7], Eq(1));
+    ASSERT_THAT(pyr.data[pyr.offset[7]].min, DoubleNear(-1.0, 1e-4));
+    ASSERT_THAT(pyr.data[pyr.offset[7]].max, DoubleNear(1.0, 1e-4));
+}
+
+TEST_F(NAME, query_contains_samples)
+{
+    sample(sin, 0.0, 20.0, 4097);
+    ASSERT_THAT(
+        csfg_pyramid_build(&pyr, x.data(), y.data(), 4097, 4096), Eq(0));
+
+    /* The bucket boundaries of the query don't line up with the pyramid, so
+     * the result may be a little wider than the samples, but never narrower */
+    csfg_minmax out[37];
+    csfg_pyramid_query(&pyr, 1.3, 17.9, out, 37);
+    for (int b = 0; b != 37; ++b)
+    {
+        double      step = (17.9 - 1.3) / 37;
+        csfg_minmax r    = brute_force(1.3 + b * step, 1.3 + (b + 1) * step);
+        ASSERT_THAT(out[b].min, Le(r.min));
+        ASSERT_THAT(out[b].max, Ge(r.max));
+        ASSERT_THAT(out[b].min, Ge(r.min - 2 * step));
+        ASSERT_THAT(out[b].max, Le(r.max + 2 * step));
+    }
+}
+
+TEST_F(NAME, narrow_peak_is_kept)
+{
+    /* A single spike that is much narrower than one bucket */
+    double x[] = {0.0, 0.5, 0.5001, 0.5002, 1.0};
+    double y[] = {0.0, 0.0, 80.0, 0.0, 0.0};
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x, y, 5, 1024), Eq(0));
+
+    csfg_minmax out[10];
+    csfg_pyramid_query(&pyr, 0.0, 1.0, out, 10);
+    ASSERT_THAT(out[5].max, DoubleEq(80.0));
+    ASSERT_THAT(out[4].max, DoubleEq(0.0));
+    ASSERT_THAT(out[6].max, DoubleEq(0.0));
+}
+
+TEST_F(NAME, sparse_points_fill_buckets)
+{
+    /* A straight line through many buckets without any points in them */
+    double x[] = {0.0, 1.0};
+    double y[] = {0.0, 1.0};
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x, y, 2, 256), Eq(0));
+
+    csfg_minmax out[4];
+    csfg_pyramid_query(&pyr, 0.0, 1.0, out, 4);
+    for (int b = 0; b != 4; ++b)
+    {
+        ASSERT_THAT(out[b].min, DoubleNear(b * 0.25, 1e-9));
+        ASSERT_THAT(out[b].max, DoubleNear((b + 1) * 0.25, 1e-9));
+    }
+}
+
+TEST_F(NAME, outside_of_range_is_empty)
+{
+    sample(sin, 0.0, 1.0, 100);
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x.data(), y.data(), 100, 64), Eq(0));
+
+    csfg_minmax out[4];
+    csfg_pyramid_query(&pyr, -2.0, 2.0, out, 4);
+    ASSERT_THAT(out[0].min, Gt(out[0].max));
+    ASSERT_THAT(out[1].min, Gt(out[1].max));
+    ASSERT_THAT(out[2].min, Le(out[2].max));
+    ASSERT_THAT(out[3].min, Gt(out[3].max));
+}
+
+TEST_F(NAME, non_finite_values_are_skipped)
+{
+    double x[] = {0.0, 1.0, 2.0, 3.0};
+    double y[] = {1.0, NAN, 2.0, 3.0};
+    ASSERT_THAT(csfg_pyramid_build(&pyr, x, y, 4, 3), Eq(0));
+
+    csfg_minmax out[3];
+    csfg_pyramid_query(&pyr, 0.0, 3.0, out, 3);
+    ASSERT_THAT(out[0].min, Gt(out[0].max));
+    ASSERT_THAT(out[2].min, DoubleEq(2.0));
+    ASSERT_THAT(out[2].max, DoubleEq(3.0));
+}
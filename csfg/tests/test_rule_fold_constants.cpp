@@ -44,7 +44,7 @@ TEST_F(NAME, simplify_constant_expression_with_negate)
     ASSERT_GE(r1, 0);
     ASSERT_GT(csfg_rule_fold_constants(&p1), 0);
     ASSERT_EQ(p1->nodes[p1->nodes[r1].child[1]].type, CSFG_EXPR_LIT);
-    ASSERT_FLOAT_EQ(p1->nodes[p1->nodes[r1].child[1]].value.lit, -1.0);
+    ASSERT_DOUBLE_EQ(csfg_expr_lit_value(p1, p1->nodes[r1].child[1]), -1.0);
 }
 
 TEST_F(NAME, simplify_constant_expressions_exponent)
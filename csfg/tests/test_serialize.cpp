@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+
+extern "C" {
+#include "csfg/graph/graph.h"
+#include "csfg/io/deserialize.h"
+#include "csfg/io/io.h"
+#include "csfg/io/serialize.h"
+}
+
+#define NAME test_serialize
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override { serializer_init(&ser); }
+    void TearDown() override { serializer_deinit(ser); }
+
+    struct serializer* ser;
+};
+
+TEST_F(NAME, arrays_are_little_endian)
+{
+    uint16_t u16[2] = {0x0102, 0x0304};
+    uint32_t u32[1] = {0x05060708};
+    ASSERT_EQ(serialize_lu16_array(&ser, u16, 2), 0);
+    ASSERT_EQ(serialize_lu32_array(&ser, u32, 1), 0);
+
+    const uint8_t expected[] = {0x02, 0x01, 0x04, 0x03, 0x08, 0x07, 0x06, 0x05};
+    ASSERT_EQ(vec_count(ser), 8);
+    for (int i = 0; i != 8; ++i)
+        EXPECT_EQ(vec_data(ser)[i], expected[i]);
+
+    /* Must match the scalar writers */
+    struct deserializer des = deserializer(vec_data(ser), vec_count(ser));
+    EXPECT_EQ(deserialize_lu16(&des), 0x0102);
+    EXPECT_EQ(deserialize_lu16(&des), 0x0304);
+    EXPECT_EQ(deserialize_lu32(&des), 0x05060708u);
+}
+
+TEST_F(NAME, array_round_trip)
+{
+    int32_t i32[3]  = {-1, 0, 70000};
+    double  f64[2]  = {3.14159, -1e300};
+    int32_t i32r[3] = {0};
+    double  f64r[2] = {0};
+
+    ASSERT_EQ(serialize_li32_array(&ser, i32, 3), 0);
+    ASSERT_EQ(serialize_lf64_array(&ser, f64, 2), 0);
+
+    struct deserializer des = deserializer(vec_data(ser), vec_count(ser));
+    deserialize_li32_array(&des, i32r, 3);
+    deserialize_lf64_array(&des, f64r, 2);
+    ASSERT_FALSE(deserializer_err(&des));
+    ASSERT_EQ(deserializer_bytes_left(&des), 0);
+    EXPECT_EQ(i32r[0], -1);
+    EXPECT_EQ(i32r[2], 70000);
+    EXPECT_EQ(f64r[0], 3.14159);
+    EXPECT_EQ(f64r[1], -1e300);
+}
+
+TEST_F(NAME, array_past_end_sets_error)
+{
+    uint32_t u32[2] = {1, 2};
+    ASSERT_EQ(serialize_lu32_array(&ser, u32, 1), 0);
+
+    struct deserializer des = deserializer(vec_data(ser), vec_count(ser));
+    deserialize_lu32_array(&des, u32, 2);
+    ASSERT_TRUE(deserializer_err(&des));
+    EXPECT_EQ(u32[0], 1u);
+    EXPECT_EQ(u32[1], 2u);
+}
+
+/* Run with --gtest_also_run_disabled_tests */
+TEST_F(NAME, DISABLED_graph_throughput)
+{
+    struct csfg_graph g, loaded;
+    int               i, node_in, node_out;
+    const int         iterations = 50;
+
+    csfg_graph_init(&g);
+    csfg_graph_init(&loaded);
+    for (i = 0; i != 2000; ++i)
+        ASSERT_GE(csfg_graph_add_node(&g, "node"), 0);
+    for (i = 0; i != 1999; ++i)
+        ASSERT_GE(
+            csfg_graph_add_edge_parse_expr(
+                &g, i, i + 1, cstr_view("a*s^2 + b*s + 1/(c*s + 2.5)")),
+            0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (i = 0; i != iterations; ++i)
+    {
+        serializer_clear(ser);
+        ASSERT_EQ(csfg_io_graph_save(&ser, &g, 0, 1999), 0);
+    }
+    auto save_end = std::chrono::steady_clock::now();
+    for (i = 0; i != iterations; ++i)
+    {
+        struct deserializer des = deserializer(vec_data(ser), vec_count(ser));
+        ASSERT_EQ(csfg_io_graph_load(&des, &loaded, &node_in, &node_out), 0);
+    }
+    auto load_end = std::chrono::steady_clock::now();
+
+    double mb = (double)vec_count(ser) * iterations / (1024.0 * 1024.0);
+    std::printf(
+        "%d bytes per graph, save: %.1f MB/s, load: %.1f MB/s\n",
+        vec_count(ser),
+        mb / std::chrono::duration<double>(save_end - start).count(),
+        mb / std::chrono::duration<double>(load_end - save_end).count());
+
+    csfg_graph_deinit(&loaded);
+    csfg_graph_deinit(&g);
+}
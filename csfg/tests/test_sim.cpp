@@ -0,0 +1,244 @@
+#include "csfg/tests/LogHelper.hpp"
+
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "csfg/numeric/sim.h"
+#include "csfg/numeric/ss.h"
+#include "csfg/numeric/tf.h"
+}
+
+#include <complex>
+#include <initializer_list>
+#include <vector>
+
+#define NAME test_sim
+
+using namespace testing;
+
+struct NAME : public Test, LogHelper
+{
+    void SetUp() override
+    {
+        csfg_tf_init(&tf);
+        csfg_sim_init(&sim);
+    }
+    void TearDown() override
+    {
+        csfg_sim_deinit(&sim);
+        csfg_tf_deinit(&tf);
+    }
+
+    /* Coefficients in ascending order of s */
+    void make_tf(
+        std::initializer_list<double> num, std::initializer_list<double> den)
+    {
+        for (double c : num)
+            csfg_cpoly_push(&tf.num, csfg_complex(c, 0.0));
+        for (double c : den)
+            csfg_cpoly_push(&tf.den, csfg_complex(c, 0.0));
+        tf.factor = csfg_cpoly_monic(tf.den);
+        tf.factor = csfg_complex_div(tf.factor, csfg_cpoly_monic(tf.num));
+        csfg_cpoly_find_roots(&tf.zeros, tf.num, 0, 0.0);
+        csfg_cpoly_find_roots(&tf.poles, tf.den, 0, 0.0);
+    }
+
+    std::vector<double> step(int n)
+    {
+        std::vector<double> y(n, 1.0);
+        csfg_sim_run(&sim, y.data(), y.data(), n);
+        return y;
+    }
+
+    struct csfg_tf  tf;
+    struct csfg_sim sim;
+};
+
+TEST_F(NAME, invalid_arguments)
+{
+    make_tf({1.0, 1.0}, {1.0, 1.0});
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.0, CSFG_BILINEAR), Eq(-1));
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, -1.0, CSFG_BILINEAR), Eq(-1));
+}
+
+TEST_F(NAME, improper_tf_fails)
+{
+    make_tf({1.0, 1.0, 1.0}, {1.0, 1.0});
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.01, CSFG_BILINEAR), Eq(-1));
+    EXPECT_THAT(
+        log(),
+        LogStartsWith(
+            "[Error] Can't simulate an improper transfer function\n"));
+}
+
+TEST_F(NAME, first_order_zoh_is_exact)
+{
+    /* 2 / (s + 3) */
+    make_tf({2.0}, {3.0, 1.0});
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.01, CSFG_ZOH), Eq(0));
+
+    std::vector<double> y = step(500);
+    for (int k = 0; k != 500; ++k)
+    {
+        /* The output at sample k only depends on inputs before it */
+        double t        = 0.01 * k;
+        double expected = 2.0 / 3.0 * (1.0 - exp(-3.0 * t));
+        ASSERT_THAT(y[k], DoubleNear(expected, 1e-12));
+    }
+}
+
+TEST_F(NAME, second_order_zoh_is_exact)
+{
+    /* wn^2 / (s^2 + 2*zeta*wn*s + wn^2) */
+    double wn = 10.0, zeta = 0.2;
+    double wd = wn * sqrt(1 - zeta * zeta);
+    make_tf({wn * wn}, {wn * wn, 2 * zeta * wn, 1.0});
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.001, CSFG_ZOH), Eq(0));
+
+    std::vector<double> y = step(3000);
+    for (int k = 0; k != 3000; ++k)
+    {
+        double t        = 0.001 * k;
+        double envelope = exp(-zeta * wn * t);
+        double expected =
+            1.0 - envelope * (cos(wd * t) + zeta * wn / wd * sin(wd * t));
+        ASSERT_THAT(y[k], DoubleNear(expected, 1e-9));
+    }
+}
+
+TEST_F(NAME, third_order_zoh_is_exact)
+{
+    /* 1 / (s + 1)^3. The root finder resolves the triple pole only to about
+     * 1e-5, so the poles are set exactly. */
+    make_tf({1.0}, {1.0, 3.0, 3.0, 1.0});
+    csfg_rpoly_clear(tf.poles);
+    for (int i = 0; i != 3; ++i)
+        csfg_rpoly_push(&tf.poles, csfg_complex(-1.0, 0.0));
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.1, CSFG_ZOH), Eq(0));
+
+    /* The hold applies to the input of the whole cascade, so the samples are
+     * exact and not just close for small steps */
+    std::vector<double> y = step(200);
+    for (int k = 0; k != 200; ++k)
+    {
+        double t        = 0.1 * k;
+        double expected = 1.0 - exp(-t) * (1.0 + t + t * t / 2);
+        ASSERT_THAT(y[k], DoubleNear(expected, 1e-12)) << "t = " << t;
+    }
+}
+
+TEST_F(NAME, zoh_matches_state_space_step_response)
+{
+    /* (s + 2)(s^2 + s + 9) / ((s + 1)(s^2 + 0.4*s + 4)(s^2 + 2*s + 25)) */
+    make_tf(
+        {18.0, 11.0, 3.0, 1.0}, {100.0, 118.0, 47.8, 32.2, 3.4, 1.0});
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.05, CSFG_ZOH), Eq(0));
+    ASSERT_THAT(vec_count(sim.sections), Eq(3));
+
+    struct csfg_ss ss;
+    csfg_ss_init(&ss);
+    ASSERT_THAT(csfg_ss_from_tf_controllable(&ss, &tf), Eq(0));
+    std::vector<double> expected(400);
+    ASSERT_THAT(
+        csfg_ss_step_response(&ss, 0.05, expected.data(), 400), Eq(0));
+    csfg_ss_deinit(&ss);
+
+    std::vector<double> y = step(400);
+    for (int k = 0; k != 400; ++k)
+        ASSERT_THAT(y[k], DoubleNear(expected[k], 1e-9)) << "k = " << k;
+}
+
+TEST_F(NAME, repeated_poles)
+{
+    /* 1 / (s + 1)^3 */
+    make_tf({1.0}, {1.0, 3.0, 3.0, 1.0});
+
+    for (auto method : {CSFG_BILINEAR, CSFG_ZOH})
+    {
+        ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.001, method), Eq(0));
+        std::vector<double> y = step(10000);
+        for (int k = 0; k < 10000; k += 100)
+        {
+            double t        = 0.001 * k;
+            double expected = 1.0 - exp(-t) * (1.0 + t + t * t / 2);
+            ASSERT_THAT(y[k], DoubleNear(expected, 1e-3)) << "t = " << t;
+        }
+    }
+}
+
+TEST_F(NAME, biproper_tf_has_feedthrough)
+{
+    /* (s + 2) / (s + 1) starts at 1 and settles at 2 */
+    make_tf({2.0, 1.0}, {1.0, 1.0});
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.001, CSFG_ZOH), Eq(0));
+    std::vector<double> y = step(20000);
+    ASSERT_THAT(y[0], DoubleNear(1.0, 1e-9));
+    ASSERT_THAT(y.back(), DoubleNear(2.0, 1e-6));
+}
+
+TEST_F(NAME, high_order_is_stable)
+{
+    /* 8th order Butterworth with a cutoff at 1 rad/s, built from its poles so
+     * the expanded denominator is exact to double precision */
+    std::vector<std::complex<double>> den = {1.0};
+    for (int k = 0; k != 8; ++k)
+    {
+        double theta = M_PI / 2 + M_PI * (2 * k + 1) / 16;
+        std::complex<double> p(cos(theta), sin(theta));
+        std::vector<std::complex<double>> next(den.size() + 1, 0.0);
+        for (size_t i = 0; i != den.size(); ++i)
+        {
+            next[i + 1] += den[i];
+            next[i] -= den[i] * p;
+        }
+        den = next;
+    }
+    csfg_cpoly_push(&tf.num, csfg_complex(1.0, 0.0));
+    for (auto c : den)
+        csfg_cpoly_push(&tf.den, csfg_complex(c.real(), 0.0));
+    csfg_cpoly_find_roots(&tf.poles, tf.den, 0, 0.0);
+
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.01, CSFG_BILINEAR), Eq(0));
+    ASSERT_THAT(vec_count(sim.sections), Eq(4));
+
+    std::vector<double> y = step(200000);
+    ASSERT_THAT(y.back(), DoubleNear(1.0, 1e-9));
+    for (double v : y)
+        ASSERT_THAT(fabs(v), Lt(1.5));
+}
+
+TEST_F(NAME, sine_input_matches_frequency_response)
+{
+    /* 1 / (s^2 + 0.5*s + 1) at w = 2 */
+    double dt = 0.0005, w = 2.0;
+    make_tf({1.0}, {1.0, 0.5, 1.0});
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, dt, CSFG_BILINEAR), Eq(0));
+
+    int                 n = 200000;
+    std::vector<double> y(n);
+    for (int k = 0; k != n; ++k)
+        y[k] = sin(w * k * dt);
+    csfg_sim_run(&sim, y.data(), y.data(), n);
+
+    /* Once the transient has decayed the amplitude is |H(jw)| */
+    double peak = 0.0;
+    for (int k = n / 2; k != n; ++k)
+        peak = std::max(peak, fabs(y[k]));
+    double expected = csfg_complex_mag(csfg_tf_eval(&tf, csfg_complex(0, w)));
+    ASSERT_THAT(peak, DoubleNear(expected, 1e-4));
+}
+
+TEST_F(NAME, chunks_continue_and_reset)
+{
+    make_tf({1.0}, {1.0, 0.5, 1.0});
+    ASSERT_THAT(csfg_sim_from_tf(&sim, &tf, 0.01, CSFG_BILINEAR), Eq(0));
+    std::vector<double> whole = step(1000);
+
+    csfg_sim_reset(&sim);
+    std::vector<double> first  = step(300);
+    std::vector<double> second = step(700);
+    for (int k = 0; k != 300; ++k)
+        ASSERT_THAT(first[k], DoubleEq(whole[k]));
+    for (int k = 0; k != 700; ++k)
+        ASSERT_THAT(second[k], DoubleEq(whole[k + 300]));
+}
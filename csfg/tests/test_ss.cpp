@@ -0,0 +1,175 @@
+#include "csfg/tests/LogHelper.hpp"
+
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "csfg/numeric/ss.h"
+#include "csfg/numeric/tf.h"
+}
+
+#include <initializer_list>
+#include <vector>
+
+#define NAME test_ss
+
+using namespace testing;
+
+struct NAME : public Test, LogHelper
+{
+    void SetUp() override
+    {
+        csfg_tf_init(&tf);
+        csfg_ss_init(&ss);
+    }
+    void TearDown() override
+    {
+        csfg_ss_deinit(&ss);
+        csfg_tf_deinit(&tf);
+    }
+
+    /* Coefficients in ascending order of s */
+    void make_tf(
+        std::initializer_list<double> num, std::initializer_list<double> den)
+    {
+        for (double c : num)
+            csfg_cpoly_push(&tf.num, csfg_complex(c, 0.0));
+        for (double c : den)
+            csfg_cpoly_push(&tf.den, csfg_complex(c, 0.0));
+        tf.factor = csfg_cpoly_monic(tf.den);
+        tf.factor = csfg_complex_div(tf.factor, csfg_cpoly_monic(tf.num));
+    }
+
+    static double re(const struct csfg_mat* mat, int r, int c)
+    {
+        return csfg_mat_get(mat, r, c)->real;
+    }
+
+    struct csfg_tf tf;
+    struct csfg_ss ss;
+};
+
+TEST_F(NAME, controllable_form)
+{
+    /* (s + 3) / (2s^2 + 6s + 4) */
+    make_tf({3.0, 1.0}, {4.0, 6.0, 2.0});
+    ASSERT_THAT(csfg_ss_from_tf_controllable(&ss, &tf), Eq(0));
+
+    ASSERT_THAT(csfg_mat_rows(ss.A), Eq(2));
+    ASSERT_THAT(re(ss.A, 0, 0), DoubleEq(0.0));
+    ASSERT_THAT(re(ss.A, 0, 1), DoubleEq(1.0));
+    ASSERT_THAT(re(ss.A, 1, 0), DoubleEq(-2.0));
+    ASSERT_THAT(re(ss.A, 1, 1), DoubleEq(-3.0));
+    ASSERT_THAT(re(ss.B, 0, 0), DoubleEq(0.0));
+    ASSERT_THAT(re(ss.B, 1, 0), DoubleEq(1.0));
+    ASSERT_THAT(re(ss.C, 0, 0), DoubleEq(1.5));
+    ASSERT_THAT(re(ss.C, 0, 1), DoubleEq(0.5));
+    ASSERT_THAT(re(ss.D, 0, 0), DoubleEq(0.0));
+}
+
+TEST_F(NAME, observable_form_is_dual)
+{
+    make_tf({3.0, 1.0}, {4.0, 6.0, 2.0});
+    ASSERT_THAT(csfg_ss_from_tf_observable(&ss, &tf), Eq(0));
+
+    ASSERT_THAT(re(ss.A, 0, 0), DoubleEq(0.0));
+    ASSERT_THAT(re(ss.A, 0, 1), DoubleEq(-2.0));
+    ASSERT_THAT(re(ss.A, 1, 0), DoubleEq(1.0));
+    ASSERT_THAT(re(ss.A, 1, 1), DoubleEq(-3.0));
+    ASSERT_THAT(re(ss.B, 0, 0), DoubleEq(1.5));
+    ASSERT_THAT(re(ss.B, 1, 0), DoubleEq(0.5));
+    ASSERT_THAT(re(ss.C, 0, 0), DoubleEq(0.0));
+    ASSERT_THAT(re(ss.C, 0, 1), DoubleEq(1.0));
+    ASSERT_THAT(re(ss.D, 0, 0), DoubleEq(0.0));
+}
+
+TEST_F(NAME, biproper_tf_has_feedthrough)
+{
+    /* (2s + 1) / (s + 1) = 2 - 1 / (s + 1) */
+    make_tf({1.0, 2.0}, {1.0, 1.0});
+    ASSERT_THAT(csfg_ss_from_tf_controllable(&ss, &tf), Eq(0));
+    ASSERT_THAT(re(ss.A, 0, 0), DoubleEq(-1.0));
+    ASSERT_THAT(re(ss.C, 0, 0), DoubleEq(-1.0));
+    ASSERT_THAT(re(ss.D, 0, 0), DoubleEq(2.0));
+
+    std::vector<double> y(1000);
+    ASSERT_THAT(csfg_ss_step_response(&ss, 0.01, y.data(), 1000), Eq(0));
+    for (int k = 0; k != 1000; ++k)
+        ASSERT_THAT(y[k], DoubleNear(1.0 + exp(-0.01 * k), 1e-12));
+}
+
+TEST_F(NAME, improper_tf_fails)
+{
+    make_tf({1.0, 1.0, 1.0}, {1.0, 1.0});
+    ASSERT_THAT(csfg_ss_from_tf_controllable(&ss, &tf), Eq(-1));
+    EXPECT_THAT(
+        log(),
+        LogStartsWith("[Error] Can't realize an improper transfer function in "
+                      "state space\n"));
+}
+
+TEST_F(NAME, invalid_time_step)
+{
+    double y[4];
+    make_tf({1.0}, {1.0, 1.0});
+    ASSERT_THAT(csfg_ss_from_tf_controllable(&ss, &tf), Eq(0));
+    ASSERT_THAT(csfg_ss_step_response(&ss, 0.0, y, 4), Eq(-1));
+    ASSERT_THAT(csfg_ss_impulse_response(&ss, -1.0, y, 4), Eq(-1));
+}
+
+TEST_F(NAME, impulse_response_second_order)
+{
+    /* wn^2 / (s^2 + 2*zeta*wn*s + wn^2) */
+    double wn = 10.0, zeta = 0.2;
+    double wd = wn * sqrt(1 - zeta * zeta);
+    make_tf({wn * wn}, {wn * wn, 2 * zeta * wn, 1.0});
+
+    for (int observable = 0; observable != 2; ++observable)
+    {
+        ASSERT_THAT(
+            observable ? csfg_ss_from_tf_observable(&ss, &tf)
+                       : csfg_ss_from_tf_controllable(&ss, &tf),
+            Eq(0));
+
+        std::vector<double> y(2000);
+        ASSERT_THAT(
+            csfg_ss_impulse_response(&ss, 0.001, y.data(), 2000), Eq(0));
+        for (int k = 0; k != 2000; ++k)
+        {
+            double t        = 0.001 * k;
+            double expected = wn * wn / wd * exp(-zeta * wn * t) * sin(wd * t);
+            ASSERT_THAT(y[k], DoubleNear(expected, 1e-9)) << "t = " << t;
+        }
+    }
+}
+
+TEST_F(NAME, step_response_repeated_poles)
+{
+    /* 1 / (s + 1)^6 has a sixfold pole, which partial fractions struggle
+     * with */
+    make_tf({1.0}, {1.0, 6.0, 15.0, 20.0, 15.0, 6.0, 1.0});
+    ASSERT_THAT(csfg_ss_from_tf_controllable(&ss, &tf), Eq(0));
+
+    std::vector<double> y(2000);
+    ASSERT_THAT(csfg_ss_step_response(&ss, 0.01, y.data(), 2000), Eq(0));
+    for (int k = 0; k != 2000; ++k)
+    {
+        double t = 0.01 * k, sum = 0.0, term = 1.0;
+        for (int i = 0; i != 6; ++i)
+        {
+            sum += term;
+            term *= t / (i + 1);
+        }
+        ASSERT_THAT(y[k], DoubleNear(1.0 - exp(-t) * sum, 1e-9)) << "t = " << t;
+    }
+}
+
+TEST_F(NAME, pure_gain)
+{
+    double y[3];
+    make_tf({3.0}, {2.0});
+    ASSERT_THAT(csfg_ss_from_tf_controllable(&ss, &tf), Eq(0));
+    ASSERT_THAT(csfg_mat_rows(ss.A), Eq(0));
+    ASSERT_THAT(csfg_ss_step_response(&ss, 0.1, y, 3), Eq(0));
+    ASSERT_THAT(y[0], DoubleEq(1.5));
+    ASSERT_THAT(y[2], DoubleEq(1.5));
+}
@@ -0,0 +1,113 @@
+#include "csfg/tests/LogHelper.hpp"
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "csfg/util/text_cache.h"
+}
+
+#define NAME test_text_cache
+
+using namespace ::testing;
+
+struct NAME : Test, LogHelper
+{
+public:
+    void SetUp() override { ASSERT_EQ(text_cache_init(&cache, 3), 0); }
+    void TearDown() override { text_cache_deinit(&cache); }
+
+    int insert(const char* font, double size, const char* text, double adv)
+    {
+        struct text_extents ext = {adv, adv, 10.0};
+        return text_cache_insert(
+            &cache, cstr_view(font), size, cstr_view(text), &ext);
+    }
+    const struct text_extents*
+    find(const char* font, double size, const char* text)
+    {
+        return text_cache_find(
+            &cache, cstr_view(font), size, cstr_view(text));
+    }
+
+    struct text_cache cache;
+};
+
+TEST_F(NAME, find_inserted)
+{
+    ASSERT_EQ(insert("Sans", 12, "abc", 1.0), 0);
+    ASSERT_EQ(insert("Sans", 12, "def", 2.0), 0);
+    ASSERT_EQ(text_cache_count(&cache), 2);
+
+    ASSERT_NE(find("Sans", 12, "abc"), nullptr);
+    ASSERT_EQ(find("Sans", 12, "abc")->x_advance, 1.0);
+    ASSERT_EQ(find("Sans", 12, "def")->x_advance, 2.0);
+    ASSERT_EQ(find("Sans", 12, "xyz"), nullptr);
+}
+
+TEST_F(NAME, font_and_size_are_part_of_key)
+{
+    ASSERT_EQ(insert("Sans", 12, "abc", 1.0), 0);
+    ASSERT_EQ(insert("Sans", 16, "abc", 2.0), 0);
+    ASSERT_EQ(insert("Serif", 12, "abc", 3.0), 0);
+
+    ASSERT_EQ(find("Sans", 12, "abc")->x_advance, 1.0);
+    ASSERT_EQ(find("Sans", 16, "abc")->x_advance, 2.0);
+    ASSERT_EQ(find("Serif", 12, "abc")->x_advance, 3.0);
+}
+
+TEST_F(NAME, insert_existing_updates)
+{
+    ASSERT_EQ(insert("Sans", 12, "abc", 1.0), 0);
+    ASSERT_EQ(insert("Sans", 12, "abc", 5.0), 0);
+    ASSERT_EQ(text_cache_count(&cache), 1);
+    ASSERT_EQ(find("Sans", 12, "abc")->x_advance, 5.0);
+}
+
+TEST_F(NAME, evicts_least_recently_used)
+{
+    ASSERT_EQ(insert("Sans", 12, "a", 1.0), 0);
+    ASSERT_EQ(insert("Sans", 12, "b", 2.0), 0);
+    ASSERT_EQ(insert("Sans", 12, "c", 3.0), 0);
+
+    /* Using "a" makes "b" the least recently used */
+    ASSERT_NE(find("Sans", 12, "a"), nullptr);
+    ASSERT_EQ(insert("Sans", 12, "d", 4.0), 0);
+
+    ASSERT_EQ(text_cache_count(&cache), 3);
+    ASSERT_EQ(find("Sans", 12, "b"), nullptr);
+    ASSERT_EQ(find("Sans", 12, "a")->x_advance, 1.0);
+    ASSERT_EQ(find("Sans", 12, "c")->x_advance, 3.0);
+    ASSERT_EQ(find("Sans", 12, "d")->x_advance, 4.0);
+}
+
+TEST_F(NAME, many_inserts_stay_bounded)
+{
+    char buf[32];
+    for (int i = 0; i != 1000; ++i)
+    {
+        snprintf(buf, sizeof(buf), "text %d", i);
+        ASSERT_EQ(insert("Sans", 12, buf, i), 0);
+        ASSERT_LE(text_cache_count(&cache), 3);
+    }
+
+    ASSERT_EQ(find("Sans", 12, "text 996"), nullptr);
+    ASSERT_EQ(find("Sans", 12, "text 997")->x_advance, 997.0);
+    ASSERT_EQ(find("Sans", 12, "text 998")->x_advance, 998.0);
+    ASSERT_EQ(find("Sans", 12, "text 999")->x_advance, 999.0);
+}
+
+TEST_F(NAME, clear)
+{
+    ASSERT_EQ(insert("Sans", 12, "a", 1.0), 0);
+    ASSERT_EQ(insert("Sans", 12, "b", 2.0), 0);
+    text_cache_clear(&cache);
+    ASSERT_EQ(text_cache_count(&cache), 0);
+    ASSERT_EQ(find("Sans", 12, "a"), nullptr);
+
+    ASSERT_EQ(insert("Sans", 12, "a", 1.0), 0);
+    ASSERT_EQ(insert("Sans", 12, "b", 2.0), 0);
+    ASSERT_EQ(insert("Sans", 12, "c", 3.0), 0);
+    ASSERT_EQ(insert("Sans", 12, "d", 4.0), 0);
+    ASSERT_EQ(text_cache_count(&cache), 3);
+    ASSERT_EQ(find("Sans", 12, "a"), nullptr);
+}
@@ -0,0 +1,147 @@
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "csfg/numeric/tf.h"
+}
+
+#define NAME test_tf_bode
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override
+    {
+        csfg_tf_init(&tf);
+        csfg_bode_vec_init(&points);
+    }
+    void TearDown() override
+    {
+        csfg_bode_vec_deinit(points);
+        csfg_tf_deinit(&tf);
+    }
+
+    /* 1 / (s^2 + wp/qp*s + wp^2) */
+    void make_lowpass(double wp, double qp)
+    {
+        csfg_cpoly_push(&tf.num, csfg_complex(1.0, 0.0));
+        csfg_cpoly_push(&tf.den, csfg_complex(wp * wp, 0.0));
+        csfg_cpoly_push(&tf.den, csfg_complex(wp / qp, 0.0));
+        csfg_cpoly_push(&tf.den, csfg_complex(1.0, 0.0));
+        csfg_cpoly_find_roots(&tf.poles, tf.den, 0, 0.0);
+    }
+
+    double mag_db(double f)
+    {
+        return 20.0 * log10(
+                          csfg_complex_mag(
+                              csfg_tf_eval(&tf, csfg_complex(0.0, f))));
+    }
+
+    /* Linear interpolation of the polyline */
+    double interpolate_mag_db(double log_f)
+    {
+        for (int i = 1; i < vec_count(points); ++i)
+        {
+            const csfg_bode_point* a = vec_get(points, i - 1);
+            const csfg_bode_point* b = vec_get(points, i);
+            if (log_f <= b->log_f)
+            {
+                double t = (log_f - a->log_f) / (b->log_f - a->log_f);
+                return a->mag_db + (b->mag_db - a->mag_db) * t;
+            }
+        }
+        return NAN;
+    }
+
+    struct csfg_tf        tf;
+    struct csfg_bode_vec* points;
+};
+
+TEST_F(NAME, invalid_interval)
+{
+    make_lowpass(1.0, 0.707);
+    ASSERT_THAT(csfg_tf_bode(&points, &tf, 0.0, 10.0, 0.1, 0.01), Eq(-1));
+    ASSERT_THAT(csfg_tf_bode(&points, &tf, 10.0, 1.0, 0.1, 0.01), Eq(-1));
+}
+
+TEST_F(NAME, endpoints_and_order)
+{
+    make_lowpass(1.0, 0.707);
+    ASSERT_THAT(csfg_tf_bode(&points, &tf, 0.01, 100.0, 0.1, 0.01), Eq(0));
+    ASSERT_THAT(vec_count(points), Gt(2));
+    ASSERT_THAT(vec_first(points)->log_f, DoubleEq(-2.0));
+    ASSERT_THAT(vec_last(points)->log_f, DoubleEq(2.0));
+    for (int i = 1; i < vec_count(points); ++i)
+        ASSERT_THAT(
+            vec_get(points, i)->log_f, Gt(vec_get(points, i - 1)->log_f));
+}
+
+TEST_F(NAME, values_match_tf)
+{
+    make_lowpass(1.0, 0.707);
+    ASSERT_THAT(csfg_tf_bode(&points, &tf, 0.01, 100.0, 0.1, 0.01), Eq(0));
+    for (int i = 0; i < vec_count(points); ++i)
+    {
+        double f = pow(10.0, vec_get(points, i)->log_f);
+        ASSERT_THAT(vec_get(points, i)->mag_db, DoubleNear(mag_db(f), 1e-9));
+    }
+}
+
+TEST_F(NAME, phase_is_unwrapped)
+{
+    /* Two pole pairs turn the phase by -360 degrees in total */
+    csfg_cpoly_push(&tf.num, csfg_complex(1.0, 0.0));
+    csfg_cpoly_push(&tf.den, csfg_complex(1.0, 0.0));
+    csfg_cpoly_push(&tf.den, csfg_complex(4.0, 0.0));
+    csfg_cpoly_push(&tf.den, csfg_complex(6.0, 0.0));
+    csfg_cpoly_push(&tf.den, csfg_complex(4.0, 0.0));
+    csfg_cpoly_push(&tf.den, csfg_complex(1.0, 0.0));
+    csfg_cpoly_find_roots(&tf.poles, tf.den, 0, 0.0);
+
+    ASSERT_THAT(csfg_tf_bode(&points, &tf, 0.001, 1000.0, 0.1, 0.01), Eq(0));
+    ASSERT_THAT(vec_first(points)->phase, DoubleNear(0.0, 0.01));
+    ASSERT_THAT(vec_last(points)->phase, DoubleNear(-2 * M_PI, 0.01));
+    for (int i = 1; i < vec_count(points); ++i)
+        ASSERT_THAT(
+            vec_get(points, i)->phase - vec_get(points, i - 1)->phase,
+            Lt(0.5));
+}
+
+TEST_F(NAME, resolves_high_q_resonance)
+{
+    /* Peak of about 20*log10(Q) = 80dB that is only 1e-4 wide */
+    make_lowpass(1.0, 10000.0);
+    ASSERT_THAT(csfg_tf_bode(&points, &tf, 0.01, 100.0, 0.1, 0.01), Eq(0));
+
+    double peak = -INFINITY;
+    for (int i = 0; i < vec_count(points); ++i)
+        peak = std::max(peak, vec_get(points, i)->mag_db);
+    ASSERT_THAT(peak, DoubleNear(mag_db(1.0), 0.5));
+
+    /* A uniform grid would need millions of points for the same accuracy */
+    ASSERT_THAT(vec_count(points), Lt(2000));
+}
+
+TEST_F(NAME, polyline_is_within_tolerance)
+{
+    make_lowpass(1.0, 20.0);
+    ASSERT_THAT(csfg_tf_bode(&points, &tf, 0.01, 100.0, 0.1, 0.01), Eq(0));
+
+    for (int i = 0; i <= 4000; ++i)
+    {
+        double log_f = -2.0 + 4.0 * i / 4000;
+        ASSERT_THAT(
+            interpolate_mag_db(log_f), DoubleNear(mag_db(pow(10, log_f)), 0.5))
+            << "log_f = " << log_f;
+    }
+}
+
+TEST_F(NAME, flat_regions_use_few_points)
+{
+    /* Constant gain */
+    csfg_cpoly_push(&tf.num, csfg_complex(2.0, 0.0));
+    csfg_cpoly_push(&tf.den, csfg_complex(1.0, 0.0));
+    ASSERT_THAT(csfg_tf_bode(&points, &tf, 0.01, 100.0, 0.1, 0.01), Eq(0));
+    ASSERT_THAT(vec_count(points), Le(41));
+}
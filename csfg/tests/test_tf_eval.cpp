@@ -7,6 +7,9 @@ extern "C" {
 #include "csfg/symbolic/var_table.h"
 }
 
+#include <cmath>
+#include <string>
+
 #define NAME test_tf_eval
 
 using namespace testing;
@@ -96,3 +99,35 @@ TEST_F(NAME, bandpass)
         csfg_tf_eval(&tf, csfg_complex(0, 5)),
         ComplexEq(0.00319744, -0.0799040));
 }
+
+TEST_F(NAME, high_order_butterworth_at_realistic_cutoff)
+{
+    const struct csfg_coeff_expr* coeff;
+
+    /* 12th order Butterworth with wc = 1000 rad/s. The coefficients span 36
+     * orders of magnitude, which the root finder can't resolve. */
+    std::string text = "wc^12/(1";
+    for (int k = 1; k <= 6; ++k)
+        text += "*(s^2+a" + std::to_string(k) + "*wc*s+wc^2)";
+    text += ")";
+    int expr = csfg_expr_parse(&p, cstr_view(text.c_str()));
+    ASSERT_THAT(csfg_expr_to_rational(&tf_expr, &p, expr, "s"), Eq(0));
+    vec_for_each (tf_expr.num, coeff)
+        csfg_var_table_populate(&vt, p, coeff->expr);
+    vec_for_each (tf_expr.den, coeff)
+        csfg_var_table_populate(&vt, p, coeff->expr);
+    for (int k = 1; k <= 6; ++k)
+        csfg_var_table_set_lit(
+            &vt,
+            cstr_view(("a" + std::to_string(k)).c_str()),
+            2 * sin((2 * k - 1) * M_PI / 24));
+    csfg_var_table_set_lit(&vt, cstr_view("wc"), 1000);
+
+    ASSERT_THAT(csfg_tf_from_symbolic(&tf, p, &tf_expr, &vt), Eq(0));
+    for (double w : {1.0, 100.0, 1000.0, 2000.0})
+    {
+        double mag = csfg_complex_mag(csfg_tf_eval(&tf, csfg_complex(0, w)));
+        double expected = 1.0 / sqrt(1.0 + pow(w / 1000.0, 24));
+        ASSERT_THAT(mag, DoubleNear(expected, expected * 1e-9)) << "w = " << w;
+    }
+}
@@ -0,0 +1,479 @@
+#include "csfg/tests/LogHelper.hpp"
+
+#include "gmock/gmock.h"
+
+#include <math.h>
+#include <string>
+
+extern "C" {
+#include "csfg/graph/graph.h"
+#include "csfg/numeric/tf.h"
+#include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/var_table.h"
+}
+
+#define NAME test_tf_from_graph
+
+using namespace testing;
+
+struct NAME : public Test, LogHelper
+{
+    void SetUp() override
+    {
+        csfg_graph_init(&g);
+        csfg_var_table_init(&subs);
+        csfg_var_table_init(&params);
+        csfg_tf_init(&tf);
+        csfg_path_vec_init(&paths);
+        csfg_path_vec_init(&loops);
+        csfg_expr_pool_init(&pool);
+    }
+    void TearDown() override
+    {
+        csfg_expr_pool_deinit(pool);
+        csfg_path_vec_deinit(loops);
+        csfg_path_vec_deinit(paths);
+        csfg_tf_deinit(&tf);
+        csfg_var_table_deinit(&params);
+        csfg_var_table_deinit(&subs);
+        csfg_graph_deinit(&g);
+    }
+
+    /* Reference solution: Mason's gain formula evaluated at a real "s" */
+    double mason(int n_in, int n_out, double s)
+    {
+        csfg_path_vec_clear(paths);
+        csfg_path_vec_clear(loops);
+        if (csfg_graph_find_forward_paths(&g, &paths, n_in, n_out) != 0)
+            return -1;
+        if (csfg_graph_find_loops(&g, &loops) != 0)
+            return -1;
+        int expr = csfg_graph_mason(&g, &pool, paths, loops);
+        expr = csfg_expr_insert_substitutions(&pool, expr, &subs);
+        if (expr < 0)
+            return -1;
+        csfg_var_table_set_lit(&params, cstr_view("s"), s);
+        return csfg_expr_eval(pool, expr, &params);
+    }
+
+    struct csfg_graph      g;
+    struct csfg_var_table  subs;
+    struct csfg_var_table  params;
+    struct csfg_tf         tf;
+    struct csfg_path_vec*  paths;
+    struct csfg_path_vec*  loops;
+    struct csfg_expr_pool* pool;
+};
+
+TEST_F(NAME, first_order_lowpass)
+{
+    int Vin  = csfg_graph_add_node(&g, "Vin");
+    int Vout = csfg_graph_add_node(&g, "Vout");
+    csfg_graph_add_edge_parse_expr(&g, Vin, Vout, cstr_view("1/(1+s*R*C)"));
+    csfg_var_table_set_lit(&params, cstr_view("R"), 1e3);
+    csfg_var_table_set_lit(&params, cstr_view("C"), 1e-6);
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, Vin, Vout, &subs, &params), 0);
+    ASSERT_EQ(vec_count(tf.poles), 1);
+    ASSERT_EQ(vec_count(tf.zeros), 0);
+    EXPECT_NEAR(vec_first(tf.poles)->real, -1e3, 1e-3);
+
+    struct csfg_complex H = csfg_tf_eval(&tf, csfg_complex(0, 1e3));
+    EXPECT_NEAR(H.real, 0.5, 1e-6);
+    EXPECT_NEAR(H.imag, -0.5, 1e-6);
+}
+
+TEST_F(NAME, pole_zero_cancellation)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    int n3 = csfg_graph_add_node(&g, "n3");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("1/(s+a)"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n3, cstr_view("k*(s+a)/(s+b)"));
+    csfg_var_table_set_lit(&params, cstr_view("a"), 2);
+    csfg_var_table_set_lit(&params, cstr_view("b"), 5);
+    csfg_var_table_set_lit(&params, cstr_view("k"), 3);
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n3, &subs, &params), 0);
+    ASSERT_EQ(vec_count(tf.poles), 1);
+    ASSERT_EQ(vec_count(tf.zeros), 0);
+    EXPECT_NEAR(vec_first(tf.poles)->real, -5, 1e-6);
+
+    /* 3 / (s+5) */
+    struct csfg_complex H = csfg_tf_eval(&tf, csfg_complex(1, 2));
+    EXPECT_NEAR(H.real, 3.0 * 6 / 40, 1e-6);
+    EXPECT_NEAR(H.imag, -3.0 * 2 / 40, 1e-6);
+}
+
+TEST_F(NAME, active_lowpass_filter)
+{
+    int Vin  = csfg_graph_add_node(&g, "Vin");
+    int I2   = csfg_graph_add_node(&g, "I2");
+    int V2   = csfg_graph_add_node(&g, "V2");
+    int V3   = csfg_graph_add_node(&g, "V3");
+    int V4   = csfg_graph_add_node(&g, "V4");
+    int Vout = csfg_graph_add_node(&g, "Vout");
+    csfg_graph_add_edge_parse_expr(&g, Vin, I2, cstr_view("G1"));
+    csfg_graph_add_edge_parse_expr(&g, I2, V2, cstr_view("z2"));
+    csfg_graph_add_edge_parse_expr(&g, V2, V4, cstr_view("-1"));
+    csfg_graph_add_edge_parse_expr(&g, V3, V4, cstr_view("1"));
+    csfg_graph_add_edge_parse_expr(&g, V4, Vout, cstr_view("A"));
+    csfg_graph_add_edge_parse_expr(&g, Vout, I2, cstr_view("G2+s*C"));
+
+    // clang-format off
+    csfg_var_table_set_parse_expr(&subs, cstr_view("y2"), cstr_view("G1 + G2 + s*C"));
+    csfg_var_table_set_parse_expr(&subs, cstr_view("z2"), cstr_view("1/y2"));
+    double G1 = 3;  csfg_var_table_set_lit(&params, cstr_view("G1"), G1);
+    double G2 = 5;  csfg_var_table_set_lit(&params, cstr_view("G2"), G2);
+    double C  = 7;  csfg_var_table_set_lit(&params, cstr_view("C"), C);
+    double A  = 13; csfg_var_table_set_lit(&params, cstr_view("A"), A);
+    // clang-format on
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, Vin, Vout, &subs, &params), 0);
+
+    /* The denominator of z2 is common to every loop and cancels */
+    ASSERT_EQ(vec_count(tf.poles), 1);
+    ASSERT_EQ(vec_count(tf.zeros), 0);
+
+    for (double s : {0.1, 1.0, 11.0})
+    {
+        double z2 = 1.0 / (G1 + G2 + s * C);
+        double expected = (-G1 * z2 * A) / (1 + A * (G2 + s * C) * z2);
+        struct csfg_complex H = csfg_tf_eval(&tf, csfg_complex(s, 0));
+        EXPECT_NEAR(H.real, expected, 1e-9);
+        EXPECT_NEAR(H.imag, 0.0, 1e-9);
+    }
+}
+
+TEST_F(NAME, no_forward_path)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    int n3 = csfg_graph_add_node(&g, "n3");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("a"));
+    csfg_graph_add_edge_parse_expr(&g, n3, n2, cstr_view("b"));
+
+    csfg_var_table_set_lit(&params, cstr_view("a"), 2.0);
+    csfg_var_table_set_lit(&params, cstr_view("b"), 3.0);
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n3, &subs, &params), -1);
+    EXPECT_THAT(
+        log(),
+        LogStartsWith(
+            "[Error] There is no path from input node 0 to output node 2\n"));
+    EXPECT_EQ(vec_count(tf.num), 0);
+    EXPECT_EQ(vec_count(tf.den), 0);
+    EXPECT_EQ(vec_count(tf.poles), 0);
+    EXPECT_EQ(vec_count(tf.zeros), 0);
+    EXPECT_EQ(vec_count(tf.sections), 0);
+}
+
+TEST_F(NAME, invalid_nodes_fail)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("2"));
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, 5, &subs, &params), -1);
+    EXPECT_THAT(
+        log(),
+        LogStartsWith("[Error] Input node 0 or output node 5 doesn't exist "
+                      "in the graph\n"));
+}
+
+TEST_F(NAME, failure_clears_previous_result)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    int n3 = csfg_graph_add_node(&g, "n3");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("1/(1+s)"));
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n2, &subs, &params), 0);
+    ASSERT_EQ(vec_count(tf.poles), 1);
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n3, &subs, &params), -1);
+    EXPECT_EQ(vec_count(tf.num), 0);
+    EXPECT_EQ(vec_count(tf.den), 0);
+    EXPECT_EQ(vec_count(tf.poles), 0);
+    EXPECT_EQ(vec_count(tf.zeros), 0);
+    EXPECT_EQ(vec_count(tf.sections), 0);
+}
+
+TEST_F(NAME, more_coefficients_than_supported_fails)
+{
+    /* 300 stages of degree 60 need more than CSFG_CPOLY_MAX_COEFFS samples
+     * once rounded up to the FFT size */
+    int prev = csfg_graph_add_node(&g, "V0");
+    int in   = prev;
+    for (int i = 1; i <= 300; ++i)
+    {
+        std::string name = "V" + std::to_string(i);
+        int         node = csfg_graph_add_node(&g, name.c_str());
+        csfg_graph_add_edge_parse_expr(
+            &g, prev, node, cstr_view("1/(1+s^60)"));
+        prev = node;
+    }
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, in, prev, &subs, &params), -1);
+    EXPECT_THAT(
+        log(),
+        LogStartsWith("[Error] Can't interpolate a transfer function with "
+                      "32768 coefficients, at most 16384 are supported\n"));
+    EXPECT_EQ(vec_count(tf.den), 0);
+}
+
+TEST_F(NAME, coefficients_spanning_too_many_magnitudes_fail)
+{
+    /* 40 RC stages have coefficients from 1 to 1e-120, which the samples on
+     * one circle can't resolve */
+    int prev = csfg_graph_add_node(&g, "V0");
+    int in   = prev;
+    for (int i = 1; i <= 40; ++i)
+    {
+        std::string name = "V" + std::to_string(i);
+        int         node = csfg_graph_add_node(&g, name.c_str());
+        csfg_graph_add_edge_parse_expr(
+            &g, prev, node, cstr_view("1/(1+s*R*C)"));
+        prev = node;
+    }
+    csfg_var_table_set_lit(&params, cstr_view("R"), 1e3);
+    csfg_var_table_set_lit(&params, cstr_view("C"), 1e-6);
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, in, prev, &subs, &params), -1);
+    EXPECT_THAT(
+        log(),
+        LogStartsWith("[Error] Can't interpolate the transfer function "
+                      "accurately, the coefficients span too many orders of "
+                      "magnitude\n"));
+    EXPECT_EQ(vec_count(tf.num), 0);
+    EXPECT_EQ(vec_count(tf.den), 0);
+    EXPECT_EQ(vec_count(tf.poles), 0);
+}
+
+TEST_F(NAME, degrees_around_previous_coefficient_limit)
+{
+    /* 1/(1+s^k) has k poles on the unit circle. The previous limit was 64
+     * coefficients, so these cross it and the FFT size boundary */
+    for (int degree : {62, 63, 64, 70})
+    {
+        std::string expr = "1/(1+s^" + std::to_string(degree) + ")";
+        csfg_graph_clear(&g);
+        int n1 = csfg_graph_add_node(&g, "n1");
+        int n2 = csfg_graph_add_node(&g, "n2");
+        csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view(expr.c_str()));
+
+        ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n2, &subs, &params), 0)
+            << "degree " << degree;
+        EXPECT_EQ(vec_count(tf.poles), degree) << "degree " << degree;
+        EXPECT_EQ(vec_count(tf.zeros), 0) << "degree " << degree;
+        for (int i = 0; i != vec_count(tf.poles); ++i)
+            EXPECT_NEAR(csfg_complex_mag(*vec_get(tf.poles, i)), 1.0, 1e-6)
+                << "degree " << degree;
+
+        static const double w[3] = {0.5, 0.9, 2.0};
+        for (int i = 0; i != 3; ++i)
+        {
+            struct csfg_complex s = csfg_complex(0, w[i]);
+            struct csfg_complex sk =
+                csfg_complex_pow(s, csfg_complex(degree, 0));
+            struct csfg_complex expected = csfg_complex_div(
+                csfg_complex(1, 0), csfg_complex_add(csfg_complex(1, 0), sk));
+            struct csfg_complex H = csfg_tf_eval(&tf, s);
+            EXPECT_NEAR(H.real, expected.real, 1e-6) << "degree " << degree;
+            EXPECT_NEAR(H.imag, expected.imag, 1e-6) << "degree " << degree;
+        }
+    }
+}
+
+TEST_F(NAME, repeated_poles_cancel_with_repeated_zeros)
+{
+    /* k parallel lowpass filters sum to k/(1+s/1000), but the interpolated
+     * polynomials have k-1 common roots at -1000 which only cancel as a
+     * cluster */
+    for (int k : {3, 5, 8})
+    {
+        csfg_graph_clear(&g);
+        int n1 = csfg_graph_add_node(&g, "n1");
+        int n2 = csfg_graph_add_node(&g, "n2");
+        for (int i = 0; i != k; ++i)
+            csfg_graph_add_edge_parse_expr(
+                &g, n1, n2, cstr_view("1/(1+s/1000)"));
+
+        ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n2, &subs, &params), 0);
+        ASSERT_EQ(vec_count(tf.poles), 1) << k << " edges";
+        EXPECT_EQ(vec_count(tf.zeros), 0) << k << " edges";
+        EXPECT_NEAR(vec_first(tf.poles)->real, -1e3, 1e-6) << k << " edges";
+
+        struct csfg_complex H = csfg_tf_eval(&tf, csfg_complex(0, 1e3));
+        EXPECT_NEAR(H.real, k * 0.5, 1e-9) << k << " edges";
+        EXPECT_NEAR(H.imag, -k * 0.5, 1e-9) << k << " edges";
+    }
+}
+
+TEST_F(NAME, nearly_equal_pole_and_zero_cancel)
+{
+    /* 1e-7 relative distance is within the cancellation tolerance */
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    csfg_graph_add_edge_parse_expr(
+        &g, n1, n2, cstr_view("(s+1000)/(s+1000.0001)"));
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n2, &subs, &params), 0);
+    EXPECT_EQ(vec_count(tf.poles), 0);
+    EXPECT_EQ(vec_count(tf.zeros), 0);
+}
+
+TEST_F(NAME, close_but_distinct_roots_dont_cancel)
+{
+    /* 1e-4 relative distance is outside the cancellation tolerance */
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    csfg_graph_add_edge_parse_expr(
+        &g, n1, n2, cstr_view("(s+1000)/(s+1000.1)"));
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n2, &subs, &params), 0);
+    ASSERT_EQ(vec_count(tf.poles), 1);
+    ASSERT_EQ(vec_count(tf.zeros), 1);
+    EXPECT_NEAR(vec_first(tf.poles)->real, -1000.1, 1e-6);
+    EXPECT_NEAR(vec_first(tf.zeros)->real, -1000, 1e-6);
+
+    /* A double zero between two distinct poles is not a repeated root */
+    csfg_graph_clear(&g);
+    n1 = csfg_graph_add_node(&g, "n1");
+    n2 = csfg_graph_add_node(&g, "n2");
+    csfg_graph_add_edge_parse_expr(
+        &g, n1, n2, cstr_view("(s+1000)^2/((s+1000.1)*(s+999.9))"));
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n2, &subs, &params), 0);
+    EXPECT_EQ(vec_count(tf.poles), 2);
+    EXPECT_EQ(vec_count(tf.zeros), 2);
+}
+
+TEST_F(NAME, two_nontouching_loops_matches_mason)
+{
+    int n1 = csfg_graph_add_node(&g, "n1");
+    int n2 = csfg_graph_add_node(&g, "n2");
+    int n3 = csfg_graph_add_node(&g, "n3");
+    int n4 = csfg_graph_add_node(&g, "n4");
+    csfg_graph_add_edge_parse_expr(&g, n1, n2, cstr_view("G1/(s+a)"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n3, cstr_view("G2"));
+    csfg_graph_add_edge_parse_expr(&g, n3, n4, cstr_view("G3*s/(s+b)"));
+    csfg_graph_add_edge_parse_expr(&g, n4, n3, cstr_view("H3"));
+    csfg_graph_add_edge_parse_expr(&g, n2, n1, cstr_view("H1"));
+    csfg_graph_add_edge_parse_expr(&g, n4, n1, cstr_view("H2/(s+c)"));
+
+    // clang-format off
+    csfg_var_table_set_lit(&params, cstr_view("G1"), 3);
+    csfg_var_table_set_lit(&params, cstr_view("G2"), 5);
+    csfg_var_table_set_lit(&params, cstr_view("G3"), 7);
+    csfg_var_table_set_lit(&params, cstr_view("H1"), 0.1);
+    csfg_var_table_set_lit(&params, cstr_view("H2"), -0.2);
+    csfg_var_table_set_lit(&params, cstr_view("H3"), 0.3);
+    csfg_var_table_set_lit(&params, cstr_view("a"), 2);
+    csfg_var_table_set_lit(&params, cstr_view("b"), 10);
+    csfg_var_table_set_lit(&params, cstr_view("c"), 50);
+    // clang-format on
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, n1, n4, &subs, &params), 0);
+
+    for (double s : {0.01, 0.5, 3.0, 40.0, 1e3})
+    {
+        double expected       = mason(n1, n4, s);
+        struct csfg_complex H = csfg_tf_eval(&tf, csfg_complex(s, 0));
+        EXPECT_NEAR(H.real, expected, fabs(expected) * 1e-6);
+        EXPECT_NEAR(H.imag, 0.0, 1e-9);
+    }
+}
+
+TEST_F(NAME, active_lowpass_filter_matches_mason)
+{
+    int Vin  = csfg_graph_add_node(&g, "Vin");
+    int I2   = csfg_graph_add_node(&g, "I2");
+    int V2   = csfg_graph_add_node(&g, "V2");
+    int V3   = csfg_graph_add_node(&g, "V3");
+    int V4   = csfg_graph_add_node(&g, "V4");
+    int Vout = csfg_graph_add_node(&g, "Vout");
+    csfg_graph_add_edge_parse_expr(&g, Vin, I2, cstr_view("G1"));
+    csfg_graph_add_edge_parse_expr(&g, I2, V2, cstr_view("z2"));
+    csfg_graph_add_edge_parse_expr(&g, V2, V4, cstr_view("-1"));
+    csfg_graph_add_edge_parse_expr(&g, V3, V4, cstr_view("1"));
+    csfg_graph_add_edge_parse_expr(&g, V4, Vout, cstr_view("A/(1+s/w)"));
+    csfg_graph_add_edge_parse_expr(&g, Vout, I2, cstr_view("G2+s*C"));
+
+    // clang-format off
+    csfg_var_table_set_parse_expr(&subs, cstr_view("y2"), cstr_view("G1 + G2 + s*C"));
+    csfg_var_table_set_parse_expr(&subs, cstr_view("z2"), cstr_view("1/y2"));
+    csfg_var_table_set_lit(&params, cstr_view("G1"), 1e-3);
+    csfg_var_table_set_lit(&params, cstr_view("G2"), 1e-4);
+    csfg_var_table_set_lit(&params, cstr_view("C"), 1e-9);
+    csfg_var_table_set_lit(&params, cstr_view("A"), 1e5);
+    csfg_var_table_set_lit(&params, cstr_view("w"), 10);
+    // clang-format on
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, Vin, Vout, &subs, &params), 0);
+
+    for (double s : {1.0, 1e2, 1e4, 1e6})
+    {
+        double expected       = mason(Vin, Vout, s);
+        struct csfg_complex H = csfg_tf_eval(&tf, csfg_complex(s, 0));
+        EXPECT_NEAR(H.real, expected, fabs(expected) * 1e-6);
+    }
+}
+
+TEST_F(NAME, rc_ladder_with_clustered_poles)
+{
+    /* Buffered RC stages, each 1/(1+s*R*C) with a pole at -1000 rad/s. The
+     * 8-fold pole is refined, the 16-fold pole is found only roughly, so the
+     * polynomials are evaluated instead of the sections. */
+    for (int stages : {8, 16})
+    {
+        csfg_graph_clear(&g);
+        int prev = csfg_graph_add_node(&g, "V0");
+        int in   = prev;
+        for (int i = 1; i <= stages; ++i)
+        {
+            std::string name = "V" + std::to_string(i);
+            int         node = csfg_graph_add_node(&g, name.c_str());
+            csfg_graph_add_edge_parse_expr(
+                &g, prev, node, cstr_view("1/(1+s*R*C)"));
+            prev = node;
+        }
+        csfg_var_table_set_lit(&params, cstr_view("R"), 1e3);
+        csfg_var_table_set_lit(&params, cstr_view("C"), 1e-6);
+
+        ASSERT_EQ(csfg_tf_from_graph(&tf, &g, in, prev, &subs, &params), 0);
+        if (stages == 8)
+            for (int i = 0; i != vec_count(tf.poles); ++i)
+                EXPECT_NEAR(vec_get(tf.poles, i)->real, -1e3, 1e-6);
+        double mag = csfg_complex_mag(csfg_tf_eval(&tf, csfg_complex(0, 1e3)));
+        EXPECT_NEAR(mag, pow(0.5, stages / 2.0), 1e-9) << stages << " stages";
+        mag = csfg_complex_mag(csfg_tf_eval(&tf, csfg_complex(0, 1)));
+        EXPECT_NEAR(mag, pow(1 + 1e-6, -stages / 2.0), 1e-9)
+            << stages << " stages";
+    }
+}
+
+TEST_F(NAME, more_nodes_than_fit_into_8_bits)
+{
+    /* A long chain of unity gains followed by a first order lowpass */
+    int prev = csfg_graph_add_node(&g, "V0");
+    int in   = prev;
+    for (int i = 1; i <= 300; ++i)
+    {
+        std::string name = "V" + std::to_string(i);
+        int         node = csfg_graph_add_node(&g, name.c_str());
+        csfg_graph_add_edge_parse_expr(
+            &g, prev, node, cstr_view(i == 300 ? "1/(1+s*R*C)" : "1"));
+        prev = node;
+    }
+    csfg_var_table_set_lit(&params, cstr_view("R"), 1e3);
+    csfg_var_table_set_lit(&params, cstr_view("C"), 1e-6);
+
+    ASSERT_EQ(csfg_tf_from_graph(&tf, &g, in, prev, &subs, &params), 0);
+    ASSERT_EQ(vec_count(tf.poles), 1);
+    EXPECT_NEAR(vec_first(tf.poles)->real, -1e3, 1e-6);
+    EXPECT_NEAR(
+        csfg_complex_mag(csfg_tf_eval(&tf, csfg_complex(0, 1e3))),
+        sqrt(0.5),
+        1e-9);
+}
@@ -0,0 +1,148 @@
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "csfg/numeric/tf.h"
+}
+
+#include <complex>
+#include <vector>
+
+#define NAME test_tf_sections
+
+using namespace testing;
+
+struct NAME : public Test
+{
+    void SetUp() override { csfg_tf_init(&tf); }
+    void TearDown() override { csfg_tf_deinit(&tf); }
+
+    static void push_roots(
+        struct csfg_rpoly**                      roots,
+        struct csfg_cpoly**                      poly,
+        const std::vector<std::complex<double>>& list)
+    {
+        std::vector<std::complex<double>> coeffs = {1.0};
+        for (auto r : list)
+        {
+            std::vector<std::complex<double>> next(coeffs.size() + 1, 0.0);
+            for (size_t i = 0; i != coeffs.size(); ++i)
+            {
+                next[i + 1] += coeffs[i];
+                next[i] -= coeffs[i] * r;
+            }
+            coeffs = next;
+            csfg_rpoly_push(roots, csfg_complex(r.real(), r.imag()));
+        }
+        for (auto c : coeffs)
+            csfg_cpoly_push(poly, csfg_complex(c.real(), c.imag()));
+    }
+
+    void make_tf(
+        const std::vector<std::complex<double>>& zeros,
+        const std::vector<std::complex<double>>& poles)
+    {
+        push_roots(&tf.zeros, &tf.num, zeros);
+        push_roots(&tf.poles, &tf.den, poles);
+    }
+
+    struct csfg_tf tf;
+};
+
+TEST_F(NAME, pairs_conjugates_and_real_roots)
+{
+    make_tf({}, {{-1, 2}, {-3, 0}, {-1, -2}, {-5, 0}, {-4, 0}});
+    ASSERT_THAT(csfg_tf_factor_sections(&tf.sections, &tf), Eq(0));
+    ASSERT_THAT(vec_count(tf.sections), Eq(3));
+
+    /* Ordered by frequency: s^2+2s+5, s^2+7s+12, s+5 */
+    const struct csfg_sos* s = vec_get(tf.sections, 0);
+    EXPECT_THAT(s->a[0], DoubleNear(5.0, 1e-12));
+    EXPECT_THAT(s->a[1], DoubleNear(2.0, 1e-12));
+    EXPECT_THAT(s->a[2], DoubleEq(1.0));
+    s = vec_get(tf.sections, 1);
+    EXPECT_THAT(s->a[0], DoubleNear(12.0, 1e-12));
+    EXPECT_THAT(s->a[1], DoubleNear(7.0, 1e-12));
+    EXPECT_THAT(s->a[2], DoubleEq(1.0));
+    s = vec_get(tf.sections, 2);
+    EXPECT_THAT(s->a[0], DoubleNear(5.0, 1e-12));
+    EXPECT_THAT(s->a[1], DoubleEq(1.0));
+    EXPECT_THAT(s->a[2], DoubleEq(0.0));
+    for (int i = 0; i != 3; ++i)
+    {
+        EXPECT_THAT(vec_get(tf.sections, i)->b[0], DoubleEq(1.0));
+        EXPECT_THAT(vec_get(tf.sections, i)->b[1], DoubleEq(0.0));
+        EXPECT_THAT(vec_get(tf.sections, i)->b[2], DoubleEq(0.0));
+    }
+}
+
+TEST_F(NAME, zeros_are_placed_over_nearby_poles)
+{
+    /* Notch at 100 rad/s, poles at 1 and 100 rad/s */
+    make_tf(
+        {{0, 100}, {0, -100}}, {{-1, 0}, {-2, 0}, {-50, 86.6}, {-50, -86.6}});
+    ASSERT_THAT(csfg_tf_factor_sections(&tf.sections, &tf), Eq(0));
+    ASSERT_THAT(vec_count(tf.sections), Eq(2));
+
+    const struct csfg_sos* s = vec_get(tf.sections, 0);
+    EXPECT_THAT(s->b[0], DoubleNear(10000.0, 1e-6));
+    EXPECT_THAT(s->a[0], DoubleNear(2500.0 + 86.6 * 86.6, 1e-6));
+    s = vec_get(tf.sections, 1);
+    EXPECT_THAT(s->b[0], DoubleEq(1.0));
+    EXPECT_THAT(s->a[0], DoubleNear(2.0, 1e-12));
+}
+
+TEST_F(NAME, improper_tf_gets_sections_without_poles)
+{
+    make_tf({{-1, 0}, {-2, 0}, {-3, 0}}, {{-4, 0}});
+    ASSERT_THAT(csfg_tf_factor_sections(&tf.sections, &tf), Eq(0));
+    ASSERT_THAT(vec_count(tf.sections), Eq(2));
+
+    for (double w : {0.1, 1.0, 10.0})
+    {
+        struct csfg_complex expected = csfg_tf_eval(&tf, csfg_complex(0, w));
+        csfg_sos_vec_clear(tf.sections);
+        struct csfg_complex horner = csfg_tf_eval(&tf, csfg_complex(0, w));
+        ASSERT_THAT(expected.real, DoubleNear(horner.real, 1e-9));
+        ASSERT_THAT(expected.imag, DoubleNear(horner.imag, 1e-9));
+        ASSERT_THAT(csfg_tf_factor_sections(&tf.sections, &tf), Eq(0));
+    }
+}
+
+TEST_F(NAME, complex_coefficients_are_rejected)
+{
+    make_tf({}, {{-1, 2}, {-3, 1}});
+    ASSERT_THAT(csfg_tf_factor_sections(&tf.sections, &tf), Eq(1));
+    ASSERT_THAT(vec_count(tf.sections), Eq(0));
+}
+
+TEST_F(NAME, eval_high_order_butterworth)
+{
+    /* 12th order Butterworth, |T(jw)|^2 = 1 / (1 + w^24) */
+    std::vector<std::complex<double>> poles;
+    for (int k = 0; k != 12; ++k)
+        poles.push_back(std::polar(1.0, M_PI / 2 + M_PI * (2 * k + 1) / 24));
+    make_tf({}, poles);
+    ASSERT_THAT(csfg_tf_factor_sections(&tf.sections, &tf), Eq(0));
+    ASSERT_THAT(vec_count(tf.sections), Eq(6));
+
+    for (double log_w = -3.0; log_w <= 3.0; log_w += 0.01)
+    {
+        double              w   = pow(10.0, log_w);
+        struct csfg_complex t   = csfg_tf_eval(&tf, csfg_complex(0, w));
+        double              mag = csfg_complex_mag(t);
+        double expected = 1.0 / sqrt(1.0 + pow(w, 24));
+        ASSERT_THAT(mag / expected, DoubleNear(1.0, 1e-12)) << "w = " << w;
+    }
+}
+
+TEST_F(NAME, roots_that_dont_match_the_polynomials_are_rejected)
+{
+    make_tf({}, {{-1, 0}, {-2, 0}, {-3, 0}});
+    vec_get(tf.poles, 1)->real = -2.1;
+    ASSERT_THAT(csfg_tf_factor_sections(&tf.sections, &tf), Eq(1));
+    ASSERT_THAT(vec_count(tf.sections), Eq(0));
+
+    /* Evaluation falls back to the polynomials */
+    struct csfg_complex t = csfg_tf_eval(&tf, csfg_complex(0, 0));
+    ASSERT_THAT(t.real, DoubleNear(1.0 / 6, 1e-12));
+}
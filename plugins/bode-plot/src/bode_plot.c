@@ -1,5 +1,16 @@
 #include "bode-plot/bode_plot.h"
+#include "csfg/numeric/pyramid.h"
 #include "csfg/numeric/tf.h"
+#include "csfg/util/mem.h"
+
+/* Maximum deviation of the sampled response from the exact response */
+#define TOLERANCE_DB  0.1
+#define TOLERANCE_RAD 0.01
+/* Resolution of the finest pyramid level over the whole frequency interval.
+ * Zooming in stops once a pixel is smaller than one of these buckets */
+#define PYRAMID_BUCKETS 65536
+/* Factor by which one step of the mouse wheel zooms */
+#define ZOOM_STEP 1.2
 
 struct _BodePlot
 {
@@ -8,72 +19,145 @@ struct _BodePlot
     GtkWidget* drawing_area_phase;
 
     const struct csfg_tf* tf;
+    struct csfg_bode_vec* points;
+    struct csfg_pyramid pyr_mag;
+    struct csfg_pyramid pyr_phase;
+
+    /* One bucket per pixel column of the visible range */
+    struct csfg_minmax* columns;
+    int columns_capacity;
+
+    /* Visible and full range, in log10(rad/s) */
+    double view_start, view_end;
+    double full_start, full_end;
+    double drag_start;
+    double pointer_x;
 };
 
 G_DEFINE_DYNAMIC_TYPE(BodePlot, bode_plot, GTK_TYPE_BOX)
 
+/* -------------------------------------------------------------------------- */
+static void clamp_view(BodePlot* plot, int width)
+{
+    double full_span = plot->full_end - plot->full_start;
+    double min_span  = full_span * width / PYRAMID_BUCKETS;
+    double span      = plot->view_end - plot->view_start;
+
+    if (span > full_span)
+        span = full_span;
+    if (span < min_span)
+        span = min_span;
+    if (plot->view_start < plot->full_start)
+        plot->view_start = plot->full_start;
+    if (plot->view_start + span > plot->full_end)
+        plot->view_start = plot->full_end - span;
+    plot->view_end = plot->view_start + span;
+}
+
+/* -------------------------------------------------------------------------- */
+static int rebuild_pyramids(BodePlot* plot)
+{
+    double* log_f;
+    double* mag;
+    double* phase;
+    int     i, n = vec_count(plot->points);
+    int     result = -1;
+
+    log_f = mem_alloc((int)sizeof(double) * n * 3);
+    if (log_f == NULL)
+        return -1;
+    mag   = log_f + n;
+    phase = log_f + 2 * n;
+    for (i = 0; i != n; ++i)
+    {
+        log_f[i] = vec_get(plot->points, i)->log_f;
+        mag[i]   = vec_get(plot->points, i)->mag_db;
+        phase[i] = vec_get(plot->points, i)->phase;
+    }
+
+    if (csfg_pyramid_build(&plot->pyr_mag, log_f, mag, n, PYRAMID_BUCKETS) ==
+            0 &&
+        csfg_pyramid_build(
+            &plot->pyr_phase, log_f, phase, n, PYRAMID_BUCKETS) == 0)
+        result = 0;
+
+    mem_free(log_f);
+    return result;
+}
+
 /* -------------------------------------------------------------------------- */
 static void draw_mag_or_phase(
     int width, int height, cairo_t* cr, BodePlot* plot, int mag_mode)
 {
-    struct csfg_complex y;
-
-    double f_start, f_end, f;
-    double exp_start, exp_end, exp_step, exp_;
-    double val, val_min, val_max;
-    double scale_x, scale_y;
+    const struct csfg_pyramid* pyr;
+    const struct csfg_minmax*  col;
+    double                     val_min, val_max;
+    double                     scale_y, offset_y;
+    int                        i;
 
-    if (plot->tf == NULL)
+    if (plot->tf == NULL || vec_count(plot->points) < 2 || width < 1)
         return;
 
-    if (csfg_tf_interesting_frequency_interval(plot->tf, &f_start, &f_end) != 0)
-        return;
-    exp_start = log10(f_start);
-    exp_end   = log10(f_end);
-    exp_step  = (exp_end - exp_start) / width;
+    if (plot->columns_capacity < width)
+    {
+        struct csfg_minmax* columns =
+            mem_realloc(plot->columns, (int)sizeof(*columns) * width);
+        if (columns == NULL)
+            return;
+        plot->columns          = columns;
+        plot->columns_capacity = width;
+    }
+
+    /* Only the visible part of the response is summarized, at one bucket per
+     * pixel, so the cost doesn't depend on the zoom level or on how many
+     * points the response was sampled at */
+    clamp_view(plot, width);
+    pyr = mag_mode ? &plot->pyr_mag : &plot->pyr_phase;
+    csfg_pyramid_query(
+        pyr, plot->view_start, plot->view_end, plot->columns, width);
 
     val_min = DBL_MAX;
     val_max = -DBL_MAX;
-    for (exp_ = exp_start; exp_ <= exp_end; exp_ += exp_step)
+    for (i = 0; i != width; ++i)
     {
-        f   = pow(10, exp_);
-        y   = csfg_tf_eval(plot->tf, csfg_complex(0.0, f));
-        val = mag_mode ? csfg_complex_mag(y) : csfg_complex_phase(y);
-        if (val_max < val)
-            val_max = val;
-        if (val_min > val)
-            val_min = val;
+        col = &plot->columns[i];
+        if (col->min > col->max)
+            continue;
+        if (val_max < col->max)
+            val_max = col->max;
+        if (val_min > col->min)
+            val_min = col->min;
     }
-    if (mag_mode)
+    if (val_min > val_max)
+        return;
+    if (val_max - val_min < 1e-9)
     {
-        val_max = 20 * log10(val_max);
-        val_min = 20 * log10(val_min);
+        val_max += 1.0;
+        val_min -= 1.0;
     }
-    scale_x = width / (exp_end - exp_start);
-    scale_y = height / (val_max - val_min) * 0.45;
+    scale_y  = height / (val_max - val_min) * 0.45;
+    offset_y = val_max * scale_y + height / 20.0;
 
-    cairo_translate(
-        cr, -exp_start * scale_x, val_max * scale_y + height / 20.0);
     cairo_set_source_rgb(cr, 0.8, 0.8, 0.8);
     cairo_set_line_width(cr, 1.0);
-    cairo_move_to(cr, exp_start * scale_x, 0.0);
-    cairo_line_to(cr, exp_end * scale_x, 0.0);
+    cairo_move_to(cr, 0.0, offset_y);
+    cairo_line_to(cr, width, offset_y);
     cairo_stroke(cr);
 
+    /* Each column is drawn as a vertical line spanning its range, which keeps
+     * narrow resonance peaks visible when zoomed out */
     cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
     cairo_set_line_width(cr, 1.0);
-    for (exp_ = exp_start; exp_ <= exp_end; exp_ += exp_step)
+    for (i = 0; i != width; ++i)
     {
-        f   = pow(10, exp_);
-        y   = csfg_tf_eval(plot->tf, csfg_complex(0.0, f));
-        val = mag_mode ? csfg_complex_mag(y) : csfg_complex_phase(y);
-        if (mag_mode)
-            val = 20 * log10(val);
-
-        if (exp_ == exp_start)
-            cairo_move_to(cr, exp_ * scale_x, val * -scale_y);
-        else
-            cairo_line_to(cr, exp_ * scale_x, val * -scale_y);
+        col = &plot->columns[i];
+        if (col->min > col->max)
+        {
+            cairo_new_sub_path(cr);
+            continue;
+        }
+        cairo_line_to(cr, i + 0.5, offset_y - col->max * scale_y);
+        cairo_line_to(cr, i + 0.5, offset_y - col->min * scale_y);
     }
     cairo_stroke(cr);
 }
@@ -105,24 +189,136 @@ static void draw_phase_cb(
     (void)area;
 }
 
+/* -------------------------------------------------------------------------- */
+static void queue_draw(BodePlot* plot)
+{
+    gtk_widget_queue_draw(plot->drawing_area_mag);
+    gtk_widget_queue_draw(plot->drawing_area_phase);
+}
+
+/* -------------------------------------------------------------------------- */
+static gboolean scroll_cb(
+    GtkEventControllerScroll* controller,
+    double dx,
+    double dy,
+    gpointer user_data)
+{
+    BodePlot* plot = user_data;
+    GtkWidget* area =
+        gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(controller));
+    int width = gtk_widget_get_width(area);
+    double pivot, factor;
+    (void)dx;
+
+    if (width < 1)
+        return FALSE;
+
+    /* Zoom around the frequency under the mouse cursor */
+    pivot = plot->view_start +
+            (plot->view_end - plot->view_start) * plot->pointer_x / width;
+    factor = pow(ZOOM_STEP, dy);
+
+    plot->view_start = pivot - (pivot - plot->view_start) * factor;
+    plot->view_end   = pivot + (plot->view_end - pivot) * factor;
+    clamp_view(plot, width);
+    queue_draw(plot);
+    return TRUE;
+}
+
+/* -------------------------------------------------------------------------- */
+static void motion_cb(
+    GtkEventControllerMotion* controller,
+    double x,
+    double y,
+    gpointer user_data)
+{
+    BodePlot* plot = user_data;
+    (void)controller, (void)y;
+    plot->pointer_x = x;
+}
+
+/* -------------------------------------------------------------------------- */
+static void
+drag_begin(GtkGestureDrag* gesture, double x, double y, gpointer user_data)
+{
+    BodePlot* plot = user_data;
+    (void)gesture, (void)x, (void)y;
+    plot->drag_start = plot->view_start;
+}
+
+/* -------------------------------------------------------------------------- */
+static void drag_update(
+    GtkGestureDrag* gesture,
+    double offset_x,
+    double offset_y,
+    gpointer user_data)
+{
+    BodePlot* plot = user_data;
+    GtkWidget* area =
+        gtk_event_controller_get_widget(GTK_EVENT_CONTROLLER(gesture));
+    int width   = gtk_widget_get_width(area);
+    double span = plot->view_end - plot->view_start;
+    (void)offset_y;
+
+    if (width < 1)
+        return;
+
+    plot->view_start = plot->drag_start - offset_x * span / width;
+    plot->view_end   = plot->view_start + span;
+    clamp_view(plot, width);
+    queue_draw(plot);
+}
+
+/* -------------------------------------------------------------------------- */
+static void add_controllers(BodePlot* self, GtkWidget* area)
+{
+    GtkEventController* scroll =
+        gtk_event_controller_scroll_new(GTK_EVENT_CONTROLLER_SCROLL_VERTICAL);
+    GtkEventController* motion = gtk_event_controller_motion_new();
+    GtkGesture*         drag   = gtk_gesture_drag_new();
+
+    g_signal_connect(motion, "motion", G_CALLBACK(motion_cb), self);
+    gtk_widget_add_controller(area, motion);
+
+    g_signal_connect(scroll, "scroll", G_CALLBACK(scroll_cb), self);
+    gtk_widget_add_controller(area, scroll);
+
+    g_signal_connect(drag, "drag-begin", G_CALLBACK(drag_begin), self);
+    g_signal_connect(drag, "drag-update", G_CALLBACK(drag_update), self);
+    gtk_widget_add_controller(area, GTK_EVENT_CONTROLLER(drag));
+}
+
 /* -------------------------------------------------------------------------- */
 static void bode_plot_init(BodePlot* self)
 {
     g_object_set(self, "orientation", GTK_ORIENTATION_VERTICAL, NULL);
 
     self->tf = NULL;
+    csfg_bode_vec_init(&self->points);
+    csfg_pyramid_init(&self->pyr_mag);
+    csfg_pyramid_init(&self->pyr_phase);
+    self->columns          = NULL;
+    self->columns_capacity = 0;
+    self->view_start       = 0.0;
+    self->view_end         = 1.0;
+    self->full_start       = 0.0;
+    self->full_end         = 1.0;
+    self->drag_start       = 0.0;
+    self->pointer_x        = 0.0;
 
     self->drawing_area_mag = gtk_drawing_area_new();
     gtk_widget_set_hexpand(self->drawing_area_mag, TRUE);
     gtk_widget_set_size_request(self->drawing_area_mag, 1, 200);
     gtk_drawing_area_set_draw_func(
         GTK_DRAWING_AREA(self->drawing_area_mag), draw_mag_cb, self, NULL);
+    add_controllers(self, self->drawing_area_mag);
 
     self->drawing_area_phase = gtk_drawing_area_new();
     gtk_widget_set_hexpand(self->drawing_area_phase, TRUE);
     gtk_widget_set_size_request(self->drawing_area_phase, 1, 200);
     gtk_drawing_area_set_draw_func(
         GTK_DRAWING_AREA(self->drawing_area_phase), draw_phase_cb, self, NULL);
+    add_controllers(self, self->drawing_area_phase);
 
     gtk_box_append(GTK_BOX(self), self->drawing_area_mag);
     gtk_box_append(GTK_BOX(self), self->drawing_area_phase);
@@ -131,7 +327,13 @@ static void bode_plot_init(BodePlot* self)
 /* -------------------------------------------------------------------------- */
 static void bode_plot_finalize(GObject* obj)
 {
-    (void)obj;
+    BodePlot* self = PLUGIN_BODE_PLOT(obj);
+    if (self->columns != NULL)
+        mem_free(self->columns);
+    csfg_pyramid_deinit(&self->pyr_phase);
+    csfg_pyramid_deinit(&self->pyr_mag);
+    csfg_bode_vec_deinit(self->points);
+    G_OBJECT_CLASS(bode_plot_parent_class)->finalize(obj);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -162,7 +364,25 @@ BodePlot* bode_plot_new(void)
 /* -------------------------------------------------------------------------- */
 void bode_plot_set_tf(BodePlot* plot, const struct csfg_tf* tf)
 {
+    double f_start, f_end;
+
     plot->tf = tf;
-    gtk_widget_queue_draw(plot->drawing_area_mag);
-    gtk_widget_queue_draw(plot->drawing_area_phase);
+    csfg_bode_vec_clear(plot->points);
+    if (tf != NULL &&
+        csfg_tf_interesting_frequency_interval(tf, &f_start, &f_end) == 0 &&
+        csfg_tf_bode(
+            &plot->points, tf, f_start, f_end, TOLERANCE_DB, TOLERANCE_RAD) ==
+            0 &&
+        rebuild_pyramids(plot) == 0)
+    {
+        /* A new transfer function resets the zoom */
+        plot->full_start = log10(f_start);
+        plot->full_end   = log10(f_end);
+        plot->view_start = plot->full_start;
+        plot->view_end   = plot->full_end;
+    }
+    else
+        csfg_bode_vec_clear(plot->points);
+
+    queue_draw(plot);
 }
@@ -58,6 +58,15 @@ struct plugin_notify_interface
     void (*parameters_changed)(
         struct plugin_notify_context* ctx,
         const struct plugin_ctx* source_plugin);
+
+    /*! Call this instead of graph_structure_changed() if only the expression
+     * of a single edge changed, and nothing else about the graph. This is a
+     * lot cheaper to process, because the graph does not need to be
+     * re-analyzed. */
+    void (*edge_expr_changed)(
+        struct plugin_notify_context* ctx,
+        const struct plugin_ctx* source_plugin,
+        int edge_idx);
 };
 
 struct dpsfg_ui_center_interface
@@ -121,15 +130,15 @@ struct dpsfg_graph_interface
  */
 struct dpsfg_expr_interface
 {
-    /*! Called when the graph's symbolic expression is calculated. The
-     * expression will be large and messy, as it is the raw output of mason's
-     * gain rule. */
+    /*! Called when the graph's symbolic expression is calculated. This is the
+     * raw output of mason's gain rule, where the gain of every edge is
+     * represented by the symbol G[i], "i" being the index of the edge. */
     void (*on_mason_expr)(
         struct plugin_ctx* ctx, const struct csfg_expr_pool* pool, int expr);
 
-    /*! Called after the substitution table has been applied to the graph's
-     * expression. This will mostly make the expression even larger than
-     * on_mason_expr(). */
+    /*! Called after the edge expressions and the substitution table have been
+     * inserted into the graph's expression. This will mostly make the
+     * expression a lot larger than on_mason_expr(). */
     void (*on_substituted_expr)(
         struct plugin_ctx* ctx, const struct csfg_expr_pool* pool, int expr);
 
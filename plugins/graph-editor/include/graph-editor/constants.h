@@ -4,3 +4,8 @@
 #define ARROW_RADIUS         8
 #define DEFAULT_NODE_SPACING (GRID * 6)
 #define DEFAULT_NODE_RADIUS  10
+
+/* Font of node names and edge expressions. Also the key under which their
+ * sizes are stored in the shared text cache */
+#define LABEL_FONT      "Sans 12"
+#define LABEL_FONT_SIZE 12
@@ -15,18 +15,27 @@ void draw_help(
     int show_7steps,
     int show_shortcuts);
 
-void draw_grid(
-    struct _cairo* cr,
-    double pan_x,
-    double pan_y,
-    int width,
-    int height,
-    double zoom);
+/*!
+ * @brief Draws the background grid over a rectangle in graph coordinates.
+ */
+void draw_grid(struct _cairo* cr, int x1, int y1, int x2, int y2);
 
+/*
+ * The functions below draw the items listed in "visible", which are indices
+ * into the graph's nodes/edges or into the drawing. The plain versions draw
+ * the items as they look when nothing is selected. Those are cached by the
+ * editor, see render_cache.h. The overlay versions draw the highlights and
+ * selection symbols on top.
+ */
 void draw_edges(
     struct _cairo* cr,
     const struct csfg_graph* g,
-    const struct node_attr_hmap* node_attrs,
+    const struct spatial_result_vec* visible,
+    const struct edge_attr_hmap* edge_attrs);
+void draw_edges_overlay(
+    struct _cairo* cr,
+    const struct csfg_graph* g,
+    const struct spatial_result_vec* visible,
     const struct edge_attr_hmap* edge_attrs,
     enum graph_model_mode mode,
     int active_edge_id,
@@ -34,6 +43,14 @@ void draw_edges(
 void draw_nodes(
     struct _cairo* cr,
     const struct csfg_graph* g,
+    const struct spatial_result_vec* visible,
+    const struct node_attr_hmap* node_attrs,
+    int node_in_id,
+    int node_out_id);
+void draw_nodes_overlay(
+    struct _cairo* cr,
+    const struct csfg_graph* g,
+    const struct spatial_result_vec* visible,
     const struct node_attr_hmap* node_attrs,
     enum graph_model_mode mode,
     int node_in_id,
@@ -41,8 +58,15 @@ void draw_nodes(
     int active_node_id,
     int selected_node_id,
     int reconnect_node_id);
-
 void draw_drawing(
-    struct _cairo* cr, const struct line_vec* drawing, double zoom);
+    struct _cairo* cr,
+    const struct line_vec* drawing,
+    const struct spatial_result_vec* visible,
+    double zoom);
+void draw_drawing_overlay(
+    struct _cairo* cr,
+    const struct line_vec* drawing,
+    const struct spatial_result_vec* visible,
+    double zoom);
 void draw_multi_selection(
     struct _cairo* cr, double x1, double y1, double x2, double y2);
@@ -39,4 +39,3 @@ int drawing_load(
     const struct csfg_graph* g);
 
 void drawing_clear(struct line_vec* drawing);
-int try_select_line(const struct line_vec* drawing, int x, int y);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "graph-editor/color.h"
+#include "graph-editor/spatial.h"
 #include <stdint.h>
 
 struct csfg_graph;
@@ -32,8 +33,16 @@ struct graph_model
     struct node_attr_hmap* node_attrs;
     struct edge_attr_hmap* edge_attrs;
     struct undo_stack_vec* undo_stack;
+    /* Snapshot of the state at undo_stack_ptr. New states are stored as a
+     * delta against it */
+    struct serializer* undo_state;
     struct line_vec* drawing;
 
+    /* Bounding boxes of the nodes, edges and lines. Use
+     * graph_model_spatial_index() to access it */
+    struct spatial_index spatial;
+    struct spatial_result_vec* spatial_result;
+
     struct color graph_color;
     struct color draw_color;
 
@@ -47,6 +56,8 @@ struct graph_model
     int node_out_id;
 
     enum graph_model_mode mode;
+
+    unsigned spatial_valid : 1;
 };
 
 void select_next_active_node_in_direction(
@@ -76,6 +87,9 @@ int create_new_node(struct graph_model* model, int n_id_prev);
 int delete_edge(struct graph_model* model, int edge_id);
 int delete_node(struct graph_model* model, int node_id);
 void delete_multi_selection_objects(struct graph_model* model);
+int try_select_node(struct graph_model* model, int x, int y);
+int try_select_edge(struct graph_model* model, int x, int y);
+int try_select_line(struct graph_model* model, int x, int y);
 void multi_select_nodes_and_lines(
     struct graph_model* model, int x1, int y1, int x2, int y2, int append);
 void multi_deselect_all(struct graph_model* model);
@@ -93,5 +107,36 @@ void graph_model_set_graph(
     struct graph_model* model, struct csfg_graph* g, int node_in, int node_out);
 void graph_model_clear_graph(struct graph_model* model);
 void notify_graph_changed(struct graph_model* model);
+void notify_edge_expr_changed(struct graph_model* model, int edge_idx);
 void graph_model_rebuild_graph(
     struct graph_model* model, int node_in, int node_out);
+
+/*!
+ * @brief Returns the spatial index of the nodes, edges and lines. It is
+ * rebuilt first if it was invalidated, or if items were added or removed
+ * since it was last built.
+ */
+struct spatial_index* graph_model_spatial_index(struct graph_model* model);
+/*!
+ * @brief Causes the spatial index to be rebuilt on the next access. Call this
+ * after items were added, removed or reordered.
+ */
+void graph_model_invalidate_spatial_index(struct graph_model* model);
+/*!
+ * @brief Moves items whose bounding box changed to their new cells. Call this
+ * after moving nodes, edges or lines, or after changing their text.
+ */
+void graph_model_update_spatial_index(struct graph_model* model);
+/*!
+ * @brief Finds the items of a kind whose bounding box overlaps a rectangle in
+ * graph coordinates. The result is stored in model->spatial_result and is
+ * valid until the next query.
+ * @return Returns -1 if memory could not be allocated.
+ */
+int graph_model_query(
+    struct graph_model* model,
+    enum spatial_kind kind,
+    int x1,
+    int y1,
+    int x2,
+    int y2);
@@ -0,0 +1,62 @@
+#pragma once
+
+struct _cairo;
+struct _cairo_surface;
+struct graph_model;
+
+/*
+ * The editor canvas is composed of several cached layers. Each layer is an
+ * off-screen surface that covers the visible part of the graph plus a margin.
+ * Layers are only redrawn where something changed: the graph model's spatial
+ * index records the areas covered by moved, added or removed items (see
+ * spatial.h), and panning only draws the strips that scroll into view.
+ * Selection highlights and other transient state are drawn on top of the
+ * layers every frame, see draw_*_overlay() in draw.h.
+ */
+
+/* Extra pixels cached on each side of the view, so small pans don't have to
+ * draw anything */
+#define RENDER_CACHE_MARGIN 128
+
+enum render_layer_id
+{
+    RENDER_LAYER_GRID,
+    RENDER_LAYER_GRAPH,    /* Nodes and edges */
+    RENDER_LAYER_DRAWING,  /* Freehand lines */
+
+    RENDER_LAYER_COUNT
+};
+
+struct render_layer
+{
+    struct _cairo_surface* surface;
+    /* Position of the surface's top-left pixel, in graph coordinates
+     * multiplied by zoom */
+    int x, y;
+    int width, height;
+    double zoom;
+};
+
+struct render_cache
+{
+    struct render_layer layers[RENDER_LAYER_COUNT];
+};
+
+void render_cache_init(struct render_cache* cache);
+void render_cache_deinit(struct render_cache* cache);
+
+/*!
+ * @brief Brings the layers up to date and paints them. "cr" must have an
+ * identity transformation.
+ * @param[in] pan_x, pan_y Offset of the graph origin in pixels. Must be
+ * whole numbers, otherwise the cached surfaces would have to be resampled.
+ */
+void render_cache_paint(
+    struct render_cache* cache,
+    struct _cairo* cr,
+    struct graph_model* model,
+    int pan_x,
+    int pan_y,
+    double zoom,
+    int width,
+    int height);
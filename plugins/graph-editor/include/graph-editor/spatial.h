@@ -0,0 +1,136 @@
+#pragma once
+
+#include "csfg/util/hmap.h"
+#include "csfg/util/vec.h"
+#include "graph-editor/constants.h"
+#include <stdint.h>
+
+/*
+ * Uniform grid over the bounding boxes of the nodes, edges and drawing lines
+ * in the graph editor. Items are identified by their kind and their index
+ * into the graph's node/edge vectors or the drawing. Each item is linked into
+ * every cell its bounding box overlaps, so looking up a region only touches
+ * the items near it instead of every item.
+ *
+ * Queries return candidates whose bounding box overlaps the region. Callers
+ * still have to test the exact geometry.
+ *
+ * The index also records which areas changed, so the editor only has to
+ * redraw those parts of its cached canvas layers.
+ */
+
+#define SPATIAL_CELL_SIZE (GRID * 8)
+/* Items spanning more cells than this are kept in a separate list that is
+ * checked by every query, instead of being linked into each cell */
+#define SPATIAL_MAX_ITEM_CELLS 64
+
+enum spatial_kind
+{
+    SPATIAL_NODE,
+    SPATIAL_EDGE,
+    SPATIAL_LINE,
+
+    SPATIAL_KIND_COUNT
+};
+
+enum spatial_dirty
+{
+    SPATIAL_CLEAN,
+    SPATIAL_DIRTY_REGION,
+    SPATIAL_DIRTY_ALL
+};
+
+struct spatial_rect
+{
+    int x1, y1, x2, y2; /* Inclusive */
+};
+
+struct spatial_item
+{
+    struct spatial_rect bb;    /* Bounding box in graph coordinates */
+    struct spatial_rect cells; /* Cells the item is linked into */
+    unsigned stamp;            /* Last query that visited the item */
+    unsigned present  : 1;
+    unsigned oversize : 1;
+};
+
+/* Singly linked list node. The lists of all cells share one vector */
+struct spatial_entry
+{
+    int item; /* (idx * SPATIAL_KIND_COUNT) + kind */
+    int next;
+};
+
+VEC_DECLARE(spatial_item_vec, struct spatial_item, 32)
+VEC_DECLARE(spatial_entry_vec, struct spatial_entry, 32)
+VEC_DECLARE(spatial_result_vec, int, 32)
+/* Maps a packed cell coordinate to the first entry of the cell's list */
+HMAP_DECLARE(extern, spatial_cell_hmap, uint32_t, int, 32)
+
+struct spatial_index
+{
+    struct spatial_cell_hmap* cells;
+    struct spatial_entry_vec* entries;
+    struct spatial_item_vec* items[SPATIAL_KIND_COUNT];
+    int free_entry;
+    int oversize_entry;
+    unsigned stamp;
+
+    /* Covers the old and new bounding boxes of every item that was inserted,
+     * moved or removed since the last call to spatial_take_dirty() */
+    struct spatial_rect dirty[SPATIAL_KIND_COUNT];
+    enum spatial_dirty dirty_state[SPATIAL_KIND_COUNT];
+};
+
+void spatial_init(struct spatial_index* index);
+void spatial_deinit(struct spatial_index* index);
+/*! @brief Removes all items and marks everything as dirty */
+void spatial_clear(struct spatial_index* index);
+/*! @brief Number of items of a kind, including the ones that were removed */
+int spatial_count(const struct spatial_index* index, enum spatial_kind kind);
+
+/*!
+ * @brief Inserts an item or moves it to a new bounding box. Moving an item
+ * within the cells it already occupies only updates the bounding box.
+ * @return Returns -1 if memory could not be allocated. The item is removed
+ * from the index in this case.
+ */
+int spatial_set(
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    int idx,
+    const struct spatial_rect* bb);
+void spatial_remove(
+    struct spatial_index* index, enum spatial_kind kind, int idx);
+
+/*!
+ * @brief Finds all items of a kind whose bounding box overlaps a rectangle.
+ * @param[out] result Cleared, then filled with the indices of the items in
+ * ascending order, so callers visit them in the same order as when iterating
+ * the graph or drawing.
+ * @return Returns -1 if memory could not be allocated.
+ */
+int spatial_query(
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    const struct spatial_rect* rect,
+    struct spatial_result_vec** result);
+
+void spatial_mark_dirty(
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    const struct spatial_rect* bb);
+/*!
+ * @brief Marks everything as dirty. Use this for changes that don't affect the
+ * bounding boxes, such as colors.
+ */
+void spatial_mark_all_dirty(struct spatial_index* index);
+/*!
+ * @brief Returns what changed since the last call and resets it.
+ * @param[out] rect Receives the dirty area if SPATIAL_DIRTY_REGION is
+ * returned.
+ */
+enum spatial_dirty spatial_take_dirty(
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    struct spatial_rect* rect);
@@ -6,12 +6,38 @@ struct serializer;
 struct deserializer;
 struct graph_model;
 
-VEC_DECLARE(undo_stack_vec, struct serializer*, 32)
+/*
+ * Each state on the undo stack is a snapshot of the graph, attributes and
+ * drawing. Most states are stored as a binary delta against the previous
+ * state, see csfg/io/delta.h. Every few states, or when the delta would be
+ * large, a full snapshot (keyframe) is stored instead, which limits how many
+ * deltas have to be applied to restore a state.
+ */
+
+/* At most this many deltas follow a keyframe */
+#define UNDO_KEYFRAME_INTERVAL 32
+/* The oldest states are discarded once the stack uses more memory than this */
+#define UNDO_MEMORY_BUDGET (8 * 1024 * 1024)
+
+struct undo_entry
+{
+    struct serializer* data;
+    unsigned keyframe : 1;
+};
+
+VEC_DECLARE(undo_stack_vec, struct undo_entry, 32)
 
 int undo_push_state(struct graph_model* model);
 int undo(struct graph_model* model);
 int redo(struct graph_model* model);
 int undo_save_stack(struct serializer** ser, const struct graph_model* model);
-int undo_load_stack(struct deserializer* des, struct graph_model* model);
+/*!
+ * @param[in] version Version of the plugin's save data. Version 0 stored
+ * every state as a full snapshot.
+ */
+int undo_load_stack(
+    struct deserializer* des, struct graph_model* model, int version);
 void undo_clear_stack(struct graph_model* model);
 void undo_reinit_stack(struct graph_model* model);
+/*! @brief Number of bytes used by all states on the stack */
+int undo_stack_memory(const struct graph_model* model);
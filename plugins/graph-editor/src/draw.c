@@ -1,11 +1,13 @@
 #include "csfg/graph/graph.h"
 #include "csfg/util/str.h"
+#include "csfg/util/text_cache.h"
 #include "graph-editor/attr.h"
 #include "graph-editor/color.h"
 #include "graph-editor/constants.h"
 #include "graph-editor/draw.h"
 #include "graph-editor/drawing.h"
 #include "graph-editor/geometry.h"
+#include "graph-editor/spatial.h"
 #include <cairo.h>
 #include <librsvg/rsvg.h>
 #include <math.h>
@@ -13,69 +15,103 @@
 
 /* -------------------------------------------------------------------------- */
 static void draw_grid_with_size(
-    cairo_t* cr,
-    double pan_x,
-    double pan_y,
-    int width,
-    int height,
-    int grid_width,
-    double color)
+    cairo_t* cr, int x1, int y1, int x2, int y2, int grid_width, double color)
 {
-    int from_x = -(int)pan_x / grid_width * grid_width - grid_width;
-    int from_y = -(int)pan_y / grid_width * grid_width - grid_width;
-    int to_x   = from_x + width + grid_width;
-    int to_y   = from_y + height + grid_width;
+    int x, y;
+    int from_x = (x1 >= 0 ? x1 : x1 - grid_width + 1) / grid_width * grid_width;
+    int from_y = (y1 >= 0 ? y1 : y1 - grid_width + 1) / grid_width * grid_width;
 
     cairo_set_source_rgb(cr, color, color, color);
-    for (int x = from_x; x < to_x; x += grid_width)
+    for (x = from_x; x <= x2; x += grid_width)
     {
-        cairo_move_to(cr, x, from_y);
-        cairo_line_to(cr, x, to_y);
+        cairo_move_to(cr, x, y1);
+        cairo_line_to(cr, x, y2);
     }
-    for (int y = from_y; y < to_y; y += grid_width)
+    for (y = from_y; y <= y2; y += grid_width)
     {
-        cairo_move_to(cr, from_x, y);
-        cairo_line_to(cr, to_x, y);
+        cairo_move_to(cr, x1, y);
+        cairo_line_to(cr, x2, y);
     }
     cairo_stroke(cr);
 }
 
 /* -------------------------------------------------------------------------- */
-void draw_grid(
-    cairo_t* cr, double pan_x, double pan_y, int width, int height, double zoom)
+void draw_grid(cairo_t* cr, int x1, int y1, int x2, int y2)
 {
-    pan_x /= zoom;
-    pan_y /= zoom;
-    width /= zoom;
-    height /= zoom;
+    draw_grid_with_size(cr, x1, y1, x2, y2, GRID, 0.8);
+    draw_grid_with_size(cr, x1, y1, x2, y2, GRID * 6, 0.7);
+}
 
-    draw_grid_with_size(cr, pan_x, pan_y, width, height, GRID, 0.8);
-    draw_grid_with_size(cr, pan_x, pan_y, width, height, GRID * 6, 0.7);
+/* -------------------------------------------------------------------------- */
+static PangoLayout* create_label_layout(cairo_t* cr, const char* text)
+{
+    PangoLayout* layout        = pango_cairo_create_layout(cr);
+    PangoFontDescription* desc = pango_font_description_from_string(LABEL_FONT);
+    pango_layout_set_font_description(layout, desc);
+    pango_layout_set_text(layout, text, -1);
+    pango_font_description_free(desc);
+    return layout;
 }
 
 /* -------------------------------------------------------------------------- */
 static void draw_text(
     cairo_t* cr, const char* text, double x, double y, double offset_angle)
 {
-    PangoLayout* layout = pango_cairo_create_layout(cr);
-    pango_layout_set_text(layout, text, -1);
-    PangoFontDescription* desc = pango_font_description_from_string("Sans 12");
-    pango_layout_set_font_description(layout, desc);
+    PangoLayout* layout               = NULL;
+    struct text_cache* cache          = text_cache_shared();
+    const struct text_extents* cached = NULL;
+    struct text_extents ext;
+    double clip_x1, clip_y1, clip_x2, clip_y2;
+
+    /* Shaping the text is only necessary if the label is actually visible.
+     * The size is usually known from a previous frame */
+    if (cache != NULL)
+        cached = text_cache_find(
+            cache, cstr_view(LABEL_FONT), LABEL_FONT_SIZE, cstr_view(text));
+    if (cached != NULL)
+        ext = *cached;
+    else
+    {
+        int w, h;
+        layout = create_label_layout(cr, text);
+        pango_layout_get_pixel_size(layout, &w, &h);
+        ext.x_advance = w;
+        ext.width     = w;
+        ext.height    = h;
+        if (cache != NULL)
+            text_cache_insert(
+                cache,
+                cstr_view(LABEL_FONT),
+                LABEL_FONT_SIZE,
+                cstr_view(text),
+                &ext);
+    }
 
-    int tw, th;
-    pango_layout_get_pixel_size(layout, &tw, &th);
+    double tw = ext.width, th = ext.height;
     double tx = x - tw / 2.0;
     double ty = y - th / 2.0;
 
     tx += cos(offset_angle) * (tw / 2.0 + th);
     ty += sin(offset_angle) * (th / 2.0 + th);
 
+    /* Redrawing part of a cached layer touches many labels that lie outside
+     * of the region */
+    cairo_clip_extents(cr, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
+    if (tx > clip_x2 || ty > clip_y2 || tx + tw < clip_x1 || ty + th < clip_y1)
+    {
+        if (layout != NULL)
+            g_object_unref(layout);
+        return;
+    }
+
+    if (layout == NULL)
+        layout = create_label_layout(cr, text);
+
     cairo_set_source_rgb(cr, 0, 0, 0);
     cairo_move_to(cr, tx, ty);
     pango_cairo_show_layout(cr, layout);
 
     g_object_unref(layout);
-    pango_font_description_free(desc);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -154,7 +190,8 @@ static void draw_node(
     int is_in_node,
     int is_out_node)
 {
-    draw_text(cr, name, x, y, M_PI / 2);
+    if (name != NULL)
+        draw_text(cr, name, x, y, M_PI / 2);
 
     cairo_set_source_rgb(cr, r, g, b);
     cairo_move_to(cr, x + radius, y);
@@ -250,7 +287,8 @@ static void draw_edge(
     if (text_angle < M_PI)
         text_angle += M_PI;
     draw_arrow(cr, control_x, control_y, arrow_angle, r, g, b);
-    draw_text(cr, expr_str, control_x, control_y, text_angle);
+    if (expr_str != NULL)
+        draw_text(cr, expr_str, control_x, control_y, text_angle);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -265,27 +303,53 @@ void draw_help(
 }
 
 /* -------------------------------------------------------------------------- */
-void draw_drawing(cairo_t* cr, const struct line_vec* drawing, double zoom)
+static void draw_line(cairo_t* cr, const struct line* line, double width)
 {
     int i;
-    const struct line* line;
     const struct point* point;
-    vec_for_each (drawing, line)
+
+    cairo_set_source_rgb(
+        cr,
+        line->color.r / 255.0,
+        line->color.g / 255.0,
+        line->color.b / 255.0);
+    cairo_set_line_width(cr, width);
+    vec_enumerate (line->points, i, point)
     {
-        cairo_set_source_rgb(
-            cr,
-            line->color.r / 255.0,
-            line->color.g / 255.0,
-            line->color.b / 255.0);
-        cairo_set_line_width(cr, (line->selected ? 5.0 : 3.0) / zoom);
-        vec_enumerate (line->points, i, point)
-        {
-            if (i == 0)
-                cairo_move_to(cr, point->x, point->y);
-            else
-                cairo_line_to(cr, point->x, point->y);
-        }
-        cairo_stroke(cr);
+        if (i == 0)
+            cairo_move_to(cr, point->x, point->y);
+        else
+            cairo_line_to(cr, point->x, point->y);
+    }
+    cairo_stroke(cr);
+}
+
+/* -------------------------------------------------------------------------- */
+void draw_drawing(
+    cairo_t* cr,
+    const struct line_vec* drawing,
+    const struct spatial_result_vec* visible,
+    double zoom)
+{
+    const int* idx;
+    vec_for_each (visible, idx)
+        draw_line(cr, vec_get(drawing, *idx), 3.0 / zoom);
+}
+
+/* -------------------------------------------------------------------------- */
+void draw_drawing_overlay(
+    cairo_t* cr,
+    const struct line_vec* drawing,
+    const struct spatial_result_vec* visible,
+    double zoom)
+{
+    const int* idx;
+    const struct line* line;
+    vec_for_each (visible, idx)
+    {
+        line = vec_get(drawing, *idx);
+        if (line->selected)
+            draw_line(cr, line, 5.0 / zoom);
     }
 }
 
@@ -302,32 +366,22 @@ void draw_multi_selection(
 void draw_edges(
     cairo_t* cr,
     const struct csfg_graph* g,
-    const struct node_attr_hmap* node_attrs,
-    const struct edge_attr_hmap* edge_attrs,
-    enum graph_model_mode mode,
-    int active_edge_id,
-    int reconnect_edge_id)
+    const struct spatial_result_vec* visible,
+    const struct edge_attr_hmap* edge_attrs)
 {
-    struct color color;
+    const int* idx;
     const struct csfg_edge* e;
     const struct csfg_node *n_src, *n_dst;
     const struct edge_attr* ea;
-    const struct node_attr *na_src, *na_dst;
 
-    csfg_graph_for_each_edge (g, e)
+    vec_for_each (visible, idx)
     {
-        n_src  = csfg_graph_get_node(g, e->n_idx_from);
-        n_dst  = csfg_graph_get_node(g, e->n_idx_to);
-        ea     = edge_attr_hmap_find(edge_attrs, e->id);
-        na_src = node_attr_hmap_find(node_attrs, n_src->id);
-        na_dst = node_attr_hmap_find(node_attrs, n_dst->id);
-        if (ea == NULL || na_src == NULL || na_dst == NULL)
+        e     = csfg_graph_get_edge(g, *idx);
+        n_src = csfg_graph_get_node(g, e->n_idx_from);
+        n_dst = csfg_graph_get_node(g, e->n_idx_to);
+        ea    = edge_attr_hmap_find(edge_attrs, e->id);
+        if (ea == NULL)
             continue;
-        color = ea->color;
-        if (e->id == active_edge_id)
-            color = highlight_color(ea->color);
-        if (e->id == reconnect_edge_id)
-            color = highlight_color(ea->color);
         draw_edge(
             cr,
             n_src->x,
@@ -337,9 +391,56 @@ void draw_edges(
             n_dst->x,
             n_dst->y,
             str_cstr(ea->expr_str),
-            color.r / 255.0,
-            color.g / 255.0,
-            color.b / 255.0);
+            ea->color.r / 255.0,
+            ea->color.g / 255.0,
+            ea->color.b / 255.0);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+void draw_edges_overlay(
+    cairo_t* cr,
+    const struct csfg_graph* g,
+    const struct spatial_result_vec* visible,
+    const struct edge_attr_hmap* edge_attrs,
+    enum graph_model_mode mode,
+    int active_edge_id,
+    int reconnect_edge_id)
+{
+    struct color color;
+    const int* idx;
+    const struct csfg_edge* e;
+    const struct csfg_node *n_src, *n_dst;
+    const struct edge_attr* ea;
+    int highlight;
+
+    vec_for_each (visible, idx)
+    {
+        e         = csfg_graph_get_edge(g, *idx);
+        highlight = e->id == active_edge_id || e->id == reconnect_edge_id;
+        ea        = edge_attr_hmap_find(edge_attrs, e->id);
+        if (ea == NULL || (!highlight && !ea->selected))
+            continue;
+
+        color = highlight ? highlight_color(ea->color) : ea->color;
+        if (highlight)
+        {
+            /* The label is already part of the edge layer */
+            n_src = csfg_graph_get_node(g, e->n_idx_from);
+            n_dst = csfg_graph_get_node(g, e->n_idx_to);
+            draw_edge(
+                cr,
+                n_src->x,
+                n_src->y,
+                e->x,
+                e->y,
+                n_dst->x,
+                n_dst->y,
+                NULL,
+                color.r / 255.0,
+                color.g / 255.0,
+                color.b / 255.0);
+        }
         if ((mode == MODE_MOVE && e->id == active_edge_id) ||
             (mode == MODE_RECONNECT_FROM && e->id == reconnect_edge_id))
         {
@@ -369,6 +470,41 @@ void draw_edges(
 void draw_nodes(
     cairo_t* cr,
     const struct csfg_graph* g,
+    const struct spatial_result_vec* visible,
+    const struct node_attr_hmap* node_attrs,
+    int node_in_id,
+    int node_out_id)
+{
+    const int* idx;
+    const struct csfg_node* n;
+    const struct node_attr* na;
+
+    vec_for_each (visible, idx)
+    {
+        n  = csfg_graph_get_node(g, *idx);
+        na = node_attr_hmap_find(node_attrs, n->id);
+        if (na == NULL)
+            continue;
+        draw_node(
+            cr,
+            n->x,
+            n->y,
+            na->radius,
+            str_cstr(n->name),
+            na->color.r / 255.0,
+            na->color.g / 255.0,
+            na->color.b / 255.0,
+            0,
+            n->id == node_in_id,
+            n->id == node_out_id);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+void draw_nodes_overlay(
+    cairo_t* cr,
+    const struct csfg_graph* g,
+    const struct spatial_result_vec* visible,
     const struct node_attr_hmap* node_attrs,
     enum graph_model_mode mode,
     int node_in_id,
@@ -378,25 +514,29 @@ void draw_nodes(
     int reconnect_node_id)
 {
     struct color color;
+    const int* idx;
     const struct csfg_node* n;
     const struct node_attr* na;
+    int highlight;
 
-    csfg_graph_for_each_node (g, n)
+    vec_for_each (visible, idx)
     {
-        na = node_attr_hmap_find(node_attrs, n->id);
-        if (na == NULL)
+        n         = csfg_graph_get_node(g, *idx);
+        highlight = n->id == active_node_id || n->id == reconnect_node_id;
+        na        = node_attr_hmap_find(node_attrs, n->id);
+        if (na == NULL ||
+            (!highlight && !na->selected && n->id != selected_node_id))
+        {
             continue;
-        color = na->color;
-        if (n->id == active_node_id)
-            color = highlight_color(na->color);
-        if (n->id == reconnect_node_id)
-            color = highlight_color(na->color);
+        }
+
+        color = highlight ? highlight_color(na->color) : na->color;
         draw_node(
             cr,
             n->x,
             n->y,
             na->radius,
-            str_cstr(n->name),
+            NULL,
             color.r / 255.0,
             color.g / 255.0,
             color.b / 255.0,
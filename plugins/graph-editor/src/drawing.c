@@ -117,19 +117,3 @@ void drawing_clear(struct line_vec* drawing)
     while (vec_count(drawing))
         point_vec_deinit(line_vec_pop(drawing)->points);
 }
-
-/* -------------------------------------------------------------------------- */
-int try_select_line(const struct line_vec* drawing, int x, int y)
-{
-    int line_idx;
-    const struct line* line;
-    const struct point* point;
-    vec_enumerate (drawing, line_idx, line)
-        vec_for_each (line->points, point)
-            if (x <= point->x + GRID && x >= point->x - GRID &&
-                y <= point->y + GRID && y >= point->y - GRID)
-            {
-                return line_idx;
-            }
-    return -1;
-}
@@ -11,8 +11,10 @@
 #include "graph-editor/graph_editor.h"
 #include "graph-editor/graph_helpers.h"
 #include "graph-editor/graph_model.h"
+#include "graph-editor/render_cache.h"
 #include "graph-editor/undo.h"
 #include <librsvg/rsvg.h>
+#include <math.h>
 
 #define COLOR_BUTTONS_LIST                                                     \
     X(1, "1", 0x333333)                                                        \
@@ -61,6 +63,7 @@ struct _GraphEditor
     int drag_end_x, drag_end_y;
 
     struct graph_model* model;
+    struct render_cache render_cache;
 
     unsigned show_shortcuts     : 1;
     unsigned show_seven_steps   : 1;
@@ -73,7 +76,7 @@ G_DEFINE_DYNAMIC_TYPE(GraphEditor, graph_editor, GTK_TYPE_BOX)
 /* -------------------------------------------------------------------------- */
 static void finish_editing(GtkEntry* entry, gpointer user_data)
 {
-    int n_idx;
+    int n_idx, e_idx, changed_e_idx = -1;
     struct csfg_node* n;
     struct csfg_edge* e;
     struct edge_attr* ea;
@@ -96,18 +99,23 @@ static void finish_editing(GtkEntry* entry, gpointer user_data)
         ea = edge_attr_hmap_find(model->edge_attrs, model->active_edge_id);
         str_set_cstr(&ea->expr_str, text);
 
-        csfg_graph_for_each_edge (model->graph, e)
+        csfg_graph_enumerate_edges (model->graph, e_idx, e)
             if (e->id == model->active_edge_id)
             {
                 csfg_expr_pool_clear(e->pool);
                 e->expr = csfg_expr_parse(&e->pool, cstr_view(text));
+                changed_e_idx = e_idx;
+                break;
             }
     }
 
     gtk_widget_unparent(editor->entry);
     editor->entry = NULL;
 
-    notify_graph_changed(model);
+    if (changed_e_idx > -1)
+        notify_edge_expr_changed(model, changed_e_idx);
+    else
+        notify_graph_changed(model);
     undo_push_state(model);
     gtk_widget_queue_draw(editor->drawing_area);
 }
@@ -894,43 +902,68 @@ static void draw_cb(
     int height,
     gpointer user_data)
 {
-    const GraphEditor* editor       = user_data;
-    const struct graph_model* model = editor->model;
+    int x1, y1, x2, y2;
+    int pan_x, pan_y;
+    GraphEditor* editor       = user_data;
+    struct graph_model* model = editor->model;
     (void)area;
 
+    /* The cached layers can only be blitted at whole pixel offsets */
+    pan_x = (int)floor(editor->pan_x + 0.5);
+    pan_y = (int)floor(editor->pan_y + 0.5);
+
+    /* Visible region in graph coordinates */
+    x1 = (int)floor(-pan_x / editor->zoom);
+    y1 = (int)floor(-pan_y / editor->zoom);
+    x2 = (int)ceil((width - pan_x) / editor->zoom);
+    y2 = (int)ceil((height - pan_y) / editor->zoom);
+
     draw_help(
         cr,
         editor->seven_steps,
         editor->show_seven_steps,
         editor->show_shortcuts);
 
-    cairo_translate(cr, editor->pan_x, editor->pan_y);
+    render_cache_paint(
+        &editor->render_cache,
+        cr,
+        model,
+        pan_x,
+        pan_y,
+        editor->zoom,
+        width,
+        height);
+
+    /* Everything that depends on the selection or the mouse is drawn on top
+     * of the cached layers every frame */
+    cairo_translate(cr, pan_x, pan_y);
     cairo_scale(cr, editor->zoom, editor->zoom);
 
-    cairo_set_line_width(cr, 0.5 / editor->zoom);
-    draw_grid(cr, editor->pan_x, editor->pan_y, width, height, editor->zoom);
-
     cairo_set_line_width(cr, 2.0 / editor->zoom);
-    draw_edges(
-        cr,
-        model->graph,
-        model->node_attrs,
-        model->edge_attrs,
-        model->mode,
-        model->active_edge_id,
-        model->reconnect_edge_id);
-    draw_nodes(
-        cr,
-        model->graph,
-        model->node_attrs,
-        model->mode,
-        model->node_in_id,
-        model->node_out_id,
-        model->active_node_id,
-        model->marked_node_id,
-        model->reconnect_node_id);
-
-    draw_drawing(cr, model->drawing, editor->zoom);
+    if (graph_model_query(model, SPATIAL_EDGE, x1, y1, x2, y2) == 0)
+        draw_edges_overlay(
+            cr,
+            model->graph,
+            model->spatial_result,
+            model->edge_attrs,
+            model->mode,
+            model->active_edge_id,
+            model->reconnect_edge_id);
+    if (graph_model_query(model, SPATIAL_NODE, x1, y1, x2, y2) == 0)
+        draw_nodes_overlay(
+            cr,
+            model->graph,
+            model->spatial_result,
+            model->node_attrs,
+            model->mode,
+            model->node_in_id,
+            model->node_out_id,
+            model->active_node_id,
+            model->marked_node_id,
+            model->reconnect_node_id);
+    if (graph_model_query(model, SPATIAL_LINE, x1, y1, x2, y2) == 0)
+        draw_drawing_overlay(
+            cr, model->drawing, model->spatial_result, editor->zoom);
     cairo_set_line_width(cr, 2.0 / editor->zoom);
 
     if (editor->is_box_selecting)
@@ -969,7 +1002,7 @@ static void click_down(
         case MODE_RECONNECT_FROM:
             if (model->reconnect_node_id > -1)
             {
-                int e_id = try_select_edge(model->graph, x, y);
+                int e_id = try_select_edge(model, x, y);
                 if (node_is_connected_to_edge(
                         model->graph, model->reconnect_node_id, e_id))
                 {
@@ -981,8 +1014,7 @@ static void click_down(
             }
             if (model->reconnect_edge_id > -1)
             {
-                int n_id =
-                    try_select_node(model->graph, model->node_attrs, x, y);
+                int n_id = try_select_node(model, x, y);
                 if (node_is_connected_to_edge(
                         model->graph, n_id, model->reconnect_edge_id))
                 {
@@ -994,7 +1026,7 @@ static void click_down(
             }
             break;
         case MODE_RECONNECT_TO: {
-            int n_id = try_select_node(model->graph, model->node_attrs, x, y);
+            int n_id = try_select_node(model, x, y);
             if (n_id > -1)
             {
                 model->active_node_id = reconnect_edge(
@@ -1076,7 +1108,7 @@ drag_begin(GtkGestureDrag* gesture, double x, double y, gpointer user_data)
              * not spread over 2 event handlers */
             /* Priorities: Drawing > Edge > Node -- feels better */
 
-            if ((id = try_select_edge(model->graph, x, y)) > -1)
+            if ((id = try_select_edge(model, x, y)) > -1)
             {
                 ea = edge_attr_hmap_find(model->edge_attrs, id);
                 if (add_to_multiselect)
@@ -1111,9 +1143,7 @@ drag_begin(GtkGestureDrag* gesture, double x, double y, gpointer user_data)
                     ea->drag_begin_y = e->y;
                 }
             }
-            else if (
-                (id = try_select_node(model->graph, model->node_attrs, x, y)) >
-                -1)
+            else if ((id = try_select_node(model, x, y)) > -1)
             {
                 na = node_attr_hmap_find(model->node_attrs, id);
                 if (add_to_multiselect)
@@ -1148,7 +1178,7 @@ drag_begin(GtkGestureDrag* gesture, double x, double y, gpointer user_data)
                     na->drag_begin_y = n->y;
                 }
             }
-            else if ((line_idx = try_select_line(model->drawing, x, y)) > -1)
+            else if ((line_idx = try_select_line(model, x, y)) > -1)
             {
                 if (add_to_multiselect && model->active_node_id > -1)
                 {
@@ -1318,6 +1348,8 @@ static void drag_update(
                         line->drag_begin_x = (int)offset_x;
                         line->drag_begin_y = (int)offset_y;
                     }
+
+                graph_model_update_spatial_index(model);
             }
 
             /* Update selection of objects if box selecting is active */
@@ -1343,6 +1375,7 @@ static void drag_update(
                 return;
             point->x = (int)x;
             point->y = (int)y;
+            graph_model_update_spatial_index(model);
             break;
     }
 
@@ -1731,6 +1764,8 @@ static void graph_editor_init(GraphEditor* self)
     self->fix_physical_units = 0;
     self->is_box_selecting   = 0;
 
+    render_cache_init(&self->render_cache);
+
     self->seven_steps =
         load_svg("/ch/thecomet/dpsfg/graph-editor/images/7-steps.svg");
 
@@ -1790,6 +1825,7 @@ static void graph_editor_init(GraphEditor* self)
 static void graph_editor_finalize(GObject* object)
 {
     GraphEditor* self = PLUGIN_GRAPH_EDITOR(object);
+    render_cache_deinit(&self->render_cache);
     g_object_unref(self->seven_steps);
     G_OBJECT_CLASS(graph_editor_parent_class)->finalize(object);
 }
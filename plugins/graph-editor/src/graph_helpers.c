@@ -1,5 +1,4 @@
 #include "csfg/graph/graph.h"
-#include "graph-editor/attr.h"
 #include "graph-editor/constants.h"
 #include "graph-editor/geometry.h"
 #include "graph-editor/graph_helpers.h"
@@ -89,47 +88,6 @@ int find_farthest_node_in_direction(
     return new_active_node;
 }
 
-/* -------------------------------------------------------------------------- */
-int find_nearest_node_in_direction(
-    const struct csfg_graph* graph,
-    int active_node_id,
-    double dirx,
-    double diry,
-    double current_x,
-    double current_y)
-{
-    int idx;
-    const struct csfg_node* n;
-    double dx, dy;
-    double new_dist, dist = 100000. * 100000.;
-
-    if (graph == NULL)
-        return -1;
-
-    csfg_graph_enumerate_nodes (graph, idx, n)
-    {
-        if (n->id == active_node_id)
-            continue;
-
-        dx       = current_x - n->x;
-        dy       = current_y - n->y;
-        new_dist = dx * dx + dy * dy;
-        if (new_dist < dist)
-        {
-            if (dirx > 0 && n->x > current_x)
-                dist = new_dist, active_node_id = n->id;
-            if (dirx < 0 && n->x < current_x)
-                dist = new_dist, active_node_id = n->id;
-            if (diry > 0 && n->y > current_y)
-                dist = new_dist, active_node_id = n->id;
-            if (diry < 0 && n->y < current_y)
-                dist = new_dist, active_node_id = n->id;
-        }
-    }
-
-    return active_node_id;
-}
-
 /* -------------------------------------------------------------------------- */
 int find_farthest_edge_in_direction(
     const struct csfg_graph* graph, int active_edge_id, double dx, double dy)
@@ -163,47 +121,6 @@ int find_farthest_edge_in_direction(
     return active_edge_id;
 }
 
-/* -------------------------------------------------------------------------- */
-int find_nearest_edge_in_direction(
-    const struct csfg_graph* graph,
-    int active_edge_id,
-    double dirx,
-    double diry,
-    double current_x,
-    double current_y)
-{
-    int idx;
-    const struct csfg_edge* e;
-    double dx, dy;
-    double new_dist, dist = 100000. * 100000.;
-
-    if (graph == NULL)
-        return -1;
-
-    csfg_graph_enumerate_edges (graph, idx, e)
-    {
-        if (e->id == active_edge_id)
-            continue;
-
-        dx       = current_x - e->x;
-        dy       = current_y - e->y;
-        new_dist = dx * dx + dy * dy;
-        if (new_dist < dist)
-        {
-            if (dirx > 0 && e->x > current_x)
-                dist = new_dist, active_edge_id = e->id;
-            if (dirx < 0 && e->x < current_x)
-                dist = new_dist, active_edge_id = e->id;
-            if (diry > 0 && e->y > current_y)
-                dist = new_dist, active_edge_id = e->id;
-            if (diry < 0 && e->y < current_y)
-                dist = new_dist, active_edge_id = e->id;
-        }
-    }
-
-    return active_edge_id;
-}
-
 /* -------------------------------------------------------------------------- */
 int is_near_any_other_node(
     const struct csfg_graph* g,
@@ -452,49 +369,3 @@ void bump_all_edges_connected_to_node(struct csfg_graph* g, int n_id)
         if (e->n_idx_from == n_idx || e->n_idx_to == n_idx)
             bump_edge(g, e);
 }
-
-/* -------------------------------------------------------------------------- */
-int try_select_node(
-    const struct csfg_graph* g,
-    const struct node_attr_hmap* attrs,
-    int mouse_x,
-    int mouse_y)
-{
-    int dx, dy, idx;
-    const struct csfg_node* n;
-    const struct node_attr* na;
-
-    if (g == NULL)
-        return -1;
-
-    csfg_graph_enumerate_nodes (g, idx, n)
-    {
-        na = node_attr_hmap_find(attrs, n->id);
-        dx = mouse_x - n->x;
-        dy = mouse_y - n->y;
-        if (dx * dx + dy * dy < na->radius * na->radius)
-            return n->id;
-    }
-
-    return -1;
-}
-
-/* -------------------------------------------------------------------------- */
-int try_select_edge(const struct csfg_graph* g, int mouse_x, int mouse_y)
-{
-    int dx, dy, idx;
-    const struct csfg_edge* e;
-
-    if (g == NULL)
-        return -1;
-
-    csfg_graph_enumerate_edges (g, idx, e)
-    {
-        dx = mouse_x - e->x;
-        dy = mouse_y - e->y;
-        if (dx * dx + dy * dy < ARROW_RADIUS * ARROW_RADIUS)
-            return e->id;
-    }
-
-    return -1;
-}
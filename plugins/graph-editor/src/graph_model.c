@@ -2,13 +2,92 @@
 #include "csfg/io/serialize.h"
 #include "csfg/symbolic/expr.h"
 #include "csfg/util/str.h"
+#include "csfg/util/text_cache.h"
 #include "dpsfg-plugin.h"
 #include "graph-editor/attr.h"
 #include "graph-editor/constants.h"
 #include "graph-editor/drawing.h"
+#include "graph-editor/geometry.h"
 #include "graph-editor/graph_helpers.h"
 #include "graph-editor/graph_model.h"
 #include "graph-editor/undo.h"
+#include <math.h>
+
+/* -------------------------------------------------------------------------- */
+/*!
+ * @brief Finds the nearest node or edge in a direction by querying squares of
+ * increasing size around the current position, until the square contains the
+ * circle through the nearest candidate.
+ */
+static int find_nearest_in_direction(
+    struct graph_model* model,
+    enum spatial_kind kind,
+    int exclude_id,
+    double dirx,
+    double diry,
+    double current_x,
+    double current_y)
+{
+    const int* idx;
+    int r, id, x, y, found_id = exclude_id;
+    int count = kind == SPATIAL_NODE ? csfg_graph_node_count(model->graph)
+                                     : csfg_graph_edge_count(model->graph);
+    double dx, dy, new_dist, dist = 100000. * 100000.;
+
+    for (r = SPATIAL_CELL_SIZE; r < 1 << 20; r *= 2)
+    {
+        if (graph_model_query(
+                model,
+                kind,
+                (int)current_x - r,
+                (int)current_y - r,
+                (int)current_x + r,
+                (int)current_y + r) != 0)
+        {
+            break;
+        }
+
+        vec_for_each (model->spatial_result, idx)
+        {
+            if (kind == SPATIAL_NODE)
+            {
+                const struct csfg_node* n =
+                    csfg_graph_get_node(model->graph, *idx);
+                id = n->id, x = n->x, y = n->y;
+            }
+            else
+            {
+                const struct csfg_edge* e =
+                    csfg_graph_get_edge(model->graph, *idx);
+                id = e->id, x = e->x, y = e->y;
+            }
+            if (id == exclude_id)
+                continue;
+
+            dx       = current_x - x;
+            dy       = current_y - y;
+            new_dist = dx * dx + dy * dy;
+            if (new_dist < dist)
+            {
+                if (dirx > 0 && x > current_x)
+                    dist = new_dist, found_id = id;
+                if (dirx < 0 && x < current_x)
+                    dist = new_dist, found_id = id;
+                if (diry > 0 && y > current_y)
+                    dist = new_dist, found_id = id;
+                if (diry < 0 && y < current_y)
+                    dist = new_dist, found_id = id;
+            }
+        }
+
+        if (found_id != exclude_id && dist <= (double)r * r)
+            break;
+        if (vec_count(model->spatial_result) == count)
+            break;
+    }
+
+    return found_id;
+}
 
 /* -------------------------------------------------------------------------- */
 void select_next_active_node_in_direction(
@@ -21,11 +100,11 @@ void select_next_active_node_in_direction(
     e = find_edge(model->graph, model->active_edge_id);
 
     if (n != NULL)
-        model->active_node_id = find_nearest_node_in_direction(
-            model->graph, model->active_node_id, dx, dy, n->x, n->y);
+        model->active_node_id = find_nearest_in_direction(
+            model, SPATIAL_NODE, model->active_node_id, dx, dy, n->x, n->y);
     else if (e != NULL)
-        model->active_node_id = find_nearest_node_in_direction(
-            model->graph, model->active_node_id, dx, dy, e->x, e->y);
+        model->active_node_id = find_nearest_in_direction(
+            model, SPATIAL_NODE, model->active_node_id, dx, dy, e->x, e->y);
     else
         model->active_node_id =
             find_farthest_node_in_direction(model->graph, dx, dy);
@@ -45,11 +124,11 @@ void select_next_active_edge_in_direction(
     e = find_edge(model->graph, model->active_edge_id);
 
     if (e != NULL)
-        model->active_edge_id = find_nearest_edge_in_direction(
-            model->graph, model->active_edge_id, dx, dy, e->x, e->y);
+        model->active_edge_id = find_nearest_in_direction(
+            model, SPATIAL_EDGE, model->active_edge_id, dx, dy, e->x, e->y);
     else if (n != NULL)
-        model->active_edge_id = find_nearest_edge_in_direction(
-            model->graph, model->active_edge_id, dx, dy, n->x, n->y);
+        model->active_edge_id = find_nearest_in_direction(
+            model, SPATIAL_EDGE, model->active_edge_id, dx, dy, n->x, n->y);
     else
         model->active_edge_id = find_farthest_edge_in_direction(
             model->graph, model->active_edge_id, dx, dy);
@@ -270,6 +349,7 @@ void move_active_node_in_direction(
         model->graph, model->active_node_id, n1_prev_x, n1_prev_y, 0);
     bump_all_edges_connected_to_node(model->graph, model->active_node_id);
 
+    graph_model_update_spatial_index(model);
     model->icb->graph_layout_changed(model->cb, model->plugin_ctx);
 }
 
@@ -284,6 +364,7 @@ void move_active_edge_in_direction(
     e->x += dx * GRID;
     e->y += dy * GRID;
 
+    graph_model_update_spatial_index(model);
     model->icb->graph_layout_changed(model->cb, model->plugin_ctx);
 }
 
@@ -543,6 +624,78 @@ void delete_multi_selection_objects(struct graph_model* model)
 
     if (need_graph_gc)
         csfg_graph_gc(model->graph);
+
+    graph_model_invalidate_spatial_index(model);
+}
+
+/* -------------------------------------------------------------------------- */
+int try_select_node(struct graph_model* model, int x, int y)
+{
+    int dx, dy;
+    const int* idx;
+    const struct csfg_node* n;
+    const struct node_attr* na;
+
+    if (model->graph == NULL)
+        return -1;
+    if (graph_model_query(model, SPATIAL_NODE, x, y, x, y) != 0)
+        return -1;
+
+    vec_for_each (model->spatial_result, idx)
+    {
+        n  = csfg_graph_get_node(model->graph, *idx);
+        na = node_attr_hmap_find(model->node_attrs, n->id);
+        dx = x - n->x;
+        dy = y - n->y;
+        if (dx * dx + dy * dy < na->radius * na->radius)
+            return n->id;
+    }
+
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int try_select_edge(struct graph_model* model, int x, int y)
+{
+    int dx, dy;
+    const int* idx;
+    const struct csfg_edge* e;
+
+    if (model->graph == NULL)
+        return -1;
+    if (graph_model_query(model, SPATIAL_EDGE, x, y, x, y) != 0)
+        return -1;
+
+    vec_for_each (model->spatial_result, idx)
+    {
+        e  = csfg_graph_get_edge(model->graph, *idx);
+        dx = x - e->x;
+        dy = y - e->y;
+        if (dx * dx + dy * dy < ARROW_RADIUS * ARROW_RADIUS)
+            return e->id;
+    }
+
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int try_select_line(struct graph_model* model, int x, int y)
+{
+    const int* idx;
+    const struct point* point;
+
+    if (graph_model_query(model, SPATIAL_LINE, x, y, x, y) != 0)
+        return -1;
+
+    vec_for_each (model->spatial_result, idx)
+        vec_for_each (vec_get(model->drawing, *idx)->points, point)
+            if (x <= point->x + GRID && x >= point->x - GRID &&
+                y <= point->y + GRID && y >= point->y - GRID)
+            {
+                return *idx;
+            }
+
+    return -1;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -554,6 +707,7 @@ void multi_select_nodes_and_lines(
     struct node_attr* na;
     struct line* line;
     struct point* point;
+    const int* idx;
     double tmp;
 
     if (model->graph == NULL)
@@ -564,31 +718,42 @@ void multi_select_nodes_and_lines(
     if (y1 > y2)
         tmp = y1, y1 = y2, y2 = tmp;
 
-    csfg_graph_for_each_node (model->graph, n)
-    {
-        na = node_attr_hmap_find(model->node_attrs, n->id);
-        if (x1 <= n->x + na->radius && x2 >= n->x - na->radius &&
-            y1 <= n->y + na->radius && y2 >= n->y - na->radius)
+    if (graph_model_query(model, SPATIAL_NODE, x1, y1, x2, y2) == 0)
+        vec_for_each (model->spatial_result, idx)
         {
-            na->selected = append;
+            n  = csfg_graph_get_node(model->graph, *idx);
+            na = node_attr_hmap_find(model->node_attrs, n->id);
+            if (x1 <= n->x + na->radius && x2 >= n->x - na->radius &&
+                y1 <= n->y + na->radius && y2 >= n->y - na->radius)
+            {
+                na->selected = append;
+            }
         }
-    }
 
-    csfg_graph_for_each_edge (model->graph, e)
-        if (x1 <= e->x + GRID / 2.0 && x2 >= e->x - GRID / 2.0 &&
-            y1 <= e->y + GRID / 2.0 && y2 >= e->y - GRID / 2.0)
+    if (graph_model_query(model, SPATIAL_EDGE, x1, y1, x2, y2) == 0)
+        vec_for_each (model->spatial_result, idx)
         {
-            edge_attr_hmap_find(model->edge_attrs, e->id)->selected = append;
-        }
-
-    vec_for_each (model->drawing, line)
-        vec_for_each (line->points, point)
-            if (x1 <= point->x + GRID && x2 >= point->x - GRID &&
-                y1 <= point->y + GRID && y2 >= point->y - GRID)
+            e = csfg_graph_get_edge(model->graph, *idx);
+            if (x1 <= e->x + GRID / 2.0 && x2 >= e->x - GRID / 2.0 &&
+                y1 <= e->y + GRID / 2.0 && y2 >= e->y - GRID / 2.0)
             {
-                line->selected = append;
-                break;
+                edge_attr_hmap_find(model->edge_attrs, e->id)->selected =
+                    append;
             }
+        }
+
+    if (graph_model_query(model, SPATIAL_LINE, x1, y1, x2, y2) == 0)
+        vec_for_each (model->spatial_result, idx)
+        {
+            line = vec_get(model->drawing, *idx);
+            vec_for_each (line->points, point)
+                if (x1 <= point->x + GRID && x2 >= point->x - GRID &&
+                    y1 <= point->y + GRID && y2 >= point->y - GRID)
+                {
+                    line->selected = append;
+                    break;
+                }
+        }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -680,6 +845,9 @@ void recolor_selected_objects(struct graph_model* model, struct color color)
     vec_for_each (model->drawing, line)
         if (line->selected)
             line->color = color;
+
+    /* Colors are part of the editor's cached canvas layers */
+    spatial_mark_all_dirty(&model->spatial);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -703,10 +871,28 @@ void notify_graph_changed(struct graph_model* model)
     if (node_out_idx == csfg_graph_node_count(model->graph))
         node_out_idx = -1;
 
+    graph_model_invalidate_spatial_index(model);
     model->icb->graph_structure_changed(
         model->cb, model->plugin_ctx, node_in_idx, node_out_idx);
 }
 
+/* -------------------------------------------------------------------------- */
+void notify_edge_expr_changed(struct graph_model* model, int edge_idx)
+{
+    if (model->graph == NULL)
+        return;
+
+    /* The expression is drawn next to the edge. Its size may have changed,
+     * and the old text has to be redrawn even if it didn't */
+    graph_model_update_spatial_index(model);
+    if (edge_idx < spatial_count(&model->spatial, SPATIAL_EDGE))
+        spatial_mark_dirty(
+            &model->spatial,
+            SPATIAL_EDGE,
+            &vec_get(model->spatial.items[SPATIAL_EDGE], edge_idx)->bb);
+    model->icb->edge_expr_changed(model->cb, model->plugin_ctx, edge_idx);
+}
+
 /* -------------------------------------------------------------------------- */
 void graph_model_rebuild_graph(
     struct graph_model* model, int node_in, int node_out)
@@ -717,6 +903,7 @@ void graph_model_rebuild_graph(
     struct node_attr* na;
     struct edge_attr* ea;
 
+    graph_model_invalidate_spatial_index(model);
     if (model->graph == NULL)
         return;
 
@@ -776,10 +963,15 @@ void graph_model_init(
     edge_attr_hmap_init(&model->edge_attrs);
 
     undo_stack_vec_init(&model->undo_stack);
+    serializer_init(&model->undo_state);
     model->undo_stack_ptr = -1;
 
     line_vec_init(&model->drawing);
 
+    spatial_init(&model->spatial);
+    spatial_result_vec_init(&model->spatial_result);
+    model->spatial_valid = 0;
+
     model->graph_color = hex_rgb(0x333333);
     model->draw_color  = hex_rgb(0x333333);
 
@@ -799,7 +991,6 @@ void graph_model_deinit(struct graph_model* model)
 {
     int idx, id;
     struct edge_attr* ea;
-    struct serializer** ser;
     struct line* line;
 
     vec_for_each (model->drawing, line)
@@ -811,9 +1002,12 @@ void graph_model_deinit(struct graph_model* model)
     edge_attr_hmap_deinit(model->edge_attrs);
     node_attr_hmap_deinit(model->node_attrs);
 
-    vec_for_each (model->undo_stack, ser)
-        serializer_deinit(*ser);
+    undo_clear_stack(model);
     undo_stack_vec_deinit(model->undo_stack);
+    serializer_deinit(model->undo_state);
+
+    spatial_result_vec_deinit(model->spatial_result);
+    spatial_deinit(&model->spatial);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -830,3 +1024,245 @@ void graph_model_clear_graph(struct graph_model* model)
     model->graph = NULL;
     graph_model_rebuild_graph(model, -1, -1);
 }
+
+/* -------------------------------------------------------------------------- */
+/* Rough size of a label drawn by draw_text(), used to pad bounding boxes so
+ * labels sticking out of the view are still drawn. Labels that were drawn
+ * before have their exact size in the shared text cache */
+#define TEXT_CHAR_WIDTH 12
+#define TEXT_HEIGHT     24
+
+static int label_width(const struct str* text)
+{
+    const struct text_extents* ext;
+    struct text_cache* cache = text_cache_shared();
+
+    if (cache != NULL)
+    {
+        ext = text_cache_find(
+            cache, cstr_view(LABEL_FONT), LABEL_FONT_SIZE, str_view(text));
+        if (ext != NULL)
+            return (int)ceil(ext->width);
+    }
+
+    return str_len(text) * TEXT_CHAR_WIDTH;
+}
+
+static void
+rect_add_point(struct spatial_rect* bb, double x, double y, double pad)
+{
+    if (bb->x1 > x - pad)
+        bb->x1 = (int)floor(x - pad);
+    if (bb->y1 > y - pad)
+        bb->y1 = (int)floor(y - pad);
+    if (bb->x2 < x + pad)
+        bb->x2 = (int)ceil(x + pad);
+    if (bb->y2 < y + pad)
+        bb->y2 = (int)ceil(y + pad);
+}
+
+/* -------------------------------------------------------------------------- */
+static void node_bb(
+    struct spatial_rect* bb,
+    const struct csfg_node* n,
+    const struct node_attr* na)
+{
+    int text_w = label_width(n->name);
+
+    bb->x1 = bb->x2 = n->x;
+    bb->y1 = bb->y2 = n->y;
+    /* Selection symbols are drawn slightly outside of the radius */
+    rect_add_point(bb, n->x, n->y, na->radius * 1.2 + GRID / 2.0);
+    /* The name is drawn below the node */
+    rect_add_point(bb, n->x - text_w / 2.0, n->y + 2 * TEXT_HEIGHT, 0);
+    rect_add_point(bb, n->x + text_w / 2.0, n->y + 2 * TEXT_HEIGHT, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+static int angle_is_on_arc(double a, double start, double end)
+{
+    double sweep = fmod(end - start + 4 * M_PI, 2 * M_PI);
+    return fmod(a - start + 4 * M_PI, 2 * M_PI) <= sweep;
+}
+
+/* -------------------------------------------------------------------------- */
+static void edge_bb(
+    struct spatial_rect* bb,
+    const struct csfg_node* from,
+    const struct csfg_node* to,
+    const struct csfg_edge* e,
+    const struct edge_attr* ea)
+{
+    int orientation, i;
+    double cx, cy, radius, a1, a2;
+    int text_w = label_width(ea->expr_str);
+
+    bb->x1 = bb->x2 = e->x;
+    bb->y1 = bb->y2 = e->y;
+    rect_add_point(bb, from->x, from->y, 0);
+    rect_add_point(bb, to->x, to->y, 0);
+
+    /* Same shapes as draw_edge(). Arcs can bulge out past their end points */
+    orientation = calc_circle(
+        &cx, &cy, &radius, from->x, from->y, e->x, e->y, to->x, to->y);
+    if (orientation)
+    {
+        a1 = atan2(from->y - cy, from->x - cx);
+        a2 = atan2(to->y - cy, to->x - cx);
+        for (i = 0; i != 4; ++i)
+            if (orientation > 0 ? angle_is_on_arc(i * M_PI / 2, a1, a2)
+                                : angle_is_on_arc(i * M_PI / 2, a2, a1))
+            {
+                rect_add_point(
+                    bb, cx + radius * cos(i * M_PI / 2),
+                    cy + radius * sin(i * M_PI / 2), 0);
+            }
+    }
+    else if (calc_circle_two_points_overlapping(
+                 &cx,
+                 &cy,
+                 &radius,
+                 from->x,
+                 from->y,
+                 e->x,
+                 e->y,
+                 to->x,
+                 to->y))
+    {
+        rect_add_point(bb, cx, cy, radius);
+    }
+
+    /* Arrow, selection symbols and the expression, which is drawn on either
+     * side of the control point */
+    rect_add_point(bb, e->x, e->y, ARROW_RADIUS * 2 + GRID / 2.0);
+    rect_add_point(bb, e->x, e->y, text_w + TEXT_HEIGHT);
+}
+
+/* -------------------------------------------------------------------------- */
+static void line_bb(struct spatial_rect* bb, const struct line* line)
+{
+    const struct point* point;
+
+    if (vec_count(line->points) == 0)
+    {
+        bb->x1 = bb->y1 = bb->x2 = bb->y2 = 0;
+        return;
+    }
+
+    bb->x1 = bb->x2 = vec_first(line->points)->x;
+    bb->y1 = bb->y2 = vec_first(line->points)->y;
+    /* Lines can be selected from up to GRID away */
+    vec_for_each (line->points, point)
+        rect_add_point(bb, point->x, point->y, GRID);
+}
+
+/* -------------------------------------------------------------------------- */
+static int update_spatial_index(struct graph_model* model)
+{
+    int idx;
+    struct spatial_rect bb;
+    const struct csfg_node* n;
+    const struct csfg_edge* e;
+    const struct node_attr* na;
+    const struct edge_attr* ea;
+    const struct line* line;
+
+    csfg_graph_enumerate_nodes (model->graph, idx, n)
+    {
+        na = node_attr_hmap_find(model->node_attrs, n->id);
+        if (na == NULL)
+            continue;
+        node_bb(&bb, n, na);
+        if (spatial_set(&model->spatial, SPATIAL_NODE, idx, &bb) != 0)
+            return -1;
+    }
+
+    csfg_graph_enumerate_edges (model->graph, idx, e)
+    {
+        ea = edge_attr_hmap_find(model->edge_attrs, e->id);
+        if (ea == NULL)
+            continue;
+        edge_bb(
+            &bb,
+            csfg_graph_get_node(model->graph, e->n_idx_from),
+            csfg_graph_get_node(model->graph, e->n_idx_to),
+            e,
+            ea);
+        if (spatial_set(&model->spatial, SPATIAL_EDGE, idx, &bb) != 0)
+            return -1;
+    }
+
+    vec_enumerate (model->drawing, idx, line)
+    {
+        line_bb(&bb, line);
+        if (spatial_set(&model->spatial, SPATIAL_LINE, idx, &bb) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+struct spatial_index* graph_model_spatial_index(struct graph_model* model)
+{
+    struct spatial_index* index = &model->spatial;
+
+    if (model->spatial_valid &&
+        spatial_count(index, SPATIAL_NODE) ==
+            csfg_graph_node_count(model->graph) &&
+        spatial_count(index, SPATIAL_EDGE) ==
+            csfg_graph_edge_count(model->graph) &&
+        spatial_count(index, SPATIAL_LINE) == vec_count(model->drawing))
+    {
+        return index;
+    }
+
+    spatial_clear(index);
+    model->spatial_valid = update_spatial_index(model) == 0;
+
+    return index;
+}
+
+/* -------------------------------------------------------------------------- */
+void graph_model_invalidate_spatial_index(struct graph_model* model)
+{
+    model->spatial_valid = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void graph_model_update_spatial_index(struct graph_model* model)
+{
+    if (!model->spatial_valid)
+        return;
+
+    /* Items that are not moved are left alone by spatial_set(), and moving an
+     * item within its cells is cheap. This only touches the hashmap for items
+     * that actually crossed a cell boundary */
+    if (update_spatial_index(model) != 0)
+        model->spatial_valid = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int graph_model_query(
+    struct graph_model* model,
+    enum spatial_kind kind,
+    int x1,
+    int y1,
+    int x2,
+    int y2)
+{
+    struct spatial_rect rect;
+    int tmp;
+
+    if (x1 > x2)
+        tmp = x1, x1 = x2, x2 = tmp;
+    if (y1 > y2)
+        tmp = y1, y1 = y2, y2 = tmp;
+    rect.x1 = x1;
+    rect.y1 = y1;
+    rect.x2 = x2;
+    rect.y2 = y2;
+
+    return spatial_query(
+        graph_model_spatial_index(model), kind, &rect, &model->spatial_result);
+}
@@ -51,6 +51,7 @@ graph_on_structure_changed(struct plugin_ctx* ctx, int node_in, int node_out)
 }
 static void graph_on_layout_changed(struct plugin_ctx* ctx)
 {
+    graph_model_update_spatial_index(&ctx->graph_model);
     graph_editor_redraw_graph(ctx->graph_editor);
 }
 
@@ -58,7 +59,7 @@ static void graph_on_layout_changed(struct plugin_ctx* ctx)
 static int io_on_save(struct plugin_ctx* ctx, struct serializer** ser)
 {
     const struct graph_model* model = &ctx->graph_model;
-    serialize_lu16(ser, 0x0000); /* version */
+    serialize_lu16(ser, 0x0001); /* version */
     if (attrs_save(ser, model->node_attrs, model->edge_attrs, model->graph) !=
         0)
         return -1;
@@ -79,7 +80,8 @@ static int io_on_load(struct plugin_ctx* ctx, struct deserializer* des)
 
     switch (version)
     {
-        case 0x000:
+        case 0x0000:
+        case 0x0001:
             if (attrs_load(
                     des,
                     &model->node_attrs,
@@ -88,11 +90,12 @@ static int io_on_load(struct plugin_ctx* ctx, struct deserializer* des)
                 return -1;
             if (drawing_load(des, &model->drawing, model->graph) != 0)
                 return -1;
-            if (undo_load_stack(des, model) != 0)
+            if (undo_load_stack(des, model, version) != 0)
                 return -1;
             break;
     }
 
+    graph_model_invalidate_spatial_index(model);
     return 0;
 }
 
@@ -0,0 +1,340 @@
+#include "graph-editor/draw.h"
+#include "graph-editor/graph_model.h"
+#include "graph-editor/render_cache.h"
+#include "graph-editor/spatial.h"
+#include <cairo.h>
+#include <math.h>
+
+/* -------------------------------------------------------------------------- */
+static void draw_layer_content(
+    enum render_layer_id id,
+    cairo_t* cr,
+    struct graph_model* model,
+    const struct spatial_rect* r,
+    double zoom)
+{
+    switch (id)
+    {
+        case RENDER_LAYER_GRID:
+            cairo_set_line_width(cr, 0.5 / zoom);
+            draw_grid(cr, r->x1, r->y1, r->x2, r->y2);
+            break;
+
+        case RENDER_LAYER_GRAPH:
+            cairo_set_line_width(cr, 2.0 / zoom);
+            if (graph_model_query(
+                    model, SPATIAL_EDGE, r->x1, r->y1, r->x2, r->y2) == 0)
+                draw_edges(
+                    cr, model->graph, model->spatial_result, model->edge_attrs);
+            if (graph_model_query(
+                    model, SPATIAL_NODE, r->x1, r->y1, r->x2, r->y2) == 0)
+                draw_nodes(
+                    cr,
+                    model->graph,
+                    model->spatial_result,
+                    model->node_attrs,
+                    model->node_in_id,
+                    model->node_out_id);
+            break;
+
+        case RENDER_LAYER_DRAWING:
+            if (graph_model_query(
+                    model, SPATIAL_LINE, r->x1, r->y1, r->x2, r->y2) == 0)
+                draw_drawing(cr, model->drawing, model->spatial_result, zoom);
+            break;
+
+        case RENDER_LAYER_COUNT: break;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Redraws a rectangle of a layer, given in pixels (x2/y2 exclusive) */
+static void redraw_region(
+    struct render_layer* layer,
+    enum render_layer_id id,
+    struct graph_model* model,
+    int x1,
+    int y1,
+    int x2,
+    int y2)
+{
+    cairo_t* cr;
+    struct spatial_rect r;
+
+    if (x1 < layer->x)
+        x1 = layer->x;
+    if (y1 < layer->y)
+        y1 = layer->y;
+    if (x2 > layer->x + layer->width)
+        x2 = layer->x + layer->width;
+    if (y2 > layer->y + layer->height)
+        y2 = layer->y + layer->height;
+    if (x1 >= x2 || y1 >= y2)
+        return;
+
+    cr = cairo_create(layer->surface);
+    cairo_translate(cr, -layer->x, -layer->y);
+    cairo_rectangle(cr, x1, y1, x2 - x1, y2 - y1);
+    cairo_clip(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+    cairo_scale(cr, layer->zoom, layer->zoom);
+
+    /* Every item touching a pixel of the region has to be drawn again, so
+     * round the region outwards */
+    r.x1 = (int)floor(x1 / layer->zoom);
+    r.y1 = (int)floor(y1 / layer->zoom);
+    r.x2 = (int)ceil(x2 / layer->zoom);
+    r.y2 = (int)ceil(y2 / layer->zoom);
+    draw_layer_content(id, cr, model, &r, layer->zoom);
+
+    cairo_destroy(cr);
+}
+
+/* -------------------------------------------------------------------------- */
+static void redraw_dirty(
+    struct render_layer* layer,
+    enum render_layer_id id,
+    struct graph_model* model,
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    int layer_was_drawn)
+{
+    struct spatial_rect r;
+    /* Strokes and anti-aliasing reach a little past the bounding boxes */
+    const int pad = 2;
+    enum spatial_dirty state = spatial_take_dirty(index, kind, &r);
+
+    /* The dirty region still has to be taken if the whole layer was just
+     * drawn, otherwise it would be drawn again next frame */
+    if (layer_was_drawn)
+        return;
+
+    switch (state)
+    {
+        case SPATIAL_CLEAN: break;
+        case SPATIAL_DIRTY_REGION:
+            redraw_region(
+                layer,
+                id,
+                model,
+                (int)floor(r.x1 * layer->zoom) - pad,
+                (int)floor(r.y1 * layer->zoom) - pad,
+                (int)ceil(r.x2 * layer->zoom) + pad + 1,
+                (int)ceil(r.y2 * layer->zoom) + pad + 1);
+            break;
+        case SPATIAL_DIRTY_ALL:
+            redraw_region(
+                layer,
+                id,
+                model,
+                layer->x,
+                layer->y,
+                layer->x + layer->width,
+                layer->y + layer->height);
+            break;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Moves the layer so its top-left pixel is at x,y. The overlapping part of the
+ * old surface is copied and only the strips that were not covered before are
+ * drawn.
+ */
+static int scroll_layer(
+    struct render_layer* layer,
+    enum render_layer_id id,
+    struct graph_model* model,
+    int x,
+    int y)
+{
+    cairo_t* cr;
+    int ox = layer->x, oy = layer->y;
+    int w = layer->width, h = layer->height;
+    int overlap_x1, overlap_x2;
+    cairo_surface_t* surface = cairo_surface_create_similar(
+        layer->surface, CAIRO_CONTENT_COLOR_ALPHA, w, h);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+    {
+        cairo_surface_destroy(surface);
+        return -1;
+    }
+
+    cr = cairo_create(surface);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(cr, layer->surface, ox - x, oy - y);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+
+    cairo_surface_destroy(layer->surface);
+    layer->surface = surface;
+    layer->x       = x;
+    layer->y       = y;
+
+    /* Full-height strips on the left and right */
+    if (x < ox)
+        redraw_region(layer, id, model, x, y, ox, y + h);
+    if (x + w > ox + w)
+        redraw_region(layer, id, model, ox + w, y, x + w, y + h);
+
+    /* Strips at the top and bottom, between the left and right ones */
+    overlap_x1 = x > ox ? x : ox;
+    overlap_x2 = x + w < ox + w ? x + w : ox + w;
+    if (overlap_x1 < overlap_x2)
+    {
+        if (y < oy)
+            redraw_region(layer, id, model, overlap_x1, y, overlap_x2, oy);
+        if (y + h > oy + h)
+            redraw_region(
+                layer, id, model, overlap_x1, oy + h, overlap_x2, y + h);
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Makes sure the layer covers the visible pixels vx,vy,vw,vh.
+ * @return Returns 1 if the layer was drawn completely, 0 if it was reused,
+ * and -1 if the surface could not be created.
+ */
+static int update_layer(
+    struct render_layer* layer,
+    enum render_layer_id id,
+    cairo_t* target,
+    struct graph_model* model,
+    int vx,
+    int vy,
+    int vw,
+    int vh,
+    double zoom)
+{
+    int w = vw + 2 * RENDER_CACHE_MARGIN;
+    int h = vh + 2 * RENDER_CACHE_MARGIN;
+
+    if (layer->surface == NULL || layer->zoom != zoom || layer->width != w ||
+        layer->height != h)
+    {
+        if (layer->surface != NULL)
+            cairo_surface_destroy(layer->surface);
+        layer->surface = cairo_surface_create_similar(
+            cairo_get_target(target), CAIRO_CONTENT_COLOR_ALPHA, w, h);
+        if (cairo_surface_status(layer->surface) != CAIRO_STATUS_SUCCESS)
+        {
+            cairo_surface_destroy(layer->surface);
+            layer->surface = NULL;
+            return -1;
+        }
+
+        layer->x      = vx - RENDER_CACHE_MARGIN;
+        layer->y      = vy - RENDER_CACHE_MARGIN;
+        layer->width  = w;
+        layer->height = h;
+        layer->zoom   = zoom;
+        redraw_region(
+            layer, id, model, layer->x, layer->y, layer->x + w, layer->y + h);
+        return 1;
+    }
+
+    if (vx < layer->x || vy < layer->y || vx + vw > layer->x + w ||
+        vy + vh > layer->y + h)
+    {
+        if (scroll_layer(
+                layer,
+                id,
+                model,
+                vx - RENDER_CACHE_MARGIN,
+                vy - RENDER_CACHE_MARGIN) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void render_cache_init(struct render_cache* cache)
+{
+    int i;
+    for (i = 0; i != RENDER_LAYER_COUNT; ++i)
+    {
+        cache->layers[i].surface = NULL;
+        cache->layers[i].x       = 0;
+        cache->layers[i].y       = 0;
+        cache->layers[i].width   = 0;
+        cache->layers[i].height  = 0;
+        cache->layers[i].zoom    = 0.0;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+void render_cache_deinit(struct render_cache* cache)
+{
+    int i;
+    for (i = 0; i != RENDER_LAYER_COUNT; ++i)
+        if (cache->layers[i].surface != NULL)
+            cairo_surface_destroy(cache->layers[i].surface);
+}
+
+/* -------------------------------------------------------------------------- */
+void render_cache_paint(
+    struct render_cache* cache,
+    cairo_t* cr,
+    struct graph_model* model,
+    int pan_x,
+    int pan_y,
+    double zoom,
+    int width,
+    int height)
+{
+    int i;
+    int drawn[RENDER_LAYER_COUNT];
+    struct render_layer* layer;
+    /* Rebuilding the index marks everything as dirty. Do it before the dirty
+     * regions are taken, not in the middle of drawing a layer */
+    struct spatial_index* index = graph_model_spatial_index(model);
+
+    for (i = 0; i != RENDER_LAYER_COUNT; ++i)
+    {
+        layer = &cache->layers[i];
+        drawn[i] = update_layer(
+            layer, i, cr, model, -pan_x, -pan_y, width, height, zoom);
+    }
+
+    layer = &cache->layers[RENDER_LAYER_GRAPH];
+    drawn[RENDER_LAYER_GRAPH] |= layer->surface == NULL;
+    redraw_dirty(
+        layer,
+        RENDER_LAYER_GRAPH,
+        model,
+        index,
+        SPATIAL_EDGE,
+        drawn[RENDER_LAYER_GRAPH]);
+    redraw_dirty(
+        layer,
+        RENDER_LAYER_GRAPH,
+        model,
+        index,
+        SPATIAL_NODE,
+        drawn[RENDER_LAYER_GRAPH]);
+    layer = &cache->layers[RENDER_LAYER_DRAWING];
+    drawn[RENDER_LAYER_DRAWING] |= layer->surface == NULL;
+    redraw_dirty(
+        layer,
+        RENDER_LAYER_DRAWING,
+        model,
+        index,
+        SPATIAL_LINE,
+        drawn[RENDER_LAYER_DRAWING]);
+
+    for (i = 0; i != RENDER_LAYER_COUNT; ++i)
+    {
+        layer = &cache->layers[i];
+        if (layer->surface == NULL)
+            continue;
+        cairo_set_source_surface(
+            cr, layer->surface, layer->x + pan_x, layer->y + pan_y);
+        cairo_paint(cr);
+    }
+}
@@ -0,0 +1,442 @@
+#include "graph-editor/spatial.h"
+#include <stdlib.h> /* qsort */
+
+VEC_DEFINE(spatial_item_vec, struct spatial_item, 32)
+VEC_DEFINE(spatial_entry_vec, struct spatial_entry, 32)
+VEC_DEFINE(spatial_result_vec, int, 32)
+HMAP_DEFINE(extern, spatial_cell_hmap, uint32_t, int, 32)
+
+/* -------------------------------------------------------------------------- */
+static int cell_coord(int x)
+{
+    /* Rounds towards negative infinity, unlike division */
+    return x >= 0 ? x / SPATIAL_CELL_SIZE
+                  : -((-x - 1) / SPATIAL_CELL_SIZE) - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+static uint32_t cell_key(int cx, int cy)
+{
+    return ((uint32_t)(uint16_t)cx << 16) | (uint16_t)cy;
+}
+
+/* -------------------------------------------------------------------------- */
+static void cells_of(const struct spatial_rect* bb, struct spatial_rect* cells)
+{
+    cells->x1 = cell_coord(bb->x1);
+    cells->y1 = cell_coord(bb->y1);
+    cells->x2 = cell_coord(bb->x2);
+    cells->y2 = cell_coord(bb->y2);
+}
+
+/* -------------------------------------------------------------------------- */
+static double cell_count(const struct spatial_rect* cells)
+{
+    return ((double)cells->x2 - cells->x1 + 1) *
+           ((double)cells->y2 - cells->y1 + 1);
+}
+
+/* -------------------------------------------------------------------------- */
+static int rect_eq(const struct spatial_rect* a, const struct spatial_rect* b)
+{
+    return a->x1 == b->x1 && a->y1 == b->y1 && a->x2 == b->x2 &&
+           a->y2 == b->y2;
+}
+
+/* -------------------------------------------------------------------------- */
+static int overlaps(const struct spatial_rect* a, const struct spatial_rect* b)
+{
+    return a->x1 <= b->x2 && a->x2 >= b->x1 && a->y1 <= b->y2 &&
+           a->y2 >= b->y1;
+}
+
+/* -------------------------------------------------------------------------- */
+void spatial_mark_dirty(
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    const struct spatial_rect* bb)
+{
+    struct spatial_rect* dirty = &index->dirty[kind];
+
+    switch (index->dirty_state[kind])
+    {
+        case SPATIAL_CLEAN:
+            *dirty                   = *bb;
+            index->dirty_state[kind] = SPATIAL_DIRTY_REGION;
+            break;
+        case SPATIAL_DIRTY_REGION:
+            if (dirty->x1 > bb->x1)
+                dirty->x1 = bb->x1;
+            if (dirty->y1 > bb->y1)
+                dirty->y1 = bb->y1;
+            if (dirty->x2 < bb->x2)
+                dirty->x2 = bb->x2;
+            if (dirty->y2 < bb->y2)
+                dirty->y2 = bb->y2;
+            break;
+        case SPATIAL_DIRTY_ALL: break;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+static int alloc_entry(struct spatial_index* index, int item, int next)
+{
+    int e;
+    struct spatial_entry* entry;
+
+    if (index->free_entry > -1)
+    {
+        e                 = index->free_entry;
+        entry             = vec_get(index->entries, e);
+        index->free_entry = entry->next;
+    }
+    else
+    {
+        entry = spatial_entry_vec_emplace(&index->entries);
+        if (entry == NULL)
+            return -1;
+        e = vec_count(index->entries) - 1;
+    }
+
+    entry->item = item;
+    entry->next = next;
+    return e;
+}
+
+/* -------------------------------------------------------------------------- */
+static void unlink_entry(struct spatial_index* index, int* head, int item)
+{
+    int e;
+    struct spatial_entry* entry;
+
+    while (*head > -1)
+    {
+        e     = *head;
+        entry = vec_get(index->entries, e);
+        if (entry->item == item)
+        {
+            *head             = entry->next;
+            entry->next       = index->free_entry;
+            index->free_entry = e;
+            return;
+        }
+        head = &entry->next;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+static void unlink_item(
+    struct spatial_index* index, int item, const struct spatial_item* it)
+{
+    int cx, cy;
+    uint32_t key;
+    int* head;
+
+    if (it->oversize)
+    {
+        unlink_entry(index, &index->oversize_entry, item);
+        return;
+    }
+
+    for (cy = it->cells.y1; cy <= it->cells.y2; ++cy)
+        for (cx = it->cells.x1; cx <= it->cells.x2; ++cx)
+        {
+            key  = cell_key(cx, cy);
+            head = spatial_cell_hmap_find(index->cells, key);
+            if (head == NULL)
+                continue;
+            unlink_entry(index, head, item);
+            if (*head == -1)
+                spatial_cell_hmap_erase(index->cells, key);
+        }
+}
+
+/* -------------------------------------------------------------------------- */
+static int link_item(
+    struct spatial_index* index, int item, const struct spatial_item* it)
+{
+    int cx, cy, e;
+    int* head;
+
+    if (it->oversize)
+    {
+        e = alloc_entry(index, item, index->oversize_entry);
+        if (e < 0)
+            return -1;
+        index->oversize_entry = e;
+        return 0;
+    }
+
+    for (cy = it->cells.y1; cy <= it->cells.y2; ++cy)
+        for (cx = it->cells.x1; cx <= it->cells.x2; ++cx)
+        {
+            switch (spatial_cell_hmap_emplace_or_get(
+                &index->cells, cell_key(cx, cy), &head))
+            {
+                case HMAP_OOM   : return -1;
+                case HMAP_NEW   : *head = -1; break;
+                case HMAP_EXISTS: break;
+            }
+
+            /* Allocating the entry doesn't touch the hashmap, so "head" is
+             * still valid afterwards */
+            e = alloc_entry(index, item, *head);
+            if (e < 0)
+                return -1;
+            *head = e;
+        }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void spatial_init(struct spatial_index* index)
+{
+    int kind;
+
+    spatial_cell_hmap_init(&index->cells);
+    spatial_entry_vec_init(&index->entries);
+    for (kind = 0; kind != SPATIAL_KIND_COUNT; ++kind)
+    {
+        spatial_item_vec_init(&index->items[kind]);
+        index->dirty[kind].x1 = index->dirty[kind].x2 = 0;
+        index->dirty[kind].y1 = index->dirty[kind].y2 = 0;
+    }
+
+    index->free_entry     = -1;
+    index->oversize_entry = -1;
+    index->stamp          = 0;
+
+    spatial_mark_all_dirty(index);
+}
+
+/* -------------------------------------------------------------------------- */
+void spatial_deinit(struct spatial_index* index)
+{
+    int kind;
+
+    for (kind = 0; kind != SPATIAL_KIND_COUNT; ++kind)
+        spatial_item_vec_deinit(index->items[kind]);
+    spatial_entry_vec_deinit(index->entries);
+    spatial_cell_hmap_deinit(index->cells);
+}
+
+/* -------------------------------------------------------------------------- */
+void spatial_clear(struct spatial_index* index)
+{
+    int kind;
+
+    for (kind = 0; kind != SPATIAL_KIND_COUNT; ++kind)
+        spatial_item_vec_clear(index->items[kind]);
+    spatial_entry_vec_clear(index->entries);
+    spatial_cell_hmap_clear(index->cells);
+
+    index->free_entry     = -1;
+    index->oversize_entry = -1;
+
+    spatial_mark_all_dirty(index);
+}
+
+/* -------------------------------------------------------------------------- */
+int spatial_count(const struct spatial_index* index, enum spatial_kind kind)
+{
+    return vec_count(index->items[kind]);
+}
+
+/* -------------------------------------------------------------------------- */
+int spatial_set(
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    int idx,
+    const struct spatial_rect* bb)
+{
+    struct spatial_item* it;
+    struct spatial_rect cells;
+    int oversize;
+    int item = idx * SPATIAL_KIND_COUNT + kind;
+
+    while (vec_count(index->items[kind]) <= idx)
+    {
+        it = spatial_item_vec_emplace(&index->items[kind]);
+        if (it == NULL)
+            return -1;
+        it->stamp    = 0;
+        it->present  = 0;
+        it->oversize = 0;
+    }
+
+    cells_of(bb, &cells);
+    oversize = cell_count(&cells) > SPATIAL_MAX_ITEM_CELLS;
+
+    it = vec_get(index->items[kind], idx);
+    if (it->present && rect_eq(bb, &it->bb))
+        return 0;
+
+    if (it->present)
+        spatial_mark_dirty(index, kind, &it->bb);
+    spatial_mark_dirty(index, kind, bb);
+
+    if (it->present)
+    {
+        if ((oversize && it->oversize) ||
+            (!oversize && !it->oversize && rect_eq(&cells, &it->cells)))
+        {
+            it->bb    = *bb;
+            it->cells = cells;
+            return 0;
+        }
+        unlink_item(index, item, it);
+    }
+
+    it->bb       = *bb;
+    it->cells    = cells;
+    it->present  = 1;
+    it->oversize = oversize;
+    if (link_item(index, item, it) != 0)
+    {
+        unlink_item(index, item, it);
+        it->present = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void spatial_remove(
+    struct spatial_index* index, enum spatial_kind kind, int idx)
+{
+    struct spatial_item* it;
+
+    if (idx >= vec_count(index->items[kind]))
+        return;
+
+    it = vec_get(index->items[kind], idx);
+    if (it->present)
+    {
+        spatial_mark_dirty(index, kind, &it->bb);
+        unlink_item(index, idx * SPATIAL_KIND_COUNT + kind, it);
+    }
+    it->present = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void spatial_mark_all_dirty(struct spatial_index* index)
+{
+    int kind;
+    for (kind = 0; kind != SPATIAL_KIND_COUNT; ++kind)
+        index->dirty_state[kind] = SPATIAL_DIRTY_ALL;
+}
+
+/* -------------------------------------------------------------------------- */
+enum spatial_dirty spatial_take_dirty(
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    struct spatial_rect* rect)
+{
+    enum spatial_dirty state = index->dirty_state[kind];
+
+    *rect                    = index->dirty[kind];
+    index->dirty_state[kind] = SPATIAL_CLEAN;
+
+    return state;
+}
+
+/* -------------------------------------------------------------------------- */
+static int visit_list(
+    struct spatial_index* index,
+    int e,
+    enum spatial_kind kind,
+    const struct spatial_rect* rect,
+    struct spatial_result_vec** result)
+{
+    int idx;
+    const struct spatial_entry* entry;
+    struct spatial_item* it;
+
+    for (; e > -1; e = entry->next)
+    {
+        entry = vec_get(index->entries, e);
+        if (entry->item % SPATIAL_KIND_COUNT != (int)kind)
+            continue;
+
+        /* Items are linked into every cell they overlap */
+        idx = entry->item / SPATIAL_KIND_COUNT;
+        it  = vec_get(index->items[kind], idx);
+        if (it->stamp == index->stamp)
+            continue;
+        it->stamp = index->stamp;
+
+        if (overlaps(&it->bb, rect))
+            if (spatial_result_vec_push(result, idx) != 0)
+                return -1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static int cmp_idx(const void* a, const void* b)
+{
+    return *(const int*)a - *(const int*)b;
+}
+
+/* -------------------------------------------------------------------------- */
+int spatial_query(
+    struct spatial_index* index,
+    enum spatial_kind kind,
+    const struct spatial_rect* rect,
+    struct spatial_result_vec** result)
+{
+    struct spatial_rect cells;
+    struct spatial_item* it;
+    int slot, cx, cy, k;
+    uint32_t key;
+    int* head;
+
+    spatial_result_vec_clear(*result);
+
+    if (++index->stamp == 0)
+    {
+        for (k = 0; k != SPATIAL_KIND_COUNT; ++k)
+            vec_for_each (index->items[k], it)
+                it->stamp = 0;
+        index->stamp = 1;
+    }
+
+    /* When zoomed out, the view can cover more cells than are occupied */
+    cells_of(rect, &cells);
+    if (cell_count(&cells) > hmap_count(index->cells))
+    {
+        hmap_for_each (index->cells, slot, key, head)
+        {
+            cx = (int16_t)(key >> 16);
+            cy = (int16_t)(key & 0xFFFF);
+            if (cx >= cells.x1 && cx <= cells.x2 && cy >= cells.y1 &&
+                cy <= cells.y2)
+            {
+                if (visit_list(index, *head, kind, rect, result) != 0)
+                    return -1;
+            }
+        }
+    }
+    else
+    {
+        for (cy = cells.y1; cy <= cells.y2; ++cy)
+            for (cx = cells.x1; cx <= cells.x2; ++cx)
+            {
+                head = spatial_cell_hmap_find(index->cells, cell_key(cx, cy));
+                if (head != NULL)
+                    if (visit_list(index, *head, kind, rect, result) != 0)
+                        return -1;
+            }
+    }
+
+    if (visit_list(index, index->oversize_entry, kind, rect, result) != 0)
+        return -1;
+
+    if (vec_count(*result) > 1)
+        qsort((*result)->data, (*result)->count, sizeof(int), cmp_idx);
+
+    return 0;
+}
@@ -1,28 +1,19 @@
+#include "csfg/io/delta.h"
 #include "csfg/io/deserialize.h"
 #include "csfg/io/io.h"
 #include "csfg/io/serialize.h"
+#include "csfg/util/log.h"
 #include "graph-editor/attr.h"
 #include "graph-editor/drawing.h"
 #include "graph-editor/graph_helpers.h"
 #include "graph-editor/graph_model.h"
 #include "graph-editor/undo.h"
 
-VEC_DEFINE(undo_stack_vec, struct serializer*, 32)
+VEC_DEFINE(undo_stack_vec, struct undo_entry, 32)
 
 /* -------------------------------------------------------------------------- */
-int undo_push_state(struct graph_model* model)
+static int snapshot(struct serializer** ser, const struct graph_model* model)
 {
-    struct serializer** ser;
-
-    /* destroy future */
-    while (vec_count(model->undo_stack) - 1 > model->undo_stack_ptr)
-        serializer_deinit(*undo_stack_vec_pop(model->undo_stack));
-
-    ser = undo_stack_vec_emplace(&model->undo_stack);
-    if (ser == NULL)
-        return -1;
-    serializer_init(ser);
-
     if (csfg_io_graph_save(
             ser,
             model->graph,
@@ -31,115 +22,326 @@ int undo_push_state(struct graph_model* model)
         attrs_save(ser, model->node_attrs, model->edge_attrs, model->graph) !=
             0 ||
         drawing_save(ser, model->drawing, model->graph) != 0)
-    {
-        serializer_deinit(*undo_stack_vec_pop(model->undo_stack));
         return -1;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static int restore(struct graph_model* model, const struct serializer* state)
+{
+    int node_in, node_out;
+    struct deserializer des = deserializer(vec_data(state), vec_count(state));
+
+    if (csfg_io_graph_load(&des, model->graph, &node_in, &node_out) != 0)
+        return -1;
+    graph_model_rebuild_graph(model, node_in, node_out);
+    if (attrs_load(
+            &des, &model->node_attrs, &model->edge_attrs, model->graph) != 0)
+        return -1;
+    if (drawing_load(&des, &model->drawing, model->graph) != 0)
+        return -1;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*!
+ * @brief Reconstructs the snapshot of a state by applying the deltas since
+ * the previous keyframe.
+ */
+static int reconstruct(
+    const struct undo_stack_vec* stack, int idx, struct serializer** out)
+{
+    struct serializer* tmp;
+    int i = idx;
+
+    while (!vec_get(stack, i)->keyframe)
+        i--;
+
+    serializer_clear(*out);
+    if (serialize_data(
+            out,
+            vec_data(vec_get(stack, i)->data),
+            vec_count(vec_get(stack, i)->data)) != 0)
+        return -1;
+
+    serializer_init(&tmp);
+    for (i = i + 1; i <= idx; ++i)
+    {
+        const struct serializer* delta = vec_get(stack, i)->data;
+        serializer_clear(tmp);
+        if (delta_apply(
+                &tmp,
+                vec_data(*out),
+                vec_count(*out),
+                vec_data(delta),
+                vec_count(delta)) != 0)
+            goto fail;
+        serializer_swap(out, &tmp);
     }
+    serializer_deinit(tmp);
 
-    model->undo_stack_ptr++;
     return 0;
+
+fail:
+    serializer_deinit(tmp);
+    return -1;
 }
 
 /* -------------------------------------------------------------------------- */
-int undo(struct graph_model* model)
+static void pop_entry(struct graph_model* model)
 {
-    int node_in, node_out;
-    struct serializer* ser;
-    struct deserializer des;
+    struct undo_entry* entry = undo_stack_vec_pop(model->undo_stack);
+    serializer_deinit(entry->data);
+}
 
-    if (model->undo_stack_ptr > 0)
+/* -------------------------------------------------------------------------- */
+/*!
+ * @brief Discards the oldest state. If the next state is a delta, it is
+ * turned into a keyframe first.
+ */
+static int drop_oldest(struct graph_model* model)
+{
+    struct undo_entry* next = vec_get(model->undo_stack, 1);
+    if (!next->keyframe)
     {
-        ser = *vec_get(model->undo_stack, model->undo_stack_ptr - 1);
-        des = deserializer(vec_data(ser), vec_count(ser));
-        if (csfg_io_graph_load(&des, model->graph, &node_in, &node_out) != 0)
-            return -1;
-        graph_model_rebuild_graph(model, node_in, node_out);
-        if (attrs_load(
-                &des, &model->node_attrs, &model->edge_attrs, model->graph) !=
-            0)
-            return -1;
-        if (drawing_load(&des, &model->drawing, model->graph) != 0)
+        struct serializer* state;
+        serializer_init(&state);
+        if (reconstruct(model->undo_stack, 1, &state) != 0)
+        {
+            serializer_deinit(state);
             return -1;
-        model->undo_stack_ptr--;
+        }
+
+        next = vec_get(model->undo_stack, 1);
+        serializer_deinit(next->data);
+        next->data     = state;
+        next->keyframe = 1;
     }
 
+    serializer_deinit(vec_get(model->undo_stack, 0)->data);
+    undo_stack_vec_erase(model->undo_stack, 0);
+    model->undo_stack_ptr--;
+
     return 0;
 }
 
 /* -------------------------------------------------------------------------- */
-int redo(struct graph_model* model)
+int undo_push_state(struct graph_model* model)
 {
-    int node_in, node_out;
-    struct serializer* ser;
-    struct deserializer des;
+    struct undo_entry* entry;
+    struct serializer* state;
+    struct serializer* delta;
+    int i, deltas;
 
-    if (model->undo_stack_ptr + 1 < vec_count(model->undo_stack))
+    /* destroy future */
+    while (vec_count(model->undo_stack) - 1 > model->undo_stack_ptr)
+        pop_entry(model);
+
+    serializer_init(&state);
+    serializer_init(&delta);
+    if (snapshot(&state, model) != 0)
+        goto fail;
+
+    deltas = 0;
+    for (i = model->undo_stack_ptr; i >= 0; --i, ++deltas)
+        if (vec_get(model->undo_stack, i)->keyframe)
+            break;
+
+    entry = undo_stack_vec_emplace(&model->undo_stack);
+    if (entry == NULL)
+        goto fail;
+
+    /* Deltas are computed against the snapshot of the current state, which is
+     * kept around, so pushing a state costs O(graph size) time, but only
+     * O(change) memory */
+    entry->keyframe = 1;
+    if (model->undo_stack_ptr >= 0 && deltas < UNDO_KEYFRAME_INTERVAL)
     {
-        ser = *vec_get(model->undo_stack, model->undo_stack_ptr + 1);
-        des = deserializer(vec_data(ser), vec_count(ser));
-        if (csfg_io_graph_load(&des, model->graph, &node_in, &node_out) != 0)
-            return -1;
-        graph_model_rebuild_graph(model, node_in, node_out);
-        if (attrs_load(
-                &des, &model->node_attrs, &model->edge_attrs, model->graph) !=
-            0)
-            return -1;
-        if (drawing_load(&des, &model->drawing, model->graph) != 0)
-            return -1;
-        model->undo_stack_ptr++;
+        if (delta_encode(
+                &delta,
+                vec_data(model->undo_state),
+                vec_count(model->undo_state),
+                vec_data(state),
+                vec_count(state)) != 0)
+        {
+            undo_stack_vec_pop(model->undo_stack);
+            goto fail;
+        }
+        entry->keyframe = vec_count(delta) * 2 > vec_count(state);
     }
 
+    if (entry->keyframe)
+    {
+        serializer_clear(delta);
+        if (serialize_data(&delta, vec_data(state), vec_count(state)) != 0)
+        {
+            undo_stack_vec_pop(model->undo_stack);
+            goto fail;
+        }
+    }
+    serializer_compact(&delta);
+    entry->data = delta;
+
+    serializer_deinit(model->undo_state);
+    model->undo_state = state;
+    model->undo_stack_ptr++;
+
+    while (vec_count(model->undo_stack) > 1 &&
+           undo_stack_memory(model) > UNDO_MEMORY_BUDGET)
+        if (drop_oldest(model) != 0)
+            break;
+
+    return 0;
+
+fail:
+    serializer_deinit(delta);
+    serializer_deinit(state);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+static int goto_state(struct graph_model* model, int idx)
+{
+    struct serializer* state;
+
+    serializer_init(&state);
+    if (reconstruct(model->undo_stack, idx, &state) != 0)
+    {
+        serializer_deinit(state);
+        return -1;
+    }
+
+    serializer_swap(&model->undo_state, &state);
+    serializer_deinit(state);
+    model->undo_stack_ptr = idx;
+
+    return restore(model, model->undo_state);
+}
+
+/* -------------------------------------------------------------------------- */
+int undo(struct graph_model* model)
+{
+    if (model->undo_stack_ptr > 0)
+        return goto_state(model, model->undo_stack_ptr - 1);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int redo(struct graph_model* model)
+{
+    if (model->undo_stack_ptr + 1 < vec_count(model->undo_stack))
+        return goto_state(model, model->undo_stack_ptr + 1);
     return 0;
 }
 
 /* -------------------------------------------------------------------------- */
 int undo_save_stack(struct serializer** ser, const struct graph_model* model)
 {
-    struct serializer* const* state;
+    const struct undo_entry* entry;
     int err = 0;
 
     if (model->graph == NULL)
         return 0;
 
-    err += serialize_lu16(ser, vec_count(model->undo_stack));
-    err += serialize_lu16(ser, model->undo_stack_ptr);
-    vec_for_each (model->undo_stack, state)
+    err += serialize_lu32(ser, vec_count(model->undo_stack));
+    err += serialize_li32(ser, model->undo_stack_ptr);
+    vec_for_each (model->undo_stack, entry)
     {
-        err += serialize_lu16(ser, vec_count(*state));
-        err += serialize_data(ser, vec_data(*state), vec_count(*state));
+        err += serialize_u8(ser, entry->keyframe);
+        err += serialize_lu32(ser, vec_count(entry->data));
+        err +=
+            serialize_data(ser, vec_data(entry->data), vec_count(entry->data));
     }
 
     return err;
 }
 
 /* -------------------------------------------------------------------------- */
-int undo_load_stack(struct deserializer* des, struct graph_model* model)
+static int load_0(struct deserializer* des, struct graph_model* model)
 {
     int state_count, state_size;
-    struct serializer** state;
-
-    if (model->graph == NULL)
-        return 0;
-
-    undo_clear_stack(model);
+    struct undo_entry* entry;
 
+    /* Every state is a full snapshot */
     state_count           = deserialize_lu16(des);
     model->undo_stack_ptr = deserialize_lu16(des);
     while (state_count-- > 0)
     {
         state_size = deserialize_lu16(des);
-        state      = undo_stack_vec_emplace(&model->undo_stack);
-        if (state == NULL)
+        if (state_size > deserializer_bytes_left(des))
+            return log_err("Undo state is truncated\n");
+
+        entry = undo_stack_vec_emplace(&model->undo_stack);
+        if (entry == NULL)
             return -1;
-        serializer_init(state);
-        if (serializer_realloc(state, state_size) != 0)
+        entry->keyframe = 1;
+        serializer_init(&entry->data);
+        if (serialize_data(
+                &entry->data, deserialize_data1(des, state_size), state_size) !=
+            0)
             return -1;
-        deserialize_data2(des, vec_data(*state), state_size);
-        (*state)->count = state_size;
+    }
+
+    return 0;
+}
+static int load_1(struct deserializer* des, struct graph_model* model)
+{
+    int state_count, state_size;
+    struct undo_entry* entry;
+
+    state_count           = (int)deserialize_lu32(des);
+    model->undo_stack_ptr = deserialize_li32(des);
+    if (state_count < 0 || state_count > deserializer_bytes_left(des) / 5)
+        return log_err("Undo stack has an implausible size: %d\n", state_count);
+
+    while (state_count-- > 0)
+    {
+        entry = undo_stack_vec_emplace(&model->undo_stack);
+        if (entry == NULL)
+            return -1;
+        entry->keyframe = deserialize_u8(des);
+        state_size      = (int)deserialize_lu32(des);
+        serializer_init(&entry->data);
+        if (state_size < 0 || state_size > deserializer_bytes_left(des))
+            return log_err("Undo state is truncated\n");
+        if (serialize_data(
+                &entry->data, deserialize_data1(des, state_size), state_size) !=
+            0)
+            return -1;
+    }
+
+    if (vec_count(model->undo_stack) > 0 &&
+        !vec_first(model->undo_stack)->keyframe)
+        return log_err("First undo state is not a keyframe\n");
+
+    return 0;
+}
+int undo_load_stack(
+    struct deserializer* des, struct graph_model* model, int version)
+{
+    if (model->graph == NULL)
+        return 0;
+
+    undo_clear_stack(model);
+
+    if ((version == 0 ? load_0(des, model) : load_1(des, model)) != 0)
+    {
+        undo_clear_stack(model);
+        return -1;
     }
 
     if (model->undo_stack_ptr > vec_count(model->undo_stack) - 1)
         model->undo_stack_ptr = vec_count(model->undo_stack) - 1;
+    if (model->undo_stack_ptr < 0 && vec_count(model->undo_stack) > 0)
+        model->undo_stack_ptr = 0;
+    if (model->undo_stack_ptr >= 0 &&
+        reconstruct(
+            model->undo_stack, model->undo_stack_ptr, &model->undo_state) != 0)
+    {
+        undo_clear_stack(model);
+        return -1;
+    }
 
     return 0;
 }
@@ -148,7 +350,8 @@ int undo_load_stack(struct deserializer* des, struct graph_model* model)
 void undo_clear_stack(struct graph_model* model)
 {
     while (vec_count(model->undo_stack))
-        serializer_deinit(*undo_stack_vec_pop(model->undo_stack));
+        pop_entry(model);
+    serializer_clear(model->undo_state);
     model->undo_stack_ptr = -1;
 }
 
@@ -158,3 +361,13 @@ void undo_reinit_stack(struct graph_model* model)
     undo_clear_stack(model);
     undo_push_state(model);
 }
+
+/* -------------------------------------------------------------------------- */
+int undo_stack_memory(const struct graph_model* model)
+{
+    const struct undo_entry* entry;
+    int bytes = vec_capacity(model->undo_state);
+    vec_for_each (model->undo_stack, entry)
+        bytes += vec_capacity(entry->data);
+    return bytes;
+}
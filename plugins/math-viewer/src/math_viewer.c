@@ -1,6 +1,8 @@
 #include "csfg/symbolic/expr.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/tf_expr.h"
 #include "csfg/util/str.h"
+#include "csfg/util/text_cache.h"
 #include "math-viewer/math_viewer.h"
 
 #if 0
@@ -9,18 +11,6 @@
 #    include FT_FREETYPE_H
 #endif
 
-struct _MathViewer
-{
-    GtkBox parent_instance;
-    GtkWidget* drawing_area;
-
-    const struct csfg_tf_expr* tf;
-    const struct csfg_expr_pool* pool;
-    int expr;
-};
-
-G_DEFINE_DYNAMIC_TYPE(MathViewer, math_viewer, GTK_TYPE_BOX)
-
 enum csfg_layout_type
 {
     CSFG_LAYOUT_LIT,
@@ -31,6 +21,7 @@ enum csfg_layout_type
     CSFG_LAYOUT_SUB,
     CSFG_LAYOUT_MUL,
     CSFG_LAYOUT_FRAC,
+    CSFG_LAYOUT_POW,
     CSFG_LAYOUT_PARENS
 };
 
@@ -40,7 +31,7 @@ struct csfg_layout_node
     {
         struct
         {
-            float lit;
+            double lit;
         };
 
         struct
@@ -82,9 +73,54 @@ struct csfg_layout
     struct str* str;
 };
 
+/* Region of the layout that is visible, in the coordinates passed to
+ * csfg_expr_draw() */
+struct csfg_layout_clip
+{
+    double x1, y1, x2, y2;
+};
+
 static const char utf8_infinity[] = {0xE2, 0x88, 0x9E, 0x00};
 static const char utf8_cdot[]     = {0xC2, 0xB7, 0x00};
 
+#define FONT_SIZE       32
+#define CONTENT_PADDING 10
+/* Extra pixels rendered on each side of the view, so small scrolls don't
+ * have to draw the expression again */
+#define SURFACE_MARGIN 256
+
+struct _MathViewer
+{
+    GtkBox parent_instance;
+    GtkWidget* drawing_area;
+
+    const struct csfg_tf_expr* tf;
+    const struct csfg_expr_pool* pool;
+    int expr;
+
+    /* Laid out on the first draw after the expression changes. The layout
+     * copies everything it needs, so "pool" is not accessed again until the
+     * next change */
+    struct csfg_layout layout;
+    int layout_root;
+    struct str* tf_num;
+    struct str* tf_den;
+    int content_width, content_height;
+
+    /* The expression rendered at the current scroll position plus a margin */
+    cairo_surface_t* surface;
+    int surface_x, surface_y;
+    int surface_width, surface_height;
+
+    int scroll_x, scroll_y;
+    int scroll_begin_x, scroll_begin_y;
+
+    unsigned layout_valid  : 1;
+    unsigned surface_valid : 1;
+};
+
+G_DEFINE_DYNAMIC_TYPE(MathViewer, math_viewer, GTK_TYPE_BOX)
+
 /* -------------------------------------------------------------------------- */
 static int imax(int a, int b)
 {
@@ -230,6 +266,90 @@ static int new_node_frac(
     return n;
 }
 
+static int new_node_neg(struct csfg_layout_vec** nodes, int op_adv_x, int child)
+{
+    int n;
+    if (child < 0)
+        return -1;
+    n = new_node(
+        nodes,
+        CSFG_LAYOUT_NEG,
+        op_adv_x + vec_get(*nodes, child)->adv_x,
+        vec_get(*nodes, child)->height,
+        0);
+    if (n < 0)
+        return -1;
+
+    vec_get(*nodes, n)->child[0] = child;
+
+    return n;
+}
+static int new_node_pow(struct csfg_layout_vec** nodes, int base, int exp)
+{
+    int n;
+    if (base < 0 || exp < 0)
+        return -1;
+    n = new_node(
+        nodes,
+        CSFG_LAYOUT_POW,
+        vec_get(*nodes, base)->adv_x + vec_get(*nodes, exp)->adv_x,
+        vec_get(*nodes, base)->height + vec_get(*nodes, exp)->height / 2,
+        0);
+    if (n < 0)
+        return -1;
+
+    vec_get(*nodes, n)->child[0] = base;
+    vec_get(*nodes, n)->child[1] = exp;
+
+    return n;
+}
+
+/* -------------------------------------------------------------------------- */
+static void csfg_layout_init(struct csfg_layout* layout)
+{
+    csfg_layout_vec_init(&layout->nodes);
+    str_init(&layout->str);
+}
+
+/* -------------------------------------------------------------------------- */
+static void csfg_layout_deinit(struct csfg_layout* layout)
+{
+    str_deinit(layout->str);
+    csfg_layout_vec_deinit(layout->nodes);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Measuring text through cairo is the slowest part of laying out, and the
+ * same identifiers and operators appear over and over */
+static struct text_extents measure(const char* cstr, cairo_t* cr)
+{
+    cairo_matrix_t font_matrix;
+    cairo_text_extents_t text_ext;
+    struct text_extents ext;
+    const struct text_extents* cached = NULL;
+    struct text_cache* cache          = text_cache_shared();
+    struct strview font               = cstr_view(
+        cairo_toy_font_face_get_family(cairo_get_font_face(cr)));
+
+    cairo_get_font_matrix(cr, &font_matrix);
+    if (cache != NULL)
+        cached =
+            text_cache_find(cache, font, font_matrix.xx, cstr_view(cstr));
+    if (cached != NULL)
+        return *cached;
+
+    cairo_text_extents(cr, cstr, &text_ext);
+    ext.x_advance = text_ext.x_advance;
+    ext.width     = text_ext.width;
+    ext.height    = text_ext.height;
+
+    /* Not being able to cache the result is not an error */
+    if (cache != NULL)
+        text_cache_insert(cache, font, font_matrix.xx, cstr_view(cstr), &ext);
+
+    return ext;
+}
+
 /* -------------------------------------------------------------------------- */
 static int layout_recurse(
     struct csfg_layout* layout,
@@ -237,15 +357,20 @@ static int layout_recurse(
     int expr,
     cairo_t* cr);
 
+static int layout_parens(struct csfg_layout* layout, int child, cairo_t* cr)
+{
+    return new_node_parens(&layout->nodes, measure("(", cr).x_advance, child);
+}
+
 static int layout_lit(struct csfg_layout* layout, double value, cairo_t* cr)
 {
-    cairo_text_extents_t ext;
+    struct text_extents ext;
     int n;
 
     str_clear(layout->str);
     if (str_append_float(&layout->str, value) != 0)
         return -1;
-    cairo_text_extents(cr, str_cstr(layout->str), &ext);
+    ext = measure(str_cstr(layout->str), cr);
 
     n = new_node(&layout->nodes, CSFG_LAYOUT_LIT, ext.x_advance, ext.height, 0);
     if (n < 0)
@@ -256,31 +381,31 @@ static int layout_lit(struct csfg_layout* layout, double value, cairo_t* cr)
     return n;
 }
 
-static int layout_var(
-    struct csfg_layout* layout,
-    const struct csfg_expr_pool* pool,
-    int var_idx,
-    cairo_t* cr)
+static int layout_var(struct csfg_layout* layout, int var_idx, cairo_t* cr)
 {
-    cairo_text_extents_t ext;
-    const char* cstr = strlist_cstr(pool->var_names, var_idx);
-    cairo_text_extents(cr, cstr, &ext);
+    struct text_extents ext = measure(csfg_symbol_cstr(var_idx), cr);
     return new_node_var(&layout->nodes, ext.x_advance, ext.height, var_idx);
 }
 
 static int layout_inf(struct csfg_layout* layout, cairo_t* cr)
 {
-    cairo_text_extents_t ext;
-    cairo_text_extents(cr, utf8_infinity, &ext);
+    struct text_extents ext = measure(utf8_infinity, cr);
     return new_node(
         &layout->nodes, CSFG_LAYOUT_INF, ext.x_advance, ext.height, 0);
 }
 
-static int layout_neg(struct csfg_layout* layout, cairo_t* cr)
+static int layout_neg(
+    struct csfg_layout* layout,
+    const struct csfg_expr_pool* pool,
+    int child,
+    cairo_t* cr)
 {
-    cairo_text_extents_t ext;
-    cairo_text_extents(cr, "-", &ext);
-    return new_node(&layout->nodes, CSFG_LAYOUT_NEG, ext.width, ext.height, 0);
+    int need_parens = (pool->nodes[child].type == CSFG_EXPR_ADD);
+    child           = layout_recurse(layout, pool, child, cr);
+    if (need_parens)
+        child = layout_parens(layout, child, cr);
+
+    return new_node_neg(&layout->nodes, measure("-", cr).width, child);
 }
 
 static int layout_sub(
@@ -290,18 +415,15 @@ static int layout_sub(
     int right,
     cairo_t* cr)
 {
-    cairo_text_extents_t ext;
+    struct text_extents ext;
     int need_parens = (pool->nodes[right].type == CSFG_EXPR_ADD);
     left            = layout_recurse(layout, pool, left, cr);
     right           = layout_recurse(layout, pool, right, cr);
 
     if (need_parens)
-    {
-        cairo_text_extents(cr, "(", &ext);
-        right = new_node_parens(&layout->nodes, ext.x_advance, right);
-    }
+        right = layout_parens(layout, right, cr);
 
-    cairo_text_extents(cr, "-", &ext);
+    ext = measure("-", cr);
     return new_node_binop(
         &layout->nodes,
         CSFG_LAYOUT_SUB,
@@ -318,14 +440,14 @@ static int layout_add(
     int right,
     cairo_t* cr)
 {
-    cairo_text_extents_t ext;
+    struct text_extents ext;
     if (pool->nodes[right].type == CSFG_EXPR_NEG)
         return layout_sub(layout, pool, left, pool->nodes[right].child[0], cr);
 
     left  = layout_recurse(layout, pool, left, cr);
     right = layout_recurse(layout, pool, right, cr);
 
-    cairo_text_extents(cr, "+", &ext);
+    ext = measure("+", cr);
     return new_node_binop(
         &layout->nodes,
         CSFG_LAYOUT_ADD,
@@ -362,17 +484,17 @@ static int layout_mul(
     int right,
     cairo_t* cr)
 {
-    cairo_text_extents_t ext;
+    struct text_extents ext;
     int need_lparens, need_rparens;
 
     if (pool->nodes[right].type == CSFG_EXPR_POW)
     {
         int exp = pool->nodes[right].child[1];
         if (pool->nodes[exp].type == CSFG_EXPR_LIT &&
-            pool->nodes[exp].value.lit < 0.0)
+            csfg_expr_lit_value(pool, exp) < 0.0)
         {
             int base         = pool->nodes[right].child[0];
-            double exp_value = pool->nodes[exp].value.lit;
+            double exp_value = csfg_expr_lit_value(pool, exp);
             return layout_frac(layout, pool, left, base, exp_value, cr);
         }
     }
@@ -384,20 +506,42 @@ static int layout_mul(
     right = layout_recurse(layout, pool, right, cr);
 
     if (need_lparens)
-    {
-        cairo_text_extents(cr, "(", &ext);
-        left = new_node_parens(&layout->nodes, ext.x_advance, left);
-    }
+        left = layout_parens(layout, left, cr);
     if (need_rparens)
-    {
-        cairo_text_extents(cr, "(", &ext);
-        right = new_node_parens(&layout->nodes, ext.x_advance, right);
-    }
+        right = layout_parens(layout, right, cr);
 
-    cairo_text_extents(cr, utf8_cdot, &ext);
+    ext = measure(utf8_cdot, cr);
     return new_node_mul(&layout->nodes, ext.x_advance, ext.height, left, right);
 }
 
+static int layout_pow(
+    struct csfg_layout* layout,
+    const struct csfg_expr_pool* pool,
+    int left,
+    int right,
+    cairo_t* cr)
+{
+    int need_lparens = 0, need_rparens = 0;
+
+    if (pool->nodes[left].type == CSFG_EXPR_MUL ||
+        pool->nodes[left].type == CSFG_EXPR_ADD)
+        need_lparens = 1;
+    if (pool->nodes[right].type == CSFG_EXPR_MUL ||
+        pool->nodes[right].type == CSFG_EXPR_ADD)
+        need_rparens = 1;
+
+    left  = layout_recurse(layout, pool, left, cr);
+    right = layout_recurse(layout, pool, right, cr);
+    if (left < 0 || right < 0)
+        return -1;
+    if (need_lparens)
+        left = layout_parens(layout, left, cr);
+    if (need_rparens)
+        right = layout_parens(layout, right, cr);
+
+    return new_node_pow(&layout->nodes, left, right);
+}
+
 /* -------------------------------------------------------------------------- */
 static int layout_recurse(
     struct csfg_layout* layout,
@@ -405,20 +549,17 @@ static int layout_recurse(
     int expr,
     cairo_t* cr)
 {
-    int left, right, need_lparens, need_rparens;
-    cairo_text_extents_t ext;
-
     enum csfg_expr_type type = pool->nodes[expr].type;
     switch (type)
     {
         case CSFG_EXPR_GC: CSFG_DEBUG_ASSERT(0); return -1;
         case CSFG_EXPR_LIT:
-            return layout_lit(layout, pool->nodes[expr].value.lit, cr);
+            return layout_lit(layout, csfg_expr_lit_value(pool, expr), cr);
         case CSFG_EXPR_VAR:
-            return layout_var(
-                layout, pool, pool->nodes[expr].value.var_idx, cr);
+            return layout_var(layout, pool->nodes[expr].value, cr);
         case CSFG_EXPR_INF: return layout_inf(layout, cr);
-        case CSFG_EXPR_NEG: return layout_neg(layout, cr);
+        case CSFG_EXPR_NEG:
+            return layout_neg(layout, pool, pool->nodes[expr].child[0], cr);
         case CSFG_EXPR_ADD:
             return layout_add(
                 layout,
@@ -434,31 +575,12 @@ static int layout_recurse(
                 pool->nodes[expr].child[1],
                 cr);
         case CSFG_EXPR_POW:
-            left  = pool->nodes[expr].child[0];
-            right = pool->nodes[expr].child[1];
-
-            if (pool->nodes[left].type == CSFG_EXPR_MUL ||
-                pool->nodes[left].type == CSFG_EXPR_ADD)
-                need_lparens = 1;
-            if (pool->nodes[right].type == CSFG_EXPR_MUL ||
-                pool->nodes[right].type == CSFG_EXPR_ADD)
-                need_rparens = 1;
-
-            left  = layout_recurse(layout, pool, left, cr);
-            right = layout_recurse(layout, pool, right, cr);
-            if (left < 0 || right < 0)
-                return -1;
-            if (need_lparens)
-            {
-                cairo_text_extents(cr, "(", &ext);
-                left = new_node_parens(&layout->nodes, ext.x_advance, left);
-            }
-            if (need_rparens)
-            {
-                cairo_text_extents(cr, "(", &ext);
-                right = new_node_parens(&layout->nodes, ext.x_advance, right);
-            }
-            break;
+            return layout_pow(
+                layout,
+                pool,
+                pool->nodes[expr].child[0],
+                pool->nodes[expr].child[1],
+                cr);
     }
 
     return -1;
@@ -471,22 +593,33 @@ int csfg_expr_layout(
     int expr,
     cairo_t* cr)
 {
+    csfg_layout_vec_clear(layout->nodes);
     return layout_recurse(layout, pool, expr, cr);
 }
 
 /* -------------------------------------------------------------------------- */
-int csfg_expr_draw(
+static int draw_recurse(
     struct csfg_layout* layout,
-    const struct csfg_expr_pool* pool,
     int n,
     int x,
     int y,
+    const struct csfg_layout_clip* clip,
     cairo_t* cr)
 {
     enum csfg_layout_type type;
     int baseline, var_idx, left, right, num, den;
     const char* cstr;
 
+    /* A node's content lies within its height above and below the point it
+     * is drawn at. Skip subtrees that are completely outside of the visible
+     * region, which is most of a large expression */
+    if (x >= clip->x2 || x + vec_get(layout->nodes, n)->adv_x <= clip->x1 ||
+        y - vec_get(layout->nodes, n)->height >= clip->y2 ||
+        y + vec_get(layout->nodes, n)->height <= clip->y1)
+    {
+        return 0;
+    }
+
     type     = vec_get(layout->nodes, n)->type;
     left     = vec_get(layout->nodes, n)->child[0];
     right    = vec_get(layout->nodes, n)->child[1];
@@ -507,19 +640,29 @@ int csfg_expr_draw(
 
         case CSFG_LAYOUT_VAR:
             var_idx = vec_get(layout->nodes, n)->var.idx;
-            cstr    = strlist_cstr(pool->var_names, var_idx);
+            cstr    = csfg_symbol_cstr(var_idx);
             cairo_move_to(cr, x, y);
             cairo_show_text(cr, cstr);
             break;
 
-        case CSFG_LAYOUT_INF: return -1;
-        case CSFG_LAYOUT_NEG: return -1;
+        case CSFG_LAYOUT_INF:
+            cairo_move_to(cr, x, y);
+            cairo_show_text(cr, utf8_infinity);
+            break;
+
+        case CSFG_LAYOUT_NEG:
+            cairo_move_to(cr, x, y);
+            cairo_show_text(cr, "-");
+            x += vec_get(layout->nodes, n)->adv_x;
+            x -= vec_get(layout->nodes, left)->adv_x;
+            draw_recurse(layout, left, x, y, clip, cr);
+            break;
 
         case CSFG_LAYOUT_ADD:
         case CSFG_LAYOUT_SUB:
         case CSFG_LAYOUT_MUL:
             baseline = vec_get(layout->nodes, n)->binop.lhs_baseline;
-            csfg_expr_draw(layout, pool, left, x, y, cr);
+            draw_recurse(layout, left, x, y, clip, cr);
             x += vec_get(layout->nodes, left)->adv_x;
 
             baseline = vec_get(layout->nodes, n)->binop.op_baseline;
@@ -532,19 +675,19 @@ int csfg_expr_draw(
             x += vec_get(layout->nodes, n)->binop.op_adv_x;
 
             baseline = vec_get(layout->nodes, n)->binop.rhs_baseline;
-            csfg_expr_draw(layout, pool, right, x, y, cr);
+            draw_recurse(layout, right, x, y, clip, cr);
             break;
 
         case CSFG_LAYOUT_FRAC:
             num = vec_get(layout->nodes, n)->child[0];
             den = vec_get(layout->nodes, n)->child[1];
 
-            csfg_expr_draw(
+            draw_recurse(
                 layout,
-                pool,
                 num,
                 x + vec_get(layout->nodes, n)->frac.num_x,
                 y,
+                clip,
                 cr);
             y += vec_get(layout->nodes, n)->frac.sep_padding;
 
@@ -554,22 +697,29 @@ int csfg_expr_draw(
             y += vec_get(layout->nodes, num)->height;
             y += vec_get(layout->nodes, n)->frac.sep_padding;
 
-            csfg_expr_draw(
+            draw_recurse(
                 layout,
-                pool,
                 den,
                 x + vec_get(layout->nodes, n)->frac.den_x,
                 y,
+                clip,
                 cr);
 
             break;
 
+        case CSFG_LAYOUT_POW:
+            draw_recurse(layout, left, x, y, clip, cr);
+            x += vec_get(layout->nodes, left)->adv_x;
+            y -= vec_get(layout->nodes, left)->height / 2;
+            draw_recurse(layout, right, x, y, clip, cr);
+            break;
+
         case CSFG_LAYOUT_PARENS:
             cairo_move_to(cr, x, y);
             cairo_show_text(cr, "(");
             x += vec_get(layout->nodes, n)->paren.adv_x;
 
-            csfg_expr_draw(layout, pool, left, x, y, cr);
+            draw_recurse(layout, left, x, y, clip, cr);
             x += vec_get(layout->nodes, left)->adv_x;
 
             cairo_move_to(cr, x, y);
@@ -581,49 +731,201 @@ int csfg_expr_draw(
 }
 
 /* -------------------------------------------------------------------------- */
-static void draw_tf(
-    cairo_t* cr,
-    const struct csfg_expr_pool* pool,
-    const struct csfg_tf_expr* tf)
+int csfg_expr_draw(struct csfg_layout* layout, int n, int x, int y, cairo_t* cr)
+{
+    struct csfg_layout_clip clip;
+    cairo_clip_extents(cr, &clip.x1, &clip.y1, &clip.x2, &clip.y2);
+    return draw_recurse(layout, n, x, y, &clip, cr);
+}
+
+
+/* -------------------------------------------------------------------------- */
+static PangoLayout* create_tf_text_layout(cairo_t* cr)
 {
-    struct str* str;
     PangoLayout* layout;
     PangoFontDescription* desc;
+
+    layout = pango_cairo_create_layout(cr);
+    desc   = pango_font_description_from_string("Sans 16");
+    pango_layout_set_font_description(layout, desc);
+    pango_font_description_free(desc);
+
+    return layout;
+}
+
+/* -------------------------------------------------------------------------- */
+static void measure_tf(
+    cairo_t* cr, const char* num, const char* den, int* width, int* height)
+{
+    int tw, th;
+    PangoLayout* layout = create_tf_text_layout(cr);
+
+    pango_layout_set_text(layout, num, -1);
+    pango_layout_get_pixel_size(layout, width, height);
+    pango_layout_set_text(layout, den, -1);
+    pango_layout_get_pixel_size(layout, &tw, &th);
+    *width = tw > *width ? tw : *width;
+    *height += th;
+
+    g_object_unref(layout);
+}
+
+/* -------------------------------------------------------------------------- */
+static void
+draw_tf(cairo_t* cr, const char* num, const char* den, double tx, double ty)
+{
+    PangoLayout* layout;
     int tw, th;
     int widest;
-    double tx = 0.0;
-    double ty = 0.0;
 
-    str_init(&str);
     cairo_set_source_rgb(cr, 0, 0, 0);
 
-    layout = pango_cairo_create_layout(cr);
-    desc   = pango_font_description_from_string("Sans 16");
-    pango_layout_set_font_description(layout, desc);
+    layout = create_tf_text_layout(cr);
 
-    csfg_poly_expr_to_str(&str, pool, tf->num);
-    pango_layout_set_text(layout, str_cstr(str), -1);
+    pango_layout_set_text(layout, num, -1);
     cairo_move_to(cr, tx, ty);
     pango_cairo_show_layout(cr, layout);
     pango_layout_get_pixel_size(layout, &tw, &th);
     widest = tw;
 
-    str_clear(str);
-    csfg_poly_expr_to_str(&str, pool, tf->den);
-    pango_layout_set_text(layout, str_cstr(str), -1);
+    pango_layout_set_text(layout, den, -1);
     cairo_move_to(cr, tx, ty + th);
     pango_cairo_show_layout(cr, layout);
     pango_layout_get_pixel_size(layout, &tw, &th);
     widest = tw > widest ? tw : widest;
 
-    cairo_move_to(cr, 0.0, th + 1.0);
-    cairo_line_to(cr, widest, th + 1.0);
+    cairo_move_to(cr, tx, ty + th + 1.0);
+    cairo_line_to(cr, tx + widest, ty + th + 1.0);
     cairo_set_line_width(cr, 1.0);
     cairo_stroke(cr);
 
     g_object_unref(layout);
-    pango_font_description_free(desc);
-    str_deinit(str);
+}
+
+/* -------------------------------------------------------------------------- */
+static void update_layout(MathViewer* viewer, cairo_t* cr)
+{
+    const struct csfg_layout_node* root;
+
+    if (viewer->layout_valid)
+        return;
+
+    viewer->layout_valid   = 1;
+    viewer->surface_valid  = 0;
+    viewer->layout_root    = -1;
+    viewer->content_width  = 0;
+    viewer->content_height = 0;
+    str_clear(viewer->tf_num);
+    str_clear(viewer->tf_den);
+
+    if (viewer->pool != NULL && viewer->tf != NULL)
+    {
+        if (csfg_poly_expr_to_str(
+                &viewer->tf_num, viewer->pool, viewer->tf->num) != 0 ||
+            csfg_poly_expr_to_str(
+                &viewer->tf_den, viewer->pool, viewer->tf->den) != 0)
+            return;
+        measure_tf(
+            cr,
+            str_cstr(viewer->tf_num),
+            str_cstr(viewer->tf_den),
+            &viewer->content_width,
+            &viewer->content_height);
+    }
+    else if (viewer->pool != NULL && viewer->expr > -1)
+    {
+        cairo_save(cr);
+        cairo_set_font_size(cr, FONT_SIZE);
+        viewer->layout_root = csfg_expr_layout(
+            &viewer->layout, viewer->pool, viewer->expr, cr);
+        cairo_restore(cr);
+        if (viewer->layout_root < 0)
+            return;
+
+        /* See draw_recurse(): content lies within the root's height above
+         * and below its baseline */
+        root = vec_get(viewer->layout.nodes, viewer->layout_root);
+        viewer->content_width  = root->adv_x;
+        viewer->content_height = root->height * 2;
+    }
+
+    viewer->content_width += CONTENT_PADDING * 2;
+    viewer->content_height += CONTENT_PADDING * 2;
+}
+
+/* -------------------------------------------------------------------------- */
+static int render_surface(
+    MathViewer* viewer, cairo_t* target, int x, int y, int width, int height)
+{
+    cairo_t* cr;
+    const struct csfg_layout_node* root;
+
+    if (viewer->surface != NULL &&
+        (viewer->surface_width != width || viewer->surface_height != height))
+    {
+        cairo_surface_destroy(viewer->surface);
+        viewer->surface = NULL;
+    }
+    if (viewer->surface == NULL)
+    {
+        viewer->surface = cairo_surface_create_similar(
+            cairo_get_target(target), CAIRO_CONTENT_COLOR_ALPHA, width, height);
+        if (cairo_surface_status(viewer->surface) != CAIRO_STATUS_SUCCESS)
+        {
+            cairo_surface_destroy(viewer->surface);
+            viewer->surface = NULL;
+            return -1;
+        }
+    }
+
+    viewer->surface_x      = x;
+    viewer->surface_y      = y;
+    viewer->surface_width  = width;
+    viewer->surface_height = height;
+    viewer->surface_valid  = 1;
+
+    cr = cairo_create(viewer->surface);
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+    cairo_translate(cr, -x, -y);
+
+    if (viewer->layout_root > -1)
+    {
+        root = vec_get(viewer->layout.nodes, viewer->layout_root);
+        cairo_set_source_rgb(cr, 0, 0, 0);
+        cairo_set_font_size(cr, FONT_SIZE);
+        cairo_set_line_width(cr, 1.0);
+        csfg_expr_draw(
+            &viewer->layout,
+            viewer->layout_root,
+            CONTENT_PADDING,
+            CONTENT_PADDING + root->height,
+            cr);
+    }
+    else if (viewer->tf != NULL)
+        draw_tf(
+            cr,
+            str_cstr(viewer->tf_num),
+            str_cstr(viewer->tf_den),
+            CONTENT_PADDING,
+            CONTENT_PADDING);
+
+    cairo_destroy(cr);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static void clamp_scroll(MathViewer* viewer, int width, int height)
+{
+    if (viewer->scroll_x > viewer->content_width - width)
+        viewer->scroll_x = viewer->content_width - width;
+    if (viewer->scroll_y > viewer->content_height - height)
+        viewer->scroll_y = viewer->content_height - height;
+    if (viewer->scroll_x < 0)
+        viewer->scroll_x = 0;
+    if (viewer->scroll_y < 0)
+        viewer->scroll_y = 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -635,7 +937,7 @@ static void draw_cb(
     gpointer user_data)
 {
     MathViewer* viewer = user_data;
-    (void)area, (void)width, (void)height;
+    (void)area;
 
     cairo_set_source_rgb(cr, 0.8, 0.8, 0.8);
     for (int x = -1000; x < 1000; x += 20)
@@ -661,37 +963,110 @@ static void draw_cb(
         cairo_set_font_face(cr, font_face);
     */
 
-    cairo_set_source_rgb(cr, 0, 0, 0);
-    cairo_set_font_size(cr, 32);
-    struct csfg_layout layout;
-    struct csfg_expr_pool* pool;
-    csfg_layout_vec_init(&layout.nodes);
-    str_init(&layout.str);
-    csfg_expr_pool_init(&pool);
-    // int expr = csfg_expr_parse(
-    //     &pool, cstr_view("1/(1+1/(1+1/(1+1/A))) + 1/(1/(1/(1/A+1)+1)+1)+1"));
-    int expr = csfg_expr_parse(&pool, cstr_view("a/b * c/d"));
-    int n    = csfg_expr_layout(&layout, pool, expr, cr);
-    csfg_expr_draw(&layout, pool, n, 0, 60, cr);
-    csfg_expr_pool_deinit(pool);
-    str_deinit(layout.str);
-    csfg_layout_vec_deinit(layout.nodes);
+    update_layout(viewer, cr);
+    clamp_scroll(viewer, width, height);
+
+    /* Only draw the expression again if the view scrolled past the part that
+     * was rendered, or if the widget was resized */
+    if (!viewer->surface_valid ||
+        viewer->surface_width != width + SURFACE_MARGIN * 2 ||
+        viewer->surface_height != height + SURFACE_MARGIN * 2 ||
+        viewer->scroll_x < viewer->surface_x ||
+        viewer->scroll_y < viewer->surface_y ||
+        viewer->scroll_x + width > viewer->surface_x + viewer->surface_width ||
+        viewer->scroll_y + height > viewer->surface_y + viewer->surface_height)
+    {
+        if (render_surface(
+                viewer,
+                cr,
+                viewer->scroll_x - SURFACE_MARGIN,
+                viewer->scroll_y - SURFACE_MARGIN,
+                width + SURFACE_MARGIN * 2,
+                height + SURFACE_MARGIN * 2) != 0)
+            return;
+    }
 
-    /*
-    if (viewer->pool != NULL && viewer->expr > -1)
-        draw_expr(cr, viewer->pool, viewer->expr);
-    if (viewer->pool != NULL && viewer->tf != NULL)
-        draw_tf(cr, viewer->pool, viewer->tf);*/
+    cairo_set_source_surface(
+        cr,
+        viewer->surface,
+        viewer->surface_x - viewer->scroll_x,
+        viewer->surface_y - viewer->scroll_y);
+    cairo_paint(cr);
+}
+
+/* -------------------------------------------------------------------------- */
+static gboolean scroll_cb(
+    GtkEventControllerScroll* controller,
+    double dx,
+    double dy,
+    gpointer user_data)
+{
+    MathViewer* viewer = user_data;
+    (void)controller;
+
+    /* Large expressions are mostly wide. Use the wheel to scroll sideways if
+     * there is nothing to scroll vertically */
+    if (viewer->content_height <= gtk_widget_get_height(viewer->drawing_area))
+        dx += dy, dy = 0.0;
+
+    viewer->scroll_x += (int)(dx * 40.0);
+    viewer->scroll_y += (int)(dy * 40.0);
+    gtk_widget_queue_draw(viewer->drawing_area);
+    return TRUE;
+}
+
+/* -------------------------------------------------------------------------- */
+static void
+drag_begin(GtkGestureDrag* gesture, double x, double y, gpointer user_data)
+{
+    MathViewer* viewer = user_data;
+    (void)gesture, (void)x, (void)y;
+    viewer->scroll_begin_x = viewer->scroll_x;
+    viewer->scroll_begin_y = viewer->scroll_y;
+}
+
+/* -------------------------------------------------------------------------- */
+static void drag_update(
+    GtkGestureDrag* gesture,
+    double offset_x,
+    double offset_y,
+    gpointer user_data)
+{
+    MathViewer* viewer = user_data;
+    (void)gesture;
+    viewer->scroll_x = viewer->scroll_begin_x - (int)offset_x;
+    viewer->scroll_y = viewer->scroll_begin_y - (int)offset_y;
+    gtk_widget_queue_draw(viewer->drawing_area);
 }
 
 /* -------------------------------------------------------------------------- */
 static void math_viewer_init(MathViewer* self)
 {
+    self->tf   = NULL;
     self->pool = NULL;
-    self->pool = NULL;
-    self->expr = -1;
     self->expr = -1;
 
+    csfg_layout_init(&self->layout);
+    str_init(&self->tf_num);
+    str_init(&self->tf_den);
+    self->layout_root    = -1;
+    self->content_width  = 0;
+    self->content_height = 0;
+
+    self->surface        = NULL;
+    self->surface_x      = 0;
+    self->surface_y      = 0;
+    self->surface_width  = 0;
+    self->surface_height = 0;
+
+    self->scroll_x       = 0;
+    self->scroll_y       = 0;
+    self->scroll_begin_x = 0;
+    self->scroll_begin_y = 0;
+
+    self->layout_valid  = 0;
+    self->surface_valid = 0;
+
     g_object_set(self, "orientation", GTK_ORIENTATION_VERTICAL, NULL);
 
     self->drawing_area = gtk_drawing_area_new();
@@ -700,13 +1075,36 @@ static void math_viewer_init(MathViewer* self)
     gtk_drawing_area_set_draw_func(
         GTK_DRAWING_AREA(self->drawing_area), draw_cb, self, NULL);
 
+    GtkEventController* scroll =
+        gtk_event_controller_scroll_new(GTK_EVENT_CONTROLLER_SCROLL_BOTH_AXES);
+    g_signal_connect(scroll, "scroll", G_CALLBACK(scroll_cb), self);
+    gtk_widget_add_controller(self->drawing_area, scroll);
+
+    GtkGesture* drag = gtk_gesture_drag_new();
+    g_signal_connect(drag, "drag-begin", G_CALLBACK(drag_begin), self);
+    g_signal_connect(drag, "drag-update", G_CALLBACK(drag_update), self);
+    gtk_widget_add_controller(self->drawing_area, GTK_EVENT_CONTROLLER(drag));
+
     gtk_box_append(GTK_BOX(self), self->drawing_area);
 }
 
+/* -------------------------------------------------------------------------- */
+static void math_viewer_finalize(GObject* object)
+{
+    MathViewer* self = PLUGIN_MATH_VIEWER(object);
+    if (self->surface != NULL)
+        cairo_surface_destroy(self->surface);
+    str_deinit(self->tf_den);
+    str_deinit(self->tf_num);
+    csfg_layout_deinit(&self->layout);
+    G_OBJECT_CLASS(math_viewer_parent_class)->finalize(object);
+}
+
 /* -------------------------------------------------------------------------- */
 static void math_viewer_class_init(MathViewerClass* class)
 {
-    (void)class;
+    GObjectClass* object_class = G_OBJECT_CLASS(class);
+    object_class->finalize     = math_viewer_finalize;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -727,6 +1125,15 @@ MathViewer* math_viewer_new(void)
     return g_object_new(PLUGIN_TYPE_MATH_VIEWER, NULL);
 }
 
+/* -------------------------------------------------------------------------- */
+static void invalidate_layout(MathViewer* viewer)
+{
+    viewer->layout_valid = 0;
+    viewer->scroll_x     = 0;
+    viewer->scroll_y     = 0;
+    gtk_widget_queue_draw(viewer->drawing_area);
+}
+
 /* -------------------------------------------------------------------------- */
 void math_viewer_set_expr(
     MathViewer* viewer, const struct csfg_expr_pool* pool, int expr)
@@ -734,7 +1141,7 @@ void math_viewer_set_expr(
     viewer->tf   = NULL;
     viewer->pool = pool;
     viewer->expr = expr;
-    gtk_widget_queue_draw(viewer->drawing_area);
+    invalidate_layout(viewer);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -746,5 +1153,5 @@ void math_viewer_set_tf(
     viewer->tf   = tf;
     viewer->pool = pool;
     viewer->expr = -1;
-    gtk_widget_queue_draw(viewer->drawing_area);
+    invalidate_layout(viewer);
 }
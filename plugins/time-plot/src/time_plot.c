@@ -1,23 +1,131 @@
+#include "csfg/numeric/pyramid.h"
 #include "csfg/numeric/tf.h"
+#include "csfg/util/mem.h"
 #include "time-plot/time_plot.h"
 
+/* Number of samples each response is evaluated at over the whole interval.
+ * Zooming in stops once a pixel is smaller than one sample */
+#define TIME_SAMPLES 16384
+/* Factor by which one step of the mouse wheel zooms */
+#define ZOOM_STEP 1.2
+
+enum response
+{
+    RESPONSE_IMPULSE,
+    RESPONSE_STEP,
+    RESPONSE_RAMP,
+    RESPONSE_COUNT
+};
+
 struct _TimePlot
 {
     GtkBox parent_instance;
     GtkWidget* drawing_area;
 
     const struct csfg_tf* tf;
-    const struct csfg_pfd_poly* pfd_impulse;
-    const struct csfg_pfd_poly* pfd_step;
-    const struct csfg_pfd_poly* pfd_ramp;
+    const struct csfg_pfd_poly* pfd[RESPONSE_COUNT];
+    struct csfg_pyramid pyr[RESPONSE_COUNT];
+
+    /* One bucket per pixel column and response */
+    struct csfg_minmax* columns;
+    int columns_capacity;
+
+    /* Visible and full range, in seconds */
+    double view_start, view_end;
+    double full_start, full_end;
+    double drag_start;
+    double pointer_x;
 
     unsigned enable_impulse : 1;
     unsigned enable_step    : 1;
     unsigned enable_ramp    : 1;
+    unsigned samples_valid  : 1;
 };
 
 G_DEFINE_DYNAMIC_TYPE(TimePlot, time_plot, GTK_TYPE_BOX)
 
+/* -------------------------------------------------------------------------- */
+static int is_enabled(const TimePlot* plot, int r)
+{
+    switch (r)
+    {
+        case RESPONSE_IMPULSE: return plot->enable_impulse;
+        case RESPONSE_STEP: return plot->enable_step;
+        case RESPONSE_RAMP: return plot->enable_ramp;
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+static void clamp_view(TimePlot* plot, int width)
+{
+    double full_span = plot->full_end - plot->full_start;
+    double min_span  = full_span * width / TIME_SAMPLES;
+    double span      = plot->view_end - plot->view_start;
+
+    if (span > full_span)
+        span = full_span;
+    if (span < min_span)
+        span = min_span;
+    if (plot->view_start < plot->full_start)
+        plot->view_start = plot->full_start;
+    if (plot->view_start + span > plot->full_end)
+        plot->view_start = plot->full_end - span;
+    plot->view_end = plot->view_start + span;
+}
+
+/* -------------------------------------------------------------------------- */
+/*
+ * Evaluates every response once over the whole interval and summarizes the
+ * samples in pyramids. Zooming and panning only query the pyramids
+ * afterwards.
+ */
+static int rebuild_samples(TimePlot* plot)
+{
+    double* t;
+    double* y;
+    double  t_start, t_end;
+    int     i, r;
+
+    if (plot->tf == NULL ||
+        csfg_tf_interesting_time_interval(plot->tf, &t_start, &t_end) != 0 ||
+        !(t_end > t_start))
+        return -1;
+
+    t = mem_alloc((int)sizeof(double) * TIME_SAMPLES * 2);
+    if (t == NULL)
+        return -1;
+    y = t + TIME_SAMPLES;
+    for (i = 0; i != TIME_SAMPLES; ++i)
+        t[i] = t_start + (t_end - t_start) * i / (TIME_SAMPLES - 1);
+
+    for (r = 0; r != RESPONSE_COUNT; ++r)
+    {
+        csfg_pyramid_deinit(&plot->pyr[r]);
+        csfg_pyramid_init(&plot->pyr[r]);
+        if (plot->pfd[r] == NULL)
+            continue;
+
+        for (i = 0; i != TIME_SAMPLES; ++i)
+            y[i] = csfg_pfd_poly_eval_inverse_laplace(plot->pfd[r], t[i]);
+        if (csfg_pyramid_build(
+                &plot->pyr[r], t, y, TIME_SAMPLES, TIME_SAMPLES) != 0)
+            break;
+    }
+
+    mem_free(t);
+    if (r != RESPONSE_COUNT)
+        return -1;
+
+    /* New responses reset the zoom */
+    plot->full_start    = t_start;
+    plot->full_end      = t_end;
+    plot->view_start    = t_start;
+    plot->view_end      = t_end;
+    plot->samples_valid = 1;
+    return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 static void draw_mag_cb(
     GtkDrawingArea* area,
@@ -27,125 +135,93 @@ static void draw_mag_cb(
     gpointer user_data)
 {
     TimePlot* plot = user_data;
-    (void)area, (void)width, (void)height;
+    (void)area;
 
-    if (plot->tf != NULL)
+    if (plot->tf != NULL && width > 0)
     {
-        int exponent, i;
+        int exponent, i, r;
         double scale_x, scale_y;
-        double value;
-        double t_start, t_end, t_step, t;
+        double t_left, t_step, t;
         double y_min, y_max;
         double max_abs_value = 0;
+        struct csfg_minmax* col;
 
-        if (csfg_tf_interesting_time_interval(plot->tf, &t_start, &t_end) != 0)
+        if (!plot->samples_valid && rebuild_samples(plot) != 0)
             return;
-        t_step = (t_end - t_start) / width * 0.9;
 
-        y_min = DBL_MAX;
-        y_max = -DBL_MAX;
-        for (t = t_start; t <= t_end; t += t_step)
+        if (plot->columns_capacity < width * RESPONSE_COUNT)
         {
-            if (plot->enable_impulse)
-            {
-                value =
-                    csfg_pfd_poly_eval_inverse_laplace(plot->pfd_impulse, t);
-                if (!isinf(value) && !isnan(value))
-                {
-                    if (y_max < value)
-                        y_max = value;
-                    if (y_min > value)
-                        y_min = value;
-                    value = fabs(value);
-                    if (max_abs_value < value)
-                        max_abs_value = value;
-                }
-            }
+            struct csfg_minmax* columns = mem_realloc(
+                plot->columns,
+                (int)sizeof(*columns) * width * RESPONSE_COUNT);
+            if (columns == NULL)
+                return;
+            plot->columns          = columns;
+            plot->columns_capacity = width * RESPONSE_COUNT;
+        }
 
-            if (plot->enable_step)
-            {
-                value = csfg_pfd_poly_eval_inverse_laplace(plot->pfd_step, t);
-                if (!isinf(value) && !isnan(value))
-                {
-                    if (y_max < value)
-                        y_max = value;
-                    if (y_min > value)
-                        y_min = value;
-                    value = fabs(value);
-                    if (max_abs_value < value)
-                        max_abs_value = value;
-                }
-            }
+        /* Leave some space left of the vertical axis */
+        clamp_view(plot, width);
+        scale_x = width / (plot->view_end - plot->view_start) * 0.95;
+        t_left  = plot->view_start - width / 20.0 / scale_x;
 
-            if (plot->enable_ramp)
+        /* Only the visible part of the responses is summarized, at one bucket
+         * per pixel, so the cost doesn't depend on the zoom level */
+        y_min = DBL_MAX;
+        y_max = -DBL_MAX;
+        for (r = 0; r != RESPONSE_COUNT; ++r)
+        {
+            if (!is_enabled(plot, r))
+                continue;
+            col = plot->columns + r * width;
+            csfg_pyramid_query(
+                &plot->pyr[r], t_left, t_left + width / scale_x, col, width);
+            for (i = 0; i != width; ++i)
             {
-                value = csfg_pfd_poly_eval_inverse_laplace(plot->pfd_ramp, t);
-                if (!isinf(value) && !isnan(value))
-                {
-                    if (y_max < value)
-                        y_max = value;
-                    if (y_min > value)
-                        y_min = value;
-                    value = fabs(value);
-                    if (max_abs_value < value)
-                        max_abs_value = value;
-                }
+                if (col[i].min > col[i].max)
+                    continue;
+                if (y_max < col[i].max)
+                    y_max = col[i].max;
+                if (y_min > col[i].min)
+                    y_min = col[i].min;
             }
         }
-        scale_x = width / (t_end - t_start) * 0.95;
+        if (y_min > y_max)
+            y_min = y_max = 0.0;
+        max_abs_value = fabs(y_min) > fabs(y_max) ? fabs(y_min) : fabs(y_max);
+        if (max_abs_value == 0.0)
+            max_abs_value = 1.0;
         scale_y = height / max_abs_value * 0.45;
 
-        cairo_translate(cr, width / 20.0, height / 2.0);
+        cairo_translate(
+            cr, width / 20.0 - plot->view_start * scale_x, height / 2.0);
         cairo_set_source_rgb(cr, 0.8, 0.8, 0.8);
         cairo_set_line_width(cr, 1.0);
-        cairo_move_to(cr, -1000.0, 0.0);
-        cairo_line_to(cr, 1000.0, 0.0);
+        cairo_move_to(cr, t_left * scale_x, 0.0);
+        cairo_line_to(cr, t_left * scale_x + width, 0.0);
         cairo_move_to(cr, 0.0, -1000.0);
         cairo_line_to(cr, 0.0, 1000.0);
         cairo_stroke(cr);
 
-        if (plot->enable_impulse)
-        {
-            cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
-            cairo_set_line_width(cr, 1.0);
-            for (t = t_start; t <= t_end; t += t_step)
-            {
-                value =
-                    csfg_pfd_poly_eval_inverse_laplace(plot->pfd_impulse, t);
-                if (t == t_start)
-                    cairo_move_to(cr, t * scale_x, value * -scale_y);
-                else
-                    cairo_line_to(cr, t * scale_x, value * -scale_y);
-            }
-            cairo_stroke(cr);
-        }
-
-        if (plot->enable_step)
-        {
-            cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
-            cairo_set_line_width(cr, 1.0);
-            for (t = t_start; t <= t_end; t += t_step)
-            {
-                value = csfg_pfd_poly_eval_inverse_laplace(plot->pfd_step, t);
-                if (t == t_start)
-                    cairo_move_to(cr, t * scale_x, value * -scale_y);
-                else
-                    cairo_line_to(cr, t * scale_x, value * -scale_y);
-            }
-            cairo_stroke(cr);
-        }
-
-        if (plot->enable_ramp)
+        /* Each column is drawn as a vertical line spanning its range, so
+         * oscillations faster than a pixel still show up as a filled band */
+        cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+        cairo_set_line_width(cr, 1.0);
+        for (r = 0; r != RESPONSE_COUNT; ++r)
         {
-            cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
-            cairo_set_line_width(cr, 1.0);
-            for (t = t_start; t <= t_end; t += t_step)
+            if (!is_enabled(plot, r))
+                continue;
+            col = plot->columns + r * width;
+            for (i = 0; i != width; ++i)
             {
-                value = csfg_pfd_poly_eval_inverse_laplace(plot->pfd_ramp, t);
-                if (t == t_start)
-                    cairo_move_to(cr, t * scale_x, value * -scale_y);
-                else
-                    cairo_line_to(cr, t * scale_x, value * -scale_y);
+                double x = t_left * scale_x + i + 0.5;
+                if (col[i].min > col[i].max)
+                {
+                    cairo_new_sub_path(cr);
+                    continue;
+                }
+                cairo_line_to(cr, x, col[i].max * -scale_y);
+                cairo_line_to(cr, x, col[i].min * -scale_y);
             }
             cairo_stroke(cr);
         }
@@ -160,7 +236,7 @@ static void draw_mag_cb(
 
         cairo_set_line_width(cr, 1.0);
         cairo_set_source_rgb(cr, 0.6, 0.6, 0.6);
-        exponent = (int)ceil(log10(t_end));
+        exponent = (int)ceil(log10(plot->full_end));
         t        = pow(10, exponent);
         cairo_move_to(cr, t * scale_x, 5);
         cairo_line_to(cr, t * scale_x, -5);
@@ -184,6 +260,75 @@ static void draw_mag_cb(
     }
 }
 
+/* -------------------------------------------------------------------------- */
+static gboolean scroll_cb(
+    GtkEventControllerScroll* controller,
+    double dx,
+    double dy,
+    gpointer user_data)
+{
+    TimePlot* plot = user_data;
+    int width      = gtk_widget_get_width(plot->drawing_area);
+    double scale_x, pivot, factor;
+    (void)controller, (void)dx;
+
+    if (width < 1 || !plot->samples_valid)
+        return FALSE;
+
+    /* Zoom around the time under the mouse cursor */
+    scale_x = width / (plot->view_end - plot->view_start) * 0.95;
+    pivot   = plot->view_start + (plot->pointer_x - width / 20.0) / scale_x;
+    factor  = pow(ZOOM_STEP, dy);
+
+    plot->view_start = pivot - (pivot - plot->view_start) * factor;
+    plot->view_end   = pivot + (plot->view_end - pivot) * factor;
+    clamp_view(plot, width);
+    gtk_widget_queue_draw(plot->drawing_area);
+    return TRUE;
+}
+
+/* -------------------------------------------------------------------------- */
+static void motion_cb(
+    GtkEventControllerMotion* controller,
+    double x,
+    double y,
+    gpointer user_data)
+{
+    TimePlot* plot = user_data;
+    (void)controller, (void)y;
+    plot->pointer_x = x;
+}
+
+/* -------------------------------------------------------------------------- */
+static void
+drag_begin(GtkGestureDrag* gesture, double x, double y, gpointer user_data)
+{
+    TimePlot* plot = user_data;
+    (void)gesture, (void)x, (void)y;
+    plot->drag_start = plot->view_start;
+}
+
+/* -------------------------------------------------------------------------- */
+static void drag_update(
+    GtkGestureDrag* gesture,
+    double offset_x,
+    double offset_y,
+    gpointer user_data)
+{
+    TimePlot* plot = user_data;
+    int width      = gtk_widget_get_width(plot->drawing_area);
+    double span    = plot->view_end - plot->view_start;
+    (void)gesture, (void)offset_y;
+
+    if (width < 1 || !plot->samples_valid)
+        return;
+
+    plot->view_start = plot->drag_start - offset_x * span / (width * 0.95);
+    plot->view_end   = plot->view_start + span;
+    clamp_view(plot, width);
+    gtk_widget_queue_draw(plot->drawing_area);
+}
+
 /* -------------------------------------------------------------------------- */
 static void on_impulse_toggled(GtkCheckButton* button, gpointer user_data)
 {
@@ -214,6 +359,10 @@ static void time_plot_init(TimePlot* self)
     GtkWidget* check_impulse;
     GtkWidget* check_step;
     GtkWidget* check_ramp;
+    GtkEventController* scroll;
+    GtkEventController* motion;
+    GtkGesture* drag;
+    int r;
 
     g_object_set(self, "orientation", GTK_ORIENTATION_VERTICAL, NULL);
 
@@ -221,6 +370,21 @@ static void time_plot_init(TimePlot* self)
     self->enable_impulse = 0;
     self->enable_step    = 1;
     self->enable_ramp    = 0;
+    self->samples_valid  = 0;
+
+    for (r = 0; r != RESPONSE_COUNT; ++r)
+    {
+        self->pfd[r] = NULL;
+        csfg_pyramid_init(&self->pyr[r]);
+    }
+    self->columns          = NULL;
+    self->columns_capacity = 0;
+    self->view_start       = 0.0;
+    self->view_end         = 1.0;
+    self->full_start       = 0.0;
+    self->full_end         = 1.0;
+    self->drag_start       = 0.0;
+    self->pointer_x        = 0.0;
 
     self->drawing_area = gtk_drawing_area_new();
     gtk_widget_set_hexpand(self->drawing_area, TRUE);
@@ -228,6 +392,20 @@ static void time_plot_init(TimePlot* self)
     gtk_drawing_area_set_draw_func(
         GTK_DRAWING_AREA(self->drawing_area), draw_mag_cb, self, NULL);
 
+    scroll =
+        gtk_event_controller_scroll_new(GTK_EVENT_CONTROLLER_SCROLL_VERTICAL);
+    g_signal_connect(scroll, "scroll", G_CALLBACK(scroll_cb), self);
+    gtk_widget_add_controller(self->drawing_area, scroll);
+
+    motion = gtk_event_controller_motion_new();
+    g_signal_connect(motion, "motion", G_CALLBACK(motion_cb), self);
+    gtk_widget_add_controller(self->drawing_area, motion);
+
+    drag = gtk_gesture_drag_new();
+    g_signal_connect(drag, "drag-begin", G_CALLBACK(drag_begin), self);
+    g_signal_connect(drag, "drag-update", G_CALLBACK(drag_update), self);
+    gtk_widget_add_controller(self->drawing_area, GTK_EVENT_CONTROLLER(drag));
+
     check_impulse = gtk_check_button_new_with_label("Impulse");
     check_step    = gtk_check_button_new_with_label("Step");
     check_ramp    = gtk_check_button_new_with_label("Ramp");
@@ -249,7 +427,14 @@ static void time_plot_init(TimePlot* self)
 /* -------------------------------------------------------------------------- */
 static void time_plot_finalize(GObject* obj)
 {
-    (void)obj;
+    TimePlot* self = PLUGIN_time_PLOT(obj);
+    int       r;
+
+    if (self->columns != NULL)
+        mem_free(self->columns);
+    for (r = 0; r != RESPONSE_COUNT; ++r)
+        csfg_pyramid_deinit(&self->pyr[r]);
+    G_OBJECT_CLASS(time_plot_parent_class)->finalize(obj);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -280,18 +465,22 @@ TimePlot* time_plot_new(void)
 /* -------------------------------------------------------------------------- */
 void time_plot_set_tf(TimePlot* plot, const struct csfg_tf* tf)
 {
-    plot->tf = tf;
+    plot->tf            = tf;
+    plot->samples_valid = 0;
 }
 void time_plot_set_impulse(TimePlot* plot, const struct csfg_pfd_poly* pfd)
 {
-    plot->pfd_impulse = pfd;
+    plot->pfd[RESPONSE_IMPULSE] = pfd;
+    plot->samples_valid         = 0;
 }
 void time_plot_set_step(TimePlot* plot, const struct csfg_pfd_poly* pfd)
 {
-    plot->pfd_step = pfd;
+    plot->pfd[RESPONSE_STEP] = pfd;
+    plot->samples_valid      = 0;
 }
 void time_plot_set_ramp(TimePlot* plot, const struct csfg_pfd_poly* pfd)
 {
-    plot->pfd_ramp = pfd;
+    plot->pfd[RESPONSE_RAMP] = pfd;
+    plot->samples_valid      = 0;
     gtk_widget_queue_draw(plot->drawing_area);
 }
@@ -2,7 +2,8 @@
 
 struct args
 {
-    unsigned tests : 1;
+    unsigned tests   : 1;
+    unsigned numeric : 1;
 };
 
 int args_parse(struct args* a, int argc, char* argv[]);
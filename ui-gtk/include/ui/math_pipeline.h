@@ -5,6 +5,8 @@
 #include "csfg/symbolic/rulebook.h"
 #include "csfg/symbolic/tf_expr.h"
 #include "csfg/symbolic/var_table.h"
+#include "csfg/util/arena.h"
+#include "csfg/util/hash.h"
 
 struct dpsfg_plugin_interface;
 struct deserializer;
@@ -14,23 +16,85 @@ struct plugin_ctx;
 enum math_pipeline_state
 {
     MATH_PIPELINE_GRAPH_CHANGED,
+    /* Only edge expressions changed, the topology of the graph is the same */
+    MATH_PIPELINE_EDGE_EXPR_CHANGED,
     MATH_PIPELINE_SUBSTITUTIONS_CHANGED,
     MATH_PIPELINE_PARAMETERS_CHANGED
 };
 
+enum math_pipeline_mode
+{
+    /* Mason -> substitutions -> limits -> rational -> numeric */
+    MATH_PIPELINE_SYMBOLIC,
+    /* Skips all symbolic stages and computes the numeric transfer function
+     * directly from the graph. Falls back to MATH_PIPELINE_SYMBOLIC if any of
+     * the substitutions are limits, or if the graph can't be solved
+     * numerically. */
+    MATH_PIPELINE_NUMERIC
+};
+
+/* Number of previous results each cached stage remembers */
+#define MATH_PIPELINE_CACHE_SIZE 4
+
+struct math_pipeline_mason_entry
+{
+    struct csfg_expr_pool* pool;
+    int graph_expr;
+    struct csfg_path_vec* paths;
+    struct csfg_path_vec* loops;
+    struct serializer* inputs;
+    unsigned stamp; /* 0 if the entry is unused */
+};
+
+struct math_pipeline_symbolic_entry
+{
+    struct csfg_expr_pool* pool;
+    int subs_expr;
+    int lim_expr;
+    struct csfg_tf_expr tf_expr;
+    struct serializer* inputs;
+    unsigned stamp; /* 0 if the entry is unused */
+};
+
+/* Node in the substituted expression that holds the gain of an edge */
+struct math_pipeline_edge_site
+{
+    int edge_idx;
+    int node;
+};
+
+VEC_DECLARE(math_pipeline_edge_site_vec, struct math_pipeline_edge_site, 32)
+
 struct math_pipeline
 {
+    enum math_pipeline_mode mode;
+
     struct csfg_graph graph;
     struct csfg_path_vec* paths;
     struct csfg_path_vec* loops;
     int node_in, node_out;
 
+    /* Mason's gain formula in terms of the edge symbols G[i]. Only depends on
+     * the topology of the graph. The symbols map to the edge expressions,
+     * with the substitutions already inserted, through "edge_gains" */
+    struct csfg_expr_pool* graph_pool;
+    int graph_expr;
+    struct csfg_var_table edge_gains;
+
     struct csfg_var_table substitutions;
 
-    struct csfg_expr_pool* pool;
-    struct csfg_expr_pool* prev_pool;
-    int graph_expr;
+    /* Mason's gain formula with every edge symbol replaced by its gain. The
+     * nodes the gains were inserted at are remembered, so when a single edge
+     * changes, only its subtrees are replaced. Replaced subtrees are left in
+     * the pool as garbage until the expression is rebuilt. */
+    struct csfg_expr_pool* subs_pool;
     int subs_expr;
+    struct math_pipeline_edge_site_vec* edge_sites;
+    int subs_garbage;
+    int changed_edge; /* Only edge changed since the last update, or -1 */
+    unsigned subs_incremental : 1;
+
+    struct csfg_expr_pool* pool;
     int lim_expr;
     struct csfg_tf_expr tf_expr;
 
@@ -40,6 +104,35 @@ struct math_pipeline
     struct csfg_pfd_poly* pfd_impulse;
     struct csfg_pfd_poly* pfd_step;
     struct csfg_pfd_poly* pfd_ramp;
+
+    /* Temporary pools used by the stages, and the temporaries of the symbolic
+     * library (see arena_scratch_set()), are allocated from here. It is reset
+     * at the end of every update */
+    struct arena scratch;
+
+    /* The inputs of the stages, serialized: the topology of the graph,
+     * followed by the edge expressions and substitutions, followed by the
+     * parameters. The inputs of each stage are a prefix of the next stage's
+     * inputs. A size of -1 means the inputs could not be serialized */
+    struct serializer* inputs;
+    int topology_size;
+    int symbolic_size;
+
+    /* Each stage remembers the inputs it was last computed from and is
+     * skipped if they are unchanged. The symbolic stages additionally keep
+     * copies of their most recent results, so reverting a change (undo,
+     * toggling a substitution) restores the result instead of recomputing
+     * it. Inputs are compared byte for byte, so a result is never restored
+     * for different inputs. An empty serializer is never equal to any
+     * inputs */
+    struct serializer* mason_inputs;
+    struct serializer* symbolic_inputs;
+    struct serializer* numeric_inputs;
+    unsigned symbolic_from_graph : 1;
+    unsigned cache_stamp;
+    struct math_pipeline_mason_entry mason_cache[MATH_PIPELINE_CACHE_SIZE];
+    struct math_pipeline_symbolic_entry
+        symbolic_cache[MATH_PIPELINE_CACHE_SIZE];
 };
 
 void math_pipeline_init(struct math_pipeline* pl);
@@ -47,8 +140,45 @@ void math_pipeline_deinit(struct math_pipeline* pl);
 void math_pipeline_clear(struct math_pipeline* pl);
 int math_pipeline_load(struct math_pipeline* pl, struct deserializer* des);
 int math_pipeline_save(const struct math_pipeline* pl, struct serializer** ser);
+/*!
+ * @brief Brings all stages up to date with the graph, substitutions and
+ * parameters. Stages whose inputs did not change are skipped.
+ * @param[in] state What changed. MATH_PIPELINE_GRAPH_CHANGED and
+ * MATH_PIPELINE_EDGE_EXPR_CHANGED re-read the edge expressions of the graph.
+ */
 void math_pipeline_update(
     struct math_pipeline* pl, enum math_pipeline_state state);
+/*!
+ * @brief Same as calling @see math_pipeline_update() with
+ * MATH_PIPELINE_EDGE_EXPR_CHANGED, but only the expression of the specified
+ * edge is re-inserted into the transfer function.
+ */
+void math_pipeline_update_edge_expr(struct math_pipeline* pl, int edge_idx);
+/*!
+ * @brief Identifies the graph and substitutions the symbolic results are
+ * calculated from. Changes to the parameters don't affect the key.
+ */
+hash64 math_pipeline_cache_key(const struct math_pipeline* pl);
+/*!
+ * @brief Serializes the symbolic results (Mason's gain formula, substituted
+ * expression, limits and tf_expr) belonging to the current graph and
+ * substitutions.
+ * @return Returns -1 if the results are not available, e.g. because the
+ * pipeline has not been updated yet.
+ */
+int math_pipeline_save_cache(
+    const struct math_pipeline* pl, struct serializer** ser);
+/*!
+ * @brief Restores results saved with @see math_pipeline_save_cache() so the
+ * next call to @see math_pipeline_update() doesn't have to recalculate them.
+ * Call this after @see math_pipeline_load().
+ * @return Returns -1 if the data is invalid or was calculated from a different
+ * graph or different substitutions.
+ */
+int math_pipeline_load_cache(
+    struct math_pipeline* pl, struct deserializer* des);
+void math_pipeline_set_mode(
+    struct math_pipeline* pl, enum math_pipeline_mode mode);
 
 void math_pipeline_notify_plugins(
     const struct math_pipeline* pipeline,
@@ -22,7 +22,9 @@ static int print_help(const char* prog_name)
 
     log_raw(
         SECTION "Available options:\n" RESET
-        "  " ARG2 "-h" RESET "," ARG1 " --help  " RESET "          Print this help text.\n");
+        "  " ARG2 "-h" RESET "," ARG1 " --help  " RESET "          Print this help text.\n"
+        "     " ARG1 " --numeric " RESET "        Skip symbolic analysis and compute the transfer\n"
+        "                        function numerically. Much faster for large graphs.\n");
 
 #if defined(CSFG_TESTS)
     log_raw("     " ARG1 " --tests " RESET "          Run unit tests.\n");
@@ -48,7 +50,8 @@ int args_parse(struct args* a, int argc, char* argv[])
     char tests_flag = 0;
 
     /* Set defaults */
-    a->tests = 0;
+    a->tests   = 0;
+    a->numeric = 0;
 
     for (i = 1; i < argc; ++i)
     {
@@ -59,6 +62,8 @@ int args_parse(struct args* a, int argc, char* argv[])
                 const char* arg = &argv[i][2];
                 if (strcmp(arg, "help") == 0)
                     return print_help(argv[0]);
+                else if (strcmp(arg, "numeric") == 0)
+                    a->numeric = 1;
 #if defined(CSFG_TESTS)
                 else if (strcmp(arg, "tests") == 0)
                     tests_flag = 1;
@@ -165,11 +165,26 @@ static void parameters_changed_cb(
         pipeline,
         MATH_PIPELINE_PARAMETERS_CHANGED);
 }
+static void edge_expr_changed_cb(
+    struct plugin_notify_context* cb,
+    const struct plugin_ctx* source_plugin,
+    int edge_idx)
+{
+    struct app_ctx* app            = cb->app;
+    struct math_pipeline* pipeline = &app->pipeline;
+    math_pipeline_update_edge_expr(pipeline, edge_idx);
+    notify_plugins_about_change(
+        *app->plugins,
+        source_plugin,
+        pipeline,
+        MATH_PIPELINE_EDGE_EXPR_CHANGED);
+}
 static struct plugin_notify_interface plugin_callbacks = {
     graph_structure_changed_cb,
     graph_layout_changed_cb,
     substitutions_changed_cb,
-    parameters_changed_cb};
+    parameters_changed_cb,
+    edge_expr_changed_cb};
 
 /* -------------------------------------------------------------------------- */
 static gboolean
@@ -369,6 +384,13 @@ load_pipeline_graph_data_on_row(const void* data, int data_len, void* user_data)
     struct deserializer des  = deserializer(data, data_len);
     return math_pipeline_load(pl, &des);
 }
+static int
+load_pipeline_cache_on_row(const void* data, int data_len, void* user_data)
+{
+    struct math_pipeline* pl = user_data;
+    struct deserializer des  = deserializer(data, data_len);
+    return math_pipeline_load_cache(pl, &des);
+}
 static int load_pipeline_plugin_data_on_row(
     const void* data, int data_len, void* user_data)
 {
@@ -412,6 +434,7 @@ static int load_project(
     struct plugin_vec* plugins)
 {
     struct plugin* plugin;
+    hash64 key;
 
     math_pipeline_clear(pipeline);
 
@@ -420,6 +443,13 @@ static int load_project(
                 db, project_id, load_pipeline_graph_data_on_row, pipeline) != 0)
             return -1;
 
+    /* The symbolic results are only a cache. If they are missing or stale,
+     * the pipeline update recalculates them */
+    key = math_pipeline_cache_key(pipeline);
+    if (dbi->pipeline_cache.exists(db, project_id, key) > 0)
+        dbi->pipeline_cache.load(
+            db, project_id, key, load_pipeline_cache_on_row, pipeline);
+
     vec_for_each (plugins, plugin)
     {
         if (plugin->lib.i->graph)
@@ -504,6 +534,15 @@ static int unload_project(
         0)
         goto serialize_failed;
 
+    serializer_clear(ser);
+    if (math_pipeline_save_cache(pipeline, &ser) == 0)
+        dbi->pipeline_cache.save(
+            db,
+            project_id,
+            math_pipeline_cache_key(pipeline),
+            vec_data(ser),
+            vec_count(ser));
+
     math_pipeline_clear(pipeline);
 
     serializer_deinit(ser);
@@ -700,6 +739,8 @@ int main(int argc, char** argv)
     app_ctx.plugin_callbacks_ctx = &callbacks_ctx;
 
     math_pipeline_init(&app_ctx.pipeline);
+    if (args.numeric)
+        app_ctx.pipeline.mode = MATH_PIPELINE_NUMERIC;
     app_ctx.active_project_id = -1;
 
     app = gtk_application_new(
@@ -1,13 +1,19 @@
 #include "csfg/graph/graph.h"
+#include "csfg/io/deserialize.h"
 #include "csfg/io/io.h"
+#include "csfg/io/serialize.h"
 #include "csfg/numeric/tf.h"
 #include "csfg/platform/mfile.h"
 #include "csfg/symbolic/expr.h"
 #include "csfg/symbolic/rules.h"
+#include "csfg/symbolic/symbol.h"
 #include "csfg/symbolic/tf_expr.h"
 #include "csfg/symbolic/var_table.h"
 #include "dpsfg-plugin.h"
 #include "ui/math_pipeline.h"
+#include <string.h>
+
+VEC_DEFINE(math_pipeline_edge_site_vec, struct math_pipeline_edge_site, 32)
 
 /* -------------------------------------------------------------------------- */
 static int load_expr_ops(struct csfg_rulebook* ops)
@@ -35,19 +41,31 @@ open_file_failed:
 /* -------------------------------------------------------------------------- */
 void math_pipeline_init(struct math_pipeline* pl)
 {
+    int i;
+
+    pl->mode = MATH_PIPELINE_SYMBOLIC;
+
     csfg_graph_init(&pl->graph);
     csfg_path_vec_init(&pl->paths);
     csfg_path_vec_init(&pl->loops);
     pl->node_in  = -1;
     pl->node_out = -1;
 
+    csfg_expr_pool_init(&pl->graph_pool);
+    pl->graph_expr = -1;
+    csfg_var_table_init(&pl->edge_gains);
+
     csfg_var_table_init(&pl->substitutions);
 
+    csfg_expr_pool_init(&pl->subs_pool);
+    pl->subs_expr = -1;
+    math_pipeline_edge_site_vec_init(&pl->edge_sites);
+    pl->subs_garbage     = 0;
+    pl->changed_edge     = -1;
+    pl->subs_incremental = 0;
+
     csfg_expr_pool_init(&pl->pool);
-    csfg_expr_pool_init(&pl->prev_pool);
-    pl->graph_expr = -1;
-    pl->subs_expr  = -1;
-    pl->lim_expr   = -1;
+    pl->lim_expr = -1;
 
     csfg_tf_expr_init(&pl->tf_expr);
 
@@ -57,20 +75,63 @@ void math_pipeline_init(struct math_pipeline* pl)
     csfg_pfd_poly_init(&pl->pfd_impulse);
     csfg_pfd_poly_init(&pl->pfd_step);
     csfg_pfd_poly_init(&pl->pfd_ramp);
+
+    arena_init(&pl->scratch);
+
+    serializer_init(&pl->inputs);
+    pl->topology_size = -1;
+    pl->symbolic_size = -1;
+    serializer_init(&pl->mason_inputs);
+    serializer_init(&pl->symbolic_inputs);
+    serializer_init(&pl->numeric_inputs);
+    pl->symbolic_from_graph = 0;
+    pl->cache_stamp         = 0;
+    for (i = 0; i != MATH_PIPELINE_CACHE_SIZE; ++i)
+    {
+        csfg_expr_pool_init(&pl->mason_cache[i].pool);
+        csfg_path_vec_init(&pl->mason_cache[i].paths);
+        csfg_path_vec_init(&pl->mason_cache[i].loops);
+        serializer_init(&pl->mason_cache[i].inputs);
+        pl->mason_cache[i].stamp = 0;
+        csfg_expr_pool_init(&pl->symbolic_cache[i].pool);
+        csfg_tf_expr_init(&pl->symbolic_cache[i].tf_expr);
+        serializer_init(&pl->symbolic_cache[i].inputs);
+        pl->symbolic_cache[i].stamp = 0;
+    }
 }
 
 /* -------------------------------------------------------------------------- */
 void math_pipeline_deinit(struct math_pipeline* pl)
 {
+    int i;
+    for (i = 0; i != MATH_PIPELINE_CACHE_SIZE; ++i)
+    {
+        serializer_deinit(pl->symbolic_cache[i].inputs);
+        csfg_tf_expr_deinit(&pl->symbolic_cache[i].tf_expr);
+        csfg_expr_pool_deinit(pl->symbolic_cache[i].pool);
+        serializer_deinit(pl->mason_cache[i].inputs);
+        csfg_path_vec_deinit(pl->mason_cache[i].loops);
+        csfg_path_vec_deinit(pl->mason_cache[i].paths);
+        csfg_expr_pool_deinit(pl->mason_cache[i].pool);
+    }
+    serializer_deinit(pl->numeric_inputs);
+    serializer_deinit(pl->symbolic_inputs);
+    serializer_deinit(pl->mason_inputs);
+    serializer_deinit(pl->inputs);
+
+    arena_deinit(&pl->scratch);
     csfg_pfd_poly_deinit(pl->pfd_ramp);
     csfg_pfd_poly_deinit(pl->pfd_step);
     csfg_pfd_poly_deinit(pl->pfd_impulse);
     csfg_tf_deinit(&pl->tf);
     csfg_var_table_deinit(&pl->parameters);
     csfg_tf_expr_deinit(&pl->tf_expr);
-    csfg_expr_pool_deinit(pl->prev_pool);
     csfg_expr_pool_deinit(pl->pool);
+    math_pipeline_edge_site_vec_deinit(pl->edge_sites);
+    csfg_expr_pool_deinit(pl->subs_pool);
     csfg_var_table_deinit(&pl->substitutions);
+    csfg_var_table_deinit(&pl->edge_gains);
+    csfg_expr_pool_deinit(pl->graph_pool);
     csfg_path_vec_deinit(pl->loops);
     csfg_path_vec_deinit(pl->paths);
     csfg_graph_deinit(&pl->graph);
@@ -114,6 +175,11 @@ int math_pipeline_save(const struct math_pipeline* pl, struct serializer** ser)
 }
 
 /* -------------------------------------------------------------------------- */
+static int dup_expr(
+    struct csfg_expr_pool** dst, struct csfg_expr_pool* const* src, int expr)
+{
+    return expr < 0 ? -1 : csfg_expr_dup_recurse_from(dst, src, expr);
+}
 static void calc_graph_expression(struct math_pipeline* pl)
 {
     /* It's OK if node_in/node_out are -1 here */
@@ -121,44 +187,223 @@ static void calc_graph_expression(struct math_pipeline* pl)
         &pl->graph, &pl->paths, pl->node_in, pl->node_out);
     csfg_graph_find_loops(&pl->graph, &pl->loops);
 
-    pl->graph_expr =
-        csfg_graph_mason(&pl->graph, &pl->pool, pl->paths, pl->loops);
+    /* Every edge is represented by a symbol instead of a copy of its
+     * expression. This keeps the expression small, and it doesn't have to be
+     * recalculated when edge expressions change */
+    csfg_expr_pool_clear(pl->graph_pool);
+    pl->graph_expr = csfg_graph_transfer_function_with(
+        &pl->graph,
+        &pl->graph_pool,
+        pl->paths,
+        pl->loops,
+        pl->node_in,
+        pl->node_out,
+        csfg_graph_edge_symbol,
+        NULL);
     if (pl->graph_expr > -1)
     {
         csfg_rules_run(
-            &pl->pool,
+            &pl->graph_pool,
             csfg_rule_fold_constants,
             csfg_rule_remove_useless_ops,
             NULL);
-        pl->graph_expr = csfg_expr_gc(pl->pool, pl->graph_expr);
+        pl->graph_expr = csfg_expr_gc(pl->graph_pool, pl->graph_expr);
     }
 }
-static void calc_substitutions(struct math_pipeline* pl)
+static int has_invalid_edges(const struct csfg_graph* graph)
 {
-    pl->subs_expr = -1;
-    if (pl->graph_expr > -1)
-    {
-        pl->subs_expr = csfg_expr_insert_substitutions(
-            &pl->pool, pl->graph_expr, &pl->substitutions);
-    }
-    if (pl->subs_expr > -1)
+    const struct csfg_edge* edge;
+    csfg_graph_for_each_edge (graph, edge)
+        if (edge->expr < 0)
+            return 1;
+    return 0;
+}
+static int set_edge_gain(struct math_pipeline* pl, int edge_idx)
+{
+    struct csfg_expr_pool* pool;
+    int expr, symbol;
+    const struct csfg_edge* edge = vec_get(pl->graph.edges, edge_idx);
+
+    symbol = csfg_graph_edge_symbol_id(edge_idx);
+    if (symbol < 0 || edge->expr < 0)
+        return -1;
+
+    csfg_expr_pool_init(&pool);
+    expr = csfg_expr_dup_recurse_from(&pool, &edge->pool, edge->expr);
+    if (expr > -1)
+        expr = csfg_expr_insert_substitutions(&pool, expr, &pl->substitutions);
+    if (expr > -1)
     {
         csfg_rules_run(
-            &pl->pool,
+            &pool,
             csfg_rule_fold_constants,
             csfg_rule_remove_useless_ops,
             NULL);
-        pl->subs_expr = csfg_expr_gc(pl->pool, pl->subs_expr);
+        expr = csfg_expr_gc(pool, expr);
+    }
+    if (expr < 0 ||
+        csfg_var_table_set_expr(
+            &pl->edge_gains, csfg_symbol_view(symbol), pool, expr) != 0)
+    {
+        csfg_expr_pool_deinit(pool);
+        return -1;
+    }
+
+    return 0;
+}
+static int set_edge_gains(struct math_pipeline* pl)
+{
+    int i;
+    /* A missing gain would leave its raw symbol G[i] in the expression and in
+     * the parameters, so the whole stage fails instead */
+    csfg_var_table_clear(&pl->edge_gains);
+    for (i = 0; i != csfg_graph_edge_count(&pl->graph); ++i)
+        if (set_edge_gain(pl, i) != 0)
+            return -1;
+    return 0;
+}
+static int replace_edge_site(
+    struct math_pipeline* pl, const struct math_pipeline_edge_site* site)
+{
+    struct csfg_expr_pool* gain_pool;
+    struct csfg_expr_pool* pool;
+    int gain, root, i;
+    int symbol = csfg_graph_edge_symbol_id(site->edge_idx);
+
+    if (symbol < 0)
+        return -1;
+    gain_pool =
+        csfg_var_table_get(&pl->edge_gains, csfg_symbol_view(symbol), &gain);
+    if (gain_pool == NULL)
+        return -1;
+    root = csfg_expr_dup_recurse_from(&pl->subs_pool, &gain_pool, gain);
+    if (root < 0)
+        return -1;
+
+    /* The parent refers to the site, so the new subtree is moved into the
+     * site's node instead of being linked to the parent */
+    pool = pl->subs_pool;
+    for (i = 0; i != 2; ++i)
+        if (pool->nodes[site->node].child[i] > -1)
+        {
+            pl->subs_garbage +=
+                csfg_expr_count(pool, pool->nodes[site->node].child[i]);
+            csfg_expr_mark_deleted_recursive(
+                pool, pool->nodes[site->node].child[i]);
+        }
+    pool->nodes[site->node] = pool->nodes[root];
+    csfg_expr_mark_deleted_shallow(pool, root);
+    pl->subs_garbage++;
+
+    return 0;
+}
+static int collect_edge_sites(struct math_pipeline* pl)
+{
+    const struct csfg_expr_pool* pool = pl->subs_pool;
+    int n;
+
+    math_pipeline_edge_site_vec_clear(pl->edge_sites);
+    for (n = 0; n != pool->count; ++n)
+    {
+        struct math_pipeline_edge_site* site;
+        int edge_idx;
+
+        if (pool->nodes[n].type != CSFG_EXPR_VAR)
+            continue;
+        edge_idx = csfg_graph_edge_symbol_index(pool->nodes[n].value);
+        if (edge_idx < 0)
+            continue;
+
+        site = math_pipeline_edge_site_vec_emplace(&pl->edge_sites);
+        if (site == NULL)
+            return -1;
+        site->edge_idx = edge_idx;
+        site->node     = n;
+    }
+
+    return 0;
+}
+static int update_edge_sites(struct math_pipeline* pl, int edge_idx)
+{
+    const struct math_pipeline_edge_site* site;
+
+    if (set_edge_gain(pl, edge_idx) != 0)
+        return -1;
+    vec_for_each (pl->edge_sites, site)
+        if (site->edge_idx == edge_idx)
+            if (replace_edge_site(pl, site) != 0)
+                return -1;
+
+    return 0;
+}
+static int rebuild_substitutions(struct math_pipeline* pl)
+{
+    const struct math_pipeline_edge_site* site;
+
+    csfg_expr_pool_clear(pl->subs_pool);
+    pl->subs_garbage = 0;
+    pl->subs_expr = dup_expr(&pl->subs_pool, &pl->graph_pool, pl->graph_expr);
+    if (pl->subs_expr < 0)
+        return -1;
+
+    if (set_edge_gains(pl) != 0 || collect_edge_sites(pl) != 0)
+        return -1;
+    vec_for_each (pl->edge_sites, site)
+        if (replace_edge_site(pl, site) != 0)
+            return -1;
+
+    /* Only garbage created by later edits counts towards a rebuild */
+    pl->subs_garbage = 0;
+    return 0;
+}
+static void calc_substitutions(struct math_pipeline* pl)
+{
+    int edge_idx = pl->changed_edge;
+
+    pl->changed_edge = -1;
+    if (pl->graph_expr < 0 || has_invalid_edges(&pl->graph))
+        goto fail;
+
+    /* Only the edited edge is re-substituted, until the garbage left behind
+     * by replaced subtrees outweighs the expression */
+    if (pl->subs_incremental && edge_idx > -1 &&
+        pl->subs_garbage < csfg_expr_pool_count(pl->subs_pool) / 2)
+    {
+        if (update_edge_sites(pl, edge_idx) == 0)
+            return;
     }
+
+    if (rebuild_substitutions(pl) != 0)
+        goto fail;
+    pl->subs_incremental = 1;
+    return;
+
+fail:
+    pl->subs_expr        = -1;
+    pl->subs_incremental = 0;
 }
 static void calc_limits(struct math_pipeline* pl)
 {
     pl->lim_expr = -1;
-    if (pl->subs_expr > -1)
+    if (pl->subs_expr < 0)
+        return;
+
+    /* The substituted expression is patched in place when edges change, so
+     * the remaining stages work on a copy. Constants can only be folded
+     * across edges once the gains are inserted */
+    pl->lim_expr = dup_expr(&pl->pool, &pl->subs_pool, pl->subs_expr);
+    if (pl->lim_expr > -1)
     {
-        pl->lim_expr = csfg_expr_apply_limits(
-            &pl->pool, pl->subs_expr, &pl->substitutions);
+        csfg_rules_run(
+            &pl->pool,
+            csfg_rule_fold_constants,
+            csfg_rule_remove_useless_ops,
+            NULL);
+        pl->lim_expr = csfg_expr_gc(pl->pool, pl->lim_expr);
     }
+    if (pl->lim_expr > -1)
+        pl->lim_expr = csfg_expr_apply_limits(
+            &pl->pool, pl->lim_expr, &pl->substitutions);
     if (pl->lim_expr > -1)
         pl->lim_expr = csfg_expr_simplify(&pl->pool, pl->lim_expr);
 }
@@ -169,11 +414,14 @@ static void calc_symbolic_tf(struct math_pipeline* pl)
     {
         struct csfg_coeff_expr* c;
         csfg_expr_to_rational(&pl->tf_expr, &pl->pool, pl->lim_expr, "s");
+        /* Coefficients that are polynomials in the parameters can be brought
+         * into canonical form directly. Anything else goes through the
+         * (slower) rule-based simplifier */
         vec_for_each (pl->tf_expr.num, c)
-            if (c->expr > -1)
+            if (csfg_coeff_expr_canonicalize(&pl->pool, c) != 0)
                 c->expr = csfg_expr_simplify(&pl->pool, c->expr);
         vec_for_each (pl->tf_expr.den, c)
-            if (c->expr > -1)
+            if (csfg_coeff_expr_canonicalize(&pl->pool, c) != 0)
                 c->expr = csfg_expr_simplify(&pl->pool, c->expr);
     }
 }
@@ -189,78 +437,628 @@ static void repopulate_parameter_table(struct math_pipeline* pl)
 
     csfg_var_table_erase_unvisited(&pl->parameters);
 }
-static void calc_numeric_tf(struct math_pipeline* pl)
+static int calc_numeric_tf(struct math_pipeline* pl)
+{
+    return csfg_tf_from_symbolic(
+        &pl->tf, pl->pool, &pl->tf_expr, &pl->parameters);
+}
+static int has_limits(const struct csfg_var_table* vt)
+{
+    int slot;
+    const struct str* name;
+    const struct csfg_var_table_entry* entry;
+    hmap_for_each (vt->map, slot, name, entry)
+    {
+        (void)slot, (void)name;
+        if (entry->pool->nodes[entry->expr].type == CSFG_EXPR_INF)
+            return 1;
+    }
+    return 0;
+}
+static void clear_symbolic(struct math_pipeline* pl)
+{
+    pl->graph_expr       = -1;
+    pl->subs_expr        = -1;
+    pl->lim_expr         = -1;
+    pl->subs_incremental = 0;
+    csfg_tf_expr_clear(&pl->tf_expr);
+}
+static void repopulate_parameter_table_from_graph(struct math_pipeline* pl)
+{
+    const struct csfg_edge* edge;
+    const struct csfg_coeff_expr* coeff;
+    struct csfg_tf_expr tf_expr;
+    struct csfg_expr_pool* pool;
+
+    if (csfg_expr_pool_init_arena(&pool, &pl->scratch) != 0)
+        return;
+
+    /* Same as repopulate_parameter_table(), except the parameters are
+     * collected from every edge individually */
+    csfg_tf_expr_init(&tf_expr);
+    csfg_var_table_reset_visited(&pl->parameters);
+    csfg_graph_for_each_edge (&pl->graph, edge)
+    {
+        int expr;
+        csfg_expr_pool_clear(pool);
+        expr = csfg_expr_dup_recurse_from(&pool, &edge->pool, edge->expr);
+        if (expr > -1)
+            expr = csfg_expr_insert_substitutions(
+                &pool, expr, &pl->substitutions);
+        if (expr < 0)
+            continue;
+
+        csfg_tf_expr_clear(&tf_expr);
+        if (csfg_expr_to_rational(&tf_expr, &pool, expr, "s") != 0)
+            continue;
+
+        vec_for_each (tf_expr.num, coeff)
+            csfg_var_table_populate(&pl->parameters, pool, coeff->expr);
+        vec_for_each (tf_expr.den, coeff)
+            csfg_var_table_populate(&pl->parameters, pool, coeff->expr);
+    }
+    csfg_var_table_erase_unvisited(&pl->parameters);
+    csfg_tf_expr_deinit(&tf_expr);
+    csfg_expr_pool_deinit(pool);
+}
+static int calc_numeric_tf_from_graph(struct math_pipeline* pl)
 {
-    csfg_tf_from_symbolic(&pl->tf, pl->pool, &pl->tf_expr, &pl->parameters);
+    return csfg_tf_from_graph(
+        &pl->tf,
+        &pl->graph,
+        pl->node_in,
+        pl->node_out,
+        &pl->substitutions,
+        &pl->parameters);
+}
+static void clear_numeric_tf(struct math_pipeline* pl)
+{
+    csfg_cpoly_clear(pl->tf.num);
+    csfg_cpoly_clear(pl->tf.den);
+    csfg_rpoly_clear(pl->tf.zeros);
+    csfg_rpoly_clear(pl->tf.poles);
+    csfg_sos_vec_clear(pl->tf.sections);
 }
 static void calc_pfds(struct math_pipeline* pl)
 {
     csfg_rpoly_partial_fraction_decomposition(
         &pl->pfd_impulse, pl->tf.num, pl->tf.poles);
 
-    /* temporarily append poles to get step and ramp responses */
-    if (csfg_rpoly_push(&pl->tf.poles, csfg_complex(0, 0)) != 0)
-        goto push_step_pole_failed;
-    csfg_rpoly_partial_fraction_decomposition(
-        &pl->pfd_step, pl->tf.num, pl->tf.poles);
+    /* The step and ramp responses are T(s)/s and T(s)/s^2 */
+    if (csfg_pfd_poly_div_s(&pl->pfd_step, pl->pfd_impulse) != 0)
+        return;
+    csfg_pfd_poly_div_s(&pl->pfd_ramp, pl->pfd_step);
+}
+static int copy_poly_expr(
+    struct csfg_poly_expr** dst,
+    struct csfg_expr_pool** dst_pool,
+    const struct csfg_poly_expr* src,
+    struct csfg_expr_pool* const* src_pool)
+{
+    const struct csfg_coeff_expr* c;
+    vec_for_each (src, c)
+    {
+        int expr = dup_expr(dst_pool, src_pool, c->expr);
+        if (c->expr > -1 && expr < 0)
+            return -1;
+        if (csfg_poly_expr_push(dst, csfg_coeff_expr(c->factor, expr)) != 0)
+            return -1;
+    }
+    return 0;
+}
+static int copy_tf_expr(
+    struct csfg_tf_expr* dst,
+    struct csfg_expr_pool** dst_pool,
+    const struct csfg_tf_expr* src,
+    struct csfg_expr_pool* const* src_pool)
+{
+    csfg_tf_expr_clear(dst);
+    if (copy_poly_expr(&dst->num, dst_pool, src->num, src_pool) != 0)
+        return -1;
+    if (copy_poly_expr(&dst->den, dst_pool, src->den, src_pool) != 0)
+        return -1;
+    return 0;
+}
 
-    if (csfg_rpoly_push(&pl->tf.poles, csfg_complex(0, 0)) != 0)
-        goto push_ramp_pole_failed;
-    csfg_rpoly_partial_fraction_decomposition(
-        &pl->pfd_ramp, pl->tf.num, pl->tf.poles);
+/* -------------------------------------------------------------------------- */
+static int serialize_inputs(
+    struct serializer** ser,
+    const struct math_pipeline* pl,
+    int* topology_size)
+{
+    const struct csfg_edge* edge;
+    int err = 0;
 
-    csfg_rpoly_pop(pl->tf.poles);
-push_step_pole_failed:
-    csfg_rpoly_pop(pl->tf.poles);
-push_ramp_pole_failed:
-    return;
+    /* Mason's gain formula is expressed in terms of edge symbols, so it only
+     * depends on the topology of the graph. Everything after it also depends
+     * on the edge expressions and substitutions */
+    serializer_clear(*ser);
+    err += serialize_li32(ser, csfg_graph_node_count(&pl->graph));
+    err += serialize_li32(ser, pl->node_in);
+    err += serialize_li32(ser, pl->node_out);
+    csfg_graph_for_each_edge (&pl->graph, edge)
+    {
+        err += serialize_li32(ser, edge->n_idx_from);
+        err += serialize_li32(ser, edge->n_idx_to);
+    }
+    *topology_size = vec_count(*ser);
+
+    csfg_graph_for_each_edge (&pl->graph, edge)
+        err += csfg_io_expr_save(ser, edge->pool, edge->expr);
+    err += csfg_io_var_table_save(ser, &pl->substitutions);
+
+    return err ? -1 : vec_count(*ser);
 }
-void math_pipeline_update(
-    struct math_pipeline* pl, enum math_pipeline_state state)
+static int same_inputs(
+    const struct serializer* stored, const struct serializer* inputs, int size)
+{
+    /* Both are non-NULL if the counts match */
+    return size > 0 && vec_count(stored) == size
+           && memcmp(stored->data, inputs->data, size) == 0;
+}
+static int store_inputs(
+    struct serializer** stored, const struct serializer* inputs, int size)
 {
-    /* To prevent the pool from growing infinitely, the pool is cleared whenever
-     * an expression is recalculated. The only case where the pool can be
-     * completely cleared is when we have to re-run everything. In case of a
-     * partial update (for example, if the graph didn't change but
-     * substitutions changed), we copy over the existing graph to avoid having
-     * to run mason again. */
+    serializer_clear(*stored);
+    if (size <= 0)
+        return -1;
+    return serialize_data(stored, vec_data(inputs), size);
+}
+static int copy_paths(
+    struct csfg_path_vec** dst, const struct csfg_path_vec* src)
+{
+    const int* edge_idx;
+    csfg_path_vec_clear(*dst);
+    vec_for_each (src, edge_idx)
+        if (csfg_path_vec_push(dst, *edge_idx) != 0)
+            return -1;
+    return 0;
+}
 
-    if (state == MATH_PIPELINE_GRAPH_CHANGED)
+/* -------------------------------------------------------------------------- */
+static int find_mason_entry(
+    const struct math_pipeline* pl, const struct serializer* inputs, int size)
+{
+    int i;
+    for (i = 0; i != MATH_PIPELINE_CACHE_SIZE; ++i)
+        if (pl->mason_cache[i].stamp
+            && same_inputs(pl->mason_cache[i].inputs, inputs, size))
+        {
+            return i;
+        }
+    return -1;
+}
+static int oldest_mason_entry(const struct math_pipeline* pl)
+{
+    int i, oldest = 0;
+    for (i = 1; i != MATH_PIPELINE_CACHE_SIZE; ++i)
+        if (pl->mason_cache[i].stamp < pl->mason_cache[oldest].stamp)
+            oldest = i;
+    return oldest;
+}
+static int restore_mason(
+    struct math_pipeline* pl, const struct math_pipeline_mason_entry* entry)
+{
+    csfg_expr_pool_clear(pl->graph_pool);
+    pl->graph_expr = dup_expr(&pl->graph_pool, &entry->pool, entry->graph_expr);
+    if (entry->graph_expr > -1 && pl->graph_expr < 0)
+        return -1;
+    if (copy_paths(&pl->paths, entry->paths) != 0)
+        return -1;
+    return copy_paths(&pl->loops, entry->loops);
+}
+static void store_mason(struct math_pipeline* pl)
+{
+    struct math_pipeline_mason_entry* entry =
+        &pl->mason_cache[oldest_mason_entry(pl)];
+    csfg_expr_pool_clear(entry->pool);
+    entry->graph_expr = dup_expr(&entry->pool, &pl->graph_pool, pl->graph_expr);
+    entry->stamp      = ++pl->cache_stamp;
+    if ((pl->graph_expr > -1 && entry->graph_expr < 0)
+        || copy_paths(&entry->paths, pl->paths) != 0
+        || copy_paths(&entry->loops, pl->loops) != 0
+        || store_inputs(&entry->inputs, pl->inputs, pl->topology_size) != 0)
     {
-        csfg_expr_pool_clear(pl->pool);
+        entry->stamp = 0;
+    }
+}
+static void update_mason(struct math_pipeline* pl)
+{
+    int i;
+    if (same_inputs(pl->mason_inputs, pl->inputs, pl->topology_size))
+        return;
+
+    i = find_mason_entry(pl, pl->inputs, pl->topology_size);
+    if (i > -1 && restore_mason(pl, &pl->mason_cache[i]) == 0)
+        pl->mason_cache[i].stamp = ++pl->cache_stamp;
+    else
+    {
+        calc_graph_expression(pl);
+        store_mason(pl);
+    }
+    pl->subs_incremental = 0;
+
+    store_inputs(&pl->mason_inputs, pl->inputs, pl->topology_size);
+}
+
+/* -------------------------------------------------------------------------- */
+static int find_symbolic_entry(
+    const struct math_pipeline* pl, const struct serializer* inputs, int size)
+{
+    int i;
+    for (i = 0; i != MATH_PIPELINE_CACHE_SIZE; ++i)
+        if (pl->symbolic_cache[i].stamp
+            && same_inputs(pl->symbolic_cache[i].inputs, inputs, size))
+        {
+            return i;
+        }
+    return -1;
+}
+static int oldest_symbolic_entry(const struct math_pipeline* pl)
+{
+    int i, oldest = 0;
+    for (i = 1; i != MATH_PIPELINE_CACHE_SIZE; ++i)
+        if (pl->symbolic_cache[i].stamp < pl->symbolic_cache[oldest].stamp)
+            oldest = i;
+    return oldest;
+}
+static int restore_symbolic(
+    struct math_pipeline* pl, const struct math_pipeline_symbolic_entry* entry)
+{
+    /* The edge sites are unknown, the next edit rebuilds the expression */
+    pl->subs_incremental = 0;
+    csfg_expr_pool_clear(pl->subs_pool);
+    pl->subs_expr = dup_expr(&pl->subs_pool, &entry->pool, entry->subs_expr);
+    pl->lim_expr  = dup_expr(&pl->pool, &entry->pool, entry->lim_expr);
+    if (entry->subs_expr > -1 && pl->subs_expr < 0)
+        return -1;
+    if (entry->lim_expr > -1 && pl->lim_expr < 0)
+        return -1;
+    return copy_tf_expr(&pl->tf_expr, &pl->pool, &entry->tf_expr, &entry->pool);
+}
+static void store_symbolic(struct math_pipeline* pl)
+{
+    struct math_pipeline_symbolic_entry* entry =
+        &pl->symbolic_cache[oldest_symbolic_entry(pl)];
+    csfg_expr_pool_clear(entry->pool);
+    entry->subs_expr = dup_expr(&entry->pool, &pl->subs_pool, pl->subs_expr);
+    entry->lim_expr  = dup_expr(&entry->pool, &pl->pool, pl->lim_expr);
+    entry->stamp     = ++pl->cache_stamp;
+    if ((pl->subs_expr > -1 && entry->subs_expr < 0)
+        || (pl->lim_expr > -1 && entry->lim_expr < 0)
+        || copy_tf_expr(&entry->tf_expr, &entry->pool, &pl->tf_expr, &pl->pool)
+               != 0
+        || store_inputs(&entry->inputs, pl->inputs, pl->symbolic_size) != 0)
+    {
+        entry->stamp = 0;
+    }
+}
+static void update_symbolic(struct math_pipeline* pl)
+{
+    int i;
+    if (!pl->symbolic_from_graph
+        && same_inputs(pl->symbolic_inputs, pl->inputs, pl->symbolic_size))
+    {
+        return;
     }
-    else if (state == MATH_PIPELINE_SUBSTITUTIONS_CHANGED)
+
+    /* To prevent the pool from growing infinitely, the pool is cleared
+     * whenever the expressions are recalculated */
+    csfg_expr_pool_clear(pl->pool);
+    i = find_symbolic_entry(pl, pl->inputs, pl->symbolic_size);
+    if (i > -1 && restore_symbolic(pl, &pl->symbolic_cache[i]) == 0)
+        pl->symbolic_cache[i].stamp = ++pl->cache_stamp;
+    else
     {
-        struct csfg_expr_pool* tmp = pl->pool;
-        pl->pool                   = pl->prev_pool;
-        pl->prev_pool              = tmp;
-        /* Graph has not changed, copy over its expression, but clear every
-         * other expression */
         csfg_expr_pool_clear(pl->pool);
-        pl->graph_expr = csfg_expr_dup_recurse_from(
-            &pl->pool, &pl->prev_pool, pl->graph_expr);
+        calc_substitutions(pl);
+        calc_limits(pl);
+        calc_symbolic_tf(pl);
+        store_symbolic(pl);
     }
-    else if (state == MATH_PIPELINE_PARAMETERS_CHANGED)
+    repopulate_parameter_table(pl);
+
+    store_inputs(&pl->symbolic_inputs, pl->inputs, pl->symbolic_size);
+    pl->symbolic_from_graph = 0;
+}
+static void skip_symbolic(struct math_pipeline* pl)
+{
+    if (pl->symbolic_from_graph
+        && same_inputs(pl->symbolic_inputs, pl->inputs, pl->symbolic_size))
     {
-        /* no expression has changed */
+        return;
     }
 
-    switch (state)
+    csfg_expr_pool_clear(pl->pool);
+    clear_symbolic(pl);
+    repopulate_parameter_table_from_graph(pl);
+
+    /* Mason's gain formula was cleared as well */
+    serializer_clear(pl->mason_inputs);
+    store_inputs(&pl->symbolic_inputs, pl->inputs, pl->symbolic_size);
+    pl->symbolic_from_graph = 1;
+}
+
+/* -------------------------------------------------------------------------- */
+static void update_numeric(struct math_pipeline* pl, int from_graph)
+{
+    int size = -1;
+
+    /* The parameters are only known once the symbolic stages are done */
+    if (pl->symbolic_size > 0
+        && serialize_u8(&pl->inputs, from_graph) == 0
+        && csfg_io_var_table_save(&pl->inputs, &pl->parameters) == 0)
     {
-        case MATH_PIPELINE_GRAPH_CHANGED: /**/
-            calc_graph_expression(pl);
-            /* fallthrough */
-        case MATH_PIPELINE_SUBSTITUTIONS_CHANGED: /**/
-            calc_substitutions(pl);
-            calc_limits(pl);
-            calc_symbolic_tf(pl);
-            repopulate_parameter_table(pl);
-            /* fallthrough */
-        case MATH_PIPELINE_PARAMETERS_CHANGED: /**/
-            calc_numeric_tf(pl);
-            calc_pfds(pl);
-            /* fallthrough */
+        size = vec_count(pl->inputs);
+    }
+    if (same_inputs(pl->numeric_inputs, pl->inputs, size))
+        return;
+
+    if (!from_graph || calc_numeric_tf_from_graph(pl) != 0)
+    {
+        /* The graph can be too large to be solved numerically, in which case
+         * the transfer function is built from Mason's gain formula instead */
+        if (from_graph)
+        {
+            update_mason(pl);
+            update_symbolic(pl);
+        }
+        if (calc_numeric_tf(pl) != 0)
+            clear_numeric_tf(pl);
+    }
+    calc_pfds(pl);
+
+    store_inputs(&pl->numeric_inputs, pl->inputs, size);
+}
+
+/* -------------------------------------------------------------------------- */
+static void run_stages(struct math_pipeline* pl)
+{
+    struct arena* prev_scratch;
+    int from_graph =
+        pl->mode == MATH_PIPELINE_NUMERIC && !has_limits(&pl->substitutions);
+
+    /* Temporaries of the symbolic library are allocated from the scratch arena
+     * for the duration of the update */
+    prev_scratch = arena_scratch_set(&pl->scratch);
+
+    pl->symbolic_size =
+        serialize_inputs(&pl->inputs, pl, &pl->topology_size);
+    if (pl->symbolic_size < 0)
+        pl->topology_size = -1;
+
+    /* None of the symbolic stages are needed in numeric mode */
+    if (from_graph)
+        skip_symbolic(pl);
+    else
+    {
+        update_mason(pl);
+        update_symbolic(pl);
+    }
+    update_numeric(pl, from_graph);
+
+    pl->changed_edge = -1;
+    arena_scratch_set(prev_scratch);
+    arena_reset(&pl->scratch);
+}
+void math_pipeline_update(
+    struct math_pipeline* pl, enum math_pipeline_state state)
+{
+    /* Every edge gain depends on the substitutions */
+    if (state != MATH_PIPELINE_PARAMETERS_CHANGED)
+        pl->subs_incremental = 0;
+    run_stages(pl);
+}
+
+/* -------------------------------------------------------------------------- */
+void math_pipeline_update_edge_expr(struct math_pipeline* pl, int edge_idx)
+{
+    if (edge_idx < 0 || edge_idx >= csfg_graph_edge_count(&pl->graph))
+        pl->subs_incremental = 0;
+    pl->changed_edge = edge_idx;
+    run_stages(pl);
+}
+
+/* -------------------------------------------------------------------------- */
+hash64 math_pipeline_cache_key(const struct math_pipeline* pl)
+{
+    struct serializer* inputs;
+    int topology_size, size;
+    hash64 key = 0;
+
+    serializer_init(&inputs);
+    size = serialize_inputs(&inputs, pl, &topology_size);
+    if (size > 0)
+        key = hash64_fnv1a(vec_data(inputs), size);
+    serializer_deinit(inputs);
+
+    return key;
+}
+
+/* -------------------------------------------------------------------------- */
+static int save_poly_expr(
+    struct serializer** ser,
+    const struct csfg_expr_pool* pool,
+    const struct csfg_poly_expr* poly)
+{
+    const struct csfg_coeff_expr* c;
+    int err = 0;
+
+    err += serialize_li16(ser, vec_count(poly));
+    vec_for_each (poly, c)
+    {
+        err += serialize_lf64(ser, c->factor);
+        err += csfg_io_expr_save(ser, pool, c->expr);
+    }
+
+    return err;
+}
+int math_pipeline_save_cache(
+    const struct math_pipeline* pl, struct serializer** ser)
+{
+    const struct math_pipeline_mason_entry* mason;
+    const struct math_pipeline_symbolic_entry* symbolic;
+    struct serializer* inputs;
+    int topology_size, size, m, s, err = 0;
+    hash64 key;
+    const uint8_t version = 1;
+
+    /* The results may have been calculated in a previous update, e.g. if the
+     * pipeline is in numeric mode, so look them up in the caches */
+    serializer_init(&inputs);
+    size = serialize_inputs(&inputs, pl, &topology_size);
+    m    = find_mason_entry(pl, inputs, topology_size);
+    s    = find_symbolic_entry(pl, inputs, size);
+    if (m < 0 || s < 0)
+    {
+        serializer_deinit(inputs);
+        return -1;
+    }
+    mason    = &pl->mason_cache[m];
+    symbolic = &pl->symbolic_cache[s];
+
+    /* The key only selects the row in the database. The inputs are stored
+     * too, so a colliding key can't restore results of a different graph */
+    key = hash64_fnv1a(vec_data(inputs), size);
+    err += serialize_u8(ser, version);
+    err += serialize_lu32(ser, (uint32_t)(key & 0xFFFFFFFF));
+    err += serialize_lu32(ser, (uint32_t)(key >> 32));
+    err += serialize_li32(ser, size);
+    err += serialize_data(ser, vec_data(inputs), size);
+    serializer_deinit(inputs);
+    err += csfg_io_expr_save(ser, mason->pool, mason->graph_expr);
+    err += csfg_io_expr_save(ser, symbolic->pool, symbolic->subs_expr);
+    err += csfg_io_expr_save(ser, symbolic->pool, symbolic->lim_expr);
+    err += save_poly_expr(ser, symbolic->pool, symbolic->tf_expr.num);
+    err += save_poly_expr(ser, symbolic->pool, symbolic->tf_expr.den);
+
+    return err;
+}
+
+/* -------------------------------------------------------------------------- */
+static int load_expr(
+    struct deserializer* des,
+    struct csfg_expr_pool** pool,
+    struct csfg_expr_pool** tmp,
+    int* expr)
+{
+    /* csfg_io_expr_load() expects the pool to only contain the loaded
+     * expression, so it can't load multiple expressions into the same pool */
+    int tmp_expr = -1;
+    csfg_expr_pool_clear(*tmp);
+    if (csfg_io_expr_load(des, tmp, &tmp_expr) != 0)
+        return -1;
+    *expr = dup_expr(pool, tmp, tmp_expr);
+    return tmp_expr > -1 && *expr < 0 ? -1 : 0;
+}
+static int load_poly_expr(
+    struct deserializer* des,
+    struct csfg_expr_pool** pool,
+    struct csfg_expr_pool** tmp,
+    struct csfg_poly_expr** poly)
+{
+    int i, count = deserialize_li16(des);
+    for (i = 0; i < count; ++i)
+    {
+        int expr      = -1;
+        double factor = deserialize_lf64(des);
+        if (load_expr(des, pool, tmp, &expr) != 0)
+            return -1;
+        if (csfg_poly_expr_push(poly, csfg_coeff_expr(factor, expr)) != 0)
+            return -1;
     }
+
+    return deserializer_err(des) ? -1 : 0;
+}
+static int load_symbolic_entry(
+    struct deserializer* des,
+    struct math_pipeline_symbolic_entry* entry,
+    struct csfg_expr_pool** tmp)
+{
+    entry->subs_expr = -1;
+    entry->lim_expr  = -1;
+    csfg_expr_pool_clear(entry->pool);
+    csfg_tf_expr_clear(&entry->tf_expr);
+    if (load_expr(des, &entry->pool, tmp, &entry->subs_expr) != 0)
+        return -1;
+    if (load_expr(des, &entry->pool, tmp, &entry->lim_expr) != 0)
+        return -1;
+    if (load_poly_expr(des, &entry->pool, tmp, &entry->tf_expr.num) != 0)
+        return -1;
+    if (load_poly_expr(des, &entry->pool, tmp, &entry->tf_expr.den) != 0)
+        return -1;
+    return 0;
+}
+int math_pipeline_load_cache(struct math_pipeline* pl, struct deserializer* des)
+{
+    struct math_pipeline_mason_entry* mason;
+    struct math_pipeline_symbolic_entry* symbolic;
+    struct csfg_expr_pool* tmp;
+    struct serializer* inputs;
+    const void* stored_inputs;
+    hash64 key;
+    int topology_size, size;
+
+    serializer_init(&inputs);
+    size = serialize_inputs(&inputs, pl, &topology_size);
+    if (size <= 0 || deserialize_u8(des) != 1)
+        goto check_failed;
+    key = deserialize_lu32(des);
+    key |= (hash64)deserialize_lu32(des) << 32;
+    if (key != hash64_fnv1a(vec_data(inputs), size) ||
+        deserialize_li32(des) != size)
+        goto check_failed;
+    stored_inputs = deserialize_data1(des, size);
+    if (deserializer_err(des) || memcmp(stored_inputs, inputs->data, size) != 0)
+        goto check_failed;
+
+    mason           = &pl->mason_cache[oldest_mason_entry(pl)];
+    mason->stamp    = 0;
+    symbolic        = &pl->symbolic_cache[oldest_symbolic_entry(pl)];
+    symbolic->stamp = 0;
+
+    if (csfg_expr_pool_init_arena(&tmp, &pl->scratch) != 0)
+        goto check_failed;
+    csfg_expr_pool_clear(mason->pool);
+    if (load_expr(des, &mason->pool, &tmp, &mason->graph_expr) != 0)
+        goto fail;
+    if (load_symbolic_entry(des, symbolic, &tmp) != 0)
+        goto fail;
+    csfg_expr_pool_deinit(tmp);
+
+    /* Paths and loops are not saved. They are cheap to find compared to
+     * Mason's gain formula */
+    if (csfg_graph_find_forward_paths(
+            &pl->graph, &mason->paths, pl->node_in, pl->node_out) != 0 ||
+        csfg_graph_find_loops(&pl->graph, &mason->loops) != 0)
+        goto check_failed;
+
+    /* The next update finds the results in the caches */
+    if (store_inputs(&mason->inputs, inputs, topology_size) != 0 ||
+        store_inputs(&symbolic->inputs, inputs, size) != 0)
+        goto check_failed;
+    mason->stamp    = ++pl->cache_stamp;
+    symbolic->stamp = ++pl->cache_stamp;
+
+    serializer_deinit(inputs);
+    return 0;
+
+fail:
+    csfg_expr_pool_deinit(tmp);
+check_failed:
+    serializer_deinit(inputs);
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+void math_pipeline_set_mode(
+    struct math_pipeline* pl, enum math_pipeline_mode mode)
+{
+    if (pl->mode == mode)
+        return;
+
+    pl->mode = mode;
+    math_pipeline_update(pl, MATH_PIPELINE_GRAPH_CHANGED);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -283,8 +1081,9 @@ static void notify_expr_changed(
     if (i->expr == NULL)
         return;
 
-    i->expr->on_mason_expr(ctx, pipeline->pool, pipeline->graph_expr);
-    i->expr->on_substituted_expr(ctx, pipeline->pool, pipeline->subs_expr);
+    i->expr->on_mason_expr(ctx, pipeline->graph_pool, pipeline->graph_expr);
+    i->expr->on_substituted_expr(
+        ctx, pipeline->subs_pool, pipeline->subs_expr);
     i->expr->on_limit_expr(ctx, pipeline->pool, pipeline->lim_expr);
     i->expr->on_tf_expr(ctx, pipeline->pool, &pipeline->tf_expr);
 }
@@ -331,7 +1130,8 @@ void math_pipeline_notify_plugins(
     switch (state)
     {
         case MATH_PIPELINE_GRAPH_CHANGED:
-            if (state != MATH_PIPELINE_GRAPH_CHANGED || !is_source_plugin)
+        case MATH_PIPELINE_EDGE_EXPR_CHANGED:
+            if (!is_source_plugin)
             {
                 notify_graph_changed(pipeline, plugin_iface, plugin_ctx);
             }
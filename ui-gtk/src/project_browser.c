@@ -344,6 +344,7 @@ editable_label_text_changed_cb(DPSFGEditableLabel* editable, gpointer user_data)
         /* Move the data from the "Scratch" project to the new project */
         dbi->graph_data.move(db, SCRATCH_PROJECT_ID, new_project_id);
         dbi->plugin_data.move(db, SCRATCH_PROJECT_ID, new_project_id);
+        dbi->pipeline_cache.move(db, SCRATCH_PROJECT_ID, new_project_id);
         project_browser->active_project_id = new_project_id;
 
         /* Select the new project so the moved data gets loaded */
@@ -439,6 +440,7 @@ shortcut_delete_cb(GtkWidget* widget, GVariant* unused, gpointer user_data)
 
     dbi->graph_data.delete(db, SCRATCH_PROJECT_ID);
     dbi->plugin_data.delete(db, SCRATCH_PROJECT_ID);
+    dbi->pipeline_cache.delete(db, SCRATCH_PROJECT_ID);
 
     g_signal_emit(
         self, signals[SIGNAL_PROJECT_SELECTED], 0, SCRATCH_PROJECT_ID);